@@ -18,6 +18,9 @@ SRCS_C=(
   "./libs/fm_demod.c"
   "./libs/am_demod.c"
   "./libs/psd.c"
+  "./libs/psd_trace.c"
+  "./libs/psd_window.c"
+  "./libs/psd_pub.c"
   "./libs/sdr_HAL.c"
 )
 
@@ -27,9 +30,9 @@ SRCS_CPP=(
 )
 
 # Toolchain flags
-CFLAGS="-O2 -Wall -Wextra -pthread"
+CFLAGS="-O2 -fopenmp-simd -Wall -Wextra -pthread"
 CXXFLAGS="-O2 -Wall -Wextra -pthread -std=c++17"
-LDFLAGS="-lm"
+LDFLAGS="-lfftw3_threads -lm -lrt"
 
 # Required pkg-config modules
 PKGS=(libhackrf opus fftw3 libcjson)
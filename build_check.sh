@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Compila y ejecuta las comprobaciones numéricas de tests/ (sin hardware).
+#   ./build_check.sh          -> build/check_psd, sale != 0 si algo falla
+
+APP_NAME="check_psd"
+SRC_MAIN="tests/check_psd.c"
+LIBS_DIR="./libs"
+BUILD_DIR="./build"
+
+mkdir -p "${BUILD_DIR}"
+
+CFLAGS="-std=gnu11 -Wall -Wextra -pthread -fopenmp-simd -O2 -I${LIBS_DIR}"
+LDFLAGS="-lfftw3_threads -lm -lrt -pthread"
+
+need_pkg () {
+  local pkg="$1"
+  if ! pkg-config --exists "$pkg"; then
+    echo "[ERROR] pkg-config no encuentra '$pkg'. Instala el -dev correspondiente."
+    exit 1
+  fi
+}
+
+# psd.h arrastra sdr_HAL.h (solo cabeceras de hackrf, no se linkea)
+need_pkg libhackrf
+need_pkg fftw3
+DEP_CFLAGS="$(pkg-config --cflags libhackrf fftw3)"
+DEP_LIBS="$(pkg-config --libs fftw3)"
+
+CJSON_PKG=""
+if pkg-config --exists libcjson; then CJSON_PKG="libcjson"
+elif pkg-config --exists cjson; then CJSON_PKG="cjson"
+fi
+
+LIB_SOURCES=(
+  "${LIBS_DIR}/psd.c"
+  "${LIBS_DIR}/psd_trace.c"
+  "${LIBS_DIR}/psd_window.c"
+  "${LIBS_DIR}/psd_archive.c"
+  "${LIBS_DIR}/psd_sweep.c"
+)
+
+if [[ -n "${CJSON_PKG}" ]]; then
+  DEP_CFLAGS+=" $(pkg-config --cflags ${CJSON_PKG})"
+  DEP_LIBS+=" $(pkg-config --libs ${CJSON_PKG})"
+elif [[ -f "${LIBS_DIR}/cJSON.c" ]]; then
+  LIB_SOURCES+=( "${LIBS_DIR}/cJSON.c" )
+else
+  echo "[ERROR] No encontré cJSON (pkg-config ni ${LIBS_DIR}/cJSON.c)"
+  exit 1
+fi
+
+gcc ${CFLAGS} ${DEP_CFLAGS} \
+  "${SRC_MAIN}" "${LIB_SOURCES[@]}" \
+  -o "${BUILD_DIR}/${APP_NAME}" \
+  ${DEP_LIBS} ${LDFLAGS}
+
+echo "[BUILD] ${BUILD_DIR}/${APP_NAME}"
+"${BUILD_DIR}/${APP_NAME}"
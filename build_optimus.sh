@@ -21,18 +21,35 @@ SRCS=(
   "./libs/am_demod.c"
   "./libs/opus_tx.c"
   "./libs/psd.c"
+  "./libs/psd_trace.c"
+  "./libs/psd_window.c"
+  "./libs/psd_waterfall.c"
+  "./libs/psd_persist.c"
+  "./libs/psd_detect.c"
+  "./libs/psd_burst.c"
+  "./libs/psd_mask.c"
+  "./libs/psd_meas.c"
+  "./libs/psd_occ.c"
+  "./libs/psd_archive.c"
+  "./libs/tone_track.c"
+  "./libs/psd_fcache.c"
+  "./libs/psd_pub.c"
+  "./libs/psd_pyramid.c"
+  "./libs/psd_stream.c"
+  "./libs/psd_cal.c"
   "./libs/sdr_HAL.c"
   "./libs/pipeline_threads.c"
+  "./libs/zmq_util.c"
   "./libs/cic_decim.c"
   
 )
 
 # Toolchain flags
-CFLAGS="-O2 -Wall -Wextra -pthread"
-LDFLAGS="-lm"
+CFLAGS="-O2 -fopenmp-simd -Wall -Wextra -pthread"
+LDFLAGS="-lfftw3_threads -lm -lrt"
 
-# Required pkg-config modules (Debian names: libhackrf, opus, fftw3, cjson)
-PKGS=(libhackrf opus fftw3 libcjson)
+# Required pkg-config modules (Debian names: libhackrf, opus, fftw3, cjson, zmq, zlib1g)
+PKGS=(libhackrf opus fftw3 libcjson libzmq zlib)
 
 # ========= Helpers =========
 need_cmd() {
@@ -72,7 +89,7 @@ if [[ $missing -ne 0 ]]; then
 
 Fix (Debian/Ubuntu):
   sudo apt update
-  sudo apt install -y pkg-config libhackrf-dev libopus-dev libfftw3-dev libcjson-dev
+  sudo apt install -y pkg-config libhackrf-dev libopus-dev libfftw3-dev libcjson-dev libzmq3-dev
 
 Then re-run:
   ./build.sh
@@ -14,7 +14,7 @@ mkdir -p "${BUILD_DIR}"
 # Flags según modo
 # -----------------------------
 CSTD="-std=gnu11"
-COMMON_CFLAGS="-Wall -Wextra -Wpedantic -pthread -fno-omit-frame-pointer"
+COMMON_CFLAGS="-Wall -Wextra -Wpedantic -pthread -fno-omit-frame-pointer -fopenmp-simd"
 if [[ "${MODE}" == "release" ]]; then
   OPTFLAGS="-O2 -DNDEBUG"
 else
@@ -22,7 +22,7 @@ else
 fi
 
 CFLAGS="${CSTD} ${COMMON_CFLAGS} ${OPTFLAGS} -I${LIBS_DIR}"
-LDFLAGS="-lm -pthread"
+LDFLAGS="-lfftw3_threads -lm -lrt -pthread"
 
 echo "[BUILD] mode=${MODE}"
 echo "[BUILD] output=${BUILD_DIR}/${APP_NAME}"
@@ -71,6 +71,13 @@ fi
 # -----------------------------
 LIB_SOURCES=(
   "${LIBS_DIR}/psd.c"
+  "${LIBS_DIR}/psd_trace.c"
+  "${LIBS_DIR}/psd_window.c"
+  "${LIBS_DIR}/psd_pub.c"
+  "${LIBS_DIR}/psd_meas.c"
+  "${LIBS_DIR}/psd_cal.c"
+  "${LIBS_DIR}/psd_sweep.c"
+  "${LIBS_DIR}/psd_sched.c"
   "${LIBS_DIR}/sdr_HAL.c"
   "${LIBS_DIR}/ring_buffer.c"
 )
@@ -27,25 +27,212 @@ typedef enum {
     BARTLETT_TYPE
 } PsdWindowType_t;
 
+typedef enum {
+    PSD_ESTIMATOR_WELCH,
+    PSD_ESTIMATOR_MULTITAPER    // DPSS tapers + adaptive (Thomson) weighting
+} PsdEstimator_t;
+
 typedef struct {
     PsdWindowType_t window_type;
+    double window_param;    // Kaiser beta / Tukey alpha (0 = default)
     double sample_rate;
     int nperseg;
     int noverlap;
+    int zoom_decim;         // Zoom-FFT decimation (0/1 = full band)
+    double zoom_shift_hz;   // NCO shift: this offset from the LO lands at DC
+    PsdEstimator_t estimator;
+    double mt_nw;           // multitaper time-bandwidth product (0 = 4)
+    int mt_k;               // number of tapers (0 = 2*NW - 1)
 } PsdConfig_t;
 
 typedef enum {
     REALTIME_MODE,
     CAMPAIGN_MODE,
-    DEMODE_MODE
+    DEMODE_MODE,
+    RTSA_MODE               // Gapless streaming FFT, traces at frame_rate
 }rf_mode_t;
 
+typedef struct {
+    char *path;             // NULL = waterfall disabled
+    int rows;
+    double row_ms;
+    bool quantize_u8;       // uint8 dB rows instead of float32
+    double db_min;
+    double db_max;
+} WaterfallCfg_t;
+
+/* DPX-style persistence: frequency x amplitude hit density with exponential fade */
+#define PSD_PX_DEFAULT_LEVELS 256
+#define PSD_PX_DEFAULT_COLS   1024
+typedef struct {
+    char *path;             // NULL = persistence disabled
+    int levels;             // amplitude rows (0 = 256)
+    int max_cols;           // frequency columns (0 = 1024)
+    double db_min;
+    double db_max;
+    double decay_s;         // 0 = infinite persistence
+    double publish_ms;
+} PersistenceCfg_t;
+
+/* Noise floor + channel detection on every published trace (ZMQ "psd_detect") */
+#define PSD_DETECT_TOPIC "psd_detect"
+typedef struct {
+    bool enabled;
+    double res_db;          // noise histogram resolution (0 = 0.5)
+    double percentile;      // (0 = 50)
+    double delta_db;        // threshold above the noise floor (0 = 15)
+    int gap_bins;
+    int min_bins;
+} DetectCfg_t;
+
+/* Per-frame burst start/stop events (ZMQ "psd_burst") */
+#define PSD_BURST_TOPIC "psd_burst"
+typedef struct {
+    bool enabled;
+    double chan_hz;         // 0 = span / 512
+    double on_db;           // 0 = 10
+    double off_db;          // 0 = on_db - 4
+    double min_on_ms;
+    double hang_ms;
+    double noise_tau_s;     // 0 = 2 s
+} BurstCfg_t;
+
+/* Limit line: {"mask": {"points": [[f_hz, level_db], ...], "relative", "carrier_hz", "report_ms"}} */
+#define PSD_MASK_MAX_POINTS 64
+#define PSD_MASK_TOPIC      "psd_mask"
+typedef struct {
+    bool valid;
+    bool relative;          // point frequencies are offsets from carrier_hz
+    double carrier_hz;      // 0 = center_freq
+    double report_ms;       // summary period (0 = 1000)
+    int n_points;
+    double f_hz[PSD_MASK_MAX_POINTS];
+    double level_db[PSD_MASK_MAX_POINTS];   // in the configured dB scale
+} MaskCfg_t;
+
+/* One measured channel; adjacent channels sit at +-adj_offset_hz with adj_bw_hz (0 = bw_hz) */
+typedef struct {
+    double center_hz;
+    double bw_hz;
+    double adj_offset_hz;
+    double adj_bw_hz;
+} MeasChannel_t;
+
+typedef struct {
+    int n_channels;         // 0 = measurements disabled
+    MeasChannel_t *channels;  // heap, freed by free_desired_psd
+    double obw_pct;         // occupied bandwidth fraction in percent (0 = 99)
+} MeasCfg_t;
+
+/* Fixed-frequency trackers on the demod IQ stream: {"tones": {"freqs": [hz, ...], "rbw_hz", "rate_hz", "publish_ms"}} */
+#define TONE_TRACK_MAX 32
+typedef struct {
+    int n_tones;            // 0 = tracker disabled
+    double freq_hz[TONE_TRACK_MAX];   // absolute
+    double rbw_hz;          // sliding-DFT window = fs / rbw_hz (0 = 1000)
+    double rate_hz;         // power points per second and tone (0 = 1000)
+    double publish_ms;      // points batched per message (0 = 100)
+} ToneCfg_t;
+
+/* PSD history: {"archive": {"dir", "quantize", "db_min", "db_max", "segment_mb", "segment_s", "keep", "queue"}} */
+typedef struct {
+    char *dir;              // NULL = archive disabled
+    bool quantize_u8;       // uint8 dB records instead of float32
+    double db_min;
+    double db_max;
+    double segment_mb;      // 0 = 256
+    double segment_s;       // 0 = 3600
+    int keep_segments;      // 0 = keep all
+    int queue_rows;         // 0 = 256
+} ArchiveCfg_t;
+
+/* Remote spectrum stream: {"stream": {"port", "bind", "bins", "db_min", "db_max", "deadband", "compress", "clients"}} */
+typedef struct {
+    int port;               // 0 = off
+    char *bind;             // NULL = loopback only
+    int bins;               // max-pool to this many bins (0 = 2048)
+    double db_min;          // uint8 range (0/0 = -140..-12.5)
+    double db_max;
+    int deadband;           // levels a bin must move before it is resent
+    bool compress;          // zlib on top of the delta
+    int max_clients;        // 0 = 8
+} StreamCfg_t;
+
+/* CAMPAIGN_MODE sweep: {"sweep": {"f_start", "f_stop", "dwell_ms", "usable", "overlap", "settle_us", "dc_notch_hz", "passes"}} */
+typedef struct {
+    double f_start_hz;      // 0/0 = center_freq +- span/2
+    double f_stop_hz;
+    double dwell_ms;        // IQ kept per step after settling (0 = 8 Welch segments)
+    double usable;          // fraction of the sample rate kept per step (0 = 0.75)
+    double overlap;         // fraction of the usable band shared by neighbouring steps (0 = 0.25)
+    double settle_us;       // dropped after each retune, on top of the transfer in flight (0 = 500)
+    double dc_notch_hz;     // LO spike left to the neighbouring steps (0 = off)
+    int passes;             // 0 = sweep forever
+} SweepCfg_t;
+
+/* CAMPAIGN_MODE job list: {"jobs": [{"id", "center_freq_hz", "span", "rbw_hz", "duration_s", "window",
+   "sample_rate_hz", "lna_gain", "vga_gain", "antenna_amp"}, ...]}; unset fields take the top-level value */
+typedef struct {
+    char id[32];            // "" = "job<n>"
+    double center_hz;
+    double span;            // 0 = top-level
+    int rbw;                // 0 = top-level
+    double duration_s;      // 0 = what find_params_psd asks for
+    int window;             // PsdWindowType_t, -1 = top-level
+    double sample_rate;     // 0 = top-level
+    int lna_gain;           // -1 = top-level
+    int vga_gain;           // -1 = top-level
+    int amp;                // -1 = top-level
+} JobCfg_t;
+
+/* Long-term per-bin power statistics: {"occupancy": {"res_db", "db_min", "db_max", "cols", "threshold_db", "path", "save_s"}} */
+typedef struct {
+    bool enabled;
+    double res_db;          // bucket width (0 = 0.5 dB)
+    double db_min;
+    double db_max;
+    int max_cols;           // 0 = 1024
+    double threshold_db;    // duty-cycle threshold (NAN = P10 of each bin + 6 dB)
+    char *path;             // sketch file: resumed at start, saved every save_s and at exit (NULL = memory only)
+    double save_s;          // 0 = 60
+} OccupancyCfg_t;
+
+/* {"occ_query": {"quantiles": [10, 50, 90], "threshold_db", "merge": [path, ...], "save": path, "reset"}} */
+#define OCC_QUERY_MAX_Q     8
+#define OCC_QUERY_MAX_MERGE 8
+typedef struct {
+    bool valid;
+    int n_q;
+    double q_pct[OCC_QUERY_MAX_Q];          // empty = 10, 50, 90
+    double threshold_db;                    // NAN = occupancy default
+    int n_merge;
+    char *merge[OCC_QUERY_MAX_MERGE];       // saved sketches added to the live one for this report
+    char *save;                             // write the live sketch here
+    bool reset;                             // start a new accumulation window after the report
+} OccQueryCfg_t;
+
+#define PSD_FCACHE_DEFAULT_MB 256
+typedef struct {
+    double seconds;         // 0 = frame cache disabled
+    int max_mb;             // 0 = PSD_FCACHE_DEFAULT_MB
+} FrameCacheCfg_t;
+
+/* Recompute from the frame cache: {"cache_query": {"window_s", "age_s", "mode"}} */
+typedef struct {
+    bool valid;
+    double window_s;        // averaging window (0 = all cached frames)
+    double age_s;           // window ends this long before the newest frame
+    int mode;               // psd_fc_mode_t: 0 mean, 1 max, 2 min
+} CacheQueryCfg_t;
+
 typedef struct {
     rf_mode_t rf_mode;
     bool with_metrics;
     uint64_t center_freq;
     double sample_rate;
     double span;
+    bool zoom;              // NCO + CIC decimation down to ~2.5x span before the FFT
+    double lo_offset;       // LO tuned this far below center_freq (keeps the DC spike out of span)
     int lna_gain;
     int vga_gain;
     bool amp_enabled;
@@ -55,8 +242,39 @@ typedef struct {
     int rbw;
     double overlap;
     PsdWindowType_t window_type;
+    double window_param;
+    PsdEstimator_t estimator;
+    double mt_nw;
+    int mt_k;
     char *scale;
+    char *calibration;      // per-bin correction table (psd_cal.h), NULL = ideal 50 ohm chain
     int ppm_error;
+    double frame_rate;      // RTSA_MODE traces per second (0 = default)
+    int display_bins;       // max-pool published traces down to this many bins (0 = off)
+    int pyramid_min_bins;   // max/mean display pyramid in "<shm>_pyr", pooled down to this size (0 = off)
+    bool zmq_frames;        // scaled span as a binary ZMQ message on "psd_frame" every trace
+
+    // Persistent traces (psd_trace_kind_t bitmask)
+    unsigned trace_mask;
+    double ema_tau_s;
+    bool trace_time;        // keep per-bin time of max/min
+
+    WaterfallCfg_t waterfall;
+    PersistenceCfg_t persistence;
+    DetectCfg_t detect;
+    BurstCfg_t burst;
+    MaskCfg_t mask;
+    MeasCfg_t measure;
+    ToneCfg_t tones;
+    OccupancyCfg_t occupancy;
+    ArchiveCfg_t archive;
+    StreamCfg_t stream;
+    SweepCfg_t sweep;
+    JobCfg_t *jobs;         // heap, freed by free_desired_psd
+    int n_jobs;
+    OccQueryCfg_t occ_query;
+    FrameCacheCfg_t frame_cache;
+    CacheQueryCfg_t cache_query;
 } DesiredCfg_t;
 
 typedef struct {
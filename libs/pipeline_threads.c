@@ -10,6 +10,20 @@
 
 /* Use CIC library */
 #include "cic_decim.h"
+#include "psd_waterfall.h"
+#include "psd_pub.h"
+#include "psd_fcache.h"
+#include "psd_persist.h"
+#include "psd_detect.h"
+#include "psd_burst.h"
+#include "psd_mask.h"
+#include "psd_meas.h"
+#include "psd_occ.h"
+#include "psd_archive.h"
+#include "psd_pyramid.h"
+#include "psd_stream.h"
+#include "psd_cal.h"
+#include "tone_track.h"
 
 
 /* ---------- Metrics helpers: FM deviation & AM depth ---------- */
@@ -26,6 +40,9 @@
 #define DEV_REPORT_SEC       0.5f
 #define DEPTH_REPORT_SEC     0.5f
 
+/* RTSA: shm / ZMQ / stream llevan cada traza; el CSV (tmp + rename) como mucho a este ritmo */
+#define RTSA_CSV_PERIOD_SEC  1.0
+
 
 typedef struct {
     float dev_max_hz;
@@ -123,30 +140,6 @@ static const char* mode_str(demod_mode_t m) {
     switch (m) { case DEMOD_AM: return "AM"; case DEMOD_FM: return "FM"; default: return "UNKNOWN"; }
 }
 
-/* CSV helper: freq_rel + center_freq => freq_abs */
-static int save_results_csv(const char *csv_path,
-                            double* freq_array_rel,
-                            double* psd_array,
-                            int length,
-                            const SDR_cfg_t *local_hack,
-                            const char *scale_label)
-{
-    if (!csv_path || !freq_array_rel || !psd_array || length <= 0 || !local_hack) return -1;
-
-    FILE *fp = fopen(csv_path, "w");
-    if (!fp) { perror("[CSV] fopen"); return -1; }
-
-    fprintf(fp, "freq_hz,psd_%s\n", (scale_label && scale_label[0]) ? scale_label : "lin");
-
-    for (int i = 0; i < length; i++) {
-        double f_abs = freq_array_rel[i] + (double)local_hack->center_freq;
-        fprintf(fp, "%.6f,%.12e\n", f_abs, psd_array[i]);
-    }
-
-    fclose(fp);
-    return 0;
-}
-
 /* ---------- thread fns ---------- */
 
 static void* decim_thread_fn(void* arg) {
@@ -196,12 +189,56 @@ static void* decim_thread_fn(void* arg) {
                 atomic_fetch_add(ctx->iq_demod_drops,
                                  (unsigned long)((size_t)out_idx - w));
             }
+            if (ctx->iq_tone_rb) {
+                w = rb_sig_write(ctx->iq_tone_rb, out_bytes, (size_t)out_idx);
+                if (w < (size_t)out_idx && ctx->iq_tone_drops) {
+                    atomic_fetch_add(ctx->iq_tone_drops, (unsigned long)((size_t)out_idx - w));
+                }
+            }
         }
     }
 
     fprintf(stderr, "[DECIM] Exit\n");
     return NULL;
 }
+static void tone_emit(void *user, const char *json)
+{
+    zpub_publish((zpub_t*)user, TONE_TRACK_TOPIC, json);
+}
+
+/* Sliding-DFT bank on the decimated IQ: power of a few fixed carriers at kHz rates */
+static void* tone_thread_fn(void* arg) {
+    pipeline_ctx_t *ctx = (pipeline_ctx_t*)arg;
+
+    tone_track_t tt;
+    if (tone_track_open(&tt, &ctx->desired_cfg->tones, (double)ctx->sample_rate_demod,
+                        (double)ctx->hack_cfg->center_freq, tone_emit, ctx->zpub) != 0) {
+        fprintf(stderr, "[TONE] tracker disabled\n");
+        return NULL;
+    }
+
+    enum { TONE_CHUNK = 16384 }; /* bytes (even) */
+    uint8_t iq_bytes[TONE_CHUNK];
+    const double ns_per_iq = 1e9 / (double)ctx->sample_rate_demod;
+
+    while (!atomic_load(ctx->stop)) {
+        size_t got = rb_sig_read_blocking(ctx->iq_tone_rb, iq_bytes, 2, ctx->stop);
+        if (got == 0) break;
+
+        got += rb_sig_read(ctx->iq_tone_rb, iq_bytes + got, TONE_CHUNK - got);
+        got = (got / 2) * 2;
+
+        /* time of the first sample = now - (this chunk + still queued) */
+        size_t backlog = (rb_sig_available(ctx->iq_tone_rb) + got) / 2;
+        uint64_t t0 = psd_now_ns() - (uint64_t)((double)backlog * ns_per_iq);
+        tone_track_feed_iq8(&tt, (const int8_t*)iq_bytes, got / 2, t0);
+    }
+
+    fprintf(stderr, "[TONE] Exit | %llu messages\n", (unsigned long long)tt.msgs);
+    tone_track_close(&tt);
+    return NULL;
+}
+
 static void* demod_thread_fn(void* arg) {
     pipeline_ctx_t *ctx = (pipeline_ctx_t*)arg;
 
@@ -368,6 +405,885 @@ static void* net_thread_fn(void* arg) {
     return NULL;
 }
 
+/* Span crop indices for the relative frequency axis (span centered lo_offset above the LO) */
+static int psd_span_crop(const pipeline_ctx_t *ctx, const double *freq, int nbins, int *start_out)
+{
+    return psd_span_bins(freq, nbins, ctx->desired_cfg->lo_offset, ctx->desired_cfg->span, start_out);
+}
+
+/* Span crop + publication of one scaled PSD trace: shm (fast path) and CSV (optional, when csv_due) */
+static void psd_publish_trace(pipeline_ctx_t *ctx, psd_shm_t *shm,
+                              double *freq, double *psd, int nbins, uint64_t t_ns, bool csv_due)
+{
+    int start_idx;
+    int valid_len = psd_span_crop(ctx, freq, nbins, &start_idx);
+
+    if (valid_len <= 0) {
+        fprintf(stderr, "[PSD] Warning: span crop -> 0 bins\n");
+        return;
+    }
+
+    double *f_pub = &freq[start_idx];
+    double *p_pub = &psd[start_idx];
+    double *pool = NULL;
+
+    /* Large FFTs: max-pool the span down to display_bins (caller's arrays stay intact) */
+    int max_bins = ctx->desired_cfg->display_bins;
+    if (max_bins > 0 && valid_len > max_bins) {
+        pool = (double*)malloc(2 * (size_t)max_bins * sizeof(double));
+        if (pool) {
+            valid_len = psd_maxpool(f_pub, p_pub, valid_len, max_bins, pool, pool + max_bins);
+            f_pub = pool;
+            p_pub = pool + max_bins;
+        }
+    }
+
+    if (shm && shm->hdr) {
+        double df = (valid_len > 1) ? (f_pub[1] - f_pub[0]) : 0.0;
+        psd_shm_publish(shm, p_pub, valid_len,
+                        (double)ctx->hack_cfg->center_freq, ctx->psd_cfg->sample_rate,
+                        f_pub[0], df, ctx->desired_cfg->scale, t_ns);
+    }
+
+    if (csv_due && ctx->psd_csv_path &&
+        psd_save_csv(ctx->psd_csv_path, f_pub, p_pub, valid_len,
+                     ctx->hack_cfg->center_freq, ctx->desired_cfg->scale, NULL) == 0 &&
+        ctx->desired_cfg->rf_mode != RTSA_MODE) {
+        fprintf(stderr, "[PSD] Saved CSV: %s | bins=%d | drops=%lu\n",
+                ctx->psd_csv_path, valid_len,
+                (unsigned long)atomic_load(ctx->psd_drops));
+    }
+
+    free(pool);
+}
+
+/* "static/last_psd.csv" + "max" -> "static/last_psd_max.csv" */
+static void trace_csv_path(const char *base, const char *name, char *out, size_t len)
+{
+    const char *dot = strrchr(base, '.');
+    const char *slash = strrchr(base, '/');
+    if (!dot || (slash && dot < slash)) dot = base + strlen(base);
+    snprintf(out, len, "%.*s_%s%s", (int)(dot - base), base, name, dot);
+}
+
+/* Export every enabled persistent trace next to the main CSV (scratch = nbins doubles) */
+static void psd_publish_traces(pipeline_ctx_t *ctx, const psd_trace_t *tr,
+                               double *freq, double *scratch, int nbins)
+{
+    if (!tr || !tr->mask || !ctx->psd_csv_path) return;   // CSV only: callers rate-limit it
+
+    int start_idx;
+    int valid_len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    if (valid_len <= 0) return;
+
+    for (int k = 0; k < PSD_TRACE_COUNT; k++) {
+        psd_trace_kind_t kind = (psd_trace_kind_t)(1u << k);
+        if (psd_trace_get(tr, kind, scratch) != 0) continue;
+        scale_psd(scratch, nbins, ctx->desired_cfg->scale);
+
+        const uint64_t *t = psd_trace_times(tr, kind);
+        char path[512];
+        trace_csv_path(ctx->psd_csv_path, psd_trace_name(kind), path, sizeof(path));
+        psd_save_csv(path, &freq[start_idx], &scratch[start_idx], valid_len,
+                     ctx->hack_cfg->center_freq, ctx->desired_cfg->scale,
+                     t ? &t[start_idx] : NULL);
+    }
+}
+
+/* Optional outputs hanging off one Welch engine (traces, per-frame consumers) */
+typedef struct {
+    psd_trace_t trace;
+    bool has_trace;
+
+    psd_waterfall_t wf;
+    bool has_wf;
+
+    psd_persist_t px;
+    bool has_px;
+
+    psd_burst_t burst;
+    bool has_burst;
+
+    psd_mask_t mask;
+    bool has_mask;
+
+    psd_fcache_t fc;
+    bool has_fc;
+    psd_shm_t qshm;           // query results ("<shm>_query")
+    double *q_freq;
+    double *q_psd;
+
+    psd_detector_t det;
+    bool has_det;
+    char *det_json;
+    size_t det_json_cap;
+
+    psd_meas_t meas;
+    bool has_meas;
+    char *meas_json;
+    size_t meas_json_cap;
+
+    psd_archive_t ar;
+    bool has_ar;
+
+    psd_stream_t stream;
+    bool has_stream;
+
+    psd_occ_t occ;
+    bool has_occ;
+    uint64_t occ_saved_ns;
+
+    psd_shm_t shm;
+    psd_pyr_t pyr;            // display pyramid ("<shm>_pyr")
+    bool has_pyr;
+    bool has_zframes;         // binary traces on PSD_FRAME_TOPIC
+
+    psd_cal_t cal;
+    bool has_cal;
+    psd_cal_tuning_t cal_tun; // tuning the engine's gain was set for
+    bool cal_set;
+} psd_outputs_t;
+
+static void psd_frame_dispatch(void *user, const float *frame, int nbins, uint64_t t_ns)
+{
+    psd_outputs_t *out = (psd_outputs_t*)user;
+    if (out->has_wf) psd_wf_push_frame(&out->wf, frame, nbins, t_ns);
+    if (out->has_px) psd_px_push_frame(&out->px, frame, nbins, t_ns);
+    if (out->has_burst) psd_burst_push_frame(&out->burst, frame, nbins, t_ns);
+    if (out->has_mask) psd_mask_push_frame(&out->mask, frame, nbins, t_ns);
+    if (out->has_fc) psd_fcache_push(&out->fc, frame, nbins, t_ns);
+}
+
+static void psd_burst_emit(void *user, const char *json)
+{
+    zpub_publish((zpub_t*)user, PSD_BURST_TOPIC, json);
+}
+
+static void psd_mask_emit(void *user, const char *json)
+{
+    if (user) zpub_publish((zpub_t*)user, PSD_MASK_TOPIC, json);
+    if (strstr(json, "\"state\":\"alarm\"") || strstr(json, "\"state\":\"clear\"")) {
+        fprintf(stderr, "[MASK] %s\n", json);
+    }
+}
+
+/* (Re)compile a limit mask on the current span; a repeated config is a no-op (hash) */
+static void psd_mask_apply(pipeline_ctx_t *ctx, psd_welch_t *welch, psd_outputs_t *out, const MaskCfg_t *mc)
+{
+    double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+    if (!freq) return;
+    psd_welch_freq_axis(welch, freq);
+
+    double center = (double)ctx->hack_cfg->center_freq + welch->f_shift;
+    double df = welch->fs / welch->nfft;
+    psd_mask_geom_t g = {
+        .nfft = welch->nfft,
+        .df_hz = df,
+        .center_freq_hz = (double)ctx->hack_cfg->center_freq,
+        .scale = ctx->desired_cfg->scale
+    };
+    g.crop_len = psd_span_crop(ctx, freq, welch->nfft, &g.crop_start);
+    g.f_start_hz = center - welch->fs / 2.0 + g.crop_start * df;
+    free(freq);
+
+    int rc = psd_mask_compile(&out->mask, mc, &g, psd_mask_emit, ctx->zpub);
+    if (rc < 0) {
+        fprintf(stderr, "[PSD] mask rejected%s\n", out->has_mask ? " (previous mask kept)" : "");
+        return;
+    }
+    out->has_mask = true;
+    if (!welch->on_frame && psd_welch_set_frame_cb(welch, psd_frame_dispatch, out) != 0) {
+        fprintf(stderr, "[PSD] frame buffer alloc failed (mask disabled)\n");
+        out->has_mask = false;
+    }
+}
+
+static void psd_outputs_open(pipeline_ctx_t *ctx, psd_welch_t *welch, psd_outputs_t *out)
+{
+    const DesiredCfg_t *d = ctx->desired_cfg;
+    bool linear_scale = d->scale && (strcmp(d->scale, "W") == 0 || strcmp(d->scale, "V") == 0);
+    memset(out, 0, sizeof(*out));
+    out->shm.fd = -1;
+
+    if (ctx->psd_shm_name &&
+        psd_shm_create(&out->shm, ctx->psd_shm_name, (uint32_t)welch->nfft) != 0) {
+        fprintf(stderr, "[PSD] shm publication disabled\n");
+    }
+    if (d->calibration) {
+        out->has_cal = psd_cal_load(&out->cal, d->calibration) == 0;
+        if (!out->has_cal) fprintf(stderr, "[PSD] calibration disabled\n");
+    }
+    out->pyr.fd = -1;
+    if (ctx->psd_shm_name && d->pyramid_min_bins > 0) {
+        char pname[96];
+        snprintf(pname, sizeof(pname), "%s_pyr", ctx->psd_shm_name);
+        out->has_pyr = psd_pyr_create(&out->pyr, pname, (uint32_t)welch->nfft, d->pyramid_min_bins) == 0;
+    }
+    if (d->zmq_frames && ctx->zpub) {
+        // 4 slots: the trace being filled + up to 3 still queued for slow subscribers
+        out->has_zframes = zpub_bin_enable(ctx->zpub, 4, (size_t)welch->nfft) == 0;
+        if (!out->has_zframes) fprintf(stderr, "[PSD] binary ZMQ frames disabled\n");
+    }
+
+    if (d->trace_mask) {
+        double seg_period_s = (double)welch->step / welch->fs;
+        if (psd_trace_init(&out->trace, welch->nfft, d->trace_mask, d->trace_time,
+                           d->ema_tau_s, seg_period_s) == 0) {
+            welch->trace = &out->trace;
+            out->has_trace = true;
+        } else {
+            fprintf(stderr, "[PSD] psd_trace_init failed (traces disabled)\n");
+        }
+    }
+
+    if (d->waterfall.path) {
+        /* span crop on the (fixed) relative frequency axis */
+        double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        if (freq) {
+            psd_welch_freq_axis(welch, freq);
+
+            psd_wf_cfg_t wc = {
+                .path = d->waterfall.path,
+                .nrows = d->waterfall.rows,
+                .row_ms = d->waterfall.row_ms,
+                .format = d->waterfall.quantize_u8 ? PSD_WF_U8 : PSD_WF_F32,
+                .db_min = d->waterfall.db_min,
+                .db_max = d->waterfall.db_max,
+                .nfft = welch->nfft,
+                .center_freq_hz = (double)ctx->hack_cfg->center_freq + welch->f_shift,
+                .sample_rate_hz = welch->fs,
+                .scale = d->scale
+            };
+            wc.crop_len = psd_span_crop(ctx, freq, welch->nfft, &wc.crop_start);
+            free(freq);
+
+            if (psd_wf_open(&out->wf, &wc) == 0) out->has_wf = true;
+            else fprintf(stderr, "[PSD] waterfall disabled\n");
+        }
+    }
+
+    if (d->persistence.path) {
+        double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        if (freq) {
+            psd_welch_freq_axis(welch, freq);
+
+            psd_px_cfg_t pc = {
+                .path = d->persistence.path,
+                .nlevels = d->persistence.levels,
+                .max_cols = d->persistence.max_cols,
+                .db_min = d->persistence.db_min,
+                .db_max = d->persistence.db_max,
+                .decay_s = d->persistence.decay_s,
+                .publish_ms = d->persistence.publish_ms,
+                .nfft = welch->nfft,
+                .seg_period_s = (double)welch->step / welch->fs,
+                .center_freq_hz = (double)ctx->hack_cfg->center_freq + welch->f_shift,
+                .sample_rate_hz = welch->fs,
+                .scale = d->scale
+            };
+            pc.crop_len = psd_span_crop(ctx, freq, welch->nfft, &pc.crop_start);
+            free(freq);
+
+            if (psd_px_open(&out->px, &pc) == 0) out->has_px = true;
+            else fprintf(stderr, "[PSD] persistence disabled\n");
+        }
+    }
+
+    if (d->detect.enabled) {
+        psd_detect_cfg_t dc = {
+            .res_db = d->detect.res_db,
+            .percentile = d->detect.percentile,
+            .delta_db = d->detect.delta_db,
+            .gap_bins = d->detect.gap_bins,
+            .min_bins = d->detect.min_bins
+        };
+        out->det_json_cap = psd_detect_json_cap();
+        out->det_json = (char*)malloc(out->det_json_cap);
+        if (!ctx->zpub || linear_scale) {
+            fprintf(stderr, "[PSD] detector disabled (%s)\n", linear_scale ? "needs a dB scale" : "no ZMQ publisher");
+        } else if (out->det_json && psd_detect_init(&out->det, &dc) == 0) {
+            out->has_det = true;
+        } else {
+            fprintf(stderr, "[PSD] detector alloc failed\n");
+        }
+    }
+
+    if (d->measure.n_channels > 0 && !ctx->zpub) {
+        fprintf(stderr, "[PSD] measurements disabled (no ZMQ publisher)\n");
+    } else if (d->measure.n_channels > 0) {
+        if (psd_meas_init(&out->meas, &d->measure, welch->nfft) == 0) {
+            out->meas_json_cap = psd_meas_json_cap(&out->meas);
+            out->meas_json = (char*)malloc(out->meas_json_cap);
+            if (out->meas_json) out->has_meas = true;
+            else psd_meas_free(&out->meas);
+        }
+        if (!out->has_meas) fprintf(stderr, "[PSD] measurement alloc failed\n");
+    }
+
+    if (d->archive.dir) {
+        double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        if (freq) {
+            psd_welch_freq_axis(welch, freq);
+            int start;
+            psd_ar_cfg_t ac = {
+                .dir = d->archive.dir,
+                .format = d->archive.quantize_u8 ? PSD_AR_U8 : PSD_AR_F32,
+                .db_min = d->archive.db_min,
+                .db_max = d->archive.db_max,
+                .segment_mb = d->archive.segment_mb,
+                .segment_s = d->archive.segment_s,
+                .keep_segments = d->archive.keep_segments,
+                .queue_rows = d->archive.queue_rows,
+                .center_freq_hz = (double)ctx->hack_cfg->center_freq,
+                .sample_rate_hz = ctx->psd_cfg->sample_rate,
+                .scale = d->scale
+            };
+            ac.nbins = psd_span_crop(ctx, freq, welch->nfft, &start);
+            if (ac.nbins > 1) {
+                ac.f_start_hz = (double)ctx->hack_cfg->center_freq + freq[start];
+                ac.df_hz = freq[1] - freq[0];
+            }
+            free(freq);
+
+            if (psd_ar_open(&out->ar, &ac) == 0) out->has_ar = true;
+            else fprintf(stderr, "[PSD] archive disabled\n");
+        }
+    }
+
+    if (d->stream.port > 0 && linear_scale) {
+        fprintf(stderr, "[PSD] spectrum stream disabled (needs a dB scale)\n");
+    } else if (d->stream.port > 0) {
+        psd_stream_cfg_t sc = {
+            .port = d->stream.port,
+            .bind_addr = d->stream.bind,
+            .bins = d->stream.bins,
+            .db_min = d->stream.db_min,
+            .db_max = d->stream.db_max,
+            .deadband = d->stream.deadband,
+            .compress = d->stream.compress,
+            .max_clients = d->stream.max_clients
+        };
+        if (psd_stream_open(&out->stream, &sc) == 0) out->has_stream = true;
+        else fprintf(stderr, "[PSD] spectrum stream disabled\n");
+    }
+
+    if (d->occupancy.enabled && linear_scale) {
+        fprintf(stderr, "[PSD] occupancy disabled (needs a dB scale)\n");
+    } else if (d->occupancy.enabled) {
+        double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        if (freq) {
+            psd_welch_freq_axis(welch, freq);
+            int start;
+            psd_occ_cfg_t oc = {
+                .res_db = d->occupancy.res_db,
+                .db_min = d->occupancy.db_min,
+                .db_max = d->occupancy.db_max,
+                .max_cols = d->occupancy.max_cols,
+                .scale = d->scale
+            };
+            oc.crop_len = psd_span_crop(ctx, freq, welch->nfft, &start);
+            if (oc.crop_len > 1) {
+                oc.f_start_hz = (double)ctx->hack_cfg->center_freq + freq[start];
+                oc.df_hz = freq[1] - freq[0];
+            }
+            free(freq);
+
+            if (psd_occ_open(&out->occ, &oc) == 0) {
+                out->has_occ = true;
+                /* resume a previous run on the same geometry */
+                psd_occ_t prev;
+                if (d->occupancy.path && psd_occ_load(&prev, d->occupancy.path) == 0) {
+                    if (psd_occ_merge(&out->occ, &prev) == 0) {
+                        fprintf(stderr, "[OCC] resumed %s (%llu traces)\n", d->occupancy.path,
+                                (unsigned long long)prev.h.traces);
+                    }
+                    psd_occ_close(&prev);
+                }
+                out->occ_saved_ns = psd_now_ns();
+            } else {
+                fprintf(stderr, "[PSD] occupancy disabled\n");
+            }
+        }
+    }
+
+    if (d->burst.enabled && !ctx->zpub) {
+        fprintf(stderr, "[PSD] burst detector disabled (no ZMQ publisher)\n");
+    } else if (d->burst.enabled) {
+        double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        if (freq) {
+            psd_welch_freq_axis(welch, freq);
+
+            psd_burst_cfg_t bc = {
+                .chan_hz = d->burst.chan_hz,
+                .on_db = d->burst.on_db,
+                .off_db = d->burst.off_db,
+                .min_on_ms = d->burst.min_on_ms,
+                .hang_ms = d->burst.hang_ms,
+                .noise_tau_s = d->burst.noise_tau_s,
+                .nfft = welch->nfft,
+                .seg_period_s = (double)welch->step / welch->fs,
+                .center_freq_hz = (double)ctx->hack_cfg->center_freq + welch->f_shift,
+                .sample_rate_hz = welch->fs
+            };
+            bc.crop_len = psd_span_crop(ctx, freq, welch->nfft, &bc.crop_start);
+            free(freq);
+
+            if (psd_burst_open(&out->burst, &bc, psd_burst_emit, ctx->zpub) == 0) out->has_burst = true;
+            else fprintf(stderr, "[PSD] burst detector disabled\n");
+        }
+    }
+
+    if (d->mask.valid) psd_mask_apply(ctx, welch, out, &d->mask);
+
+    if (d->frame_cache.seconds > 0) {
+        double seg_period_s = (double)welch->step / welch->fs;
+        out->q_freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        out->q_psd  = (double*)malloc((size_t)welch->nfft * sizeof(double));
+        if (out->q_freq && out->q_psd &&
+            psd_fcache_open(&out->fc, welch->nfft, d->frame_cache.seconds, seg_period_s,
+                            d->frame_cache.max_mb) == 0) {
+            out->has_fc = true;
+            psd_welch_freq_axis(welch, out->q_freq);
+            out->qshm.fd = -1;
+            if (ctx->psd_shm_name) {
+                char qname[96];
+                snprintf(qname, sizeof(qname), "%s_query", ctx->psd_shm_name);
+                psd_shm_create(&out->qshm, qname, (uint32_t)welch->nfft);
+            }
+        } else {
+            fprintf(stderr, "[PSD] frame cache disabled\n");
+        }
+    }
+
+    if (out->has_wf || out->has_px || out->has_burst || out->has_mask || out->has_fc) {
+        if (psd_welch_set_frame_cb(welch, psd_frame_dispatch, out) != 0) {
+            fprintf(stderr, "[PSD] frame buffer alloc failed (per-frame outputs disabled)\n");
+        }
+    }
+}
+
+static void psd_outputs_close(pipeline_ctx_t *ctx, psd_welch_t *welch, psd_outputs_t *out)
+{
+    psd_welch_set_frame_cb(welch, NULL, NULL);
+    welch->trace = NULL;
+    if (out->has_trace) psd_trace_free(&out->trace);
+    if (out->has_wf) psd_wf_close(&out->wf);
+    if (out->has_px) psd_px_close(&out->px);
+    if (out->has_burst) {
+        fprintf(stderr, "[BURST] %llu events\n", (unsigned long long)out->burst.events);
+        psd_burst_close(&out->burst);
+    }
+    if (out->has_fc) {
+        psd_fcache_close(&out->fc);
+        psd_shm_close(&out->qshm);
+    }
+    if (out->has_det) psd_detect_free(&out->det);
+    if (out->has_meas) psd_meas_free(&out->meas);
+    if (out->has_ar) psd_ar_close(&out->ar);
+    if (out->has_stream) psd_stream_close(&out->stream);
+    if (out->has_cal) {
+        fprintf(stderr, "[CAL] %llu vectors computed, %llu cached\n",
+                (unsigned long long)out->cal.misses, (unsigned long long)out->cal.hits);
+        psd_cal_free(&out->cal);
+    }
+    if (out->has_occ) {
+        if (ctx->desired_cfg->occupancy.path) psd_occ_save(&out->occ, ctx->desired_cfg->occupancy.path);
+        psd_occ_close(&out->occ);
+    }
+    psd_mask_free(&out->mask);
+    free(out->det_json);
+    free(out->meas_json);
+    free(out->q_freq);
+    free(out->q_psd);
+    psd_shm_close(&out->shm);
+    if (out->has_pyr) psd_pyr_close(&out->pyr);
+    memset(out, 0, sizeof(*out));
+}
+
+/* Noise floor + channels on the published span, one ZMQ message per trace */
+static void psd_publish_detect(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                               const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_det) return;
+
+    int start_idx;
+    int len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    if (len <= 0 || psd_detect_run(&out->det, &freq[start_idx], &psd[start_idx], len) < 0) return;
+
+    if (psd_detect_json(&out->det, t_ns, (double)ctx->hack_cfg->center_freq,
+                        out->det_json, out->det_json_cap) > 0) {
+        zpub_publish(ctx->zpub, PSD_DETECT_TOPIC, out->det_json);
+    }
+}
+
+/* Full-resolution scaled span -> max/mean pyramid in shm (clients pick the level per zoom) */
+static void psd_publish_pyramid(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                                const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_pyr) return;
+
+    int start_idx;
+    int len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    if (len <= 0) return;
+    double df = (len > 1) ? freq[start_idx + 1] - freq[start_idx] : 0.0;
+    psd_pyr_publish(&out->pyr, &psd[start_idx], len,
+                    (double)ctx->hack_cfg->center_freq, ctx->psd_cfg->sample_rate,
+                    freq[start_idx], df, ctx->desired_cfg->scale, t_ns);
+}
+
+/* Scaled span as one zero-copy multipart ZMQ message (dropped if every slot is still in flight) */
+static void psd_publish_zframe(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                               const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_zframes) return;
+
+    int start_idx;
+    int len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    zpub_bin_buf_t buf;
+    if (len <= 1 || zpub_bin_acquire(ctx->zpub, &buf) != 0) return;
+    if ((size_t)len > buf.cap) len = (int)buf.cap;
+
+    zpub_bin_hdr_t *h = buf.hdr;
+    h->kind = ZPUB_BIN_PSD;
+    h->t_ns = t_ns;
+    h->center_freq_hz = (double)ctx->hack_cfg->center_freq;
+    h->f_start_hz = h->center_freq_hz + freq[start_idx];
+    h->df_hz = freq[start_idx + 1] - freq[start_idx];
+    snprintf(h->scale, sizeof(h->scale), "%s", ctx->desired_cfg->scale ? ctx->desired_cfg->scale : "lin");
+
+    const double *src = &psd[start_idx];
+    float *dst = buf.data;
+    #pragma omp simd
+    for (int i = 0; i < len; i++) dst[i] = (float)src[i];
+
+    zpub_bin_publish(ctx->zpub, PSD_FRAME_TOPIC, &buf, (uint32_t)len);
+}
+
+/* Scaled span to the TCP spectrum stream (quantized here, encoded and sent by its thread) */
+static void psd_publish_stream(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                               const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_stream) return;
+
+    int start_idx;
+    int len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    if (len <= 1) return;
+    psd_stream_push(&out->stream, &psd[start_idx], len,
+                    (double)ctx->hack_cfg->center_freq + freq[start_idx],
+                    freq[start_idx + 1] - freq[start_idx], t_ns);
+}
+
+/* Scaled span into the history archive (queued; the writer thread does the I/O) */
+static void psd_publish_archive(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                                const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_ar) return;
+
+    int start_idx;
+    int len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    psd_ar_append(&out->ar, &psd[start_idx], len, t_ns);
+}
+
+/* Scaled span into the occupancy sketch; checkpoint to disk every save_s */
+static void psd_publish_occ(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                            const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_occ) return;
+
+    int start_idx;
+    int len = psd_span_crop(ctx, freq, nbins, &start_idx);
+    psd_occ_push_db(&out->occ, &psd[start_idx], len, t_ns);
+
+    const OccupancyCfg_t *oc = &ctx->desired_cfg->occupancy;
+    double save_s = oc->save_s > 0 ? oc->save_s : 60.0;
+    if (oc->path && t_ns >= out->occ_saved_ns + (uint64_t)(save_s * 1e9)) {
+        psd_occ_save(&out->occ, oc->path);
+        out->occ_saved_ns = t_ns;
+    }
+}
+
+/* Occupancy report: quantiles + duty cycle per column -> "<csv>_occ.csv" */
+static void psd_occ_query(pipeline_ctx_t *ctx, psd_outputs_t *out, const OccQueryCfg_t *q)
+{
+    if (!out->has_occ) {
+        fprintf(stderr, "[OCC] query ignored: occupancy disabled\n");
+        return;
+    }
+    uint64_t t_start = psd_now_ns();
+
+    /* other sensors / time windows: merged into a copy, the live sketch is untouched */
+    psd_occ_t merged;
+    const psd_occ_t *rep = &out->occ;
+    if (q->n_merge > 0 && psd_occ_copy(&merged, &out->occ) == 0) {
+        rep = &merged;
+        for (int i = 0; i < q->n_merge; i++) {
+            psd_occ_t other;
+            if (psd_occ_load(&other, q->merge[i]) != 0) continue;
+            if (psd_occ_merge(&merged, &other) != 0) fprintf(stderr, "[OCC] %s not merged\n", q->merge[i]);
+            psd_occ_close(&other);
+        }
+    }
+
+    static const double def_q[] = { 10.0, 50.0, 90.0 };
+    const double *qp = q->n_q > 0 ? q->q_pct : def_q;
+    int nq = q->n_q > 0 ? q->n_q : 3;
+    double thr = !isnan(q->threshold_db) ? q->threshold_db : ctx->desired_cfg->occupancy.threshold_db;
+
+    if (ctx->psd_csv_path) {
+        char path[512];
+        trace_csv_path(ctx->psd_csv_path, "occ", path, sizeof(path));
+        if (psd_occ_export_csv(rep, path, qp, nq, thr) == 0) {
+            fprintf(stderr, "[OCC] report %s | %llu traces over %.1f h | %.2f ms\n", path,
+                    (unsigned long long)rep->h.traces,
+                    (double)(rep->h.t_last_ns - rep->h.t_first_ns) / 3.6e12,
+                    (double)(psd_now_ns() - t_start) / 1e6);
+        }
+    }
+    if (rep == &merged) psd_occ_close(&merged);
+
+    if (q->save && psd_occ_save(&out->occ, q->save) == 0) fprintf(stderr, "[OCC] saved %s\n", q->save);
+    if (q->reset) psd_occ_reset(&out->occ);
+}
+
+/*
+  Calibration for the current tuning, folded into the engine's per-bin gain:
+  frames (waterfall, persistence, bursts, mask, frame cache), traces,
+  measurements and the published trace all see the same corrected levels.
+  Only a retune (or gain change) recomputes it; call before feeding samples.
+*/
+static void psd_cal_engine(pipeline_ctx_t *ctx, psd_outputs_t *out, psd_welch_t *welch)
+{
+    if (!out->has_cal) return;
+    psd_cal_tuning_t tun = {
+        .center_freq_hz = ctx->hack_cfg->center_freq,
+        .sample_rate_hz = ctx->hack_cfg->sample_rate,
+        .lna_gain = ctx->hack_cfg->lna_gain,
+        .vga_gain = ctx->hack_cfg->vga_gain,
+        .amp_enabled = ctx->hack_cfg->amp_enabled
+    };
+    const psd_cal_tuning_t *o = &out->cal_tun;
+    if (out->cal_set && o->center_freq_hz == tun.center_freq_hz && o->sample_rate_hz == tun.sample_rate_hz &&
+        o->lna_gain == tun.lna_gain && o->vga_gain == tun.vga_gain && o->amp_enabled == tun.amp_enabled) return;
+
+    double *freq = (double*)malloc((size_t)welch->nfft * sizeof(double));
+    if (!freq) return;
+    psd_welch_freq_axis(welch, freq);
+    const double *corr = psd_cal_vector(&out->cal, &tun, freq, welch->nfft);
+    free(freq);
+    if (!corr || psd_welch_set_gain_db(welch, corr) != 0) {
+        fprintf(stderr, "[PSD] calibration vector failed: levels are uncalibrated\n");
+        psd_welch_set_gain_db(welch, NULL);
+    }
+    out->cal_tun = tun;
+    out->cal_set = true;
+}
+
+/* Linear PSD -> configured scale (calibration is already in the engine's gain) */
+static void psd_scale_frame(pipeline_ctx_t *ctx, double *psd, int nbins)
+{
+    scale_psd(psd, nbins, ctx->desired_cfg->scale);
+}
+
+/* Channel power / OBW / ACPR on the linear PSD (call before scale_psd) */
+static void psd_publish_meas(pipeline_ctx_t *ctx, psd_outputs_t *out,
+                             const double *freq, const double *psd, int nbins, uint64_t t_ns)
+{
+    if (!out->has_meas) return;
+    if (psd_meas_load(&out->meas, freq, psd, nbins, (double)ctx->hack_cfg->center_freq) < 0) return;
+
+    psd_meas_run(&out->meas);
+    if (psd_meas_json(&out->meas, t_ns, out->meas_json, out->meas_json_cap) > 0) {
+        zpub_publish(ctx->zpub, PSD_MEAS_TOPIC, out->meas_json);
+    }
+}
+
+/*
+  Frame-cache query: re-average / max-hold the cached frames over another time
+  window, span or scale without touching the capture. Result goes to its own
+  shm segment and "<csv>_query.csv". A "mask" in the same JSON replaces the
+  limit mask.
+*/
+static void psd_service_query(pipeline_ctx_t *ctx, psd_welch_t *welch, psd_outputs_t *out)
+{
+    if (!ctx->psd_query_lock || !ctx->psd_query_json) return;
+
+    pthread_mutex_lock(ctx->psd_query_lock);
+    char *json = *ctx->psd_query_json;
+    *ctx->psd_query_json = NULL;
+    pthread_mutex_unlock(ctx->psd_query_lock);
+    if (!json) return;
+
+    DesiredCfg_t q;
+    if (parse_psd_config(json, &q) != 0) {
+        fprintf(stderr, "[PSD] query ignored: invalid JSON\n");
+        free(json);
+        return;
+    }
+
+    /* live mask update (same mask again = no rebuild) */
+    if (q.mask.valid) psd_mask_apply(ctx, welch, out, &q.mask);
+
+    if (q.occ_query.valid) psd_occ_query(ctx, out, &q.occ_query);
+
+    if (!q.cache_query.valid) {
+        if (!q.mask.valid && !q.occ_query.valid) {
+            fprintf(stderr, "[PSD] query ignored: expected \"cache_query\", \"mask\" or \"occ_query\"\n");
+        }
+    } else if (!out->has_fc) {
+        fprintf(stderr, "[FCACHE] query ignored: frame cache disabled\n");
+    } else {
+        uint64_t t_start = psd_now_ns();
+        double span = q.span > 0 ? q.span : ctx->desired_cfg->span;
+        const char *scale = q.scale ? q.scale : ctx->desired_cfg->scale;
+
+        int start_idx;
+        int len = psd_span_bins(out->q_freq, welch->nfft, ctx->desired_cfg->lo_offset, span, &start_idx);
+        uint64_t t_last = 0;
+        int used = (len > 0) ? psd_fcache_query(&out->fc, q.cache_query.window_s, q.cache_query.age_s,
+                                                (psd_fc_mode_t)q.cache_query.mode, start_idx, len,
+                                                &out->q_psd[start_idx], &t_last) : 0;
+
+        if (used > 0) {
+            double *f = &out->q_freq[start_idx];
+            double *p = &out->q_psd[start_idx];
+            scale_psd(p, len, scale);   // cached frames carry the calibration of their tuning
+
+            if (out->qshm.hdr) {
+                psd_shm_publish(&out->qshm, p, len, (double)ctx->hack_cfg->center_freq,
+                                ctx->psd_cfg->sample_rate, f[0], (len > 1) ? f[1] - f[0] : 0.0,
+                                scale, t_last);
+            }
+            if (ctx->psd_csv_path) {
+                char path[512];
+                trace_csv_path(ctx->psd_csv_path, "query", path, sizeof(path));
+                psd_save_csv(path, f, p, len, ctx->hack_cfg->center_freq, scale, NULL);
+            }
+        }
+
+        fprintf(stderr, "[FCACHE] query window=%.2fs age=%.2fs mode=%d -> %d frames, %d bins, %.2f ms\n",
+                q.cache_query.window_s, q.cache_query.age_s, q.cache_query.mode, used, len,
+                (double)(psd_now_ns() - t_start) / 1e6);
+    }
+    free_desired_psd(&q);
+    free(json);
+}
+
+/*
+  RTSA: capture stays armed, every sample goes through overlapped FFTs and a
+  trace is published every fs/frame_rate samples. If the producer had to drop
+  bytes, the stream has a gap: reads stop at it (rb_read_run), so everything
+  queued before the drop is fed first, then an overrun is counted and the
+  overlap restarts at the first sample after it.
+*/
+static void psd_rtsa_loop(pipeline_ctx_t *ctx)
+{
+    enum { RTSA_CHUNK = 256 * 1024 }; /* bytes (even) */
+
+    double fps = ctx->desired_cfg->frame_rate > 0 ? ctx->desired_cfg->frame_rate
+                                                  : PSD_RTSA_DEFAULT_FPS;
+    size_t frame_samples = (size_t)(ctx->psd_cfg->sample_rate / fps);
+    size_t seg_samples = (size_t)ctx->psd_cfg->nperseg *
+                         (size_t)(ctx->psd_cfg->zoom_decim > 1 ? ctx->psd_cfg->zoom_decim : 1);
+    if (frame_samples < seg_samples) frame_samples = seg_samples;
+
+    psd_welch_t welch;
+    if (psd_welch_init(&welch, ctx->psd_cfg) != 0) {
+        fprintf(stderr, "[RTSA] psd_welch_init failed\n");
+        atomic_store(ctx->stop, 1);
+        return;
+    }
+
+    psd_outputs_t out;
+    psd_outputs_open(ctx, &welch, &out);
+
+    int8_t *chunk = (int8_t*)malloc(RTSA_CHUNK);
+    double *freq  = (double*)malloc((size_t)welch.nfft * sizeof(double));
+    double *psd   = (double*)malloc((size_t)welch.nfft * sizeof(double));
+    if (!chunk || !freq || !psd) {
+        fprintf(stderr, "[RTSA] malloc failed\n");
+        free(chunk); free(freq); free(psd);
+        psd_outputs_close(ctx, &welch, &out);
+        psd_welch_free(&welch);
+        atomic_store(ctx->stop, 1);
+        return;
+    }
+
+    fprintf(stderr, "[RTSA] Start | %.1f traces/s | %zu samples/trace | step=%d\n",
+            fps, frame_samples, welch.step);
+
+    rb_reset(ctx->psd_rb);
+    *(ctx->psd_capture_active) = true;
+
+    uint64_t next_pos = 0;   // stream position right after the last byte fed
+    size_t pending = 0;
+    uint64_t last_csv_ns = 0;
+
+    while (!atomic_load(ctx->stop)) {
+        psd_service_query(ctx, &welch, &out);
+        psd_cal_engine(ctx, &out, &welch);
+
+        uint64_t start = 0;
+        size_t got = rb_read_run(ctx->psd_rb, chunk, RTSA_CHUNK, &start);
+        if (got == 0) {
+            usleep(1000);
+            continue;
+        }
+        if (start != next_pos) {
+            unsigned long n = ctx->psd_overruns ? atomic_fetch_add(ctx->psd_overruns, 1) + 1 : 0;
+            fprintf(stderr, "[RTSA] Overrun #%lu: %llu bytes lost\n", n,
+                    (unsigned long long)(start - next_pos));
+            psd_welch_flush_history(&welch);
+        }
+        got = (got / 2) * 2;   // an odd byte left over shows up as a gap on the next read
+        next_pos = start + got;
+        if (got == 0) continue;
+
+        size_t n_iq = got / 2;
+
+        /* timestamp of the first sample read = now - (read + still queued) */
+        size_t backlog = rb_available(ctx->psd_rb) / 2 + n_iq;
+        psd_welch_set_time(&welch, psd_now_ns() -
+                           (uint64_t)((double)backlog * 1e9 / ctx->psd_cfg->sample_rate));
+
+        /* slices up to the next frame boundary: one read may close several traces */
+        size_t off = 0;
+        while (off < n_iq) {
+            size_t take = n_iq - off;
+            if (take > frame_samples - pending) take = frame_samples - pending;
+            psd_welch_feed_iq8(&welch, chunk + 2 * off, take);
+            off += take;
+            pending += take;
+            if (pending < frame_samples) break;
+
+            pending = 0;
+            if (psd_welch_result(&welch, freq, psd) > 0) {
+                uint64_t t_pub = psd_now_ns();
+                bool csv_due = (t_pub - last_csv_ns) >= (uint64_t)(RTSA_CSV_PERIOD_SEC * 1e9);
+                if (csv_due) last_csv_ns = t_pub;
+                psd_publish_meas(ctx, &out, freq, psd, welch.nfft, t_pub);
+                psd_scale_frame(ctx, psd, welch.nfft);
+                psd_publish_trace(ctx, &out.shm, freq, psd, welch.nfft, t_pub, csv_due);
+                psd_publish_pyramid(ctx, &out, freq, psd, welch.nfft, t_pub);
+                psd_publish_stream(ctx, &out, freq, psd, welch.nfft, t_pub);
+                psd_publish_zframe(ctx, &out, freq, psd, welch.nfft, t_pub);
+                psd_publish_detect(ctx, &out, freq, psd, welch.nfft, t_pub);
+                psd_publish_occ(ctx, &out, freq, psd, welch.nfft, t_pub);
+                psd_publish_archive(ctx, &out, freq, psd, welch.nfft, t_pub);
+                if (csv_due) psd_publish_traces(ctx, welch.trace, freq, psd, welch.nfft);
+            }
+            psd_welch_reset(&welch);
+        }
+    }
+
+    *(ctx->psd_capture_active) = false;
+
+    free(chunk);
+    free(freq);
+    free(psd);
+    psd_outputs_close(ctx, &welch, &out);
+    psd_welch_free(&welch);
+}
+
 static void* psd_thread_fn(void* arg) {
     pipeline_ctx_t *ctx = (pipeline_ctx_t*)arg;
 
@@ -376,6 +1292,12 @@ static void* psd_thread_fn(void* arg) {
             ctx->psd_cfg->nperseg,
             (ctx->desired_cfg->scale ? ctx->desired_cfg->scale : "lin"));
 
+    if (ctx->desired_cfg->rf_mode == RTSA_MODE) {
+        psd_rtsa_loop(ctx);
+        fprintf(stderr, "[PSD] Exit\n");
+        return NULL;
+    }
+
     if ((size_t)ctx->rb_cfg->total_bytes > ctx->psd_rb->size) {
         fprintf(stderr, "[PSD] ERROR: total_bytes=%zu > PSD_RB_BYTES=%zu\n",
                 (size_t)ctx->rb_cfg->total_bytes, ctx->psd_rb->size);
@@ -383,6 +1305,17 @@ static void* psd_thread_fn(void* arg) {
         return NULL;
     }
 
+    /* Engine (window + plan) and traces persist across captures */
+    psd_welch_t welch;
+    if (psd_welch_init(&welch, ctx->psd_cfg) != 0) {
+        fprintf(stderr, "[PSD] psd_welch_init failed\n");
+        atomic_store(ctx->stop, 1);
+        return NULL;
+    }
+
+    psd_outputs_t out;
+    psd_outputs_open(ctx, &welch, &out);
+
     while (!atomic_load(ctx->stop)) {
         rb_reset(ctx->psd_rb);
         *(ctx->psd_capture_active) = true;
@@ -390,6 +1323,7 @@ static void* psd_thread_fn(void* arg) {
         int safety = ctx->psd_wait_timeout_iters;
         while (!atomic_load(ctx->stop) && safety-- > 0) {
             if (rb_available(ctx->psd_rb) >= (size_t)ctx->rb_cfg->total_bytes) break;
+            psd_service_query(ctx, &welch, &out);
             usleep((useconds_t)ctx->psd_wait_sleep_us);
         }
 
@@ -412,69 +1346,67 @@ static void* psd_thread_fn(void* arg) {
 
         rb_read(ctx->psd_rb, linear_buffer, (size_t)ctx->rb_cfg->total_bytes);
 
-        signal_iq_t *sig = load_iq_from_buffer(linear_buffer, (size_t)ctx->rb_cfg->total_bytes);
-        free(linear_buffer);
-
-        if (!sig) {
-            fprintf(stderr, "[PSD] load_iq_from_buffer failed\n");
-            usleep((useconds_t)ctx->psd_post_sleep_us);
-            continue;
-        }
+        /* the capture ended ~now: first sample is one capture length ago */
+        uint64_t t0_ns = psd_now_ns() -
+            (uint64_t)((double)ctx->rb_cfg->total_bytes / 2.0 * 1e9 / ctx->psd_cfg->sample_rate);
 
         double *freq = (double*)malloc((size_t)ctx->psd_cfg->nperseg * sizeof(double));
         double *psd  = (double*)malloc((size_t)ctx->psd_cfg->nperseg * sizeof(double));
         if (!freq || !psd) {
             fprintf(stderr, "[PSD] malloc freq/psd failed\n");
             free(freq); free(psd);
-            free_signal_iq(sig);
+            free(linear_buffer);
             usleep((useconds_t)ctx->psd_post_sleep_us);
             continue;
         }
 
-        execute_welch_psd(sig, ctx->psd_cfg, freq, psd);
-        scale_psd(psd, ctx->psd_cfg->nperseg, ctx->desired_cfg->scale);
-
-        double half_span = ctx->desired_cfg->span / 2.0;
-        int start_idx = 0;
-        int end_idx = ctx->psd_cfg->nperseg - 1;
-
-        for (int i = 0; i < ctx->psd_cfg->nperseg; i++) {
-            if (freq[i] >= -half_span) { start_idx = i; break; }
-        }
-        for (int i = start_idx; i < ctx->psd_cfg->nperseg; i++) {
-            if (freq[i] > half_span) { end_idx = i - 1; break; }
-            end_idx = i;
-        }
+        /* int8 goes straight into the segment history: no 16 B/sample complex copy */
+        psd_welch_reset(&welch);
+        psd_cal_engine(ctx, &out, &welch);
+        psd_welch_run_iq8(&welch, linear_buffer, (size_t)ctx->rb_cfg->total_bytes / 2, t0_ns);
+        free(linear_buffer);
 
-        int valid_len = end_idx - start_idx + 1;
-        if (valid_len > 0) {
-            if (save_results_csv(ctx->psd_csv_path,
-                                 &freq[start_idx],
-                                 &psd[start_idx],
-                                 valid_len,
-                                 ctx->hack_cfg,
-                                 ctx->desired_cfg->scale) == 0) {
-                fprintf(stderr, "[PSD] Saved CSV: %s | bins=%d | drops=%lu\n",
-                        ctx->psd_csv_path, valid_len,
-                        (unsigned long)atomic_load(ctx->psd_drops));
-            }
-        } else {
-            fprintf(stderr, "[PSD] Warning: span crop -> 0 bins\n");
+        if (psd_welch_result(&welch, freq, psd) > 0) {
+            psd_publish_meas(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_scale_frame(ctx, psd, welch.nfft);
+            psd_publish_trace(ctx, &out.shm, freq, psd, welch.nfft, t0_ns, true);
+            psd_publish_pyramid(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_publish_stream(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_publish_zframe(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_publish_detect(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_publish_occ(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_publish_archive(ctx, &out, freq, psd, welch.nfft, t0_ns);
+            psd_publish_traces(ctx, welch.trace, freq, psd, welch.nfft);
         }
 
         free(freq);
         free(psd);
-        free_signal_iq(sig);
 
         usleep((useconds_t)ctx->psd_post_sleep_us);
     }
 
+    psd_outputs_close(ctx, &welch, &out);
+    psd_welch_free(&welch);
+
     fprintf(stderr, "[PSD] Exit\n");
     return NULL;
 }
 
 /* ---------- public API ---------- */
 
+int pipeline_psd_post_query(pipeline_ctx_t *ctx, const char *json) {
+    if (!ctx || !json || !ctx->psd_query_lock || !ctx->psd_query_json) return -1;
+
+    char *copy = strdup(json);
+    if (!copy) return -1;
+
+    pthread_mutex_lock(ctx->psd_query_lock);
+    free(*ctx->psd_query_json);   /* an unserved older query is superseded */
+    *ctx->psd_query_json = copy;
+    pthread_mutex_unlock(ctx->psd_query_lock);
+    return 0;
+}
+
 int pipeline_threads_start(pipeline_threads_t *t, pipeline_ctx_t *ctx) {
     memset(t, 0, sizeof(*t));
 
@@ -520,6 +1452,15 @@ int pipeline_threads_start(pipeline_threads_t *t, pipeline_ctx_t *ctx) {
     }
     t->started_psd = true;
 
+    /* optional: a failed tracker does not stop the pipeline */
+    if (ctx->iq_tone_rb && ctx->zpub) {
+        if (pthread_create(&t->th_tone, NULL, tone_thread_fn, ctx) != 0) {
+            fprintf(stderr, "[PIPE] pthread_create tone failed (tracker disabled)\n");
+        } else {
+            t->started_tone = true;
+        }
+    }
+
     return 0;
 }
 
@@ -528,6 +1469,7 @@ void pipeline_threads_stop(pipeline_ctx_t *ctx) {
     rb_sig_wake_all(ctx->iq_raw_rb);
     rb_sig_wake_all(ctx->iq_demod_rb);
     rb_sig_wake_all(ctx->pcm_rb);
+    if (ctx->iq_tone_rb) rb_sig_wake_all(ctx->iq_tone_rb);
     /* psd_rb usa rb_available polling; stop flag basta */
 }
 
@@ -536,4 +1478,5 @@ void pipeline_threads_join(pipeline_threads_t *t) {
     if (t->started_demod) pthread_join(t->th_demod, NULL);
     if (t->started_net)   pthread_join(t->th_net, NULL);
     if (t->started_psd)   pthread_join(t->th_psd, NULL);
+    if (t->started_tone)  pthread_join(t->th_tone, NULL);
 }
@@ -15,6 +15,7 @@
 #include "psd.h"
 #include "datatypes.h"
 #include "sdr_HAL.h"
+#include "zmq_util.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,16 +43,23 @@ typedef struct {
     rb_sig_t *iq_raw_rb;
     rb_sig_t *iq_demod_rb;
     rb_sig_t *pcm_rb;
+    rb_sig_t *iq_tone_rb;       /* copy of the demod IQ for the tone tracker (NULL = off) */
 
     /* drops counters */
     atomic_ulong *iq_raw_drops;
     atomic_ulong *iq_demod_drops;
     atomic_ulong *pcm_drops;
+    atomic_ulong *iq_tone_drops;
 
     /* PSD RB + control */
     ring_buffer_t *psd_rb;
     volatile bool *psd_capture_active;
     atomic_ulong *psd_drops;
+    atomic_ulong *psd_overruns;   /* RTSA: times the consumer fell behind (gap) */
+
+    /* Query mailbox: frame-cache queries and live mask updates (JSON, latest wins; NULL = off) */
+    pthread_mutex_t *psd_query_lock;
+    char **psd_query_json;
 
     /* Opus tx */
     opus_tx_t *tx;
@@ -68,7 +76,9 @@ typedef struct {
     RB_cfg_t     *rb_cfg;
 
     /* Outputs */
-    const char *psd_csv_path;
+    const char *psd_shm_name;   /* binary seqlock frame in /dev/shm (NULL = off) */
+    const char *psd_csv_path;   /* slow-path text export (NULL = off) */
+    zpub_t *zpub;               /* PSD events + tone tracker series + binary traces, topics "psd_*", "tone_track" (NULL = off) */
 
     /* PSD loop params */
     int  psd_wait_timeout_iters;
@@ -81,10 +91,12 @@ typedef struct {
     pthread_t th_demod;
     pthread_t th_net;
     pthread_t th_psd;
+    pthread_t th_tone;
     bool started_decim;
     bool started_demod;
     bool started_net;
     bool started_psd;
+    bool started_tone;
 } pipeline_threads_t;
 
 
@@ -98,6 +110,9 @@ void pipeline_threads_stop(pipeline_ctx_t *ctx);
 /* join all started threads */
 void pipeline_threads_join(pipeline_threads_t *t);
 
+/* hand a JSON request ("cache_query" and/or "mask", see parse_psd_config) to the PSD thread */
+int pipeline_psd_post_query(pipeline_ctx_t *ctx, const char *json);
+
 #ifdef __cplusplus
 }
 #endif
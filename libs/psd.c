@@ -1,11 +1,15 @@
 //libs/psd.c
 #include "psd.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <fftw3.h>
-#include <alloca.h>
+#include <time.h>
 #include <complex.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 // =========================================================
 // IQ & Memory
@@ -67,6 +71,7 @@ int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
         if(strcmp(rf_mode->valuestring, "realtime") == 0) target->rf_mode = REALTIME_MODE;
         else if(strcmp(rf_mode->valuestring, "campaign") == 0) target->rf_mode = CAMPAIGN_MODE;
         else if(strcmp(rf_mode->valuestring, "demodulate") == 0) target->rf_mode = DEMODE_MODE;
+        else if(strcmp(rf_mode->valuestring, "rtsa") == 0) target->rf_mode = RTSA_MODE;
         else target->rf_mode = REALTIME_MODE;
     }
 
@@ -77,6 +82,12 @@ int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
     cJSON *span = cJSON_GetObjectItemCaseSensitive(root, "span");
     if (cJSON_IsNumber(span)) target->span = span->valuedouble;
 
+    cJSON *zoom = cJSON_GetObjectItemCaseSensitive(root, "zoom");
+    if (cJSON_IsBool(zoom)) target->zoom = cJSON_IsTrue(zoom);
+
+    cJSON *lo_off = cJSON_GetObjectItemCaseSensitive(root, "lo_offset_hz");
+    if (cJSON_IsNumber(lo_off)) target->lo_offset = lo_off->valuedouble;
+
     cJSON *sr = cJSON_GetObjectItemCaseSensitive(root, "sample_rate_hz");
     if (cJSON_IsNumber(sr)) target->sample_rate = sr->valuedouble;
 
@@ -86,10 +97,431 @@ int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
     cJSON *ov = cJSON_GetObjectItemCaseSensitive(root, "overlap");
     if (cJSON_IsNumber(ov)) target->overlap = ov->valuedouble;
 
+    cJSON *fps = cJSON_GetObjectItemCaseSensitive(root, "frame_rate_hz");
+    if (cJSON_IsNumber(fps)) target->frame_rate = fps->valuedouble;
+
+    cJSON *disp = cJSON_GetObjectItemCaseSensitive(root, "display_bins");
+    if (cJSON_IsNumber(disp)) target->display_bins = (int)disp->valuedouble;
+
+    // "pyramid": true (down to 256 bins) or the smallest level size
+    cJSON *pyr = cJSON_GetObjectItemCaseSensitive(root, "pyramid");
+    if (cJSON_IsBool(pyr)) target->pyramid_min_bins = cJSON_IsTrue(pyr) ? 256 : 0;
+    else if (cJSON_IsNumber(pyr)) target->pyramid_min_bins = (int)pyr->valuedouble;
+
+    // "calibration": CSV table (psd_cal.h)
+    cJSON *cal = cJSON_GetObjectItemCaseSensitive(root, "calibration");
+    if (cJSON_IsString(cal) && cal->valuestring) target->calibration = strdup(cal->valuestring);
+
+    cJSON *zf = cJSON_GetObjectItemCaseSensitive(root, "zmq_frames");
+    if (cJSON_IsBool(zf)) target->zmq_frames = cJSON_IsTrue(zf);
+
+    // 3b. Traces: "traces": ["max", "min", "ema", "rms"] (or a single string)
+    cJSON *traces = cJSON_GetObjectItemCaseSensitive(root, "traces");
+    if (cJSON_IsString(traces)) {
+        target->trace_mask = psd_trace_mask_from_string(traces->valuestring);
+    } else if (cJSON_IsArray(traces)) {
+        cJSON *tr;
+        cJSON_ArrayForEach(tr, traces) {
+            if (cJSON_IsString(tr)) target->trace_mask |= psd_trace_mask_from_string(tr->valuestring);
+        }
+    }
+
+    cJSON *tau = cJSON_GetObjectItemCaseSensitive(root, "ema_tau_s");
+    if (cJSON_IsNumber(tau)) target->ema_tau_s = tau->valuedouble;
+
+    cJSON *tt = cJSON_GetObjectItemCaseSensitive(root, "trace_time");
+    if (cJSON_IsBool(tt)) target->trace_time = cJSON_IsTrue(tt);
+
+    // 3c. Waterfall: {"path", "rows", "row_ms", "format": "u8"|"f32", "db_min", "db_max"}
+    cJSON *wf = cJSON_GetObjectItemCaseSensitive(root, "waterfall");
+    if (cJSON_IsObject(wf)) {
+        WaterfallCfg_t *w = &target->waterfall;
+        w->rows = 600;
+        w->row_ms = 100.0;
+        w->db_min = -140.0;
+        w->db_max = -20.0;
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(wf, "path");
+        if (cJSON_IsString(it) && it->valuestring) w->path = strdup(it->valuestring);
+        it = cJSON_GetObjectItemCaseSensitive(wf, "rows");
+        if (cJSON_IsNumber(it)) w->rows = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(wf, "row_ms");
+        if (cJSON_IsNumber(it)) w->row_ms = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(wf, "format");
+        if (cJSON_IsString(it)) w->quantize_u8 = (strcasecmp(it->valuestring, "u8") == 0);
+        it = cJSON_GetObjectItemCaseSensitive(wf, "db_min");
+        if (cJSON_IsNumber(it)) w->db_min = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(wf, "db_max");
+        if (cJSON_IsNumber(it)) w->db_max = it->valuedouble;
+    }
+
+    // 3e. Persistence: {"path", "levels", "cols", "db_min", "db_max", "decay_s", "publish_ms"}
+    cJSON *px = cJSON_GetObjectItemCaseSensitive(root, "persistence");
+    if (cJSON_IsObject(px)) {
+        PersistenceCfg_t *p = &target->persistence;
+        p->db_min = -140.0;
+        p->db_max = -20.0;
+        p->decay_s = 1.0;
+        p->publish_ms = 100.0;
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(px, "path");
+        if (cJSON_IsString(it) && it->valuestring) p->path = strdup(it->valuestring);
+        it = cJSON_GetObjectItemCaseSensitive(px, "levels");
+        if (cJSON_IsNumber(it)) p->levels = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(px, "cols");
+        if (cJSON_IsNumber(it)) p->max_cols = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(px, "db_min");
+        if (cJSON_IsNumber(it)) p->db_min = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(px, "db_max");
+        if (cJSON_IsNumber(it)) p->db_max = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(px, "decay_s");
+        if (cJSON_IsNumber(it)) p->decay_s = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(px, "publish_ms");
+        if (cJSON_IsNumber(it)) p->publish_ms = it->valuedouble;
+    }
+
+    // 3f. Detector: {"res_db", "percentile", "delta_db", "gap_bins", "min_bins"} (presence enables)
+    cJSON *det = cJSON_GetObjectItemCaseSensitive(root, "detect");
+    if (cJSON_IsObject(det)) {
+        DetectCfg_t *dc = &target->detect;
+        dc->enabled = true;
+        dc->gap_bins = 1;
+        dc->min_bins = 1;
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(det, "res_db");
+        if (cJSON_IsNumber(it)) dc->res_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(det, "percentile");
+        if (cJSON_IsNumber(it)) dc->percentile = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(det, "delta_db");
+        if (cJSON_IsNumber(it)) dc->delta_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(det, "gap_bins");
+        if (cJSON_IsNumber(it)) dc->gap_bins = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(det, "min_bins");
+        if (cJSON_IsNumber(it)) dc->min_bins = (int)it->valuedouble;
+    }
+
+    // 3g. Bursts: {"chan_hz", "on_db", "off_db", "min_on_ms", "hang_ms", "noise_tau_s"} (presence enables)
+    cJSON *bu = cJSON_GetObjectItemCaseSensitive(root, "burst");
+    if (cJSON_IsObject(bu)) {
+        BurstCfg_t *bc = &target->burst;
+        bc->enabled = true;
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(bu, "chan_hz");
+        if (cJSON_IsNumber(it)) bc->chan_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(bu, "on_db");
+        if (cJSON_IsNumber(it)) bc->on_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(bu, "off_db");
+        if (cJSON_IsNumber(it)) bc->off_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(bu, "min_on_ms");
+        if (cJSON_IsNumber(it)) bc->min_on_ms = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(bu, "hang_ms");
+        if (cJSON_IsNumber(it)) bc->hang_ms = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(bu, "noise_tau_s");
+        if (cJSON_IsNumber(it)) bc->noise_tau_s = it->valuedouble;
+    }
+
+    // 3h. Mask: {"points": [[f_hz, level_db], ...], "relative", "carrier_hz", "report_ms"}
+    cJSON *mk = cJSON_GetObjectItemCaseSensitive(root, "mask");
+    if (cJSON_IsObject(mk)) {
+        MaskCfg_t *m = &target->mask;
+        cJSON *pts = cJSON_GetObjectItemCaseSensitive(mk, "points");
+        cJSON *pt = NULL;
+        cJSON_ArrayForEach(pt, pts) {
+            if (m->n_points >= PSD_MASK_MAX_POINTS) break;
+            if (cJSON_GetArraySize(pt) != 2) continue;
+            cJSON *f = cJSON_GetArrayItem(pt, 0);
+            cJSON *l = cJSON_GetArrayItem(pt, 1);
+            if (!cJSON_IsNumber(f) || !cJSON_IsNumber(l)) continue;
+            m->f_hz[m->n_points] = f->valuedouble;
+            m->level_db[m->n_points] = l->valuedouble;
+            m->n_points++;
+        }
+        m->valid = (m->n_points >= 2);
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(mk, "relative");
+        if (cJSON_IsBool(it)) m->relative = cJSON_IsTrue(it);
+        it = cJSON_GetObjectItemCaseSensitive(mk, "carrier_hz");
+        if (cJSON_IsNumber(it)) m->carrier_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(mk, "report_ms");
+        if (cJSON_IsNumber(it)) m->report_ms = it->valuedouble;
+    }
+
+    // 3i. Measurements: {"obw_pct", "channels": [{"f", "bw", "adj", "adj_bw"}, ...],
+    //                    "plan": {"start_hz", "step_hz", "count", "bw_hz", "adj_hz"}}
+    cJSON *ms = cJSON_GetObjectItemCaseSensitive(root, "measure");
+    if (cJSON_IsObject(ms)) {
+        MeasCfg_t *mc = &target->measure;
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(ms, "obw_pct");
+        if (cJSON_IsNumber(it)) mc->obw_pct = it->valuedouble;
+
+        cJSON *chans = cJSON_GetObjectItemCaseSensitive(ms, "channels");
+        cJSON *plan = cJSON_GetObjectItemCaseSensitive(ms, "plan");
+        int n_list = cJSON_IsArray(chans) ? cJSON_GetArraySize(chans) : 0;
+        int n_plan = 0;
+        double p_start = 0, p_step = 0, p_bw = 0, p_adj = 0;
+        if (cJSON_IsObject(plan)) {
+            it = cJSON_GetObjectItemCaseSensitive(plan, "start_hz");
+            if (cJSON_IsNumber(it)) p_start = it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(plan, "step_hz");
+            if (cJSON_IsNumber(it)) p_step = it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(plan, "count");
+            if (cJSON_IsNumber(it)) n_plan = (int)it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(plan, "bw_hz");
+            if (cJSON_IsNumber(it)) p_bw = it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(plan, "adj_hz");
+            if (cJSON_IsNumber(it)) p_adj = it->valuedouble;
+            if (n_plan < 0 || p_bw <= 0) n_plan = 0;
+        }
+
+        if (n_list + n_plan > 0) {
+            mc->channels = (MeasChannel_t*)calloc((size_t)(n_list + n_plan), sizeof(MeasChannel_t));
+        }
+        if (mc->channels) {
+            cJSON *ch = NULL;
+            cJSON_ArrayForEach(ch, chans) {
+                cJSON *f = cJSON_GetObjectItemCaseSensitive(ch, "f");
+                cJSON *bw = cJSON_GetObjectItemCaseSensitive(ch, "bw");
+                if (!cJSON_IsNumber(f) || !cJSON_IsNumber(bw) || bw->valuedouble <= 0) continue;
+                MeasChannel_t *c = &mc->channels[mc->n_channels++];
+                c->center_hz = f->valuedouble;
+                c->bw_hz = bw->valuedouble;
+                it = cJSON_GetObjectItemCaseSensitive(ch, "adj");
+                if (cJSON_IsNumber(it)) c->adj_offset_hz = it->valuedouble;
+                it = cJSON_GetObjectItemCaseSensitive(ch, "adj_bw");
+                if (cJSON_IsNumber(it)) c->adj_bw_hz = it->valuedouble;
+            }
+            for (int k = 0; k < n_plan; k++) {
+                MeasChannel_t *c = &mc->channels[mc->n_channels++];
+                c->center_hz = p_start + k * p_step;
+                c->bw_hz = p_bw;
+                c->adj_offset_hz = p_adj;
+            }
+        }
+    }
+
+    // 3j. Tone tracker: {"freqs": [hz, ...], "rbw_hz", "rate_hz", "publish_ms"}
+    cJSON *tn = cJSON_GetObjectItemCaseSensitive(root, "tones");
+    if (cJSON_IsObject(tn)) {
+        ToneCfg_t *tc = &target->tones;
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(tn, "freqs");
+        tc->n_tones = 0;
+        if (cJSON_IsArray(it)) {
+            cJSON *f = NULL;
+            cJSON_ArrayForEach(f, it) {
+                if (tc->n_tones >= TONE_TRACK_MAX) break;
+                if (cJSON_IsNumber(f)) tc->freq_hz[tc->n_tones++] = f->valuedouble;
+            }
+        }
+        it = cJSON_GetObjectItemCaseSensitive(tn, "rbw_hz");
+        if (cJSON_IsNumber(it)) tc->rbw_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(tn, "rate_hz");
+        if (cJSON_IsNumber(it)) tc->rate_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(tn, "publish_ms");
+        if (cJSON_IsNumber(it)) tc->publish_ms = it->valuedouble;
+    }
+
+    // 3d. Frame cache: {"seconds", "max_mb"}; queries: {"window_s", "age_s", "mode"}
+    cJSON *fc = cJSON_GetObjectItemCaseSensitive(root, "frame_cache");
+    if (cJSON_IsObject(fc)) {
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(fc, "seconds");
+        if (cJSON_IsNumber(it)) target->frame_cache.seconds = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(fc, "max_mb");
+        if (cJSON_IsNumber(it)) target->frame_cache.max_mb = (int)it->valuedouble;
+    }
+
+    cJSON *cq = cJSON_GetObjectItemCaseSensitive(root, "cache_query");
+    if (cJSON_IsObject(cq)) {
+        CacheQueryCfg_t *q = &target->cache_query;
+        q->valid = true;
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(cq, "window_s");
+        if (cJSON_IsNumber(it)) q->window_s = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(cq, "age_s");
+        if (cJSON_IsNumber(it)) q->age_s = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(cq, "mode");
+        if (cJSON_IsString(it)) {
+            if (strcasecmp(it->valuestring, "max") == 0) q->mode = 1;
+            else if (strcasecmp(it->valuestring, "min") == 0) q->mode = 2;
+        }
+    }
+
+    // 3l. Archive: {"dir", "quantize", "db_min", "db_max", "segment_mb", "segment_s", "keep", "queue"}
+    cJSON *ar = cJSON_GetObjectItemCaseSensitive(root, "archive");
+    if (cJSON_IsObject(ar)) {
+        ArchiveCfg_t *a = &target->archive;
+        a->db_min = -140.0;
+        a->db_max = -20.0;
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(ar, "dir");
+        if (cJSON_IsString(it) && it->valuestring) a->dir = strdup(it->valuestring);
+        it = cJSON_GetObjectItemCaseSensitive(ar, "quantize");
+        if (cJSON_IsBool(it)) a->quantize_u8 = cJSON_IsTrue(it);
+        it = cJSON_GetObjectItemCaseSensitive(ar, "db_min");
+        if (cJSON_IsNumber(it)) a->db_min = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(ar, "db_max");
+        if (cJSON_IsNumber(it)) a->db_max = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(ar, "segment_mb");
+        if (cJSON_IsNumber(it)) a->segment_mb = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(ar, "segment_s");
+        if (cJSON_IsNumber(it)) a->segment_s = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(ar, "keep");
+        if (cJSON_IsNumber(it)) a->keep_segments = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(ar, "queue");
+        if (cJSON_IsNumber(it)) a->queue_rows = (int)it->valuedouble;
+    }
+
+    // 3m. Stream: {"port", "bind", "bins", "db_min", "db_max", "deadband", "compress", "clients"}
+    cJSON *sm = cJSON_GetObjectItemCaseSensitive(root, "stream");
+    if (cJSON_IsObject(sm)) {
+        StreamCfg_t *c = &target->stream;
+        c->deadband = 1;
+        c->compress = true;
+
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(sm, "port");
+        if (cJSON_IsNumber(it)) c->port = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sm, "bind");
+        if (cJSON_IsString(it) && it->valuestring) c->bind = strdup(it->valuestring);
+        it = cJSON_GetObjectItemCaseSensitive(sm, "bins");
+        if (cJSON_IsNumber(it)) c->bins = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sm, "db_min");
+        if (cJSON_IsNumber(it)) c->db_min = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sm, "db_max");
+        if (cJSON_IsNumber(it)) c->db_max = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sm, "deadband");
+        if (cJSON_IsNumber(it)) c->deadband = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sm, "compress");
+        if (cJSON_IsBool(it)) c->compress = cJSON_IsTrue(it);
+        it = cJSON_GetObjectItemCaseSensitive(sm, "clients");
+        if (cJSON_IsNumber(it)) c->max_clients = (int)it->valuedouble;
+    }
+
+    // 3n. Sweep (CAMPAIGN_MODE): {"f_start", "f_stop", "dwell_ms", "usable", "overlap", "settle_us", "dc_notch_hz", "passes"}
+    cJSON *sw = cJSON_GetObjectItemCaseSensitive(root, "sweep");
+    if (cJSON_IsObject(sw)) {
+        SweepCfg_t *c = &target->sweep;
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(sw, "f_start");
+        if (cJSON_IsNumber(it)) c->f_start_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "f_stop");
+        if (cJSON_IsNumber(it)) c->f_stop_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "dwell_ms");
+        if (cJSON_IsNumber(it)) c->dwell_ms = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "usable");
+        if (cJSON_IsNumber(it)) c->usable = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "overlap");
+        if (cJSON_IsNumber(it)) c->overlap = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "settle_us");
+        if (cJSON_IsNumber(it)) c->settle_us = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "dc_notch_hz");
+        if (cJSON_IsNumber(it)) c->dc_notch_hz = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(sw, "passes");
+        if (cJSON_IsNumber(it)) c->passes = (int)it->valuedouble;
+    }
+
+    // 3o. Jobs (CAMPAIGN_MODE): [{"id", "center_freq_hz", "span", "rbw_hz", "duration_s", "window",
+    //                           "sample_rate_hz", "lna_gain", "vga_gain", "antenna_amp"}, ...]
+    cJSON *jobs = cJSON_GetObjectItemCaseSensitive(root, "jobs");
+    int n_jobs = cJSON_IsArray(jobs) ? cJSON_GetArraySize(jobs) : 0;
+    if (n_jobs > 0) target->jobs = (JobCfg_t*)calloc((size_t)n_jobs, sizeof(JobCfg_t));
+    if (target->jobs) {
+        cJSON *jb = NULL;
+        cJSON_ArrayForEach(jb, jobs) {
+            cJSON *f = cJSON_GetObjectItemCaseSensitive(jb, "center_freq_hz");
+            if (!cJSON_IsNumber(f) || f->valuedouble <= 0) continue;
+            JobCfg_t *j = &target->jobs[target->n_jobs++];
+            j->center_hz = f->valuedouble;
+            j->window = -1;
+            j->lna_gain = -1;
+            j->vga_gain = -1;
+            j->amp = -1;
+            cJSON *it = cJSON_GetObjectItemCaseSensitive(jb, "id");
+            if (cJSON_IsString(it) && it->valuestring) snprintf(j->id, sizeof(j->id), "%s", it->valuestring);
+            it = cJSON_GetObjectItemCaseSensitive(jb, "span");
+            if (cJSON_IsNumber(it)) j->span = it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(jb, "rbw_hz");
+            if (cJSON_IsNumber(it)) j->rbw = (int)it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(jb, "duration_s");
+            if (cJSON_IsNumber(it)) j->duration_s = it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(jb, "window");
+            if (cJSON_IsString(it)) j->window = (int)get_window_type_from_string(it->valuestring);
+            it = cJSON_GetObjectItemCaseSensitive(jb, "sample_rate_hz");
+            if (cJSON_IsNumber(it)) j->sample_rate = it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(jb, "lna_gain");
+            if (cJSON_IsNumber(it)) j->lna_gain = (int)it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(jb, "vga_gain");
+            if (cJSON_IsNumber(it)) j->vga_gain = (int)it->valuedouble;
+            it = cJSON_GetObjectItemCaseSensitive(jb, "antenna_amp");
+            if (cJSON_IsBool(it)) j->amp = cJSON_IsTrue(it) ? 1 : 0;
+        }
+    }
+
+    // 3k. Occupancy: {"res_db", "db_min", "db_max", "cols", "threshold_db", "path", "save_s"}
+    cJSON *oc = cJSON_GetObjectItemCaseSensitive(root, "occupancy");
+    if (cJSON_IsObject(oc)) {
+        OccupancyCfg_t *o = &target->occupancy;
+        o->enabled = true;
+        o->threshold_db = NAN;
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(oc, "enabled");
+        if (cJSON_IsBool(it)) o->enabled = cJSON_IsTrue(it);
+        it = cJSON_GetObjectItemCaseSensitive(oc, "res_db");
+        if (cJSON_IsNumber(it)) o->res_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(oc, "db_min");
+        if (cJSON_IsNumber(it)) o->db_min = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(oc, "db_max");
+        if (cJSON_IsNumber(it)) o->db_max = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(oc, "cols");
+        if (cJSON_IsNumber(it)) o->max_cols = (int)it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(oc, "threshold_db");
+        if (cJSON_IsNumber(it)) o->threshold_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(oc, "path");
+        if (cJSON_IsString(it) && it->valuestring) o->path = strdup(it->valuestring);
+        it = cJSON_GetObjectItemCaseSensitive(oc, "save_s");
+        if (cJSON_IsNumber(it)) o->save_s = it->valuedouble;
+    }
+
+    cJSON *oq = cJSON_GetObjectItemCaseSensitive(root, "occ_query");
+    if (cJSON_IsObject(oq)) {
+        OccQueryCfg_t *q = &target->occ_query;
+        q->valid = true;
+        q->threshold_db = NAN;
+        cJSON *it = cJSON_GetObjectItemCaseSensitive(oq, "quantiles");
+        cJSON *e = NULL;
+        cJSON_ArrayForEach(e, it) {
+            if (q->n_q < OCC_QUERY_MAX_Q && cJSON_IsNumber(e)) q->q_pct[q->n_q++] = e->valuedouble;
+        }
+        it = cJSON_GetObjectItemCaseSensitive(oq, "threshold_db");
+        if (cJSON_IsNumber(it)) q->threshold_db = it->valuedouble;
+        it = cJSON_GetObjectItemCaseSensitive(oq, "merge");
+        if (cJSON_IsString(it) && it->valuestring) {
+            q->merge[q->n_merge++] = strdup(it->valuestring);
+        } else {
+            cJSON_ArrayForEach(e, it) {
+                if (q->n_merge < OCC_QUERY_MAX_MERGE && cJSON_IsString(e) && e->valuestring) {
+                    q->merge[q->n_merge++] = strdup(e->valuestring);
+                }
+            }
+        }
+        it = cJSON_GetObjectItemCaseSensitive(oq, "save");
+        if (cJSON_IsString(it) && it->valuestring) q->save = strdup(it->valuestring);
+        it = cJSON_GetObjectItemCaseSensitive(oq, "reset");
+        if (cJSON_IsBool(it)) q->reset = cJSON_IsTrue(it);
+    }
+
     // 3. Window
     cJSON *win = cJSON_GetObjectItemCaseSensitive(root, "window");
     if (cJSON_IsString(win)) target->window_type = get_window_type_from_string(win->valuestring);
 
+    cJSON *wparam = cJSON_GetObjectItemCaseSensitive(root, "window_param");
+    if (cJSON_IsNumber(wparam)) target->window_param = wparam->valuedouble;
+
+    // 3d. Estimator: "welch" (default) | "multitaper" (+ "mt_nw", "mt_tapers")
+    cJSON *est = cJSON_GetObjectItemCaseSensitive(root, "estimator");
+    if (cJSON_IsString(est) && strcasecmp(est->valuestring, "multitaper") == 0) {
+        target->estimator = PSD_ESTIMATOR_MULTITAPER;
+    }
+    cJSON *nw = cJSON_GetObjectItemCaseSensitive(root, "mt_nw");
+    if (cJSON_IsNumber(nw)) target->mt_nw = nw->valuedouble;
+    cJSON *ntap = cJSON_GetObjectItemCaseSensitive(root, "mt_tapers");
+    if (cJSON_IsNumber(ntap)) target->mt_k = (int)ntap->valuedouble;
+
     // 4. Scale
     cJSON *sc = cJSON_GetObjectItemCaseSensitive(root, "scale");
     if (cJSON_IsString(sc) && (sc->valuestring != NULL)) target->scale = strdup(sc->valuestring);
@@ -113,17 +545,55 @@ int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
 }
 
 int find_params_psd(DesiredCfg_t desired, SDR_cfg_t *hack_cfg, PsdConfig_t *psd_cfg, RB_cfg_t *rb_cfg) {
-    double enbw_factor = get_window_enbw_factor(desired.window_type);
-    double required_nperseg_val = enbw_factor * (double)desired.sample_rate / (double)desired.rbw;
-    int exponent = (int)ceil(log2(required_nperseg_val));
-    
-    psd_cfg->nperseg = (int)pow(2, exponent);
+    if (desired.rbw <= 0) {
+        fprintf(stderr, "[PSD] invalid rbw_hz %d (must be >= 1 Hz)\n", desired.rbw);
+        return -1;
+    }
+
+    // Zoom: the FFT only has to cover ~2.5x the span, so RBW sets nperseg at fs/D
+    int decim = 1;
+    if (desired.zoom && desired.span > 0) {
+        decim = (int)floor(desired.sample_rate / (PSD_ZOOM_OVERSAMPLE * desired.span));
+        if (decim > PSD_ZOOM_MAX_DECIM) decim = PSD_ZOOM_MAX_DECIM;
+        if (decim < 2) decim = 1;
+    }
+    double fs_psd = desired.sample_rate / decim;
+
+    // Smallest 2^a*3^b*5^c transform that meets the RBW (not the next power of two).
+    // ENBW is estimated at the reference length, then checked at the chosen one.
+    // Multitaper: resolution is the full bandwidth 2W = 2*NW*fs/N.
+    int nperseg;
+    if (desired.estimator == PSD_ESTIMATOR_MULTITAPER) {
+        double nw_mt = desired.mt_nw > 0 ? desired.mt_nw : PSD_DPSS_DEFAULT_NW;
+        nperseg = psd_smooth_size(2.0 * nw_mt * fs_psd / (double)desired.rbw);
+    } else {
+        double enbw_factor = psd_window_enbw(desired.window_type, 0, desired.window_param);
+        nperseg = psd_smooth_size(enbw_factor * fs_psd / (double)desired.rbw);
+        for (int it = 0; it < 4 && nperseg > 0; it++) {
+            double enbw_n = psd_window_enbw(desired.window_type, nperseg, desired.window_param);
+            if (enbw_n * fs_psd / nperseg <= (double)desired.rbw) break;
+            nperseg = psd_smooth_size(enbw_n * fs_psd / (double)desired.rbw + 1.0);
+        }
+    }
+    if (nperseg < 0) {
+        fprintf(stderr, "[PSD] rbw_hz %d at %.0f S/s needs more than %d FFT bins\n",
+                desired.rbw, fs_psd, PSD_FFT_MAX_SIZE);
+        return -1;
+    }
+
+    psd_cfg->nperseg = nperseg;
     psd_cfg->noverlap = psd_cfg->nperseg * desired.overlap;
     psd_cfg->window_type = desired.window_type;
+    psd_cfg->window_param = desired.window_param;
+    psd_cfg->estimator = desired.estimator;
+    psd_cfg->mt_nw = desired.mt_nw;
+    psd_cfg->mt_k = desired.mt_k;
     psd_cfg->sample_rate = desired.sample_rate;
+    psd_cfg->zoom_decim = decim;
+    psd_cfg->zoom_shift_hz = desired.lo_offset;
 
     hack_cfg->sample_rate = desired.sample_rate;
-    hack_cfg->center_freq = desired.center_freq;
+    hack_cfg->center_freq = (uint64_t)((double)desired.center_freq - desired.lo_offset);
     hack_cfg->amp_enabled = desired.amp_enabled;
     hack_cfg->lna_gain = desired.lna_gain;
     hack_cfg->vga_gain = desired.vga_gain;
@@ -131,6 +601,12 @@ int find_params_psd(DesiredCfg_t desired, SDR_cfg_t *hack_cfg, PsdConfig_t *psd_
 
     // Default to ~1 second of data if not specified
     rb_cfg->total_bytes = (size_t)(desired.sample_rate * 2);
+
+    // A zoomed (or multitaper) capture must still hold one full segment at the input rate
+    if (decim > 1 || desired.estimator == PSD_ESTIMATOR_MULTITAPER) {
+        size_t seg_bytes = ((size_t)psd_cfg->nperseg + PSD_ZOOM_CIC_ORDER) * (size_t)decim * 2;
+        if (rb_cfg->total_bytes < seg_bytes) rb_cfg->total_bytes = seg_bytes;
+    }
     return 0;
 }
 
@@ -146,10 +622,127 @@ void print_config_summary(DesiredCfg_t *des, SDR_cfg_t *hw, PsdConfig_t *psd, RB
     printf("Buffer Req  : %zu bytes (~%.4f sec)\n", rb->total_bytes, capture_duration);
 
     printf("\n--- PSD PROCESS (DSP) ---\n");
-    printf("Window      : %d (Enum)\n", psd->window_type);
-    printf("FFT Size    : %d bins\n", psd->nperseg);
+    const psd_window_t *win = NULL;
+    if (psd->estimator == PSD_ESTIMATOR_MULTITAPER) {
+        double nw_mt = psd->mt_nw > 0 ? psd->mt_nw : PSD_DPSS_DEFAULT_NW;
+        int k_mt = psd->mt_k > 0 ? psd->mt_k : (int)(2.0 * nw_mt) - 1;
+        printf("Estimator   : multitaper NW=%.2f K=%d (adaptive)\n", nw_mt, k_mt);
+        printf("RBW         : %.3f Hz (2W)\n",
+               2.0 * nw_mt * psd->sample_rate / (psd->zoom_decim > 1 ? psd->zoom_decim : 1) / psd->nperseg);
+    } else {
+        win = psd_window_get(psd->window_type, psd->nperseg, psd->window_param);
+    }
+    if (win) {
+        printf("Window      : %s (param %.3g) ENBW %.4f bins, CG %.4f\n",
+               psd_window_name(win->type), win->param, win->enbw, win->cg);
+        printf("RBW         : %.3f Hz\n",
+               win->enbw * psd->sample_rate / (psd->zoom_decim > 1 ? psd->zoom_decim : 1) / psd->nperseg);
+        psd_window_release(win);
+    }
+    printf("FFT Size    : %d bins%s\n", psd->nperseg,
+           psd->nperseg >= PSD_LARGE_FFT ? " (large: threaded FFTW)" : "");
     printf("Overlap     : %d bins\n", psd->noverlap);
+    if (psd->zoom_decim > 1) {
+        printf("Zoom        : D=%d (CIC%d) -> %.3f kS/s, bin %.2f Hz\n",
+               psd->zoom_decim, PSD_ZOOM_CIC_ORDER,
+               psd->sample_rate / psd->zoom_decim / 1e3,
+               psd->sample_rate / psd->zoom_decim / psd->nperseg);
+    }
+    if (des->lo_offset != 0.0) {
+        printf("LO Offset   : %.0f Hz (NCO back to span center)\n", des->lo_offset);
+    }
     printf("Scale Unit  : %s\n", des->scale ? des->scale : "dBm (Default)");
+    if (des->trace_mask) {
+        printf("Traces      :%s%s%s%s%s\n",
+               (des->trace_mask & PSD_TRACE_MAX) ? " max" : "",
+               (des->trace_mask & PSD_TRACE_MIN) ? " min" : "",
+               (des->trace_mask & PSD_TRACE_EMA) ? " ema" : "",
+               (des->trace_mask & PSD_TRACE_RMS) ? " rms" : "",
+               des->trace_time ? " (+time)" : "");
+    }
+    if (des->waterfall.path) {
+        printf("Waterfall   : %s (%d rows, %.0f ms/row, %s)\n", des->waterfall.path,
+               des->waterfall.rows, des->waterfall.row_ms,
+               des->waterfall.quantize_u8 ? "u8" : "f32");
+    }
+    if (des->persistence.path) {
+        printf("Persistence : %s (%d levels, %.0f..%.0f dB, decay %.2f s)\n", des->persistence.path,
+               des->persistence.levels > 0 ? des->persistence.levels : PSD_PX_DEFAULT_LEVELS,
+               des->persistence.db_min, des->persistence.db_max, des->persistence.decay_s);
+    }
+    if (des->detect.enabled) {
+        printf("Detector    : NF p%.0f + %.1f dB, gap %d bins (ZMQ \"%s\")\n",
+               des->detect.percentile > 0 ? des->detect.percentile : 50.0,
+               des->detect.delta_db > 0 ? des->detect.delta_db : 15.0,
+               des->detect.gap_bins, PSD_DETECT_TOPIC);
+    }
+    if (des->burst.enabled) {
+        printf("Bursts      : on %.1f dB, min %.1f ms, hang %.1f ms (ZMQ \"%s\")\n",
+               des->burst.on_db > 0 ? des->burst.on_db : 10.0,
+               des->burst.min_on_ms, des->burst.hang_ms, PSD_BURST_TOPIC);
+    }
+    if (des->mask.valid) {
+        printf("Mask        : %d points (%s), report every %.0f ms (ZMQ \"%s\")\n",
+               des->mask.n_points, des->mask.relative ? "relative to carrier" : "absolute",
+               des->mask.report_ms > 0 ? des->mask.report_ms : 1000.0, PSD_MASK_TOPIC);
+    }
+    if (des->measure.n_channels > 0) {
+        printf("Measure     : %d channels (power, %.1f%% OBW, ACPR)\n", des->measure.n_channels,
+               des->measure.obw_pct > 0 ? des->measure.obw_pct : 99.0);
+    }
+    if (des->archive.dir) {
+        printf("Archive     : %s (%s, segments %.0f MB / %.0f s, keep %d)\n", des->archive.dir,
+               des->archive.quantize_u8 ? "u8" : "f32",
+               des->archive.segment_mb > 0 ? des->archive.segment_mb : 256.0,
+               des->archive.segment_s > 0 ? des->archive.segment_s : 3600.0, des->archive.keep_segments);
+    }
+    if (des->stream.port > 0) {
+        printf("Stream      : tcp %s:%d, %d bins, deadband %d%s\n",
+               des->stream.bind ? des->stream.bind : "127.0.0.1", des->stream.port,
+               des->stream.bins > 0 ? des->stream.bins : 2048, des->stream.deadband,
+               des->stream.compress ? ", zlib" : "");
+    }
+    if (des->rf_mode == CAMPAIGN_MODE && des->n_jobs > 0) {
+        printf("Jobs        : %d queued (scheduled by rate / gain / frequency)\n", des->n_jobs);
+    } else if (des->rf_mode == CAMPAIGN_MODE) {
+        const SweepCfg_t *s = &des->sweep;
+        double f0 = (s->f_start_hz > 0 || s->f_stop_hz > 0) ? s->f_start_hz : (double)des->center_freq - des->span / 2.0;
+        double f1 = (s->f_start_hz > 0 || s->f_stop_hz > 0) ? s->f_stop_hz : (double)des->center_freq + des->span / 2.0;
+        printf("Sweep       : %.3f .. %.3f MHz, usable %.0f%%, overlap %.0f%%, passes %d%s\n",
+               f0 / 1e6, f1 / 1e6, 100.0 * (s->usable > 0 ? s->usable : 0.75),
+               100.0 * (s->overlap > 0 ? s->overlap : 0.25), s->passes,
+               s->passes > 0 ? "" : " (continuous)");
+    }
+    if (des->occupancy.enabled) {
+        printf("Occupancy   : %.2f dB buckets, %s\n",
+               des->occupancy.res_db > 0 ? des->occupancy.res_db : 0.5,
+               des->occupancy.path ? des->occupancy.path : "memory only");
+    }
+    if (des->tones.n_tones > 0) {
+        printf("Tones       : %d tracked, rbw %.0f Hz, %.0f pts/s\n", des->tones.n_tones,
+               des->tones.rbw_hz > 0 ? des->tones.rbw_hz : 1000.0,
+               des->tones.rate_hz > 0 ? des->tones.rate_hz : 1000.0);
+    }
+    if (des->display_bins > 0) {
+        printf("Display     : max-pool to %d bins\n", des->display_bins);
+    }
+    if (des->calibration) {
+        printf("Calibration : %s\n", des->calibration);
+    }
+    if (des->zmq_frames) {
+        printf("ZMQ Frames  : binary float32 traces on \"psd_frame\"\n");
+    }
+    if (des->pyramid_min_bins > 0) {
+        printf("Pyramid     : max/mean levels down to %d bins\n", des->pyramid_min_bins);
+    }
+    if (des->frame_cache.seconds > 0) {
+        printf("Frame Cache : %.1f s (max %d MB)\n", des->frame_cache.seconds,
+               des->frame_cache.max_mb > 0 ? des->frame_cache.max_mb : PSD_FCACHE_DEFAULT_MB);
+    }
+    if (des->rf_mode == RTSA_MODE) {
+        printf("RTSA Rate   : %.1f traces/s (gapless)\n",
+               des->frame_rate > 0 ? des->frame_rate : PSD_RTSA_DEFAULT_FPS);
+    }
     printf("===========================================================\n\n");
 }
 
@@ -159,6 +752,47 @@ void free_desired_psd(DesiredCfg_t *target) {
             free(target->scale);
             target->scale = NULL;
         }
+        if (target->waterfall.path) {
+            free(target->waterfall.path);
+            target->waterfall.path = NULL;
+        }
+        if (target->persistence.path) {
+            free(target->persistence.path);
+            target->persistence.path = NULL;
+        }
+        if (target->measure.channels) {
+            free(target->measure.channels);
+            target->measure.channels = NULL;
+            target->measure.n_channels = 0;
+        }
+        if (target->jobs) {
+            free(target->jobs);
+            target->jobs = NULL;
+            target->n_jobs = 0;
+        }
+        if (target->archive.dir) {
+            free(target->archive.dir);
+            target->archive.dir = NULL;
+        }
+        if (target->calibration) {
+            free(target->calibration);
+            target->calibration = NULL;
+        }
+        if (target->stream.bind) {
+            free(target->stream.bind);
+            target->stream.bind = NULL;
+        }
+        if (target->occupancy.path) {
+            free(target->occupancy.path);
+            target->occupancy.path = NULL;
+        }
+        for (int i = 0; i < target->occ_query.n_merge; i++) {
+            free(target->occ_query.merge[i]);
+            target->occ_query.merge[i] = NULL;
+        }
+        target->occ_query.n_merge = 0;
+        free(target->occ_query.save);
+        target->occ_query.save = NULL;
         // If rf_mode was allocated dynamically, free it here. 
         // In current struct it looks like an enum, but check if struct changed.
     }
@@ -169,6 +803,11 @@ void free_desired_psd(DesiredCfg_t *target) {
 // =========================================================
 
 int scale_psd(double* psd, int nperseg, const char* scale_str) {
+    return scale_psd_corrected(psd, nperseg, scale_str, NULL);
+}
+
+/* scale_psd + a per-bin calibration (dB, NULL = none) inside the same conversion pass */
+int scale_psd_corrected(double* psd, int nperseg, const char* scale_str, const double* corr_db) {
     if (!psd) return -1;
     
     const double Z = 50.0; 
@@ -182,113 +821,741 @@ int scale_psd(double* psd, int nperseg, const char* scale_str) {
         else if (strcmp(scale_str, "V") == 0)    unit = UNIT_VOLTS;
     }
 
-    for (int i = 0; i < nperseg; i++) {
-        double p_watts = psd[i] / Z;
-        if (p_watts < 1.0e-20) p_watts = 1.0e-20; 
-
-        double val_dbm = 10.0 * log10(p_watts * 1000.0);
+    if (unit == UNIT_WATTS || unit == UNIT_VOLTS) {
+        for (int i = 0; i < nperseg; i++) {
+            double p_watts = psd[i] / Z;
+            if (p_watts < 1.0e-20) p_watts = 1.0e-20;
+            if (corr_db) p_watts *= pow(10.0, corr_db[i] / 10.0);
+            psd[i] = (unit == UNIT_WATTS) ? p_watts : sqrt(p_watts * Z);
+        }
+        return 0;
+    }
 
-        switch (unit) {
-            case UNIT_DBUV: psd[i] = val_dbm + 107.0; break;
-            case UNIT_DBMV: psd[i] = val_dbm + 47.0; break;
-            case UNIT_WATTS: psd[i] = p_watts; break;
-            case UNIT_VOLTS: psd[i] = sqrt(p_watts * Z); break;
-            case UNIT_DBM:
-            default: psd[i] = val_dbm; break;
+    // dB scales: one branch-free loop, the unit is just an offset
+    const double off = (unit == UNIT_DBUV) ? 107.0 : (unit == UNIT_DBMV) ? 47.0 : 0.0;
+    if (corr_db) {
+        #pragma omp simd
+        for (int i = 0; i < nperseg; i++) {
+            double p_watts = fmax(psd[i] / Z, 1.0e-20);
+            psd[i] = 10.0 * log10(p_watts * 1000.0) + off + corr_db[i];
+        }
+    } else {
+        #pragma omp simd
+        for (int i = 0; i < nperseg; i++) {
+            double p_watts = fmax(psd[i] / Z, 1.0e-20);
+            psd[i] = 10.0 * log10(p_watts * 1000.0) + off;
         }
     }
     return 0;
 }
 
+/* Exact ENBW (bins) of the cached window at the reference length */
 double get_window_enbw_factor(PsdWindowType_t type) {
-    switch (type) {
-        case RECTANGULAR_TYPE: return 1.000;
-        case HAMMING_TYPE:     return 1.363;
-        case HANN_TYPE:        return 1.500;
-        case BLACKMAN_TYPE:    return 1.730;
-        default:               return 1.0;
+    return psd_window_enbw(type, 0, 0.0);
+}
+
+// =========================================================
+// Large-FFT support
+// =========================================================
+
+#define PSD_HUGEPAGE_BYTES (2u << 20)
+#define PSD_SIMD_ALIGN     64
+
+/* Smallest even 2^a*3^b*5^c >= n_min (FFTW is fast on these; even keeps fftshift symmetric).
+   -1 if n_min is not finite or above PSD_FFT_MAX_SIZE. */
+int psd_smooth_size(double n_min) {
+    if (!isfinite(n_min) || n_min > PSD_FFT_MAX_SIZE) return -1;
+    if (n_min <= 2.0) return 2;
+    long best = 0;
+    for (long p5 = 1; p5 < 2 * n_min; p5 *= 5) {
+        for (long p35 = p5; p35 < 2 * n_min; p35 *= 3) {
+            long n = 2 * p35;
+            while (n < n_min) n *= 2;
+            if (best == 0 || n < best) best = n;
+        }
+    }
+    return (int)best;
+}
+
+/* Workspace allocation: >= 2 MiB buffers are hugepage aligned and THP-advised */
+static void *psd_alloc(size_t bytes) {
+    void *p = NULL;
+    if (bytes >= PSD_HUGEPAGE_BYTES) {
+        size_t len = (bytes + PSD_HUGEPAGE_BYTES - 1) & ~(size_t)(PSD_HUGEPAGE_BYTES - 1);
+        if (posix_memalign(&p, PSD_HUGEPAGE_BYTES, len) != 0) return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(p, len, MADV_HUGEPAGE);
+#endif
+        return p;
+    }
+    if (posix_memalign(&p, PSD_SIMD_ALIGN, bytes) != 0) return NULL;
+    return p;
+}
+
+static pthread_once_t fftw_threads_once = PTHREAD_ONCE_INIT;
+static int fftw_threads_ok;
+
+static void fftw_threads_setup(void) {
+    fftw_threads_ok = fftw_init_threads();
+}
+
+/* FFTW threads for an nfft-point plan; only large transforms are split */
+static int psd_fft_threads(int nfft) {
+    pthread_once(&fftw_threads_once, fftw_threads_setup);
+    if (!fftw_threads_ok || nfft < PSD_LARGE_FFT) return 1;
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+    return ncpu > PSD_FFT_MAX_THREADS ? PSD_FFT_MAX_THREADS : (int)ncpu;
+}
+
+// =========================================================
+// Zoom front-end (NCO + CIC)
+// =========================================================
+
+#define PSD_ZOOM_Q      16384.0   // mixer output fixed point (Q14)
+#define PSD_ZOOM_BLOCK  4096      // decimated samples per scratch pass
+#define PSD_NCO_RENORM  4096
+
+static void zoom_reset(psd_zoom_t *z) {
+    z->phase = 0;
+    z->rot = 1.0;
+    z->rot_count = 0;
+    memset(z->integ, 0, sizeof(z->integ));
+    memset(z->comb, 0, sizeof(z->comb));
+}
+
+static void zoom_init(psd_zoom_t *z, int decim, double shift_hz, double fs_in) {
+    memset(z, 0, sizeof(*z));
+    z->decim = decim;
+    z->use_nco = (shift_hz != 0.0);
+    z->rot_step = cexp(-I * 2.0 * M_PI * shift_hz / fs_in);
+    z->out_scale = 1.0 / (pow((double)decim, PSD_ZOOM_CIC_ORDER) * PSD_ZOOM_Q);
+    zoom_reset(z);
+}
+
+static inline int64_t zoom_round(double v) {
+    return (int64_t)(v >= 0.0 ? v + 0.5 : v - 0.5);
+}
+
+/* One input sample through mixer + integrators; 1 when a decimated sample is out */
+static inline int zoom_push(psd_zoom_t *z, double re, double im, double complex *y) {
+    if (z->use_nco) {
+        double complex v = (re + im * I) * z->rot;
+        re = creal(v);
+        im = cimag(v);
+        z->rot *= z->rot_step;
+        if (++z->rot_count == PSD_NCO_RENORM) {
+            z->rot /= cabs(z->rot);
+            z->rot_count = 0;
+        }
+    }
+
+    uint64_t a = (uint64_t)zoom_round(re * PSD_ZOOM_Q);
+    uint64_t b = (uint64_t)zoom_round(im * PSD_ZOOM_Q);
+    for (int k = 0; k < PSD_ZOOM_CIC_ORDER; k++) {
+        a = (z->integ[0][k] += a);
+        b = (z->integ[1][k] += b);
+    }
+
+    if (++z->phase < z->decim) return 0;
+    z->phase = 0;
+
+    for (int k = 0; k < PSD_ZOOM_CIC_ORDER; k++) {
+        uint64_t ta = a, tb = b;
+        a -= z->comb[0][k];
+        b -= z->comb[1][k];
+        z->comb[0][k] = ta;
+        z->comb[1][k] = tb;
+    }
+    *y = ((double)(int64_t)a + (double)(int64_t)b * I) * z->out_scale;
+    return 1;
+}
+
+/* |H(f)|^-2 of the CIC at the FFT bins (fftshift order) */
+static void zoom_droop_gain(double *gain, int nfft, int decim, double fs_out) {
+    double df = fs_out / nfft;
+    for (int i = 0; i < nfft; i++) {
+        double x = M_PI * (-fs_out / 2.0 + i * df) / fs_out;   // pi * f / fs_out
+        double h = 1.0;
+        if (fabs(x) > 1e-12) h = sin(x) / (decim * sin(x / decim));
+        double h2 = pow(h * h, PSD_ZOOM_CIC_ORDER);
+        gain[i] = (h2 > 1e-12) ? 1.0 / h2 : 1e12;
     }
 }
 
-static void generate_window(PsdWindowType_t window_type, double* window_buffer, int window_length) {
-    for (int n = 0; n < window_length; n++) {
-        switch (window_type) {
-            case HANN_TYPE:
-                window_buffer[n] = 0.5 * (1 - cos((2.0 * M_PI * n) / (window_length - 1)));
-                break;
-            case RECTANGULAR_TYPE:
-                window_buffer[n] = 1.0;
-                break;
-            case BLACKMAN_TYPE:
-                window_buffer[n] = 0.42 - 0.5 * cos((2.0 * M_PI * n) / (window_length - 1)) + 0.08 * cos((4.0 * M_PI * n) / (window_length - 1));
-                break;
-            case HAMMING_TYPE:
-            default:
-                window_buffer[n] = 0.54 - 0.46 * cos((2.0 * M_PI * n) / (window_length - 1));
-                break;
+// =========================================================
+// Streaming Welch engine
+// =========================================================
+
+int psd_welch_init(psd_welch_t *w, const PsdConfig_t *config) {
+    if (!w || !config || config->nperseg <= 0) return -1;
+    if (config->noverlap < 0 || config->noverlap >= config->nperseg) return -1;
+    if (config->zoom_decim > PSD_ZOOM_MAX_DECIM) return -1;
+
+    memset(w, 0, sizeof(*w));
+    w->cfg = *config;
+    w->nfft = config->nperseg;
+    w->step = config->nperseg - config->noverlap;
+
+    int decim = config->zoom_decim > 1 ? config->zoom_decim : 1;
+    w->fs = config->sample_rate / decim;
+    w->f_shift = config->zoom_shift_hz;
+
+    if (decim > 1 || config->zoom_shift_hz != 0.0) {
+        w->zoom = (psd_zoom_t*)malloc(sizeof(psd_zoom_t));
+        w->zbuf = (double complex*)malloc(PSD_ZOOM_BLOCK * sizeof(double complex));
+        if (!w->zoom || !w->zbuf) {
+            psd_welch_free(w);
+            return -1;
+        }
+        zoom_init(w->zoom, decim, config->zoom_shift_hz, config->sample_rate);
+
+        if (decim > 1) {
+            w->droop = (double*)malloc(w->nfft * sizeof(double));
+            w->bin_gain = (double*)malloc(w->nfft * sizeof(double));
+            if (!w->droop || !w->bin_gain) {
+                psd_welch_free(w);
+                return -1;
+            }
+            zoom_droop_gain(w->droop, w->nfft, decim, w->fs);
+            memcpy(w->bin_gain, w->droop, w->nfft * sizeof(double));
+        }
+    }
+
+    w->acc     = (double*)psd_alloc(w->nfft * sizeof(double));
+    w->hist    = (double complex*)psd_alloc(w->nfft * sizeof(double complex));
+    if (!w->acc || !w->hist) {
+        psd_welch_free(w);
+        return -1;
+    }
+    memset(w->acc, 0, w->nfft * sizeof(double));
+
+    // nthreads is planner-global state: set it for every plan we create
+    w->fft_threads = psd_fft_threads(w->nfft);
+    if (fftw_threads_ok) fftw_plan_with_nthreads(w->fft_threads);
+
+    if (config->estimator == PSD_ESTIMATOR_MULTITAPER) {
+        w->dpss = psd_dpss_get(w->nfft, config->mt_nw, config->mt_k);
+        if (!w->dpss) {
+            psd_welch_free(w);
+            return -1;
+        }
+        int n = w->nfft;
+        int k = w->dpss->k;
+        w->mt_in  = (double complex*)psd_alloc((size_t)k * n * sizeof(double complex));
+        w->mt_out = (double complex*)psd_alloc((size_t)k * n * sizeof(double complex));
+        w->mt_pow = (double*)psd_alloc((size_t)n * sizeof(double));
+        if (!w->mt_in || !w->mt_out || !w->mt_pow) {
+            psd_welch_free(w);
+            return -1;
+        }
+        // K transforms of length n, back to back: one batched plan
+        w->mt_plan = fftw_plan_many_dft(1, &n, k, w->mt_in, NULL, 1, n,
+                                        w->mt_out, NULL, 1, n, FFTW_FORWARD, FFTW_ESTIMATE);
+        if (!w->mt_plan) {
+            psd_welch_free(w);
+            return -1;
         }
+        w->u_norm = 1.0 / n;   // unit-energy tapers
+        return 0;
     }
+
+    w->win     = psd_window_get(config->window_type, w->nfft, config->window_param);
+    w->fft_in  = (double complex*)psd_alloc(w->nfft * sizeof(double complex));
+    w->fft_out = (double complex*)psd_alloc(w->nfft * sizeof(double complex));
+    if (!w->win || !w->fft_in || !w->fft_out) {
+        psd_welch_free(w);
+        return -1;
+    }
+    w->window = w->win->w;
+    w->u_norm = w->win->u_norm;
+
+    w->plan = fftw_plan_dft_1d(w->nfft, w->fft_in, w->fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    if (!w->plan) {
+        psd_welch_free(w);
+        return -1;
+    }
+    return 0;
 }
 
-static void fftshift(double* data, int n) {
-    int half = n / 2;
-    double* temp = (double*)alloca(half * sizeof(double));
-    memcpy(temp, data, half * sizeof(double));
-    memcpy(data, &data[half], (n - half) * sizeof(double));
-    memcpy(&data[n - half], temp, half * sizeof(double));
+void psd_welch_free(psd_welch_t *w) {
+    if (!w) return;
+    if (w->plan) fftw_destroy_plan(w->plan);
+    free(w->fft_in);
+    free(w->fft_out);
+    psd_window_release(w->win);
+    if (w->mt_plan) fftw_destroy_plan(w->mt_plan);
+    free(w->mt_in);
+    free(w->mt_out);
+    free(w->mt_pow);
+    psd_dpss_release(w->dpss);
+    free(w->acc);
+    free(w->hist);
+    free(w->frame);
+    free(w->zoom);
+    free(w->zbuf);
+    free(w->bin_gain);
+    free(w->droop);
+    memset(w, 0, sizeof(*w));
 }
 
-void execute_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out) {
-    double complex* signal = signal_data->signal_iq;
-    size_t n_signal = signal_data->n_signal;
-    int nperseg = config->nperseg;
-    int noverlap = config->noverlap;
-    double fs = config->sample_rate;
-    
-    int nfft = nperseg;
-    int step = nperseg - noverlap;
-    int k_segments = (n_signal - noverlap) / step;
+void psd_welch_reset(psd_welch_t *w) {
+    memset(w->acc, 0, w->nfft * sizeof(double));
+    w->n_segments = 0;
+}
 
-    double* window = (double*)malloc(nperseg * sizeof(double));
-    generate_window(config->window_type, window, nperseg);
+void psd_welch_flush_history(psd_welch_t *w) {
+    w->hist_fill = 0;
+    if (w->zoom) zoom_reset(w->zoom);
+}
 
-    double u_norm = 0.0;
-    for (int i = 0; i < nperseg; i++) u_norm += window[i] * window[i];
-    u_norm /= nperseg;
+/*
+  Fused per-segment pass over one contiguous run of output bins: |X|^2 goes
+  into the Welch accumulator and, block by block while still in cache, into
+  the persistent traces. Output order is fftshift order, so the caller runs
+  this twice (upper half of the FFT, then lower half) and no shift is needed.
+*/
+#define PSD_FUSE_BLOCK 256
 
-    double complex* fft_in = fftw_alloc_complex(nfft);
-    double complex* fft_out = fftw_alloc_complex(nfft);
-    fftw_plan plan = fftw_plan_dft_1d(nfft, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+static void accumulate_run(const double complex *restrict X, const double *restrict P,
+                           double *restrict acc, const double *restrict gain, float *restrict frame,
+                           psd_trace_t *tr, int off, int count, float seg_scale, uint64_t t_ns) {
+    float pw[PSD_FUSE_BLOCK];
+    double pb[PSD_FUSE_BLOCK];
 
-    memset(p_out, 0, nfft * sizeof(double));
+    for (int b0 = 0; b0 < count; b0 += PSD_FUSE_BLOCK) {
+        int nb = count - b0;
+        if (nb > PSD_FUSE_BLOCK) nb = PSD_FUSE_BLOCK;
+        double *a = &acc[off + b0];
 
-    for (int k = 0; k < k_segments; k++) {
-        int start = k * step;
-        
-        for (int i = 0; i < nperseg; i++) {
-            fft_in[i] = signal[start + i] * window[i];
+        // |X|^2 of the block (Welch) or the already combined power (multitaper)
+        const double *p = pb;
+        if (P) {
+            p = &P[b0];
+        } else {
+            const double complex *x = &X[b0];
+            #pragma omp simd
+            for (int i = 0; i < nb; i++) {
+                double re = creal(x[i]);
+                double im = cimag(x[i]);
+                pb[i] = re * re + im * im;
+            }
+        }
+
+        if (gain) {
+            const double *g = &gain[off + b0];
+            #pragma omp simd
+            for (int i = 0; i < nb; i++) {
+                a[i] += p[i];
+                pw[i] = (float)(p[i] * g[i]) * seg_scale;
+            }
+        } else {
+            #pragma omp simd
+            for (int i = 0; i < nb; i++) {
+                a[i] += p[i];
+                pw[i] = (float)p[i] * seg_scale;
+            }
+        }
+
+        if (frame) memcpy(&frame[off + b0], pw, (size_t)nb * sizeof(float));
+
+        if (!tr) continue;
+
+        int o = off + b0;
+        if (tr->max_hold) {
+            float *mx = &tr->max_hold[o];
+            uint64_t *t = tr->t_ext[0] ? &tr->t_ext[0][o] : NULL;
+            if (t) {
+                #pragma omp simd
+                for (int i = 0; i < nb; i++) {
+                    bool up = pw[i] > mx[i];
+                    t[i]  = up ? t_ns : t[i];
+                    mx[i] = up ? pw[i] : mx[i];
+                }
+            } else {
+                #pragma omp simd
+                for (int i = 0; i < nb; i++) mx[i] = fmaxf(mx[i], pw[i]);
+            }
         }
+        if (tr->min_hold) {
+            float *mn = &tr->min_hold[o];
+            uint64_t *t = tr->t_ext[1] ? &tr->t_ext[1][o] : NULL;
+            if (t) {
+                #pragma omp simd
+                for (int i = 0; i < nb; i++) {
+                    bool dn = pw[i] < mn[i];
+                    t[i]  = dn ? t_ns : t[i];
+                    mn[i] = dn ? pw[i] : mn[i];
+                }
+            } else {
+                #pragma omp simd
+                for (int i = 0; i < nb; i++) mn[i] = fminf(mn[i], pw[i]);
+            }
+        }
+        if (tr->ema) {
+            float *e = &tr->ema[o];
+            float alpha = (tr->n_frames == 0) ? 1.0f : tr->ema_alpha;
+            #pragma omp simd
+            for (int i = 0; i < nb; i++) e[i] += alpha * (pw[i] - e[i]);
+            if (tr->ema_peak) {
+                float *pk = &tr->ema_peak[o];
+                uint64_t *t = &tr->t_ext[2][o];
+                #pragma omp simd
+                for (int i = 0; i < nb; i++) {
+                    bool up = e[i] > pk[i];
+                    t[i]  = up ? t_ns : t[i];
+                    pk[i] = up ? e[i] : pk[i];
+                }
+            }
+        }
+        if (tr->rms_sum) {
+            // double: in RTSA a float sum stops moving after 2^24 segments (~30 min)
+            double *r = &tr->rms_sum[o];
+            #pragma omp simd
+            for (int i = 0; i < nb; i++) r[i] += pw[i];
+            if (tr->rms_peak) {
+                double inv = 1.0 / (double)(tr->n_frames + 1);
+                float *pk = &tr->rms_peak[o];
+                uint64_t *t = &tr->t_ext[3][o];
+                #pragma omp simd
+                for (int i = 0; i < nb; i++) {
+                    float m = (float)(r[i] * inv);
+                    bool up = m > pk[i];
+                    t[i]  = up ? t_ns : t[i];
+                    pk[i] = up ? m : pk[i];
+                }
+            }
+        }
+    }
+}
 
-        fftw_execute(plan);
+/*
+  Multitaper segment: K tapered copies through one batched FFT, then per bin
+  Thomson's adaptive weights d_k = sqrt(l_k) S / (l_k S + (1 - l_k) s2), which
+  down-weight the leaky high-order tapers where the spectrum is low.
+  Result in mt_pow, natural FFT order, same units as |X|^2 of a unit-energy window.
+*/
+#define PSD_MT_ADAPT_ITERS 3
 
+static void multitaper_power(psd_welch_t *w, const double complex *segment) {
+    const psd_dpss_t *dp = w->dpss;
+    int n = w->nfft;
+    int K = dp->k;
+
+    double s2 = 0.0;
+    for (int i = 0; i < n; i++) {
+        double re = creal(segment[i]), im = cimag(segment[i]);
+        s2 += re * re + im * im;
+    }
+    s2 /= n;   // white-noise level of a unit-energy taper
+
+    for (int k = 0; k < K; k++) {
+        const double *v = &dp->w[(size_t)k * n];
+        double complex *in = &w->mt_in[(size_t)k * n];
+        #pragma omp simd
+        for (int i = 0; i < n; i++) in[i] = segment[i] * v[i];
+    }
+
+    fftw_execute(w->mt_plan);
+
+    for (int i = 0; i < n; i++) {
+        double sk[PSD_DPSS_MAX_K];
+        for (int k = 0; k < K; k++) {
+            double complex X = w->mt_out[(size_t)k * n + i];
+            sk[k] = creal(X) * creal(X) + cimag(X) * cimag(X);
+        }
+
+        double S = (K > 1) ? 0.5 * (sk[0] + sk[1]) : sk[0];
+        for (int it = 0; it < PSD_MT_ADAPT_ITERS; it++) {
+            double num = 0.0, den = 0.0;
+            for (int k = 0; k < K; k++) {
+                double l = dp->lambda[k];
+                double d = sqrt(l) * S / (l * S + (1.0 - l) * s2 + 1e-300);
+                num += d * d * sk[k];
+                den += d * d;
+            }
+            if (den > 0.0) S = num / den;
+        }
+        w->mt_pow[i] = S;
+    }
+}
+
+void psd_welch_segment(psd_welch_t *w, const double complex *segment, uint64_t t_ns) {
+    int nfft = w->nfft;
+    int half = nfft / 2;
+    const double complex *X = NULL;
+    const double *P = NULL;
+
+    if (w->dpss) {
+        multitaper_power(w, segment);
+        P = w->mt_pow;
+    } else {
         for (int i = 0; i < nfft; i++) {
-            double mag = cabs(fft_out[i]);
-            p_out[i] += (mag * mag);
+            w->fft_in[i] = segment[i] * w->window[i];
         }
+        fftw_execute(w->plan);
+        X = w->fft_out;
     }
 
-    double scale = 1.0 / (fs * u_norm * k_segments * nperseg);
-    for (int i = 0; i < nfft; i++) p_out[i] *= scale;
+    // Per-segment PSD scale, so traces hold single-segment densities
+    float seg_scale = (float)(1.0 / (w->fs * w->u_norm * nfft));
 
-    fftshift(p_out, nfft);
+    // out[0 .. nfft-half) <- X[half .. nfft), out[nfft-half .. nfft) <- X[0 .. half)
+    float *frame = w->on_frame ? w->frame : NULL;
+    accumulate_run(X ? &X[half] : NULL, P ? &P[half] : NULL, w->acc, w->bin_gain, frame,
+                   w->trace, 0, nfft - half, seg_scale, t_ns);
+    accumulate_run(X, P, w->acc, w->bin_gain, frame,
+                   w->trace, nfft - half, half, seg_scale, t_ns);
 
-    double df = fs / nfft;
-    for (int i = 0; i < nfft; i++) {
-        f_out[i] = -fs / 2.0 + i * df;
+    if (w->trace) w->trace->n_frames++;
+    w->n_segments++;
+
+    if (frame) w->on_frame(w->frame_user, frame, nfft, t_ns);
+}
+
+int psd_welch_set_frame_cb(psd_welch_t *w, psd_frame_cb_t cb, void *user) {
+    if (cb && !w->frame) {
+        w->frame = (float*)malloc((size_t)w->nfft * sizeof(float));
+        if (!w->frame) return -1;
+    }
+    w->on_frame = cb;
+    w->frame_user = user;
+    return 0;
+}
+
+int psd_welch_set_gain_db(psd_welch_t *w, const double *gain_db) {
+    int n = w->nfft;
+    if (!gain_db) {
+        if (w->droop) {
+            memcpy(w->bin_gain, w->droop, (size_t)n * sizeof(double));
+        } else {
+            free(w->bin_gain);
+            w->bin_gain = NULL;
+        }
+        return 0;
+    }
+    if (!w->bin_gain) {
+        w->bin_gain = (double*)malloc((size_t)n * sizeof(double));
+        if (!w->bin_gain) return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        double g = pow(10.0, gain_db[i] / 10.0);
+        w->bin_gain[i] = w->droop ? w->droop[i] * g : g;
+    }
+    return 0;
+}
+
+void psd_welch_set_time(psd_welch_t *w, uint64_t t_ns) {
+    w->t_base_ns = t_ns;
+    w->t_base_sample = w->samples_fed;
+}
+
+static uint64_t segment_time_ns(const psd_welch_t *w, uint64_t first_sample) {
+    double dt = (double)((int64_t)(first_sample - w->t_base_sample)) * 1e9 / w->fs;
+    return w->t_base_ns + (uint64_t)(int64_t)dt;
+}
+
+/* Append FFT-rate samples to the overlap history, running every completed segment */
+static size_t hist_append(psd_welch_t *w, const double complex *x, size_t n) {
+    size_t done = 0;
+    size_t segments = 0;
+
+    while (done < n) {
+        size_t room = (size_t)(w->nfft - w->hist_fill);
+        size_t take = n - done;
+        if (take > room) take = room;
+
+        memcpy(&w->hist[w->hist_fill], &x[done], take * sizeof(double complex));
+        w->hist_fill += (int)take;
+        w->samples_fed += take;
+        done += take;
+
+        if (w->hist_fill == w->nfft) {
+            psd_welch_segment(w, w->hist, segment_time_ns(w, w->samples_fed - (uint64_t)w->nfft));
+            segments++;
+
+            int keep = w->nfft - w->step;
+            memmove(w->hist, &w->hist[w->step], keep * sizeof(double complex));
+            w->hist_fill = keep;
+        }
+    }
+    return segments;
+}
+
+/* Input-rate samples through the zoom front-end (iq8 interleaved or complex) */
+static size_t zoom_feed(psd_welch_t *w, const int8_t *iq, const double complex *x, size_t n_samples) {
+    psd_zoom_t *z = w->zoom;
+    size_t slice = (size_t)PSD_ZOOM_BLOCK * (size_t)z->decim;
+    size_t segments = 0;
+
+    for (size_t s0 = 0; s0 < n_samples; s0 += slice) {
+        size_t n = n_samples - s0;
+        if (n > slice) n = slice;
+
+        size_t n_out = 0;
+        if (iq) {
+            const int8_t *src = &iq[2 * s0];
+            for (size_t i = 0; i < n; i++) {
+                n_out += zoom_push(z, (double)src[2 * i], (double)src[2 * i + 1], &w->zbuf[n_out]);
+            }
+        } else {
+            const double complex *src = &x[s0];
+            for (size_t i = 0; i < n; i++) {
+                n_out += zoom_push(z, creal(src[i]), cimag(src[i]), &w->zbuf[n_out]);
+            }
+        }
+        segments += hist_append(w, w->zbuf, n_out);
+    }
+    return segments;
+}
+
+size_t psd_welch_feed_iq8(psd_welch_t *w, const int8_t *iq, size_t n_samples) {
+    if (w->zoom) return zoom_feed(w, iq, NULL, n_samples);
+
+    size_t done = 0;
+    size_t segments = 0;
+
+    while (done < n_samples) {
+        size_t room = (size_t)(w->nfft - w->hist_fill);
+        size_t take = n_samples - done;
+        if (take > room) take = room;
+
+        double complex *dst = &w->hist[w->hist_fill];
+        const int8_t *src = &iq[2 * done];
+        for (size_t i = 0; i < take; i++) {
+            dst[i] = (double)src[2 * i] + (double)src[2 * i + 1] * I;
+        }
+        w->hist_fill += (int)take;
+        w->samples_fed += take;
+        done += take;
+
+        if (w->hist_fill == w->nfft) {
+            psd_welch_segment(w, w->hist, segment_time_ns(w, w->samples_fed - (uint64_t)w->nfft));
+            segments++;
+
+            // Keep the overlapping tail as the head of the next segment
+            int keep = w->nfft - w->step;
+            memmove(w->hist, &w->hist[w->step], keep * sizeof(double complex));
+            w->hist_fill = keep;
+        }
+    }
+    return segments;
+}
+
+int psd_welch_result(psd_welch_t *w, double* f_out, double* p_out) {
+    int nfft = w->nfft;
+    if (w->n_segments <= 0) return -1;
+
+    double scale = 1.0 / (w->fs * w->u_norm * w->n_segments * nfft);
+    if (w->bin_gain) {
+        for (int i = 0; i < nfft; i++) p_out[i] = w->acc[i] * scale * w->bin_gain[i];
+    } else {
+        for (int i = 0; i < nfft; i++) p_out[i] = w->acc[i] * scale;
+    }
+
+    psd_welch_freq_axis(w, f_out);
+    return w->n_segments;
+}
+
+/* Capture mode without the complex copy: int8 straight into the segment history */
+int psd_welch_run_iq8(psd_welch_t *w, const int8_t *iq, size_t n_samples, uint64_t t0_ns) {
+    psd_welch_flush_history(w);
+    psd_welch_set_time(w, t0_ns);
+    return (int)psd_welch_feed_iq8(w, iq, n_samples);
+}
+
+/* Relative frequency of each output bin (LO = 0), fftshift order */
+void psd_welch_freq_axis(const psd_welch_t *w, double *f_out) {
+    double df = w->fs / w->nfft;
+    double f0 = w->f_shift - w->fs / 2.0;
+    for (int i = 0; i < w->nfft; i++) {
+        f_out[i] = f0 + i * df;
+    }
+}
+
+/*
+  Display decimation: groups of ceil(n / max_bins) bins collapse to their max
+  (peaks survive, unlike averaging). f_out is the group center on a uniform
+  k*df grid. Returns bins out.
+*/
+int psd_maxpool(const double *f_in, const double *p_in, int n, int max_bins, double *f_out, double *p_out) {
+    if (n <= 0 || max_bins <= 0) return 0;
+    int k = (n + max_bins - 1) / max_bins;
+    double df = (n > 1) ? f_in[1] - f_in[0] : 0.0;
+    int m = 0;
+
+    for (int i0 = 0; i0 < n; i0 += k) {
+        int cnt = (n - i0 < k) ? n - i0 : k;
+        double mx = p_in[i0];
+        for (int i = 1; i < cnt; i++) {
+            if (p_in[i0 + i] > mx) mx = p_in[i0 + i];
+        }
+        p_out[m] = mx;
+        f_out[m] = f_in[0] + ((double)i0 + (k - 1) / 2.0) * df;
+        m++;
+    }
+    return m;
+}
+
+/* Bins of freq[] inside [center_rel - span/2, center_rel + span/2]; returns count */
+int psd_span_bins(const double *freq, int nbins, double center_rel, double span, int *start_out) {
+    double lo = center_rel - span / 2.0;
+    double hi = center_rel + span / 2.0;
+    int start_idx = 0;
+    int end_idx = nbins - 1;
+
+    for (int i = 0; i < nbins; i++) {
+        if (freq[i] >= lo) { start_idx = i; break; }
+    }
+    for (int i = start_idx; i < nbins; i++) {
+        if (freq[i] > hi) { end_idx = i - 1; break; }
+        end_idx = i;
+    }
+
+    *start_out = start_idx;
+    return end_idx - start_idx + 1;
+}
+
+int psd_welch_run(psd_welch_t *w, const signal_iq_t* signal_data, uint64_t t0_ns) {
+    const double complex* signal = signal_data->signal_iq;
+    size_t n_signal = signal_data->n_signal;
+
+    if (w->zoom) {
+        // One capture = one fresh filter run through the overlap history
+        psd_welch_flush_history(w);
+        psd_welch_set_time(w, t0_ns);
+        return (int)zoom_feed(w, NULL, signal, n_signal);
+    }
+
+    if (n_signal < (size_t)w->nfft) return 0;
+
+    psd_welch_set_time(w, t0_ns);
+
+    int k_segments = (int)((n_signal - (size_t)w->nfft) / (size_t)w->step) + 1;
+    for (int k = 0; k < k_segments; k++) {
+        uint64_t start = (uint64_t)k * (uint64_t)w->step;
+        psd_welch_segment(w, &signal[start], segment_time_ns(w, w->samples_fed + start));
+    }
+    w->samples_fed += n_signal;
+    return k_segments;
+}
+
+uint64_t psd_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void execute_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out) {
+    psd_welch_t w;
+    if (psd_welch_init(&w, config) != 0) return;
+
+    psd_welch_run(&w, signal_data, psd_now_ns());
+
+    if (psd_welch_result(&w, f_out, p_out) < 0) {
+        memset(p_out, 0, w.nfft * sizeof(double));
     }
 
-    free(window);
-    fftw_destroy_plan(plan);
-    fftw_free(fft_in);
-    fftw_free(fft_out);
+    psd_welch_free(&w);
 }
\ No newline at end of file
@@ -4,14 +4,117 @@
 
 #include "datatypes.h"
 #include "sdr_HAL.h"
+#include "psd_trace.h"
+#include "psd_window.h"
 #include <stdint.h>
+#include <fftw3.h>
 #include <cjson/cJSON.h>
 
+#define PSD_RTSA_DEFAULT_FPS 20.0
+
+/* Zoom-FFT: fs_out >= PSD_ZOOM_OVERSAMPLE * span, CIC of order PSD_ZOOM_CIC_ORDER */
+#define PSD_ZOOM_OVERSAMPLE 2.5
+#define PSD_ZOOM_CIC_ORDER  5
+#define PSD_ZOOM_MAX_DECIM  256   // int8 * Q14 + 5*log2(256) bits still fits int64
+
+/* Large transforms: threaded FFTW plans and hugepage-backed workspaces */
+#define PSD_LARGE_FFT       (1 << 20)
+#define PSD_FFT_MAX_THREADS 4
+#define PSD_FFT_MAX_SIZE    (1 << 26)   // largest nperseg find_params_psd will plan
+
+/* Per-FFT-frame hook: linear single-segment PSD, fftshift order */
+typedef void (*psd_frame_cb_t)(void *user, const float *frame, int nbins, uint64_t t_ns);
+
+/**
+ * Zoom front-end: NCO mix to the span center, then an integer CIC decimator.
+ * Integrators wrap modulo 2^64 (exact CIC arithmetic), the passband droop is
+ * undone per bin in the PSD domain.
+ */
+typedef struct {
+    int decim;
+    int phase;                // input samples since last output
+    bool use_nco;
+    double complex rot;       // NCO phasor (renormalised periodically)
+    double complex rot_step;
+    int rot_count;
+    uint64_t integ[2][PSD_ZOOM_CIC_ORDER];
+    uint64_t comb[2][PSD_ZOOM_CIC_ORDER];
+    double out_scale;         // 1 / (decim^N * Q)
+} psd_zoom_t;
+
+/**
+ * Streaming Welch engine. Window, FFTW plan and accumulator persist across
+ * calls so the same instance can be fed one capture or a continuous stream.
+ */
+typedef struct {
+    PsdConfig_t cfg;
+    int nfft;
+    int step;                 // nperseg - noverlap
+    double fs;                // rate seen by the FFT (sample_rate / zoom_decim)
+    double f_shift;           // relative frequency of the FFT DC bin
+
+    psd_zoom_t *zoom;         // NULL = full band
+    double complex *zbuf;     // decimated scratch
+    double *bin_gain;         // per-bin power gain (fftshift order): droop x psd_welch_set_gain_db, NULL = none
+    double *droop;            // CIC droop compensation alone, NULL = none
+
+    const psd_window_t *win;  // shared, from the window cache (Welch)
+    const double *window;     // win->w
+    double u_norm;
+
+    const psd_dpss_t *dpss;   // multitaper: K tapers, one batched plan
+    double complex *mt_in;
+    double complex *mt_out;
+    fftw_plan mt_plan;
+    double *mt_pow;           // adaptive-weighted |X|^2 of the current segment
+    double complex *fft_in;
+    double complex *fft_out;
+    fftw_plan plan;
+    int fft_threads;
+
+    double *acc;              // sum |X|^2 per bin (fftshift order)
+    int n_segments;           // segments accumulated since last reset
+
+    double complex *hist;     // overlap history for streaming input
+    int hist_fill;
+
+    uint64_t samples_fed;     // stream position (samples)
+    uint64_t t_base_ns;       // timestamp of sample t_base_sample
+    uint64_t t_base_sample;
+
+    psd_trace_t *trace;       // optional persistent traces (updated per segment)
+
+    float *frame;             // last segment PSD, filled only when on_frame is set
+    psd_frame_cb_t on_frame;
+    void *frame_user;
+} psd_welch_t;
+
 signal_iq_t* load_iq_from_buffer(const int8_t* buffer, size_t buffer_size);
 void free_signal_iq(signal_iq_t* signal);
 void execute_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out);
+
+int psd_welch_init(psd_welch_t *w, const PsdConfig_t *config);
+void psd_welch_free(psd_welch_t *w);
+void psd_welch_reset(psd_welch_t *w);
+void psd_welch_flush_history(psd_welch_t *w);
+int psd_welch_set_frame_cb(psd_welch_t *w, psd_frame_cb_t cb, void *user);
+void psd_welch_set_time(psd_welch_t *w, uint64_t t_ns);
+/* Extra per-bin gain in dB (fftshift order, e.g. calibration), folded into frames,
+   traces and the result from the next segment on; NULL = none */
+int psd_welch_set_gain_db(psd_welch_t *w, const double *gain_db);
+void psd_welch_segment(psd_welch_t *w, const double complex *segment, uint64_t t_ns);
+int psd_welch_run(psd_welch_t *w, const signal_iq_t* signal_data, uint64_t t0_ns);
+size_t psd_welch_feed_iq8(psd_welch_t *w, const int8_t *iq, size_t n_samples);
+int psd_welch_run_iq8(psd_welch_t *w, const int8_t *iq, size_t n_samples, uint64_t t0_ns);
+int psd_welch_result(psd_welch_t *w, double* f_out, double* p_out);
+void psd_welch_freq_axis(const psd_welch_t *w, double *f_out);
+int psd_span_bins(const double *freq, int nbins, double center_rel, double span, int *start_out);
+int psd_maxpool(const double *f_in, const double *p_in, int n, int max_bins, double *f_out, double *p_out);
+int psd_smooth_size(double n_min);
+uint64_t psd_now_ns(void);
 double get_window_enbw_factor(PsdWindowType_t type); 
 int scale_psd(double* psd, int nperseg, const char* scale_str);
+int scale_psd_corrected(double* psd, int nperseg, const char* scale_str, const double* corr_db);
 int parse_psd_config(const char *json_string, DesiredCfg_t *target);
 void free_desired_psd(DesiredCfg_t *target);
 int find_params_psd(DesiredCfg_t desired, SDR_cfg_t *hack_cfg, PsdConfig_t *psd_cfg, RB_cfg_t *rb_cfg);
@@ -0,0 +1,535 @@
+//libs/psd_archive.c
+#define _GNU_SOURCE
+#include "psd_archive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(psd_ar_header_t) == 256, "archive header must stay 256 bytes");
+_Static_assert(sizeof(psd_ar_rec_t) == 16, "archive record header must stay 16 bytes");
+
+#define PSD_AR_BATCH       16       // wake the writer once this many records wait
+#define PSD_AR_FLUSH_MS    250      // ... or after this long
+
+/* Record stride for nbins values in this format, padded to 8 bytes */
+static size_t ar_rec_bytes(uint32_t nbins, uint32_t format) {
+    size_t val = (format == PSD_AR_U8) ? 1 : sizeof(float);
+    return (sizeof(psd_ar_rec_t) + (size_t)nbins * val + 7) & ~(size_t)7;
+}
+
+/* ------------------------------ writer ------------------------------ */
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = (const uint8_t*)buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int is_segment(const struct dirent *e) {
+    size_t n = strlen(e->d_name);
+    return n > 8 && strncmp(e->d_name, "psd_", 4) == 0 && strcmp(e->d_name + n - 4, ".pda") == 0;
+}
+
+/* Oldest first (names carry the zero-padded start time) */
+static int list_segments(const char *dir, struct dirent ***out) {
+    return scandir(dir, out, is_segment, alphasort);
+}
+
+static void free_list(struct dirent **list, int n) {
+    for (int i = 0; i < n; i++) free(list[i]);
+    free(list);
+}
+
+static void ar_enforce_keep(psd_archive_t *ar) {
+    if (ar->cfg.keep_segments <= 0) return;
+
+    struct dirent **list;
+    int n = list_segments(ar->dir, &list);
+    if (n < 0) return;
+    for (int i = 0; i < n - ar->cfg.keep_segments; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", ar->dir, list[i]->d_name);
+        unlink(path);
+        size_t len = strlen(path);
+        path[len - 1] = 'i';   // .pda -> .pdi
+        unlink(path);
+    }
+    free_list(list, n);
+}
+
+static void ar_close_segment(psd_archive_t *ar) {
+    if (ar->fd >= 0) close(ar->fd);
+    if (ar->idx_fd >= 0) close(ar->idx_fd);
+    ar->fd = ar->idx_fd = -1;
+}
+
+static int ar_new_segment(psd_archive_t *ar, uint64_t t_ns) {
+    ar_close_segment(ar);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/psd_%020llu.pda", ar->dir, (unsigned long long)t_ns);
+    ar->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (ar->fd < 0) {
+        perror("[ARCH] segment");
+        return -1;
+    }
+    psd_ar_header_t h = ar->tmpl;
+    h.t_first_ns = t_ns;
+    if (write_all(ar->fd, &h, sizeof(h)) != 0) {
+        perror("[ARCH] header");
+        ar_close_segment(ar);
+        return -1;
+    }
+
+    path[strlen(path) - 1] = 'i';
+    ar->idx_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (ar->idx_fd < 0) perror("[ARCH] index");   // readers fall back to a plain binary search
+
+    ar->seg_t0 = t_ns;
+    ar->seg_recs = 0;
+    ar_enforce_keep(ar);
+    return 0;
+}
+
+static inline uint8_t *ar_slot(psd_archive_t *ar, int i) {
+    return ar->q + (size_t)i * ar->rec_bytes;
+}
+
+/* Records [head, head + n) of the queue -> segments; runs that stay in one segment go in one write */
+static void ar_write_batch(psd_archive_t *ar, int head, int n) {
+    double seg_mb = ar->cfg.segment_mb > 0 ? ar->cfg.segment_mb : 256.0;
+    double seg_s = ar->cfg.segment_s > 0 ? ar->cfg.segment_s : 3600.0;
+    uint64_t max_recs = (uint64_t)(seg_mb * 1024.0 * 1024.0 / ar->rec_bytes);
+    uint64_t max_ns = (uint64_t)(seg_s * 1e9);
+    if (max_recs < 1) max_recs = 1;
+
+    psd_ar_idx_t idx[PSD_AR_BATCH * 4 / PSD_AR_INDEX_EVERY + 2];
+    int i = 0;
+    while (i < n) {
+        int slot = (head + i) % ar->q_cap;
+        const psd_ar_rec_t *r = (const psd_ar_rec_t*)ar_slot(ar, slot);
+
+        if (ar->fd < 0 || ar->seg_recs >= max_recs || r->t_ns >= ar->seg_t0 + max_ns) {
+            if (ar_new_segment(ar, r->t_ns) != 0) {
+                ar->lost += (uint64_t)(n - i);
+                return;
+            }
+        }
+
+        // contiguous in the ring, same segment, bounded so the index buffer fits
+        int run = 0;
+        int nidx = 0;
+        while (i + run < n && slot + run < ar->q_cap && ar->seg_recs + run < max_recs &&
+               run < PSD_AR_BATCH * 4) {
+            const psd_ar_rec_t *rr = (const psd_ar_rec_t*)ar_slot(ar, slot + run);
+            if (rr->t_ns >= ar->seg_t0 + max_ns) break;
+            if ((ar->seg_recs + run) % PSD_AR_INDEX_EVERY == 0) {
+                idx[nidx].t_ns = rr->t_ns;
+                idx[nidx].rec = ar->seg_recs + run;
+                nidx++;
+            }
+            run++;
+        }
+
+        if (write_all(ar->fd, ar_slot(ar, slot), (size_t)run * ar->rec_bytes) != 0) {
+            perror("[ARCH] write");
+            ar->lost += (uint64_t)(n - i);
+            ar_close_segment(ar);   // next batch starts a fresh segment
+            return;
+        }
+        // index after the records: an entry never points past the data
+        if (nidx && ar->idx_fd >= 0) write_all(ar->idx_fd, idx, (size_t)nidx * sizeof(idx[0]));
+
+        ar->seg_recs += (uint64_t)run;
+        ar->written += (uint64_t)run;
+        i += run;
+    }
+}
+
+static void *ar_writer_fn(void *arg) {
+    psd_archive_t *ar = (psd_archive_t*)arg;
+
+    for (;;) {
+        uint64_t head = ar->q_head;
+        uint64_t tail = __atomic_load_n(&ar->q_tail, __ATOMIC_ACQUIRE);
+        bool stop = __atomic_load_n(&ar->stop, __ATOMIC_ACQUIRE);
+
+        if (tail - head < PSD_AR_BATCH && !stop) {
+            // the producer signals without the lock: a missed wakeup costs one flush period
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += PSD_AR_FLUSH_MS * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_mutex_lock(&ar->mtx);
+            pthread_cond_timedwait(&ar->cv, &ar->mtx, &ts);
+            pthread_mutex_unlock(&ar->mtx);
+            tail = __atomic_load_n(&ar->q_tail, __ATOMIC_ACQUIRE);
+            stop = __atomic_load_n(&ar->stop, __ATOMIC_ACQUIRE);
+        }
+        if (tail == head) {
+            if (stop) break;
+            continue;
+        }
+
+        int n = (int)(tail - head);
+        ar_write_batch(ar, (int)(head % (uint64_t)ar->q_cap), n);
+        __atomic_store_n(&ar->q_head, tail, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+int psd_ar_open(psd_archive_t *ar, const psd_ar_cfg_t *cfg) {
+    if (!ar || !cfg || !cfg->dir || cfg->nbins <= 0) return -1;
+    if (cfg->format == PSD_AR_U8 && cfg->db_max <= cfg->db_min) return -1;
+
+    memset(ar, 0, sizeof(*ar));
+    ar->fd = ar->idx_fd = -1;
+    ar->cfg = *cfg;
+    snprintf(ar->dir, sizeof(ar->dir), "%s", cfg->dir);
+    snprintf(ar->scale, sizeof(ar->scale), "%s", cfg->scale ? cfg->scale : "dBm");
+    ar->cfg.dir = ar->dir;
+    ar->cfg.scale = ar->scale;
+
+    if (mkdir(ar->dir, 0755) != 0 && errno != EEXIST) {
+        perror("[ARCH] mkdir");
+        return -1;
+    }
+
+    ar->rec_bytes = ar_rec_bytes((uint32_t)cfg->nbins, (uint32_t)cfg->format);
+    ar->q_cap = cfg->queue_rows > 0 ? cfg->queue_rows : 256;
+    ar->q = (uint8_t*)calloc((size_t)ar->q_cap, ar->rec_bytes);
+    if (!ar->q) return -1;
+
+    psd_ar_header_t *h = &ar->tmpl;
+    h->magic = PSD_AR_MAGIC;
+    h->version = PSD_AR_VERSION;
+    h->nbins = (uint32_t)cfg->nbins;
+    h->format = (uint32_t)cfg->format;
+    h->rec_bytes = (uint32_t)ar->rec_bytes;
+    h->center_freq_hz = cfg->center_freq_hz;
+    h->sample_rate_hz = cfg->sample_rate_hz;
+    h->f_start_hz = cfg->f_start_hz;
+    h->df_hz = cfg->df_hz;
+    h->db_min = (float)cfg->db_min;
+    h->db_max = (float)cfg->db_max;
+    snprintf(h->scale, sizeof(h->scale), "%s", ar->scale);
+
+    pthread_mutex_init(&ar->mtx, NULL);
+    pthread_cond_init(&ar->cv, NULL);
+    if (pthread_create(&ar->th, NULL, ar_writer_fn, ar) != 0) {
+        fprintf(stderr, "[ARCH] writer thread failed\n");
+        pthread_mutex_destroy(&ar->mtx);
+        pthread_cond_destroy(&ar->cv);
+        free(ar->q);
+        ar->q = NULL;
+        return -1;
+    }
+    ar->started = true;
+
+    fprintf(stderr, "[ARCH] %s | %d bins %s | %zu B/record | queue %d\n", ar->dir, cfg->nbins,
+            cfg->format == PSD_AR_U8 ? "u8" : "f32", ar->rec_bytes, ar->q_cap);
+    return 0;
+}
+
+void psd_ar_close(psd_archive_t *ar) {
+    if (!ar || !ar->started) return;
+
+    pthread_mutex_lock(&ar->mtx);
+    __atomic_store_n(&ar->stop, true, __ATOMIC_RELEASE);
+    pthread_cond_signal(&ar->cv);
+    pthread_mutex_unlock(&ar->mtx);
+    pthread_join(ar->th, NULL);
+
+    ar_close_segment(ar);
+    fprintf(stderr, "[ARCH] closed | %llu written, %llu dropped (queue full), %llu lost (I/O)\n",
+            (unsigned long long)ar->written, (unsigned long long)ar->dropped,
+            (unsigned long long)ar->lost);
+
+    pthread_mutex_destroy(&ar->mtx);
+    pthread_cond_destroy(&ar->cv);
+    free(ar->q);
+    memset(ar, 0, sizeof(*ar));
+    ar->fd = ar->idx_fd = -1;
+}
+
+int psd_ar_append(psd_archive_t *ar, const double *db, int n, uint64_t t_ns) {
+    if (!ar || !ar->started || !db || n != ar->cfg.nbins) return -1;
+
+    uint64_t tail = ar->q_tail;
+    uint64_t head = __atomic_load_n(&ar->q_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= (uint64_t)ar->q_cap) {
+        ar->dropped++;
+        return -1;
+    }
+
+    // slot tail is the producer's until q_tail moves past it
+    uint8_t *p = ar_slot(ar, (int)(tail % (uint64_t)ar->q_cap));
+    psd_ar_rec_t *r = (psd_ar_rec_t*)p;
+    r->t_ns = t_ns;
+    r->flags = 0;
+    r->pad = 0;
+    if (ar->cfg.format == PSD_AR_U8) {
+        uint8_t *q = p + sizeof(psd_ar_rec_t);
+        float lo = (float)ar->cfg.db_min;
+        float k = (float)(255.0 / (ar->cfg.db_max - ar->cfg.db_min));
+        #pragma omp simd
+        for (int i = 0; i < n; i++) {
+            float v = ((float)db[i] - lo) * k + 0.5f;
+            q[i] = (uint8_t)fminf(fmaxf(v, 0.0f), 255.0f);
+        }
+    } else {
+        float *f = (float*)(p + sizeof(psd_ar_rec_t));
+        #pragma omp simd
+        for (int i = 0; i < n; i++) f[i] = (float)db[i];
+    }
+
+    __atomic_store_n(&ar->q_tail, tail + 1, __ATOMIC_RELEASE);
+    ar->appended++;
+    if (tail + 1 - head == PSD_AR_BATCH) pthread_cond_signal(&ar->cv);
+    return 0;
+}
+
+/* ------------------------------ reader ------------------------------ */
+
+typedef struct {
+    int fd;
+    psd_ar_header_t h;
+    uint64_t lo;              // first matching record
+    uint64_t hi;              // one past the last
+} ar_span_t;
+
+static int read_rec_time(const ar_span_t *s, uint64_t rec, uint64_t *t) {
+    off_t off = (off_t)(sizeof(psd_ar_header_t) + rec * s->h.rec_bytes);
+    return pread(s->fd, t, sizeof(*t), off) == (ssize_t)sizeof(*t) ? 0 : -1;
+}
+
+/* First record in [a, b) with t > key (after = true) or t >= key */
+static uint64_t search_recs(const ar_span_t *s, uint64_t a, uint64_t b, uint64_t key, bool after) {
+    while (a < b) {
+        uint64_t mid = a + (b - a) / 2;
+        uint64_t t;
+        if (read_rec_time(s, mid, &t) != 0) return mid;
+        if (after ? (t <= key) : (t < key)) a = mid + 1;
+        else b = mid;
+    }
+    return a;
+}
+
+/* Narrow [0, nrec) with the sparse index, then binary search the remaining <= INDEX_EVERY records */
+static uint64_t seek_time(const ar_span_t *s, const psd_ar_idx_t *idx, size_t nidx,
+                          uint64_t nrec, uint64_t key, bool after) {
+    uint64_t a = 0, b = nrec;
+    if (nidx > 0) {
+        size_t lo = 0, hi = nidx;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (after ? (idx[mid].t_ns <= key) : (idx[mid].t_ns < key)) lo = mid + 1;
+            else hi = mid;
+        }
+        // idx[lo - 1] is still before the key, idx[lo] is not
+        if (lo > 0 && idx[lo - 1].rec < nrec) a = idx[lo - 1].rec;
+        if (lo < nidx && idx[lo].rec < nrec) b = idx[lo].rec + 1;
+    }
+    return search_recs(s, a, b, key, after);
+}
+
+static int load_index(const char *seg_path, psd_ar_idx_t **out, size_t *n) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s", seg_path);
+    path[strlen(path) - 1] = 'i';
+    *out = NULL;
+    *n = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(psd_ar_idx_t)) {
+        size_t cnt = (size_t)st.st_size / sizeof(psd_ar_idx_t);
+        *out = (psd_ar_idx_t*)malloc(cnt * sizeof(psd_ar_idx_t));
+        if (*out && pread(fd, *out, cnt * sizeof(psd_ar_idx_t), 0) == (ssize_t)(cnt * sizeof(psd_ar_idx_t))) {
+            *n = cnt;
+        } else {
+            free(*out);
+            *out = NULL;
+        }
+    }
+    close(fd);
+    return *out ? 0 : -1;
+}
+
+static void decode_rec(const psd_ar_header_t *h, const uint8_t *rec, float *out) {
+    const uint8_t *data = rec + sizeof(psd_ar_rec_t);
+    int n = (int)h->nbins;
+    if (h->format == PSD_AR_U8) {
+        float k = (h->db_max - h->db_min) / 255.0f;
+        #pragma omp simd
+        for (int i = 0; i < n; i++) out[i] = h->db_min + data[i] * k;
+    } else {
+        memcpy(out, data, (size_t)n * sizeof(float));
+    }
+}
+
+void psd_ar_result_free(psd_ar_result_t *res) {
+    if (!res) return;
+    free(res->t_ns);
+    free(res->db);
+    memset(res, 0, sizeof(*res));
+}
+
+int psd_ar_query(const char *dir, uint64_t t0, uint64_t t1, int max_rows,
+                 psd_ar_mode_t mode, psd_ar_result_t *res) {
+    if (!dir || !res || max_rows <= 0 || t1 < t0) return -1;
+    memset(res, 0, sizeof(*res));
+
+    struct dirent **list;
+    int nseg = list_segments(dir, &list);
+    if (nseg < 0) return -1;
+
+    ar_span_t *spans = (ar_span_t*)calloc((size_t)(nseg > 0 ? nseg : 1), sizeof(ar_span_t));
+    int nsp = 0;
+    if (!spans) {
+        free_list(list, nseg);
+        return -1;
+    }
+
+    for (int i = 0; i < nseg; i++) {
+        uint64_t seg_t = strtoull(list[i]->d_name + 4, NULL, 10);
+        if (seg_t > t1) break;
+        // records of segment i end where segment i + 1 starts
+        if (i + 1 < nseg && strtoull(list[i + 1]->d_name + 4, NULL, 10) < t0) continue;
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, list[i]->d_name);
+        ar_span_t s = { .fd = open(path, O_RDONLY) };
+        if (s.fd < 0) continue;
+
+        // the read buffer is sized from the first match: later segments must have its exact layout
+        struct stat st;
+        bool ok = fstat(s.fd, &st) == 0 &&
+                  pread(s.fd, &s.h, sizeof(s.h), 0) == (ssize_t)sizeof(s.h) &&
+                  s.h.magic == PSD_AR_MAGIC && s.h.nbins > 0 &&
+                  (s.h.format == PSD_AR_F32 || s.h.format == PSD_AR_U8) &&
+                  s.h.rec_bytes == ar_rec_bytes(s.h.nbins, s.h.format) &&
+                  (nsp == 0 || (s.h.nbins == spans[0].h.nbins && s.h.format == spans[0].h.format));
+        uint64_t nrec = ok ? (uint64_t)(st.st_size - (off_t)sizeof(psd_ar_header_t)) / s.h.rec_bytes : 0;
+        if (nrec > 0) {
+            psd_ar_idx_t *idx;
+            size_t nidx;
+            load_index(path, &idx, &nidx);
+            s.lo = seek_time(&s, idx, nidx, nrec, t0, false);
+            s.hi = seek_time(&s, idx, nidx, nrec, t1, true);
+            free(idx);
+        }
+        if (s.hi > s.lo) spans[nsp++] = s;
+        else close(s.fd);
+    }
+    free_list(list, nseg);
+
+    uint64_t total = 0;
+    for (int i = 0; i < nsp; i++) total += spans[i].hi - spans[i].lo;
+    res->matched = total;
+
+    int rc = 0;
+    if (total > 0) {
+        const psd_ar_header_t *h0 = &spans[0].h;
+        int nb = (int)h0->nbins;
+        int rows = total < (uint64_t)max_rows ? (int)total : max_rows;
+        res->nbins = nb;
+        res->f_start_hz = h0->f_start_hz;
+        res->df_hz = h0->df_hz;
+        res->center_freq_hz = h0->center_freq_hz;
+        memcpy(res->scale, h0->scale, sizeof(res->scale));
+        res->t_ns = (uint64_t*)malloc((size_t)rows * sizeof(uint64_t));
+        res->db = (float*)malloc((size_t)rows * nb * sizeof(float));
+        uint8_t *rec = (uint8_t*)malloc(h0->rec_bytes);
+        float *tmp = (float*)malloc((size_t)nb * sizeof(float));
+
+        if (!res->t_ns || !res->db || !rec || !tmp) {
+            rc = -1;
+        } else {
+            // walk the matched records once; row r owns global records [r*total/rows, (r+1)*total/rows)
+            int sp = 0;
+            uint64_t pos = spans[0].lo;
+            uint64_t g = 0;
+            for (int r = 0; r < rows; r++) {
+                uint64_t g1 = (uint64_t)(r + 1) * total / (uint64_t)rows;
+                float *row = &res->db[(size_t)r * nb];
+                int used = 0;
+                for (; g < g1; g++) {
+                    while (pos >= spans[sp].hi) {
+                        sp++;
+                        pos = spans[sp].lo;
+                    }
+                    const ar_span_t *s = &spans[sp];
+                    uint64_t cur = pos++;
+                    if (mode == PSD_AR_PICK && used > 0) {
+                        // skip the rest of the row without touching the files
+                        uint64_t skip = g1 - g - 1;
+                        while (skip > 0 && sp < nsp) {
+                            uint64_t left = spans[sp].hi - pos;
+                            uint64_t k = skip < left ? skip : left;
+                            pos += k;
+                            skip -= k;
+                            if (skip > 0 && sp + 1 < nsp) {
+                                sp++;
+                                pos = spans[sp].lo;
+                            } else {
+                                break;
+                            }
+                        }
+                        g = g1 - 1;
+                        continue;
+                    }
+
+                    off_t off = (off_t)(sizeof(psd_ar_header_t) + cur * s->h.rec_bytes);
+                    if (pread(s->fd, rec, s->h.rec_bytes, off) != (ssize_t)s->h.rec_bytes) continue;
+                    if (used == 0) {
+                        res->t_ns[r] = ((const psd_ar_rec_t*)rec)->t_ns;
+                        decode_rec(&s->h, rec, row);
+                    } else {
+                        decode_rec(&s->h, rec, tmp);
+                        if (mode == PSD_AR_MAX) {
+                            #pragma omp simd
+                            for (int i = 0; i < nb; i++) row[i] = fmaxf(row[i], tmp[i]);
+                        } else {
+                            #pragma omp simd
+                            for (int i = 0; i < nb; i++) row[i] += tmp[i];
+                        }
+                    }
+                    used++;
+                }
+                if (mode == PSD_AR_MEAN && used > 1) {
+                    float inv = 1.0f / used;
+                    for (int i = 0; i < nb; i++) row[i] *= inv;
+                }
+            }
+            res->rows = rows;
+        }
+        free(rec);
+        free(tmp);
+        if (rc != 0) psd_ar_result_free(res);
+    }
+
+    for (int i = 0; i < nsp; i++) close(spans[i].fd);
+    free(spans);
+    return rc;
+}
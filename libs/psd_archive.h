@@ -0,0 +1,150 @@
+//libs/psd_archive.h
+#ifndef PSD_ARCHIVE_H
+#define PSD_ARCHIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/*
+  PSD history archive: a directory of append-only segments (little endian, mmap'able)
+
+    <dir>/psd_<t_first_ns, 20 digits>.pda   [psd_ar_header_t, 256 bytes][record 0][record 1]...
+    <dir>/psd_<t_first_ns, 20 digits>.pdi   psd_ar_idx_t every PSD_AR_INDEX_EVERY records
+
+  A record is a psd_ar_rec_t followed by nbins values, float32 dB or uint8
+  (dB = db_min + q * (db_max - db_min) / 255, as the waterfall). Records are
+  fixed size and time ordered, so record k sits at 256 + k * rec_bytes and the
+  count is (file size - 256) / rec_bytes; a torn tail record is ignored.
+  Segment names sort by time; a new segment starts when the current one
+  reaches segment_mb or segment_s.
+*/
+
+#define PSD_AR_MAGIC        0x52414450u   /* "PDAR" */
+#define PSD_AR_VERSION      1u
+#define PSD_AR_INDEX_EVERY  64
+
+typedef enum {
+    PSD_AR_F32 = 0,
+    PSD_AR_U8  = 1
+} psd_ar_format_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nbins;
+    uint32_t format;          // psd_ar_format_t
+    uint32_t rec_bytes;       // record stride (header + data)
+    uint32_t pad;
+    double center_freq_hz;
+    double sample_rate_hz;
+    double f_start_hz;        // absolute frequency of bin 0
+    double df_hz;
+    float db_min;
+    float db_max;
+    uint64_t t_first_ns;
+    char scale[16];
+    uint8_t reserved[256 - 88];
+} psd_ar_header_t;
+
+typedef struct {
+    uint64_t t_ns;            // CLOCK_REALTIME of the trace
+    uint32_t flags;           // reserved
+    uint32_t pad;
+} psd_ar_rec_t;
+
+typedef struct {
+    uint64_t t_ns;
+    uint64_t rec;
+} psd_ar_idx_t;
+
+typedef struct {
+    const char *dir;
+    psd_ar_format_t format;
+    double db_min;            // uint8 range
+    double db_max;
+    double segment_mb;        // rotate by size (0 = 256)
+    double segment_s;         // ... or by age (0 = 3600)
+    int keep_segments;        // delete the oldest beyond this (0 = keep all)
+    int queue_rows;           // records buffered for the writer (0 = 256)
+
+    int nbins;
+    double center_freq_hz;
+    double sample_rate_hz;
+    double f_start_hz;
+    double df_hz;
+    const char *scale;
+} psd_ar_cfg_t;
+
+/**
+ * Writer. psd_ar_append copies one trace into a preallocated slot of a
+ * single-producer ring (two atomic counters, no lock) and returns; a
+ * background thread batches the ring into the current segment. If the disk
+ * falls behind the ring fills and traces are dropped (counted): the PSD
+ * thread never waits on I/O or on the writer.
+ */
+typedef struct {
+    psd_ar_cfg_t cfg;
+    char dir[256];
+    char scale[16];
+    psd_ar_header_t tmpl;     // header of every new segment
+    size_t rec_bytes;
+
+    uint8_t *q;               // q_cap records, slot = counter % q_cap
+    int q_cap;
+    uint64_t q_head;          // records taken by the writer (writer stores, producer loads)
+    uint64_t q_tail;          // records queued (producer stores, writer loads)
+    pthread_mutex_t mtx;      // only for the writer's wait; the producer never locks
+    pthread_cond_t cv;
+    bool stop;
+    bool started;
+    pthread_t th;
+
+    /* writer thread only */
+    int fd;
+    int idx_fd;
+    uint64_t seg_t0;
+    uint64_t seg_recs;
+
+    uint64_t appended;        // producer
+    uint64_t dropped;         // producer: ring full
+    uint64_t written;         // writer
+    uint64_t lost;            // writer: I/O errors
+} psd_archive_t;
+
+int  psd_ar_open(psd_archive_t *ar, const psd_ar_cfg_t *cfg);
+void psd_ar_close(psd_archive_t *ar);     // flushes the queue
+int  psd_ar_append(psd_archive_t *ar, const double *db, int n, uint64_t t_ns);
+
+typedef enum {
+    PSD_AR_PICK = 0,          // first record of each row: reads max_rows records
+    PSD_AR_MAX  = 1,          // max-hold over each row's records
+    PSD_AR_MEAN = 2           // dB mean over each row's records
+} psd_ar_mode_t;
+
+typedef struct {
+    int nbins;
+    int rows;
+    uint64_t matched;         // records inside [t0, t1]
+    double f_start_hz;
+    double df_hz;
+    double center_freq_hz;
+    char scale[16];
+    uint64_t *t_ns;           // rows
+    float *db;                // rows * nbins
+} psd_ar_result_t;
+
+/*
+  Records with t0 <= t <= t1, decimated to at most max_rows rows (row r takes
+  an equal share of the matched records). Segments outside the range are
+  skipped by name, the start/end inside a segment come from its sparse index
+  plus a binary search over at most PSD_AR_INDEX_EVERY records. Segments with
+  another bin count or format than the first match, or whose header does not
+  describe a valid record layout, are skipped. 0 = ok (rows may be 0).
+*/
+int  psd_ar_query(const char *dir, uint64_t t0, uint64_t t1, int max_rows,
+                  psd_ar_mode_t mode, psd_ar_result_t *res);
+void psd_ar_result_free(psd_ar_result_t *res);
+
+#endif
@@ -0,0 +1,213 @@
+//libs/psd_burst.c
+#include "psd_burst.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Linear PSD (50 ohm) -> dBm, same as scale_psd */
+static inline double lin_to_dbm(double p) {
+    return 10.0 * log10(fmax(p / 50.0, 1e-20) * 1000.0);
+}
+
+int psd_burst_open(psd_burst_t *b, const psd_burst_cfg_t *cfg, psd_burst_emit_fn emit, void *user) {
+    if (!b || !cfg || cfg->crop_len <= 0 || cfg->seg_period_s <= 0.0) return -1;
+    if (cfg->crop_start < 0 || cfg->crop_start + cfg->crop_len > cfg->nfft) return -1;
+
+    memset(b, 0, sizeof(*b));
+    b->cfg = *cfg;
+    b->emit = emit;
+    b->emit_user = user;
+    b->df = cfg->sample_rate_hz / cfg->nfft;
+
+    int n = cfg->crop_len;
+    if (cfg->chan_hz > 0.0) b->group = (int)lround(cfg->chan_hz / b->df);
+    else b->group = (n + PSD_BURST_AUTO_CHANNELS - 1) / PSD_BURST_AUTO_CHANNELS;
+    if (b->group < 1) b->group = 1;
+    if (b->group > n) b->group = n;
+    b->nch = (n + b->group - 1) / b->group;
+
+    double on_db = cfg->on_db > 0.0 ? cfg->on_db : 10.0;
+    double off_db = cfg->off_db > 0.0 ? fmin(cfg->off_db, on_db) : on_db - 4.0;
+    double tau = cfg->noise_tau_s > 0.0 ? cfg->noise_tau_s : 2.0;
+    double seg_ms = cfg->seg_period_s * 1e3;
+
+    b->on_ratio = (float)pow(10.0, on_db / 10.0);
+    b->off_ratio = (float)pow(10.0, off_db / 10.0);
+    b->alpha = (float)(1.0 - exp(-cfg->seg_period_s / tau));
+    b->min_on = (int)fmax(1.0, ceil(cfg->min_on_ms / seg_ms));
+    b->hang = (int)fmax(1.0, ceil(cfg->hang_ms / seg_ms));
+    b->seg_ns = (uint64_t)(cfg->seg_period_s * 1e9);
+
+    size_t m = (size_t)b->nch;
+    b->energy = (float*)malloc(m * sizeof(float));
+    b->noise = (float*)calloc(m, sizeof(float));
+    b->state = (uint8_t*)calloc(m, sizeof(uint8_t));
+    b->run = (uint32_t*)calloc(m, sizeof(uint32_t));
+    b->t_on = (uint64_t*)calloc(m, sizeof(uint64_t));
+    b->t_last = (uint64_t*)calloc(m, sizeof(uint64_t));
+    b->peak = (float*)calloc(m, sizeof(float));
+    b->peak_bin = (int*)calloc(m, sizeof(int));
+    b->msg = (char*)malloc(PSD_BURST_MSG_BYTES);
+    if (!b->energy || !b->noise || !b->state || !b->run || !b->t_on ||
+        !b->t_last || !b->peak || !b->peak_bin || !b->msg) {
+        psd_burst_close(b);
+        return -1;
+    }
+
+    fprintf(stderr, "[BURST] %d channels x %.0f Hz | on %.1f / off %.1f dB | min %d, hang %d frames (%.2f ms)\n",
+            b->nch, b->group * b->df, on_db, off_db, b->min_on, b->hang, seg_ms);
+    return 0;
+}
+
+void psd_burst_close(psd_burst_t *b) {
+    if (!b) return;
+    free(b->energy);
+    free(b->noise);
+    free(b->state);
+    free(b->run);
+    free(b->t_on);
+    free(b->t_last);
+    free(b->peak);
+    free(b->peak_bin);
+    free(b->msg);
+    memset(b, 0, sizeof(*b));
+}
+
+static void flush_msg(psd_burst_t *b) {
+    if (b->msg_len == 0) return;
+    snprintf(b->msg + b->msg_len, PSD_BURST_MSG_BYTES - b->msg_len, "]}");
+    if (b->emit) b->emit(b->emit_user, b->msg);
+    b->msg_len = 0;
+}
+
+static void add_event(psd_burst_t *b, int c, bool start, uint64_t t_ns) {
+    // worst case event below is ~220 bytes; keep room for the closing "]}"
+    if (b->msg_len + 256 > PSD_BURST_MSG_BYTES) flush_msg(b);
+    if (b->msg_len == 0) {
+        b->msg_len = (size_t)snprintf(b->msg, PSD_BURST_MSG_BYTES, "{\"t\":%llu,\"ev\":[",
+                                      (unsigned long long)t_ns);
+    } else {
+        b->msg[b->msg_len++] = ',';
+    }
+
+    const psd_burst_cfg_t *cfg = &b->cfg;
+    double f0 = cfg->center_freq_hz - cfg->sample_rate_hz / 2.0 + cfg->crop_start * b->df;
+    int first = c * b->group;
+    int len = (first + b->group <= cfg->crop_len) ? b->group : cfg->crop_len - first;
+    double center = f0 + (first + 0.5 * (len - 1)) * b->df;
+    double pk_f = f0 + b->peak_bin[c] * b->df;
+    double pk_dbm = lin_to_dbm(b->peak[c]);
+    double nf_dbm = lin_to_dbm(b->noise[c] / len);
+
+    char *p = b->msg + b->msg_len;
+    size_t room = PSD_BURST_MSG_BYTES - b->msg_len;
+    int w;
+    if (start) {
+        w = snprintf(p, room, "{\"type\":\"start\",\"ch\":%d,\"f\":%.0f,\"bw\":%.0f,\"t0\":%llu,"
+                     "\"pk_f\":%.0f,\"pk\":%.2f,\"nf\":%.2f}",
+                     c, center, len * b->df, (unsigned long long)b->t_on[c], pk_f, pk_dbm, nf_dbm);
+    } else {
+        uint64_t t1 = b->t_last[c] + b->seg_ns;
+        w = snprintf(p, room, "{\"type\":\"stop\",\"ch\":%d,\"f\":%.0f,\"bw\":%.0f,\"t0\":%llu,\"t1\":%llu,"
+                     "\"dur_ms\":%.3f,\"pk_f\":%.0f,\"pk\":%.2f,\"nf\":%.2f}",
+                     c, center, len * b->df, (unsigned long long)b->t_on[c], (unsigned long long)t1,
+                     (double)(t1 - b->t_on[c]) * 1e-6, pk_f, pk_dbm, nf_dbm);
+    }
+    if (w > 0) b->msg_len += ((size_t)w < room) ? (size_t)w : room - 1;
+    b->events++;
+}
+
+/* Track the strongest bin of channel c for the current burst */
+static void update_peak(psd_burst_t *b, const float *src, int c, bool reset) {
+    int first = c * b->group;
+    int last = first + b->group;
+    if (last > b->cfg.crop_len) last = b->cfg.crop_len;
+    if (reset) b->peak[c] = 0.0f;
+    for (int i = first; i < last; i++) {
+        if (src[i] > b->peak[c]) {
+            b->peak[c] = src[i];
+            b->peak_bin[c] = i;
+        }
+    }
+}
+
+void psd_burst_push_frame(psd_burst_t *b, const float *frame, int nbins, uint64_t t_ns) {
+    if (!b || !b->energy || nbins != b->cfg.nfft) return;
+
+    const float *src = &frame[b->cfg.crop_start];
+    int n = b->cfg.crop_len;
+    int g = b->group;
+
+    // Channel energy: contiguous sums over the span
+    for (int c = 0; c < b->nch; c++) {
+        const float *s = &src[c * g];
+        int len = (c * g + g <= n) ? g : n - c * g;
+        float acc = 0.0f;
+        #pragma omp simd reduction(+:acc)
+        for (int i = 0; i < len; i++) acc += s[i];
+        b->energy[c] = acc;
+    }
+
+    // single periodograms are noisy: average a few frames before detecting anything
+    if (b->frames < PSD_BURST_WARMUP) {
+        float w = 1.0f / (float)(++b->frames);
+        for (int c = 0; c < b->nch; c++) b->noise[c] += w * (b->energy[c] - b->noise[c]);
+        return;
+    }
+    b->frames++;
+
+    float on = b->on_ratio, off = b->off_ratio, a = b->alpha;
+    for (int c = 0; c < b->nch; c++) {
+        float e = b->energy[c];
+        float nz = b->noise[c];
+
+        switch (b->state[c]) {
+        case PSD_BURST_IDLE:
+            if (e > nz * on) {
+                b->state[c] = PSD_BURST_PENDING;
+                b->run[c] = 1;
+                b->t_on[c] = t_ns;
+                b->t_last[c] = t_ns;
+                update_peak(b, src, c, true);
+                if (b->min_on <= 1) {
+                    b->state[c] = PSD_BURST_ACTIVE;
+                    b->run[c] = 0;
+                    add_event(b, c, true, t_ns);
+                }
+            } else {
+                // idle: follow the noise, faster downwards so a burst start never inflates it
+                b->noise[c] = nz + ((e < nz) ? fminf(4.0f * a, 1.0f) : a) * (e - nz);
+            }
+            break;
+
+        case PSD_BURST_PENDING:
+            if (e > nz * off) {
+                b->t_last[c] = t_ns;
+                update_peak(b, src, c, false);
+                if (++b->run[c] >= (uint32_t)b->min_on) {
+                    b->state[c] = PSD_BURST_ACTIVE;
+                    b->run[c] = 0;
+                    add_event(b, c, true, t_ns);
+                }
+            } else {
+                b->state[c] = PSD_BURST_IDLE;   // shorter than min_on: no event
+            }
+            break;
+
+        case PSD_BURST_ACTIVE:
+            if (e > nz * off) {
+                b->t_last[c] = t_ns;
+                b->run[c] = 0;
+                update_peak(b, src, c, false);
+            } else if (++b->run[c] >= (uint32_t)b->hang) {
+                add_event(b, c, false, t_ns);
+                b->state[c] = PSD_BURST_IDLE;
+            }
+            break;
+        }
+    }
+
+    flush_msg(b);
+}
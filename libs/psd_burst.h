@@ -0,0 +1,79 @@
+//libs/psd_burst.h
+#ifndef PSD_BURST_H
+#define PSD_BURST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "datatypes.h"
+
+#define PSD_BURST_AUTO_CHANNELS 512    // channel count when chan_hz is not given
+#define PSD_BURST_MSG_BYTES    8192
+#define PSD_BURST_WARMUP       16     // frames averaged into the first noise estimate
+
+typedef enum {
+    PSD_BURST_IDLE = 0,
+    PSD_BURST_PENDING,        // above on_db, waiting for min_on
+    PSD_BURST_ACTIVE          // start sent; stop after hang frames below off_db
+} psd_burst_state_t;
+
+typedef struct {
+    double chan_hz;           // channel width (0 = span / PSD_BURST_AUTO_CHANNELS)
+    double on_db;             // start when channel energy > noise + on_db
+    double off_db;            // ... and keep going while > noise + off_db (hysteresis)
+    double min_on_ms;         // shorter bursts are dropped (0 = one frame)
+    double hang_ms;           // stop after this long below off_db (0 = one frame)
+    double noise_tau_s;       // noise estimate time constant (idle channels only)
+
+    int nfft;
+    int crop_start;
+    int crop_len;
+    double seg_period_s;
+    double center_freq_hz;
+    double sample_rate_hz;
+} psd_burst_cfg_t;
+
+/* Called with one JSON message per frame that has events */
+typedef void (*psd_burst_emit_fn)(void *user, const char *json);
+
+/**
+ * Start/stop detector on the per-segment frames (linear, fftshift order).
+ * The span is split into channels; each channel's energy is tracked against
+ * its own noise estimate, so an event is known one FFT frame after it happens.
+ * Single-threaded (frame hook of the PSD thread).
+ */
+typedef struct {
+    psd_burst_cfg_t cfg;
+    int nch;
+    int group;                // bins per channel
+    double df;
+
+    int min_on;               // frames
+    int hang;                 // frames
+    float on_ratio;
+    float off_ratio;
+    float alpha;              // noise EMA weight per idle frame
+
+    float *energy;
+    float *noise;
+    uint8_t *state;
+    uint32_t *run;            // frames above (pending) / below (active)
+    uint64_t *t_on;
+    uint64_t *t_last;         // last frame above off_db
+    float *peak;              // burst peak (linear bin)
+    int *peak_bin;
+
+    uint64_t frames;
+    uint64_t seg_ns;
+    uint64_t events;
+
+    char *msg;
+    size_t msg_len;
+    psd_burst_emit_fn emit;
+    void *emit_user;
+} psd_burst_t;
+
+int  psd_burst_open(psd_burst_t *b, const psd_burst_cfg_t *cfg, psd_burst_emit_fn emit, void *user);
+void psd_burst_close(psd_burst_t *b);
+void psd_burst_push_frame(psd_burst_t *b, const float *frame, int nbins, uint64_t t_ns);
+
+#endif
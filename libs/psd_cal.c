@@ -0,0 +1,225 @@
+//libs/psd_cal.c
+#include "psd_cal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+    int bb;
+    double key;
+    double x;
+    double y;
+} cal_row_t;
+
+static int cmp_row(const void *a, const void *b) {
+    const cal_row_t *ra = (const cal_row_t*)a, *rb = (const cal_row_t*)b;
+    if (ra->bb != rb->bb) return ra->bb - rb->bb;
+    if (ra->key != rb->key) return ra->key < rb->key ? -1 : 1;
+    if (ra->x != rb->x) return ra->x < rb->x ? -1 : 1;
+    return 0;
+}
+
+void psd_cal_free(psd_cal_t *cal) {
+    if (!cal) return;
+    free(cal->pts);
+    free(cal->rf);
+    free(cal->bb);
+    for (int i = 0; i < PSD_CAL_CACHE; i++) free(cal->cache[i].db);
+    memset(cal, 0, sizeof(*cal));
+}
+
+int psd_cal_load(psd_cal_t *cal, const char *path) {
+    if (!cal || !path) return -1;
+    memset(cal, 0, sizeof(*cal));
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror("[CAL] open");
+        return -1;
+    }
+
+    cal_row_t *rows = NULL;
+    int n = 0, cap = 0, line_no = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *s = line;
+        while (*s == ' ' || *s == '\t') s++;
+        if (*s == '#' || *s == '\n' || *s == '\r' || *s == '\0') continue;
+
+        char kind[8];
+        cal_row_t r;
+        if (sscanf(s, "%7[^,],%lf,%lf,%lf", kind, &r.key, &r.x, &r.y) != 4 ||
+            (strcmp(kind, "rf") != 0 && strcmp(kind, "bb") != 0)) {
+            fprintf(stderr, "[CAL] %s:%d ignored\n", path, line_no);
+            continue;
+        }
+        if (strcmp(kind, "rf") == 0) {
+            // rf rows are freq,gain: the curve key is the gain
+            double f = r.key;
+            r.key = r.x;
+            r.x = f;
+            r.bb = 0;
+        } else {
+            r.bb = 1;
+        }
+        if (n == cap) {
+            cap = cap ? 2 * cap : 256;
+            cal_row_t *t = (cal_row_t*)realloc(rows, (size_t)cap * sizeof(*rows));
+            if (!t) {
+                free(rows);
+                fclose(fp);
+                return -1;
+            }
+            rows = t;
+        }
+        rows[n++] = r;
+    }
+    fclose(fp);
+
+    if (n == 0) {
+        fprintf(stderr, "[CAL] %s: no rows\n", path);
+        free(rows);
+        return -1;
+    }
+    qsort(rows, (size_t)n, sizeof(*rows), cmp_row);
+
+    cal->pts = (psd_cal_pt_t*)malloc((size_t)n * sizeof(psd_cal_pt_t));
+    cal->rf = (psd_cal_curve_t*)calloc((size_t)n, sizeof(psd_cal_curve_t));
+    cal->bb = (psd_cal_curve_t*)calloc((size_t)n, sizeof(psd_cal_curve_t));
+    if (!cal->pts || !cal->rf || !cal->bb) {
+        free(rows);
+        psd_cal_free(cal);
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        cal->pts[i].x = rows[i].x;
+        cal->pts[i].y = rows[i].y;
+        bool bb = rows[i].bb != 0;
+        psd_cal_curve_t *cv = bb ? cal->bb : cal->rf;
+        int *nc = bb ? &cal->n_bb : &cal->n_rf;
+        if (*nc == 0 || cv[*nc - 1].key != rows[i].key) {
+            cv[*nc].key = rows[i].key;
+            cv[*nc].start = i;
+            (*nc)++;
+        }
+        cv[*nc - 1].n++;
+    }
+    cal->npts = n;
+    free(rows);
+
+    fprintf(stderr, "[CAL] %s: %d points | %d RF gain curves | %d baseband curves\n",
+            path, n, cal->n_rf, cal->n_bb);
+    return 0;
+}
+
+/* Curve value at x for ascending x: *h walks forward (start it at 0) */
+static double curve_walk(const psd_cal_t *cal, const psd_cal_curve_t *cv, double x, int *h) {
+    const psd_cal_pt_t *p = &cal->pts[cv->start];
+    int n = cv->n;
+    if (x <= p[0].x) return p[0].y;
+    if (x >= p[n - 1].x) return p[n - 1].y;
+    while (*h + 1 < n - 1 && p[*h + 1].x <= x) (*h)++;
+    while (*h > 0 && p[*h].x > x) (*h)--;
+    const psd_cal_pt_t *a = &p[*h], *b = &p[*h + 1];
+    double w = (b->x > a->x) ? (x - a->x) / (b->x - a->x) : 0.0;
+    return a->y + w * (b->y - a->y);
+}
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static uint64_t tuning_key(const psd_cal_tuning_t *t, const double *freq_rel, int n) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    int amp = t->amp_enabled ? 1 : 0;
+    h = fnv1a(h, &t->center_freq_hz, sizeof(t->center_freq_hz));
+    h = fnv1a(h, &t->sample_rate_hz, sizeof(t->sample_rate_hz));
+    h = fnv1a(h, &t->lna_gain, sizeof(t->lna_gain));
+    h = fnv1a(h, &t->vga_gain, sizeof(t->vga_gain));
+    h = fnv1a(h, &amp, sizeof(amp));
+    h = fnv1a(h, &n, sizeof(n));
+    h = fnv1a(h, &freq_rel[0], sizeof(double));
+    h = fnv1a(h, &freq_rel[n - 1], sizeof(double));
+    return h ? h : 1;
+}
+
+static void cal_compute(const psd_cal_t *cal, const psd_cal_tuning_t *t, const double *freq_rel, int n,
+                        double *out) {
+    // RF: the two gain curves around the nominal gain
+    double g = t->lna_gain + t->vga_gain + (t->amp_enabled ? PSD_CAL_AMP_DB : 0.0);
+    const psd_cal_curve_t *ra = NULL, *rb = NULL;
+    double w = 0.0;
+    if (cal->n_rf > 0) {
+        int k = 0;
+        while (k + 1 < cal->n_rf && cal->rf[k + 1].key <= g) k++;
+        ra = rb = &cal->rf[k];
+        if (g > ra->key && k + 1 < cal->n_rf) {
+            rb = &cal->rf[k + 1];
+            w = (g - ra->key) / (rb->key - ra->key);
+        }
+    }
+
+    // baseband: nearest sample rate, offsets scaled to it
+    const psd_cal_curve_t *bc = NULL;
+    double bscale = 1.0;
+    for (int k = 0; k < cal->n_bb; k++) {
+        if (!bc || fabs(cal->bb[k].key - t->sample_rate_hz) < fabs(bc->key - t->sample_rate_hz)) bc = &cal->bb[k];
+    }
+    if (bc && t->sample_rate_hz > 0.0) bscale = bc->key / t->sample_rate_hz;
+
+    int ha = 0, hb = 0, hc = 0;
+    double f_lo = (double)t->center_freq_hz;
+    for (int i = 0; i < n; i++) {
+        double v = 0.0;
+        if (ra) {
+            double f = f_lo + freq_rel[i];
+            v = curve_walk(cal, ra, f, &ha);
+            if (rb != ra) v += w * (curve_walk(cal, rb, f, &hb) - v);
+        }
+        if (bc) v += curve_walk(cal, bc, freq_rel[i] * bscale, &hc);
+        out[i] = v;
+    }
+}
+
+const double* psd_cal_vector(psd_cal_t *cal, const psd_cal_tuning_t *tun, const double *freq_rel, int n) {
+    if (!cal || !cal->pts || !tun || !freq_rel || n <= 0) return NULL;
+
+    uint64_t key = tuning_key(tun, freq_rel, n);
+    psd_cal_entry_t *lru = &cal->cache[0];
+    cal->tick++;
+    for (int i = 0; i < PSD_CAL_CACHE; i++) {
+        psd_cal_entry_t *e = &cal->cache[i];
+        if (e->key == key && e->n == n) {
+            e->last_use = cal->tick;
+            cal->hits++;
+            return e->db;
+        }
+        if (e->last_use < lru->last_use) lru = e;
+    }
+
+    if (lru->n != n) {
+        free(lru->db);
+        lru->db = (double*)malloc((size_t)n * sizeof(double));
+        lru->n = lru->db ? n : 0;
+        if (!lru->db) {
+            lru->key = 0;
+            return NULL;
+        }
+    }
+    cal_compute(cal, tun, freq_rel, n, lru->db);
+    lru->key = key;
+    lru->last_use = cal->tick;
+    cal->misses++;
+
+    fprintf(stderr, "[CAL] vector for %.3f MHz, gain %d/%d%s: %.2f .. %.2f dB\n",
+            tun->center_freq_hz / 1e6, tun->lna_gain, tun->vga_gain, tun->amp_enabled ? "+amp" : "",
+            lru->db[0], lru->db[n - 1]);
+    return lru->db;
+}
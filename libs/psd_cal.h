@@ -0,0 +1,82 @@
+//libs/psd_cal.h
+#ifndef PSD_CAL_H
+#define PSD_CAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Calibration table (CSV, '#' comments). Two kinds of rows, any order:
+
+    rf,<freq_hz>,<gain_db>,<corr_db>       RF response: absolute frequency x nominal
+                                           gain (lna + vga + 14 dB if the amp is on)
+    bb,<sample_rate_hz>,<offset_hz>,<corr_db>
+                                           baseband / filter shape: offset from the LO
+                                           at that sample rate
+
+  corr_db is what has to be added to the ideal-50-ohm reading to get the
+  true level. A bin's correction is rf(f_abs, gain) + bb(f - f_LO): linear
+  in frequency inside each curve (held flat past its ends), linear between
+  the two gain curves around the current gain, and from the baseband curve
+  of the nearest sample rate with the offset scaled to the current rate.
+*/
+
+#define PSD_CAL_CACHE 8
+#define PSD_CAL_AMP_DB 14.0
+
+typedef struct {
+    double x;
+    double y;
+} psd_cal_pt_t;
+
+typedef struct {
+    double key;               // gain_db (rf) / sample rate (bb)
+    int start;                // into pts[], sorted by x
+    int n;
+} psd_cal_curve_t;
+
+/* Tuning the correction depends on */
+typedef struct {
+    uint64_t center_freq_hz;  // LO
+    double sample_rate_hz;    // SDR rate (sets the baseband filter)
+    int lna_gain;
+    int vga_gain;
+    bool amp_enabled;
+} psd_cal_tuning_t;
+
+typedef struct {
+    uint64_t key;             // 0 = empty
+    uint64_t last_use;
+    int n;
+    double *db;
+} psd_cal_entry_t;
+
+/**
+ * Loaded table + the last PSD_CAL_CACHE correction vectors, keyed on a hash
+ * of the tuning and the frequency axis. Retuning back to a known
+ * configuration costs a lookup; only new ones are interpolated.
+ */
+typedef struct {
+    psd_cal_pt_t *pts;
+    int npts;
+    psd_cal_curve_t *rf;      // sorted by gain
+    int n_rf;
+    psd_cal_curve_t *bb;      // sorted by sample rate
+    int n_bb;
+
+    psd_cal_entry_t cache[PSD_CAL_CACHE];
+    uint64_t tick;
+    uint64_t hits;
+    uint64_t misses;
+} psd_cal_t;
+
+int  psd_cal_load(psd_cal_t *cal, const char *path);
+void psd_cal_free(psd_cal_t *cal);
+
+/*
+  Per-bin correction (dB) for n bins at freq_rel[] (offset from the LO,
+  ascending). Owned by the cache: valid until the next call. NULL on error.
+*/
+const double* psd_cal_vector(psd_cal_t *cal, const psd_cal_tuning_t *tun, const double *freq_rel, int n);
+
+#endif
@@ -0,0 +1,151 @@
+//libs/psd_detect.c
+#include "psd_detect.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PSD_DETECT_JSON_CH_BYTES 96
+
+int psd_detect_init(psd_detector_t *d, const psd_detect_cfg_t *cfg) {
+    if (!d) return -1;
+    memset(d, 0, sizeof(*d));
+    if (cfg) d->cfg = *cfg;
+    if (d->cfg.res_db <= 0.0) d->cfg.res_db = 0.5;
+    if (d->cfg.percentile <= 0.0 || d->cfg.percentile > 100.0) d->cfg.percentile = 50.0;
+    if (d->cfg.delta_db <= 0.0) d->cfg.delta_db = 15.0;
+    if (d->cfg.gap_bins < 0) d->cfg.gap_bins = 1;
+    if (d->cfg.min_bins < 1) d->cfg.min_bins = 1;
+
+    d->hist = (uint32_t*)malloc(PSD_DETECT_MAX_HIST * sizeof(uint32_t));
+    d->ch = (psd_channel_t*)malloc(PSD_DETECT_MAX_CHANNELS * sizeof(psd_channel_t));
+    if (!d->hist || !d->ch) {
+        psd_detect_free(d);
+        return -1;
+    }
+    return 0;
+}
+
+void psd_detect_free(psd_detector_t *d) {
+    if (!d) return;
+    free(d->hist);
+    free(d->ch);
+    memset(d, 0, sizeof(*d));
+}
+
+/*
+  Noise floor: bins below the requested percentile, then the most populated
+  res_db cell among them. One counting histogram over [min, max] gives both
+  the percentile and the mode.
+*/
+static double noise_floor(psd_detector_t *d, const double *x, int n) {
+    double lo = x[0], hi = x[0];
+    for (int i = 1; i < n; i++) {
+        lo = fmin(lo, x[i]);
+        hi = fmax(hi, x[i]);
+    }
+
+    double res = d->cfg.res_db;
+    int nb = (int)ceil((hi - lo) / res) + 1;
+    if (nb > PSD_DETECT_MAX_HIST) {
+        nb = PSD_DETECT_MAX_HIST;
+        res = (hi - lo) / (nb - 1);
+    }
+
+    uint32_t *h = d->hist;
+    memset(h, 0, (size_t)nb * sizeof(uint32_t));
+    double inv = 1.0 / res;
+    for (int i = 0; i < n; i++) h[(int)((x[i] - lo) * inv)]++;
+
+    // percentile cell, then the mode at or below it
+    uint64_t target = (uint64_t)ceil(d->cfg.percentile / 100.0 * n);
+    uint64_t cum = 0;
+    int kp = nb - 1;
+    for (int k = 0; k < nb; k++) {
+        cum += h[k];
+        if (cum >= target) { kp = k; break; }
+    }
+    if (cum < 10) {
+        // too few samples below the percentile: median (as the Python reference)
+        uint64_t half = (uint64_t)(n + 1) / 2;
+        cum = 0;
+        for (int k = 0; k < nb; k++) {
+            cum += h[k];
+            if (cum >= half) return lo + (k + 0.5) * res;
+        }
+    }
+
+    int best = 0;
+    for (int k = 1; k <= kp; k++) {
+        if (h[k] > h[best]) best = k;
+    }
+    return lo + (best + 0.5) * res;
+}
+
+static void close_channel(psd_detector_t *d, const double *freq, const double *x, int a, int b, double df) {
+    if (b - a + 1 < d->cfg.min_bins || d->n_ch >= PSD_DETECT_MAX_CHANNELS) return;
+
+    double sw = 0.0, swf = 0.0;
+    int pk = a;
+    for (int i = a; i <= b; i++) {
+        double w = exp(x[i] * (M_LN10 / 10.0));
+        sw += w;
+        swf += w * freq[i];
+        if (x[i] > x[pk]) pk = i;
+    }
+
+    psd_channel_t *c = &d->ch[d->n_ch++];
+    c->center_hz = swf / (sw + 1e-300);
+    c->bw_hz = (b - a + 1) * df;
+    c->peak_hz = freq[pk];
+    c->peak_db = x[pk];
+    c->snr_db = x[pk] - d->noise_floor_db;
+    c->start = a;
+    c->len = b - a + 1;
+}
+
+int psd_detect_run(psd_detector_t *d, const double *freq, const double *psd_db, int n) {
+    if (!d || !d->hist || !freq || !psd_db || n <= 0) return -1;
+
+    d->n_ch = 0;
+    d->noise_floor_db = noise_floor(d, psd_db, n);
+    d->threshold_db = d->noise_floor_db + d->cfg.delta_db;
+
+    double df = (n > 1) ? freq[1] - freq[0] : 0.0;
+    double thr = d->threshold_db;
+    int gap = d->cfg.gap_bins;
+
+    // runs above threshold; a gap of <= gap_bins between two runs joins them
+    int start = -1, last = -1;
+    for (int i = 0; i < n; i++) {
+        if (psd_db[i] <= thr) continue;
+        if (start >= 0 && i - last - 1 > gap) {
+            close_channel(d, freq, psd_db, start, last, df);
+            start = -1;
+        }
+        if (start < 0) start = i;
+        last = i;
+    }
+    if (start >= 0) close_channel(d, freq, psd_db, start, last, df);
+
+    return d->n_ch;
+}
+
+size_t psd_detect_json_cap(void) {
+    return 128 + (size_t)PSD_DETECT_MAX_CHANNELS * PSD_DETECT_JSON_CH_BYTES;
+}
+
+int psd_detect_json(const psd_detector_t *d, uint64_t t_ns, double f_ref_hz, char *buf, size_t cap) {
+    if (!d || !buf || cap < 128) return -1;
+
+    size_t pos = (size_t)snprintf(buf, cap, "{\"t\":%llu,\"nf\":%.2f,\"thr\":%.2f,\"ch\":[",
+                                  (unsigned long long)t_ns, d->noise_floor_db, d->threshold_db);
+    for (int k = 0; k < d->n_ch && pos + PSD_DETECT_JSON_CH_BYTES < cap; k++) {
+        const psd_channel_t *c = &d->ch[k];
+        pos += (size_t)snprintf(buf + pos, cap - pos, "%s[%.0f,%.0f,%.0f,%.2f,%.2f]",
+                                k ? "," : "", f_ref_hz + c->center_hz, c->bw_hz, f_ref_hz + c->peak_hz,
+                                c->peak_db, c->snr_db);
+    }
+    pos += (size_t)snprintf(buf + pos, cap - pos, "]}");
+    return (int)pos;
+}
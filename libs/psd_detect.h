@@ -0,0 +1,58 @@
+//libs/psd_detect.h
+#ifndef PSD_DETECT_H
+#define PSD_DETECT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "datatypes.h"
+
+#define PSD_DETECT_MAX_HIST     4096   // histogram bins (resolution widens past this)
+#define PSD_DETECT_MAX_CHANNELS 256
+
+typedef struct {
+    double res_db;            // noise histogram resolution (0 = 0.5 dB)
+    double percentile;        // noise floor = mode of the bins below this percentile (0 = 50)
+    double delta_db;          // detection threshold above the noise floor (0 = 15 dB)
+    int gap_bins;             // close gaps up to this many bins inside one channel (< 0 = 1)
+    int min_bins;             // drop channels narrower than this
+} psd_detect_cfg_t;
+
+typedef struct {
+    double center_hz;         // power-weighted centroid
+    double bw_hz;             // occupied bins * df
+    double peak_hz;
+    double peak_db;
+    double snr_db;            // peak over the noise floor
+    int start;                // first / number of bins in the input
+    int len;
+} psd_channel_t;
+
+/**
+ * Noise floor + channel extraction on a dB trace, same algorithm as
+ * escale_pro_sd.py (percentile -> histogram mode, threshold, gap fill,
+ * centroids) but in one pass per stage and without sorting.
+ * Buffers are sized once; psd_detect_run does not allocate.
+ */
+typedef struct {
+    psd_detect_cfg_t cfg;
+    uint32_t *hist;
+    psd_channel_t *ch;
+    int n_ch;
+    double noise_floor_db;
+    double threshold_db;
+} psd_detector_t;
+
+int  psd_detect_init(psd_detector_t *d, const psd_detect_cfg_t *cfg);
+void psd_detect_free(psd_detector_t *d);
+
+/* freq/psd_db: n bins of one published trace. Returns channels found (d->ch), -1 on bad input */
+int  psd_detect_run(psd_detector_t *d, const double *freq, const double *psd_db, int n);
+
+/*
+  Compact JSON of the last run, frequencies shifted by f_ref_hz (LO for a relative axis):
+  {"t","nf","thr","ch":[[center_hz,bw_hz,peak_hz,peak_db,snr_db],...]}
+*/
+int  psd_detect_json(const psd_detector_t *d, uint64_t t_ns, double f_ref_hz, char *buf, size_t cap);
+size_t psd_detect_json_cap(void);
+
+#endif
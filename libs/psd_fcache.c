@@ -0,0 +1,105 @@
+//libs/psd_fcache.c
+#include "psd_fcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int psd_fcache_open(psd_fcache_t *c, int nbins, double seconds, double seg_period_s, int max_mb) {
+    if (!c || nbins <= 0 || seconds <= 0.0 || seg_period_s <= 0.0) return -1;
+    memset(c, 0, sizeof(*c));
+
+    if (max_mb <= 0) max_mb = PSD_FCACHE_DEFAULT_MB;
+    double want = ceil(seconds / seg_period_s);
+    double fit = floor((double)max_mb * 1024.0 * 1024.0 / ((double)nbins * sizeof(float)));
+    if (fit < 1.0) {
+        fprintf(stderr, "[FCACHE] %d bins do not fit in %d MB\n", nbins, max_mb);
+        return -1;
+    }
+    if (want > fit) {
+        fprintf(stderr, "[FCACHE] %.1f s requested, capped to %.1f s by max_mb=%d\n",
+                seconds, fit * seg_period_s, max_mb);
+        want = fit;
+    }
+
+    c->nbins = nbins;
+    c->capacity = (int)want;
+    c->frames = (float*)malloc((size_t)c->capacity * (size_t)nbins * sizeof(float));
+    c->t_ns = (uint64_t*)calloc((size_t)c->capacity, sizeof(uint64_t));
+    if (!c->frames || !c->t_ns) {
+        psd_fcache_close(c);
+        return -1;
+    }
+
+    fprintf(stderr, "[FCACHE] %d frames x %d bins (%.1f MB, %.2f s)\n",
+            c->capacity, nbins,
+            (double)c->capacity * nbins * sizeof(float) / (1024.0 * 1024.0),
+            c->capacity * seg_period_s);
+    return 0;
+}
+
+void psd_fcache_close(psd_fcache_t *c) {
+    if (!c) return;
+    free(c->frames);
+    free(c->t_ns);
+    memset(c, 0, sizeof(*c));
+}
+
+void psd_fcache_reset(psd_fcache_t *c) {
+    c->written = 0;
+}
+
+void psd_fcache_push(psd_fcache_t *c, const float *frame, int nbins, uint64_t t_ns) {
+    if (!c->frames || nbins != c->nbins) return;
+    int slot = (int)(c->written % (uint64_t)c->capacity);
+    memcpy(&c->frames[(size_t)slot * c->nbins], frame, (size_t)nbins * sizeof(float));
+    c->t_ns[slot] = t_ns;
+    c->written++;
+}
+
+int psd_fcache_query(const psd_fcache_t *c, double window_s, double age_s, psd_fc_mode_t mode,
+                     int bin_start, int bin_len, double *out, uint64_t *t_last_out) {
+    if (!c->frames || c->written == 0) return 0;
+    if (bin_start < 0 || bin_len <= 0 || bin_start + bin_len > c->nbins) return 0;
+
+    uint64_t avail = c->written < (uint64_t)c->capacity ? c->written : (uint64_t)c->capacity;
+    uint64_t newest = c->written - 1;
+    uint64_t t_newest = c->t_ns[newest % (uint64_t)c->capacity];
+
+    uint64_t t_end = t_newest - (uint64_t)(age_s > 0.0 ? age_s * 1e9 : 0.0);
+    uint64_t t_begin = (window_s > 0.0 && (double)t_end > window_s * 1e9)
+                           ? t_end - (uint64_t)(window_s * 1e9) : 0;
+
+    int used = 0;
+    uint64_t t_last = 0;
+
+    // newest -> oldest; timestamps are monotonic along the ring
+    for (uint64_t k = 0; k < avail; k++) {
+        uint64_t idx = newest - k;
+        int slot = (int)(idx % (uint64_t)c->capacity);
+        uint64_t t = c->t_ns[slot];
+        if (t > t_end) continue;
+        if (t < t_begin) break;
+
+        const float *f = &c->frames[(size_t)slot * c->nbins + bin_start];
+        if (used == 0) {
+            for (int i = 0; i < bin_len; i++) out[i] = f[i];
+            t_last = t;
+        } else if (mode == PSD_FC_MAX) {
+            for (int i = 0; i < bin_len; i++) out[i] = fmax(out[i], (double)f[i]);
+        } else if (mode == PSD_FC_MIN) {
+            for (int i = 0; i < bin_len; i++) out[i] = fmin(out[i], (double)f[i]);
+        } else {
+            #pragma omp simd
+            for (int i = 0; i < bin_len; i++) out[i] += f[i];
+        }
+        used++;
+    }
+
+    if (used > 1 && mode == PSD_FC_MEAN) {
+        double inv = 1.0 / used;
+        for (int i = 0; i < bin_len; i++) out[i] *= inv;
+    }
+    if (t_last_out) *t_last_out = t_last;
+    return used;
+}
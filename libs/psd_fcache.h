@@ -0,0 +1,42 @@
+//libs/psd_fcache.h
+#ifndef PSD_FCACHE_H
+#define PSD_FCACHE_H
+
+#include <stdint.h>
+#include "datatypes.h"
+
+typedef enum {
+    PSD_FC_MEAN,    // power average (Welch over the window)
+    PSD_FC_MAX,     // max-hold over the window
+    PSD_FC_MIN
+} psd_fc_mode_t;
+
+/**
+ * Bounded ring of per-segment linear PSD frames (float32, fftshift order) as
+ * emitted by the Welch engine frame hook. Lets a PSD be re-averaged over a
+ * different window, mode or span without a new capture.
+ * Single-threaded: pushes and queries come from the PSD thread.
+ */
+typedef struct {
+    int nbins;
+    int capacity;             // frames
+    float *frames;            // capacity * nbins
+    uint64_t *t_ns;           // timestamp of each slot
+    uint64_t written;         // frames pushed since open/reset
+} psd_fcache_t;
+
+/* Room for `seconds` of frames at one frame per seg_period_s, capped at max_mb */
+int  psd_fcache_open(psd_fcache_t *c, int nbins, double seconds, double seg_period_s, int max_mb);
+void psd_fcache_close(psd_fcache_t *c);
+void psd_fcache_reset(psd_fcache_t *c);
+void psd_fcache_push(psd_fcache_t *c, const float *frame, int nbins, uint64_t t_ns);
+
+/*
+  Combine the frames with t in [t_end - window_s, t_end], t_end = newest - age_s
+  (window_s <= 0: everything cached), bins [bin_start, bin_start + bin_len).
+  out[0..bin_len) is linear PSD. Returns frames used (0 = none in the window).
+*/
+int  psd_fcache_query(const psd_fcache_t *c, double window_s, double age_s, psd_fc_mode_t mode,
+                      int bin_start, int bin_len, double *out, uint64_t *t_last_out);
+
+#endif
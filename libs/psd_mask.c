@@ -0,0 +1,214 @@
+//libs/psd_mask.c
+#include "psd_mask.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static uint64_t mask_hash(const MaskCfg_t *cfg, const psd_mask_geom_t *g) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = fnv1a(h, &cfg->relative, sizeof(cfg->relative));
+    h = fnv1a(h, &cfg->carrier_hz, sizeof(cfg->carrier_hz));
+    h = fnv1a(h, &cfg->report_ms, sizeof(cfg->report_ms));
+    h = fnv1a(h, &cfg->n_points, sizeof(cfg->n_points));
+    h = fnv1a(h, cfg->f_hz, (size_t)cfg->n_points * sizeof(double));
+    h = fnv1a(h, cfg->level_db, (size_t)cfg->n_points * sizeof(double));
+    h = fnv1a(h, &g->nfft, sizeof(g->nfft));
+    h = fnv1a(h, &g->crop_start, sizeof(g->crop_start));
+    h = fnv1a(h, &g->crop_len, sizeof(g->crop_len));
+    h = fnv1a(h, &g->f_start_hz, sizeof(g->f_start_hz));
+    h = fnv1a(h, &g->df_hz, sizeof(g->df_hz));
+    h = fnv1a(h, &g->center_freq_hz, sizeof(g->center_freq_hz));
+    if (g->scale) h = fnv1a(h, g->scale, strlen(g->scale));
+    return h | 1;   // never 0 (= empty)
+}
+
+/* Mask level unit -> dBm offset (same constants as scale_psd) */
+static double unit_offset_db(const char *scale) {
+    if (scale && strcmp(scale, "dBuV") == 0) return 107.0;
+    if (scale && strcmp(scale, "dBmV") == 0) return 47.0;
+    return 0.0;
+}
+
+void psd_mask_free(psd_mask_t *m) {
+    if (!m) return;
+    free(m->inv_thr);
+    free(m->bits);
+    free(m->msg);
+    memset(m, 0, sizeof(*m));
+}
+
+int psd_mask_compile(psd_mask_t *m, const MaskCfg_t *cfg, const psd_mask_geom_t *geom,
+                     psd_mask_emit_fn emit, void *user) {
+    if (!m || !cfg || !geom || !cfg->valid || cfg->n_points < 2) return -1;
+    if (geom->crop_len <= 0 || geom->df_hz <= 0.0) return -1;
+    for (int k = 1; k < cfg->n_points; k++) {
+        if (cfg->f_hz[k] < cfg->f_hz[k - 1]) {
+            fprintf(stderr, "[MASK] points must be sorted by frequency\n");
+            return -1;
+        }
+    }
+
+    uint64_t h = mask_hash(cfg, geom);
+    if (h == m->hash) return 0;
+
+    int n = geom->crop_len;
+    int nwords = (n + 63) / 64;
+    float *inv = (float*)malloc((size_t)n * sizeof(float));
+    uint64_t *bits = (uint64_t*)calloc((size_t)nwords, sizeof(uint64_t));
+    char *msg = m->msg ? m->msg : (char*)malloc(PSD_MASK_MSG_BYTES);
+    if (!inv || !bits || !msg) {
+        free(inv);
+        free(bits);
+        if (msg != m->msg) free(msg);
+        return -1;
+    }
+
+    double f_ref = cfg->relative ? (cfg->carrier_hz > 0.0 ? cfg->carrier_hz : geom->center_freq_hz) : 0.0;
+    double off = unit_offset_db(geom->scale);
+    const double *pf = cfg->f_hz;
+    const double *pl = cfg->level_db;
+    int last = cfg->n_points - 1;
+    int limited = 0;
+
+    // bins walk up in frequency, so the segment pointer only moves forward
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        double f = geom->f_start_hz + i * geom->df_hz - f_ref;
+        if (f < pf[0] || f > pf[last]) {
+            inv[i] = 0.0f;
+            continue;
+        }
+        while (k < last - 1 && f > pf[k + 1]) k++;
+        // on a vertical step (equal frequencies) the stricter side wins
+        double level;
+        if (pf[k + 1] == pf[k]) level = fmin(pl[k], pl[k + 1]);
+        else level = pl[k] + (pl[k + 1] - pl[k]) * (f - pf[k]) / (pf[k + 1] - pf[k]);
+        if (f == pf[k + 1] && k + 2 <= last && pf[k + 2] == pf[k + 1]) level = fmin(level, pl[k + 2]);
+
+        double thr = pow(10.0, (level - off) / 10.0) * 50.0 / 1000.0;   // dBm -> linear PSD
+        inv[i] = (float)(1.0 / thr);
+        limited++;
+    }
+
+    free(m->inv_thr);
+    free(m->bits);
+    m->inv_thr = inv;
+    m->bits = bits;
+    m->msg = msg;
+    m->hash = h;
+    m->geom = *geom;
+    m->geom.scale = NULL;     // not owned
+    m->n = n;
+    m->nwords = nwords;
+    m->emit = emit;
+    m->emit_user = user;
+    m->alarm = false;
+    m->frames = 0;
+    m->viol_frames = 0;
+    m->last_report = 0;
+    m->report_ns = (uint64_t)((cfg->report_ms > 0.0 ? cfg->report_ms : 1000.0) * 1e6);
+
+    fprintf(stderr, "[MASK] compiled %d points -> %d/%d bins limited (%s, hash %016llx)\n",
+            cfg->n_points, limited, n, cfg->relative ? "relative" : "absolute",
+            (unsigned long long)h);
+    return 1;
+}
+
+static void emit_report(psd_mask_t *m, const char *state, uint64_t t_ns) {
+    const psd_mask_geom_t *g = &m->geom;
+    char *p = m->msg;
+    size_t cap = PSD_MASK_MSG_BYTES;
+    char worst[32] = "null";   // no bin under a limit carries energy
+    if (isfinite(m->worst_margin_db)) snprintf(worst, sizeof(worst), "%.2f", m->worst_margin_db);
+    size_t pos = (size_t)snprintf(p, cap,
+        "{\"t\":%llu,\"state\":\"%s\",\"bins\":%d,\"worst_db\":%s,\"worst_f\":%.0f,"
+        "\"frames\":%llu,\"viol_frames\":%llu,\"ranges\":[",
+        (unsigned long long)t_ns, state, m->n_viol, worst,
+        g->f_start_hz + m->worst_bin * g->df_hz,
+        (unsigned long long)m->frames, (unsigned long long)m->viol_frames);
+
+    // violating runs straight from the bitmap
+    int listed = 0;
+    int i = 0;
+    while (i < m->n && listed < PSD_MASK_MAX_RANGES) {
+        uint64_t w = m->bits[i >> 6] >> (i & 63);
+        if (!w) {
+            i = (i | 63) + 1;
+            continue;
+        }
+        i += __builtin_ctzll(w);
+        int a = i;
+        while (i < m->n && ((m->bits[i >> 6] >> (i & 63)) & 1)) i++;
+        pos += (size_t)snprintf(p + pos, cap - pos, "%s[%.0f,%.0f]", listed ? "," : "",
+                                g->f_start_hz + a * g->df_hz, g->f_start_hz + (i - 1) * g->df_hz);
+        listed++;
+    }
+    snprintf(p + pos, cap - pos, "]}");
+
+    if (m->emit) m->emit(m->emit_user, p);
+    m->last_report = t_ns;
+}
+
+void psd_mask_push_frame(psd_mask_t *m, const float *frame, int nbins, uint64_t t_ns) {
+    if (!m || !m->inv_thr || nbins != m->geom.nfft) return;
+
+    const float *src = &frame[m->geom.crop_start];
+    const float *inv = m->inv_thr;
+    int n = m->n;
+
+    // one pass: level / limit ratio -> bitmap word + worst ratio per 64 bins
+    int n_viol = 0;
+    int worst_word = 0;
+    float worst = 0.0f;
+    for (int w = 0; w < m->nwords; w++) {
+        int base = w * 64;
+        int len = (base + 64 <= n) ? 64 : n - base;
+        uint64_t word = 0;
+        float wr = 0.0f;
+        #pragma omp simd reduction(|:word) reduction(max:wr)
+        for (int j = 0; j < len; j++) {
+            float r = src[base + j] * inv[base + j];
+            word |= (uint64_t)(r > 1.0f) << j;
+            wr = fmaxf(wr, r);
+        }
+        m->bits[w] = word;
+        n_viol += __builtin_popcountll(word);
+        if (wr > worst) {
+            worst = wr;
+            worst_word = w;
+        }
+    }
+
+    int base = worst_word * 64;
+    int wb = base;
+    for (int j = base; j < n && j < base + 64; j++) {
+        if (src[j] * inv[j] > src[wb] * inv[wb]) wb = j;
+    }
+
+    m->n_viol = n_viol;
+    m->worst_bin = wb;
+    m->worst_margin_db = (worst > 0.0f) ? -10.0 * log10((double)worst) : INFINITY;
+    m->frames++;
+    if (n_viol) m->viol_frames++;
+
+    if (n_viol && !m->alarm) {
+        m->alarm = true;
+        m->t_alarm = t_ns;
+        emit_report(m, "alarm", t_ns);
+    } else if (!n_viol && m->alarm) {
+        m->alarm = false;
+        emit_report(m, "clear", t_ns);
+    } else if (t_ns >= m->last_report + m->report_ns) {
+        emit_report(m, m->alarm ? "violating" : "pass", t_ns);
+    }
+}
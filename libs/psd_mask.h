@@ -0,0 +1,71 @@
+//libs/psd_mask.h
+#ifndef PSD_MASK_H
+#define PSD_MASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "datatypes.h"
+
+#define PSD_MASK_MAX_RANGES  16       // violating ranges listed per report
+#define PSD_MASK_MSG_BYTES   2048
+
+/* Where the compiled mask lands: the span crop of the frames it will check */
+typedef struct {
+    int nfft;
+    int crop_start;
+    int crop_len;
+    double f_start_hz;        // absolute frequency of crop bin 0
+    double df_hz;
+    double center_freq_hz;    // default carrier for relative masks
+    const char *scale;        // unit of the mask levels (dBm, dBuV, dBmV)
+} psd_mask_geom_t;
+
+typedef void (*psd_mask_emit_fn)(void *user, const char *json);
+
+/**
+ * Limit-line checker. The piecewise-linear mask is compiled once into a
+ * per-bin 1/threshold vector (linear PSD units, 0 where the mask has no
+ * limit), so every frame costs one multiply-compare pass that fills the
+ * violation bitmap and the worst ratio. Recompiled only when the mask or
+ * the geometry hash changes.
+ */
+typedef struct {
+    uint64_t hash;            // 0 = nothing compiled
+    psd_mask_geom_t geom;
+    int n;
+    int nwords;
+
+    float *inv_thr;           // n
+    uint64_t *bits;           // nwords; bit i set = bin i over the mask
+
+    /* last frame */
+    int n_viol;
+    int worst_bin;
+    double worst_margin_db;   // limit - level at the worst bin (< 0 = violation)
+
+    bool alarm;
+    uint64_t t_alarm;
+    uint64_t frames;
+    uint64_t viol_frames;
+    uint64_t report_ns;
+    uint64_t last_report;
+
+    char *msg;
+    psd_mask_emit_fn emit;
+    void *emit_user;
+} psd_mask_t;
+
+/* 1 = (re)compiled, 0 = unchanged (same hash), -1 = invalid mask */
+int  psd_mask_compile(psd_mask_t *m, const MaskCfg_t *cfg, const psd_mask_geom_t *geom,
+                      psd_mask_emit_fn emit, void *user);
+void psd_mask_free(psd_mask_t *m);
+
+/*
+  Check one per-segment frame (linear, fftshift order, nfft bins).
+  Alarm/clear transitions are emitted immediately; a summary with the worst
+  margin and violating ranges every report_ms.
+*/
+void psd_mask_push_frame(psd_mask_t *m, const float *frame, int nbins, uint64_t t_ns);
+
+#endif
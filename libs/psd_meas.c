@@ -0,0 +1,162 @@
+//libs/psd_meas.c
+#include "psd_meas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PSD_MEAS_Z_OHM 50.0
+
+int psd_meas_init(psd_meas_t *m, const MeasCfg_t *cfg, int max_bins) {
+    if (!m || !cfg || cfg->n_channels <= 0 || !cfg->channels || max_bins <= 0) return -1;
+    memset(m, 0, sizeof(*m));
+    m->cap = max_bins;
+    m->plan = cfg->channels;
+    m->nch = cfg->n_channels;
+    m->obw_frac = (cfg->obw_pct > 0.0 && cfg->obw_pct < 100.0) ? cfg->obw_pct / 100.0 : 0.99;
+
+    m->prefix = (double*)malloc(((size_t)max_bins + 1) * sizeof(double));
+    m->res = (psd_meas_result_t*)calloc((size_t)m->nch, sizeof(psd_meas_result_t));
+    if (!m->prefix || !m->res) {
+        psd_meas_free(m);
+        return -1;
+    }
+    return 0;
+}
+
+void psd_meas_free(psd_meas_t *m) {
+    if (!m) return;
+    free(m->prefix);
+    free(m->res);
+    memset(m, 0, sizeof(*m));
+}
+
+int psd_meas_load(psd_meas_t *m, const double *freq, const double *psd_lin, int n, double f_ref_hz) {
+    if (!m || !m->prefix || n < 2 || n > m->cap) return -1;
+
+    m->n = n;
+    m->f0 = f_ref_hz + freq[0];
+    m->df = freq[1] - freq[0];
+
+    // density * df / Z = watts per bin
+    double k = m->df / PSD_MEAS_Z_OHM;
+    double acc = 0.0;
+    m->prefix[0] = 0.0;
+    for (int i = 0; i < n; i++) {
+        acc += psd_lin[i] * k;
+        m->prefix[i + 1] = acc;
+    }
+    return 0;
+}
+
+/* Bin i covers [i - 0.5, i + 0.5) in bin units; x is that continuous position */
+static inline double pos_of(const psd_meas_t *m, double f) {
+    double x = (f - m->f0) / m->df + 0.5;
+    return x < 0.0 ? 0.0 : (x > m->n ? (double)m->n : x);
+}
+
+static inline double cum_at(const psd_meas_t *m, double x) {
+    int k = (int)x;
+    if (k >= m->n) return m->prefix[m->n];
+    return m->prefix[k] + (x - k) * (m->prefix[k + 1] - m->prefix[k]);
+}
+
+/* Inverse of cum_at on [k_lo, k_hi]: position where the running power reaches target */
+static double pos_of_power(const psd_meas_t *m, double target, int k_lo, int k_hi) {
+    const double *p = m->prefix;
+    while (k_hi - k_lo > 1) {
+        int mid = (k_lo + k_hi) >> 1;
+        if (p[mid] <= target) k_lo = mid;
+        else k_hi = mid;
+    }
+    double bin = p[k_lo + 1] - p[k_lo];
+    return k_lo + (bin > 0.0 ? (target - p[k_lo]) / bin : 0.0);
+}
+
+double psd_meas_band_power(const psd_meas_t *m, double f_lo, double f_hi) {
+    if (!m || m->n == 0 || f_hi <= f_lo) return 0.0;
+    return cum_at(m, pos_of(m, f_hi)) - cum_at(m, pos_of(m, f_lo));
+}
+
+static inline double w_to_dbm(double w) {
+    return 10.0 * log10(fmax(w, 1e-23) * 1000.0);
+}
+
+void psd_meas_run(psd_meas_t *m) {
+    if (!m || m->n == 0) return;
+
+    double band_lo = m->f0 - 0.5 * m->df;
+    double band_hi = m->f0 + (m->n - 0.5) * m->df;
+
+    for (int c = 0; c < m->nch; c++) {
+        const MeasChannel_t *ch = &m->plan[c];
+        psd_meas_result_t *r = &m->res[c];
+        double lo = ch->center_hz - 0.5 * ch->bw_hz;
+        double hi = ch->center_hz + 0.5 * ch->bw_hz;
+
+        if (lo < band_lo || hi > band_hi) {
+            r->power_dbm = r->obw_hz = r->obw_center_hz = NAN;
+            r->acpr_lo_db = r->acpr_hi_db = NAN;
+            continue;
+        }
+
+        double xa = pos_of(m, lo), xb = pos_of(m, hi);
+        double ca = cum_at(m, xa);
+        double total = cum_at(m, xb) - ca;
+        r->power_dbm = w_to_dbm(total);
+
+        // occupied bandwidth: the central obw_frac of the channel power
+        if (total > 0.0) {
+            double tail = 0.5 * (1.0 - m->obw_frac) * total;
+            int k_lo = (int)xa;
+            int k_hi = (int)ceil(xb);
+            if (k_hi > m->n) k_hi = m->n;
+            if (k_hi <= k_lo) k_hi = k_lo + 1;
+            double x1 = pos_of_power(m, ca + tail, k_lo, k_hi);
+            double x2 = pos_of_power(m, ca + total - tail, k_lo, k_hi);
+            r->obw_hz = (x2 - x1) * m->df;
+            r->obw_center_hz = m->f0 + (0.5 * (x1 + x2) - 0.5) * m->df;
+        } else {
+            r->obw_hz = 0.0;
+            r->obw_center_hz = ch->center_hz;
+        }
+
+        double off = ch->adj_offset_hz > 0.0 ? ch->adj_offset_hz : ch->bw_hz;
+        double abw = ch->adj_bw_hz > 0.0 ? ch->adj_bw_hz : ch->bw_hz;
+        double fl = ch->center_hz - off, fh = ch->center_hz + off;
+        r->acpr_lo_db = (fl - 0.5 * abw >= band_lo && total > 0.0)
+            ? 10.0 * log10(fmax(psd_meas_band_power(m, fl - 0.5 * abw, fl + 0.5 * abw), 1e-30) / total) : NAN;
+        r->acpr_hi_db = (fh + 0.5 * abw <= band_hi && total > 0.0)
+            ? 10.0 * log10(fmax(psd_meas_band_power(m, fh - 0.5 * abw, fh + 0.5 * abw), 1e-30) / total) : NAN;
+    }
+}
+
+size_t psd_meas_json_cap(const psd_meas_t *m) {
+    return 64 + (size_t)(m ? m->nch : 0) * 96;
+}
+
+/* "%.<prec>f" or null (JSON has no NaN) */
+static int put_num(char *buf, size_t cap, double v, int prec) {
+    if (!isfinite(v)) return snprintf(buf, cap, "null");
+    return snprintf(buf, cap, "%.*f", prec, v);
+}
+
+int psd_meas_json(const psd_meas_t *m, uint64_t t_ns, char *buf, size_t cap) {
+    if (!m || !buf || cap < 64) return -1;
+
+    size_t pos = (size_t)snprintf(buf, cap, "{\"t\":%llu,\"ch\":[", (unsigned long long)t_ns);
+    for (int c = 0; c < m->nch && pos + 96 < cap; c++) {
+        const psd_meas_result_t *r = &m->res[c];
+        pos += (size_t)snprintf(buf + pos, cap - pos, "%s[%.0f,", c ? "," : "", m->plan[c].center_hz);
+        pos += (size_t)put_num(buf + pos, cap - pos, r->power_dbm, 2);
+        buf[pos++] = ',';
+        pos += (size_t)put_num(buf + pos, cap - pos, r->obw_hz, 0);
+        buf[pos++] = ',';
+        pos += (size_t)put_num(buf + pos, cap - pos, r->acpr_lo_db, 2);
+        buf[pos++] = ',';
+        pos += (size_t)put_num(buf + pos, cap - pos, r->acpr_hi_db, 2);
+        buf[pos++] = ']';
+    }
+    pos += (size_t)snprintf(buf + pos, cap - pos, "]}");
+    return (int)pos;
+}
@@ -0,0 +1,54 @@
+//libs/psd_meas.h
+#ifndef PSD_MEAS_H
+#define PSD_MEAS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "datatypes.h"
+
+#define PSD_MEAS_TOPIC "psd_meas"
+
+typedef struct {
+    double power_dbm;         // integrated channel power (NAN = outside the FFT band)
+    double obw_hz;            // occupied bandwidth (obw_pct of the channel power)
+    double obw_center_hz;
+    double acpr_lo_db;        // lower / upper adjacent channel power relative to the channel (dBc)
+    double acpr_hi_db;
+} psd_meas_result_t;
+
+/**
+ * Channel power / OBW / ACPR over one PSD. One pass builds the prefix sum of
+ * the linear density; after that any band power is O(1) (two lookups with
+ * fractional edge bins) and OBW is two binary searches, so hundreds of
+ * channels per trace cost less than the prefix pass itself.
+ */
+typedef struct {
+    int cap;                  // bins the prefix can hold
+    int n;
+    double *prefix;           // n + 1: power (W) of bins [0, k)
+    double f0;                // absolute center frequency of bin 0
+    double df;
+
+    const MeasChannel_t *plan;  // not owned
+    int nch;
+    double obw_frac;
+    psd_meas_result_t *res;   // nch
+} psd_meas_t;
+
+int  psd_meas_init(psd_meas_t *m, const MeasCfg_t *cfg, int max_bins);
+void psd_meas_free(psd_meas_t *m);
+
+/* Prefix pass over a linear density (V^2/Hz into 50 ohm); freq[] + f_ref_hz = absolute */
+int  psd_meas_load(psd_meas_t *m, const double *freq, const double *psd_lin, int n, double f_ref_hz);
+
+/* Integrated power (W) in [f_lo, f_hi], clipped to the loaded band */
+double psd_meas_band_power(const psd_meas_t *m, double f_lo, double f_hi);
+
+/* Measure every channel of the plan into m->res */
+void psd_meas_run(psd_meas_t *m);
+
+/* {"t","ch":[[center_hz,power_dbm,obw_hz,acpr_lo_db,acpr_hi_db],...]} */
+int    psd_meas_json(const psd_meas_t *m, uint64_t t_ns, char *buf, size_t cap);
+size_t psd_meas_json_cap(const psd_meas_t *m);
+
+#endif
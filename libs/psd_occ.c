@@ -0,0 +1,265 @@
+//libs/psd_occ.c
+#include "psd_occ.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+_Static_assert(sizeof(psd_occ_header_t) == 128, "occupancy header must stay 128 bytes");
+
+/* Halve the counts before any uint32 cell can wrap */
+#define PSD_OCC_HALVE_AT 0x80000000ull
+
+static int occ_alloc(psd_occ_t *o, int crop_len) {
+    size_t cells = (size_t)o->h.ncols * o->h.nbuckets;
+    o->counts = (uint32_t*)calloc(cells, sizeof(uint32_t));
+    o->cell = crop_len > 0 ? (uint32_t*)malloc((size_t)crop_len * sizeof(uint32_t)) : NULL;
+    return (o->counts && (crop_len <= 0 || o->cell)) ? 0 : -1;
+}
+
+int psd_occ_open(psd_occ_t *o, const psd_occ_cfg_t *cfg) {
+    if (!o || !cfg || cfg->crop_len <= 0 || cfg->df_hz <= 0.0) return -1;
+    memset(o, 0, sizeof(*o));
+
+    double res = cfg->res_db > 0.0 ? cfg->res_db : 0.5;
+    double lo = cfg->db_min, hi = cfg->db_max;
+    if (hi <= lo) {
+        lo = -140.0;
+        hi = 0.0;
+    }
+    int nb = (int)ceil((hi - lo) / res);
+    if (nb < 2) nb = 2;
+    if (nb > PSD_OCC_MAX_BUCKETS) nb = PSD_OCC_MAX_BUCKETS;
+
+    int max_cols = cfg->max_cols > 0 ? cfg->max_cols : PSD_OCC_DEFAULT_COLS;
+    o->crop_len = cfg->crop_len;
+    o->group = (cfg->crop_len + max_cols - 1) / max_cols;
+
+    psd_occ_header_t *h = &o->h;
+    h->magic = PSD_OCC_MAGIC;
+    h->version = PSD_OCC_VERSION;
+    h->ncols = (uint32_t)((cfg->crop_len + o->group - 1) / o->group);
+    h->nbuckets = (uint32_t)nb;
+    h->df_hz = cfg->df_hz * o->group;
+    h->f_start_hz = cfg->f_start_hz + 0.5 * (o->group - 1) * cfg->df_hz;
+    h->db_min = lo;
+    h->res_db = res;
+    snprintf(h->scale, sizeof(h->scale), "%s", cfg->scale ? cfg->scale : "dBm");
+
+    if (occ_alloc(o, cfg->crop_len) != 0) {
+        psd_occ_close(o);
+        return -1;
+    }
+
+    fprintf(stderr, "[OCC] %u cols (%d bins/col) x %d buckets of %.2f dB from %.1f | %.1f MB\n",
+            h->ncols, o->group, nb, res, lo,
+            (double)h->ncols * nb * sizeof(uint32_t) / (1024.0 * 1024.0));
+    return 0;
+}
+
+void psd_occ_close(psd_occ_t *o) {
+    if (!o) return;
+    free(o->counts);
+    free(o->cell);
+    memset(o, 0, sizeof(*o));
+}
+
+void psd_occ_reset(psd_occ_t *o) {
+    if (!o || !o->counts) return;
+    memset(o->counts, 0, (size_t)o->h.ncols * o->h.nbuckets * sizeof(uint32_t));
+    o->h.traces = 0;
+    o->h.t_first_ns = o->h.t_last_ns = 0;
+    o->hits_since_halve = 0;
+}
+
+static void occ_halve(psd_occ_t *o) {
+    size_t cells = (size_t)o->h.ncols * o->h.nbuckets;
+    uint32_t *c = o->counts;
+    #pragma omp simd
+    for (size_t i = 0; i < cells; i++) c[i] >>= 1;
+    o->hits_since_halve >>= 1;
+}
+
+void psd_occ_push_db(psd_occ_t *o, const double *db, int n, uint64_t t_ns) {
+    if (!o || !o->counts || !db || n != o->crop_len) return;
+
+    uint32_t *cell = o->cell;
+    uint32_t nb = o->h.nbuckets;
+    int group = o->group;
+    float top = (float)(nb - 1);
+    float inv_res = (float)(1.0 / o->h.res_db);
+    float off = (float)(-o->h.db_min / o->h.res_db);
+
+    // bucket index for the whole trace in one pass, then the scatter
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        float b = (float)db[i] * inv_res + off;
+        b = fminf(fmaxf(b, 0.0f), top);
+        cell[i] = (uint32_t)(i / group) * nb + (uint32_t)b;
+    }
+    uint32_t *counts = o->counts;
+    for (int i = 0; i < n; i++) counts[cell[i]]++;
+
+    if (o->h.traces == 0) o->h.t_first_ns = t_ns;
+    o->h.t_last_ns = t_ns;
+    o->h.traces++;
+    o->hits_since_halve += (uint64_t)group;
+    if (o->hits_since_halve >= PSD_OCC_HALVE_AT) occ_halve(o);
+}
+
+static int same_geometry(const psd_occ_header_t *a, const psd_occ_header_t *b) {
+    return a->ncols == b->ncols && a->nbuckets == b->nbuckets &&
+           fabs(a->db_min - b->db_min) < 1e-9 && fabs(a->res_db - b->res_db) < 1e-9 &&
+           fabs(a->f_start_hz - b->f_start_hz) < 1e-3 * a->df_hz &&
+           fabs(a->df_hz - b->df_hz) < 1e-6 * a->df_hz;
+}
+
+int psd_occ_merge(psd_occ_t *dst, const psd_occ_t *src) {
+    if (!dst || !src || !dst->counts || !src->counts) return -1;
+    if (!same_geometry(&dst->h, &src->h)) {
+        fprintf(stderr, "[OCC] merge: geometry differs\n");
+        return -1;
+    }
+
+    size_t cells = (size_t)dst->h.ncols * dst->h.nbuckets;
+    uint32_t *d = dst->counts;
+    const uint32_t *s = src->counts;
+    uint32_t peak = 0;
+    #pragma omp simd reduction(max:peak)
+    for (size_t i = 0; i < cells; i++) {
+        uint64_t v = (uint64_t)d[i] + s[i];
+        d[i] = (uint32_t)(v > UINT32_MAX ? UINT32_MAX : v);
+        peak = d[i] > peak ? d[i] : peak;
+    }
+
+    if (src->h.traces) {
+        if (!dst->h.traces || src->h.t_first_ns < dst->h.t_first_ns) dst->h.t_first_ns = src->h.t_first_ns;
+        if (src->h.t_last_ns > dst->h.t_last_ns) dst->h.t_last_ns = src->h.t_last_ns;
+    }
+    dst->h.traces += src->h.traces;
+    dst->hits_since_halve += src->hits_since_halve;
+    if (peak >= PSD_OCC_HALVE_AT || dst->hits_since_halve >= PSD_OCC_HALVE_AT) occ_halve(dst);
+    return 0;
+}
+
+int psd_occ_copy(psd_occ_t *dst, const psd_occ_t *src) {
+    if (!dst || !src || !src->counts) return -1;
+    memset(dst, 0, sizeof(*dst));
+    dst->h = src->h;
+    dst->group = src->group;
+    dst->hits_since_halve = src->hits_since_halve;
+    if (occ_alloc(dst, 0) != 0) {
+        psd_occ_close(dst);
+        return -1;
+    }
+    memcpy(dst->counts, src->counts, (size_t)src->h.ncols * src->h.nbuckets * sizeof(uint32_t));
+    return 0;
+}
+
+double psd_occ_quantile(const psd_occ_t *o, int col, double q) {
+    if (!o || !o->counts || col < 0 || col >= (int)o->h.ncols) return NAN;
+    const uint32_t *c = &o->counts[(size_t)col * o->h.nbuckets];
+    int nb = (int)o->h.nbuckets;
+
+    uint64_t total = 0;
+    for (int b = 0; b < nb; b++) total += c[b];
+    if (total == 0) return NAN;
+
+    double target = fmin(fmax(q, 0.0), 1.0) * (double)total;
+    uint64_t cum = 0;
+    for (int b = 0; b < nb; b++) {
+        if (c[b] && (double)(cum + c[b]) >= target) {
+            double frac = (target - (double)cum) / c[b];
+            return o->h.db_min + (b + frac) * o->h.res_db;
+        }
+        cum += c[b];
+    }
+    return o->h.db_min + nb * o->h.res_db;
+}
+
+double psd_occ_duty(const psd_occ_t *o, int col, double thr_db) {
+    if (!o || !o->counts || col < 0 || col >= (int)o->h.ncols) return NAN;
+    const uint32_t *c = &o->counts[(size_t)col * o->h.nbuckets];
+    int nb = (int)o->h.nbuckets;
+
+    double x = (thr_db - o->h.db_min) / o->h.res_db;
+    int k = (int)floor(x);
+    uint64_t total = 0;
+    double above = 0.0;
+    for (int b = 0; b < nb; b++) {
+        total += c[b];
+        if (b > k) above += c[b];
+        else if (b == k) above += c[b] * (1.0 - (x - k));   // uniform inside the bucket
+    }
+    return total ? above / (double)total : NAN;
+}
+
+int psd_occ_save(const psd_occ_t *o, const char *path) {
+    if (!o || !o->counts || !path) return -1;
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        perror("[OCC] save");
+        return -1;
+    }
+    size_t cells = (size_t)o->h.ncols * o->h.nbuckets;
+    int ok = fwrite(&o->h, sizeof(o->h), 1, fp) == 1 &&
+             fwrite(o->counts, sizeof(uint32_t), cells, fp) == cells;
+    ok = (fclose(fp) == 0) && ok;
+    // rename: readers never see a half-written sketch
+    if (!ok || rename(tmp, path) != 0) {
+        fprintf(stderr, "[OCC] save %s failed\n", path);
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int psd_occ_load(psd_occ_t *o, const char *path) {
+    if (!o || !path) return -1;
+    memset(o, 0, sizeof(*o));
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    int ok = fread(&o->h, sizeof(o->h), 1, fp) == 1 && o->h.magic == PSD_OCC_MAGIC &&
+             o->h.version == PSD_OCC_VERSION && o->h.ncols > 0 &&
+             o->h.nbuckets >= 2 && o->h.nbuckets <= PSD_OCC_MAX_BUCKETS;
+    if (ok) ok = occ_alloc(o, 0) == 0;
+    size_t cells = (size_t)o->h.ncols * o->h.nbuckets;
+    if (ok) ok = fread(o->counts, sizeof(uint32_t), cells, fp) == cells;
+    fclose(fp);
+
+    if (!ok) {
+        fprintf(stderr, "[OCC] %s: not a valid sketch\n", path);
+        psd_occ_close(o);
+        return -1;
+    }
+    // column 0 always holds full groups: its total is the per-column hit count
+    for (uint32_t b = 0; b < o->h.nbuckets; b++) o->hits_since_halve += o->counts[b];
+    return 0;
+}
+
+int psd_occ_export_csv(const psd_occ_t *o, const char *path, const double *q_pct, int nq, double thr_db) {
+    if (!o || !o->counts || !path) return -1;
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror("[OCC] csv");
+        return -1;
+    }
+    fprintf(fp, "freq_hz");
+    for (int k = 0; k < nq; k++) fprintf(fp, ",p%g_%s", q_pct[k], o->h.scale);
+    if (isnan(thr_db)) fprintf(fp, ",duty_pct_above_p10+%g\n", PSD_OCC_AUTO_THR_DB);
+    else fprintf(fp, ",duty_pct_above_%g\n", thr_db);
+
+    for (int c = 0; c < (int)o->h.ncols; c++) {
+        fprintf(fp, "%.1f", o->h.f_start_hz + c * o->h.df_hz);
+        for (int k = 0; k < nq; k++) fprintf(fp, ",%.2f", psd_occ_quantile(o, c, q_pct[k] / 100.0));
+        double thr = isnan(thr_db) ? psd_occ_quantile(o, c, 0.10) + PSD_OCC_AUTO_THR_DB : thr_db;
+        fprintf(fp, ",%.3f\n", 100.0 * psd_occ_duty(o, c, thr));
+    }
+    fclose(fp);
+    return 0;
+}
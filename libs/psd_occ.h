@@ -0,0 +1,90 @@
+//libs/psd_occ.h
+#ifndef PSD_OCC_H
+#define PSD_OCC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  Occupancy sketch file (little endian, same layout as in memory):
+
+    [psd_occ_header_t, 128 bytes]
+    [uint32 counts[ncols][nbuckets]]   bucket b covers db_min + [b, b+1) * res_db;
+                                       the first / last bucket also take everything below / above
+
+  Sketches with the same geometry (ncols, nbuckets, db_min, res_db, f_start, df)
+  add up: that is how sensors or time windows are merged.
+*/
+
+#define PSD_OCC_MAGIC    0x43434f50u   /* "POCC" */
+#define PSD_OCC_VERSION  1u
+
+#define PSD_OCC_DEFAULT_COLS 1024
+#define PSD_OCC_MAX_BUCKETS  4096
+#define PSD_OCC_AUTO_THR_DB  6.0      // NAN threshold: P10 of the bin (noise) + this
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ncols;
+    uint32_t nbuckets;
+    uint64_t traces;          // traces accumulated (after merges: sum)
+    uint64_t t_first_ns;
+    uint64_t t_last_ns;
+    double f_start_hz;        // absolute center of column 0
+    double df_hz;             // column spacing
+    double db_min;
+    double res_db;
+    char scale[16];
+    uint8_t reserved[128 - 88];
+} psd_occ_header_t;
+
+typedef struct {
+    double res_db;            // bucket width (0 = 0.5 dB)
+    double db_min;            // bucket range (0/0 = -140..0)
+    double db_max;
+    int max_cols;             // frequency columns (adjacent bins share one above this)
+
+    int crop_len;             // bins per pushed trace
+    double f_start_hz;        // absolute frequency of bin 0
+    double df_hz;
+    const char *scale;
+} psd_occ_cfg_t;
+
+/**
+ * Per-bin log-power histogram (dB buckets) over scaled PSD traces. Memory is
+ * ncols * nbuckets uint32 whatever the run length: when a column could
+ * overflow every count is halved, which keeps every quantile and duty cycle.
+ */
+typedef struct {
+    psd_occ_header_t h;
+    int group;                // trace bins per column
+    int crop_len;
+    uint32_t *counts;         // ncols * nbuckets
+    uint32_t *cell;           // crop_len, scratch
+    uint64_t hits_since_halve;
+} psd_occ_t;
+
+int  psd_occ_open(psd_occ_t *o, const psd_occ_cfg_t *cfg);
+void psd_occ_close(psd_occ_t *o);
+void psd_occ_reset(psd_occ_t *o);
+
+/* One scaled trace (crop_len dB values) */
+void psd_occ_push_db(psd_occ_t *o, const double *db, int n, uint64_t t_ns);
+
+/* dst += src; -1 if the geometries differ */
+int  psd_occ_merge(psd_occ_t *dst, const psd_occ_t *src);
+int  psd_occ_copy(psd_occ_t *dst, const psd_occ_t *src);
+
+/* q in [0, 1] -> dB (interpolated inside the bucket); NAN if the column is empty */
+double psd_occ_quantile(const psd_occ_t *o, int col, double q);
+/* Fraction of samples above thr_db */
+double psd_occ_duty(const psd_occ_t *o, int col, double thr_db);
+
+int  psd_occ_save(const psd_occ_t *o, const char *path);
+int  psd_occ_load(psd_occ_t *o, const char *path);
+
+/* freq_hz,p<q>...,duty_pct per column; quantiles in percent, thr_db NAN = auto per column */
+int  psd_occ_export_csv(const psd_occ_t *o, const char *path, const double *q_pct, int nq, double thr_db);
+
+#endif
@@ -0,0 +1,192 @@
+//libs/psd_persist.c
+#define _GNU_SOURCE
+#include "psd_persist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+_Static_assert(sizeof(psd_px_header_t) == 256, "persistence header must stay 256 bytes");
+
+/* Rescale the matrix once the hit weight gets this large (float headroom) */
+#define PSD_PX_WEIGHT_MAX 1e20f
+
+int psd_px_open(psd_persist_t *px, const psd_px_cfg_t *cfg) {
+    if (!px || !cfg || !cfg->path || cfg->crop_len <= 0) return -1;
+    if (cfg->crop_start < 0 || cfg->crop_start + cfg->crop_len > cfg->nfft) return -1;
+    if (cfg->db_max <= cfg->db_min) return -1;
+
+    memset(px, 0, sizeof(*px));
+    px->fd = -1;
+    px->cfg = *cfg;
+    if (px->cfg.nlevels <= 0) px->cfg.nlevels = PSD_PX_DEFAULT_LEVELS;
+    if (px->cfg.max_cols <= 0) px->cfg.max_cols = PSD_PX_DEFAULT_COLS;
+    if (px->cfg.nlevels > 65536) px->cfg.nlevels = 65536;
+
+    int n = cfg->crop_len;
+    px->group = (n + px->cfg.max_cols - 1) / px->cfg.max_cols;
+    px->ncols = (n + px->group - 1) / px->group;
+
+    size_t cells = (size_t)px->ncols * (size_t)px->cfg.nlevels;
+    px->hist = (float*)calloc(cells, sizeof(float));
+    px->cell = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    if (!px->hist || !px->cell) {
+        psd_px_close(px);
+        return -1;
+    }
+
+    px->weight = 1.0f;
+    px->growth = (cfg->decay_s > 0.0 && cfg->seg_period_s > 0.0)
+                     ? (float)exp(cfg->seg_period_s / cfg->decay_s) : 1.0f;
+
+    // linear PSD (V^2/Hz into 50 ohm) -> dBm, then the unit offset of scale_psd
+    const char *scale = cfg->scale;
+    if (scale && (strcmp(scale, "W") == 0 || strcmp(scale, "V") == 0)) scale = "dBm";
+    px->db_offset = (float)(10.0 * log10(1000.0 / 50.0));
+    if (scale && strcmp(scale, "dBuV") == 0) px->db_offset += 107.0f;
+    else if (scale && strcmp(scale, "dBmV") == 0) px->db_offset += 47.0f;
+    px->lvl_scale = (float)(px->cfg.nlevels / (cfg->db_max - cfg->db_min));
+
+    px->map_bytes = sizeof(psd_px_header_t) + cells * sizeof(uint16_t);
+    px->fd = open(cfg->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (px->fd < 0) {
+        perror("[PX] open");
+        psd_px_close(px);
+        return -1;
+    }
+    if (ftruncate(px->fd, (off_t)px->map_bytes) != 0) {
+        perror("[PX] ftruncate");
+        psd_px_close(px);
+        return -1;
+    }
+
+    void *map = mmap(NULL, px->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, px->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("[PX] mmap");
+        psd_px_close(px);
+        return -1;
+    }
+    px->hdr = (psd_px_header_t*)map;
+    px->out = (uint16_t*)((uint8_t*)map + sizeof(psd_px_header_t));
+
+    double df = cfg->sample_rate_hz / cfg->nfft;
+    psd_px_header_t *h = px->hdr;
+    h->version = PSD_PX_VERSION;
+    h->ncols = (uint32_t)px->ncols;
+    h->nlevels = (uint32_t)px->cfg.nlevels;
+    h->center_freq_hz = cfg->center_freq_hz;
+    h->f_start_hz = cfg->center_freq_hz - cfg->sample_rate_hz / 2.0 + cfg->crop_start * df;
+    h->df_hz = df * px->group;
+    h->db_min = (float)cfg->db_min;
+    h->db_max = (float)cfg->db_max;
+    h->decay_s = (float)cfg->decay_s;
+    snprintf(h->scale, sizeof(h->scale), "%s", scale ? scale : "dBm");
+    __atomic_store_n(&h->seq, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->magic, PSD_PX_MAGIC, __ATOMIC_RELEASE);
+
+    fprintf(stderr, "[PX] %s | %d cols (%d bins/col) x %d levels | decay %.2f s | %.1f MB\n",
+            cfg->path, px->ncols, px->group, px->cfg.nlevels, cfg->decay_s,
+            (double)px->map_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+void psd_px_close(psd_persist_t *px) {
+    if (!px) return;
+    if (px->hdr) {
+        msync(px->hdr, px->map_bytes, MS_ASYNC);
+        munmap(px->hdr, px->map_bytes);
+    }
+    if (px->fd >= 0) close(px->fd);
+    free(px->hist);
+    free(px->cell);
+    memset(px, 0, sizeof(*px));
+    px->fd = -1;
+}
+
+/* log2 for normal positive floats: exponent + quadratic on the mantissa (|err| < 5e-3) */
+static inline float fast_log2f(float x) {
+    union { float f; uint32_t u; } v = { x };
+    float e = (float)(int)((v.u >> 23) & 0xff) - 128.0f;   // the polynomial gives 1 + log2(m)
+    v.u = (v.u & 0x007fffffu) | 0x3f800000u;
+    float m = v.f;
+    return e + (-0.34484843f * m + 2.02466578f) * m - 0.67487759f;
+}
+
+void psd_px_publish(psd_persist_t *px, uint64_t t_ns) {
+    if (!px || !px->hdr) return;
+
+    size_t cells = (size_t)px->ncols * (size_t)px->cfg.nlevels;
+    const float *hist = px->hist;
+
+    float peak = 0.0f;
+    #pragma omp simd reduction(max:peak)
+    for (size_t i = 0; i < cells; i++) peak = fmaxf(peak, hist[i]);
+
+    psd_px_header_t *h = px->hdr;
+    uint64_t seq = h->seq;
+    __atomic_store_n(&h->seq, seq + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint16_t *out = px->out;
+    float k = (peak > 0.0f) ? 65535.0f / peak : 0.0f;
+    #pragma omp simd
+    for (size_t i = 0; i < cells; i++) out[i] = (uint16_t)(hist[i] * k + 0.5f);
+
+    h->t_ns = t_ns;
+    h->frames = px->frames;
+    h->max_hits = peak * px->growth / px->weight;   // in units of the newest frame's hits
+
+    __atomic_store_n(&h->seq, seq + 2, __ATOMIC_RELEASE);
+    px->last_pub_ns = t_ns;
+}
+
+void psd_px_push_frame(psd_persist_t *px, const float *frame, int nbins, uint64_t t_ns) {
+    if (!px || !px->hdr || nbins != px->cfg.nfft) return;
+
+    const float *src = &frame[px->cfg.crop_start];
+    uint32_t *cell = px->cell;
+    int n = px->cfg.crop_len;
+    int group = px->group;
+    int top = px->cfg.nlevels - 1;
+    float lvl_scale = px->lvl_scale;
+    // level = (10 log10(p) + offset - db_min) * lvl_scale, folded into one FMA on log2(p)
+    float a = (float)(10.0 * M_LN2 / M_LN10) * lvl_scale;
+    float b = (px->db_offset - (float)px->cfg.db_min) * lvl_scale;
+    uint32_t nlevels = (uint32_t)px->cfg.nlevels;
+
+    // Single quantisation pass: bin -> flat (column, level) index
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        float l = a * fast_log2f(fmaxf(src[i], 1e-30f)) + b;
+        l = fminf(fmaxf(l, 0.0f), (float)top);
+        cell[i] = (uint32_t)(i / group) * nlevels + (uint32_t)l;
+    }
+
+    /*
+      Hits: columns are frequency-major, so the indices only move forward and
+      never alias across columns. Decay is applied by growing the weight of new
+      hits; the matrix itself is only touched on the rare renormalisation.
+    */
+    float *hist = px->hist;
+    float w = px->weight;
+    for (int i = 0; i < n; i++) hist[cell[i]] += w;
+
+    px->frames++;
+    w *= px->growth;
+    if (w > PSD_PX_WEIGHT_MAX) {
+        size_t cells = (size_t)px->ncols * (size_t)px->cfg.nlevels;
+        float inv = 1.0f / w;
+        #pragma omp simd
+        for (size_t i = 0; i < cells; i++) hist[i] *= inv;
+        w = 1.0f;
+    }
+    px->weight = w;
+
+    if (t_ns >= px->last_pub_ns + (uint64_t)(px->cfg.publish_ms * 1e6)) {
+        psd_px_publish(px, t_ns);
+    }
+}
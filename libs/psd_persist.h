@@ -0,0 +1,93 @@
+//libs/psd_persist.h
+#ifndef PSD_PERSIST_H
+#define PSD_PERSIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "datatypes.h"
+
+/*
+  Persistence (DPX-style density) file layout (little endian, mmap'able):
+
+    [psd_px_header_t, 256 bytes]
+    [uint16 hist[ncols][nlevels]]      frequency-major: one column = nlevels cells
+
+  Cell value v means v / 65535 * max_hits decayed hits; level l covers
+  dB = db_min + (l + 0.5) * (db_max - db_min) / nlevels. seq is odd while the
+  matrix is being rewritten; readers re-check it after copying.
+*/
+
+#define PSD_PX_MAGIC    0x58504450u   /* "PDPX" */
+#define PSD_PX_VERSION  1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ncols;
+    uint32_t nlevels;
+    uint64_t seq;
+    uint64_t t_ns;            // CLOCK_REALTIME of the newest frame in the matrix
+    uint64_t frames;          // FFT frames accumulated since open
+    double center_freq_hz;
+    double f_start_hz;        // absolute frequency of the first bin in column 0
+    double df_hz;             // column spacing
+    float db_min;
+    float db_max;
+    float max_hits;           // decayed hit count mapped to 65535
+    float decay_s;
+    char scale[16];
+    uint8_t reserved[256 - 96];
+} psd_px_header_t;
+
+typedef struct {
+    const char *path;
+    int nlevels;
+    int max_cols;             // frequency columns (adjacent bins share a column above this)
+    double db_min;
+    double db_max;
+    double decay_s;           // exponential time constant (0 = infinite persistence)
+    double publish_ms;
+
+    int nfft;
+    int crop_start;
+    int crop_len;
+    double seg_period_s;      // one FFT frame
+    double center_freq_hz;
+    double sample_rate_hz;
+    const char *scale;
+} psd_px_cfg_t;
+
+typedef struct {
+    psd_px_cfg_t cfg;
+    int ncols;
+    int group;                // FFT bins per column
+
+    float *hist;              // ncols * nlevels, weighted hits
+    float weight;             // weight of the next hit (grows instead of decaying the matrix)
+    float growth;             // 1 / per-frame decay
+    uint32_t *cell;           // per-bin hist index of the current frame
+
+    float db_offset;          // linear PSD -> selected dB scale
+    float lvl_scale;          // levels per dB
+
+    uint64_t frames;
+    uint64_t last_pub_ns;
+
+    int fd;
+    size_t map_bytes;
+    psd_px_header_t *hdr;
+    uint16_t *out;
+} psd_persist_t;
+
+/*
+  Every FFT frame adds one hit per crop bin at (column, dB level); older hits
+  fade with exp(-age / decay_s). Publication (uint16, normalised to the busiest
+  cell) happens at most every publish_ms from inside push_frame.
+*/
+int  psd_px_open(psd_persist_t *px, const psd_px_cfg_t *cfg);
+void psd_px_close(psd_persist_t *px);
+void psd_px_push_frame(psd_persist_t *px, const float *frame, int nbins, uint64_t t_ns);
+void psd_px_publish(psd_persist_t *px, uint64_t t_ns);
+
+#endif
@@ -0,0 +1,183 @@
+//libs/psd_pub.c
+#define _GNU_SOURCE
+#include "psd_pub.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(psd_shm_header_t) == 256, "shm header must stay 256 bytes");
+
+static size_t shm_bytes(uint32_t capacity) {
+    return sizeof(psd_shm_header_t) + (size_t)capacity * sizeof(float);
+}
+
+int psd_shm_create(psd_shm_t *s, const char *name, uint32_t capacity) {
+    if (!s || !name || capacity == 0) return -1;
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    s->writer = 1;
+    snprintf(s->name, sizeof(s->name), "%s", name);
+
+    s->fd = shm_open(s->name, O_RDWR | O_CREAT, 0644);
+    if (s->fd < 0) {
+        perror("[SHM] shm_open");
+        return -1;
+    }
+
+    s->map_bytes = shm_bytes(capacity);
+    if (ftruncate(s->fd, (off_t)s->map_bytes) != 0) {
+        perror("[SHM] ftruncate");
+        psd_shm_close(s);
+        return -1;
+    }
+
+    void *map = mmap(NULL, s->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("[SHM] mmap");
+        psd_shm_close(s);
+        return -1;
+    }
+    s->hdr = (psd_shm_header_t*)map;
+    s->data = (float*)((uint8_t*)map + sizeof(psd_shm_header_t));
+
+    /* keep seq monotonic across restarts so readers notice new frames */
+    uint64_t seq = (s->hdr->magic == PSD_SHM_MAGIC) ? (s->hdr->seq + 1) & ~1ull : 0;
+    __atomic_store_n(&s->hdr->seq, seq, __ATOMIC_RELEASE);
+    s->hdr->version = PSD_SHM_VERSION;
+    s->hdr->capacity = capacity;
+    s->hdr->nbins = 0;
+    __atomic_store_n(&s->hdr->magic, PSD_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    fprintf(stderr, "[SHM] /dev/shm%s | capacity=%u bins (%.2f MB)\n",
+            s->name, capacity, (double)s->map_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+int psd_shm_publish(psd_shm_t *s, const double *psd, int nbins,
+                    double center_freq_hz, double sample_rate_hz,
+                    double f_start_rel_hz, double df_hz,
+                    const char *scale, uint64_t t_ns) {
+    if (!s || !s->hdr || !s->writer || !psd || nbins <= 0) return -1;
+    if ((uint32_t)nbins > s->hdr->capacity) nbins = (int)s->hdr->capacity;
+
+    psd_shm_header_t *h = s->hdr;
+    uint64_t seq = __atomic_load_n(&h->seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&h->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    h->nbins = (uint32_t)nbins;
+    h->timestamp_ns = t_ns;
+    h->center_freq_hz = center_freq_hz;
+    h->sample_rate_hz = sample_rate_hz;
+    h->f_start_hz = center_freq_hz + f_start_rel_hz;
+    h->df_hz = df_hz;
+    snprintf(h->scale, sizeof(h->scale), "%s", scale ? scale : "lin");
+
+    float *dst = s->data;
+    #pragma omp simd
+    for (int i = 0; i < nbins; i++) dst[i] = (float)psd[i];
+
+    __atomic_store_n(&h->seq, seq + 2, __ATOMIC_RELEASE);
+    return nbins;
+}
+
+int psd_shm_open_reader(psd_shm_t *s, const char *name) {
+    if (!s || !name) return -1;
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+
+    s->fd = shm_open(s->name, O_RDONLY, 0);
+    if (s->fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(s->fd, &st) != 0 || (size_t)st.st_size < sizeof(psd_shm_header_t)) {
+        psd_shm_close(s);
+        return -1;
+    }
+    s->map_bytes = (size_t)st.st_size;
+
+    void *map = mmap(NULL, s->map_bytes, PROT_READ, MAP_SHARED, s->fd, 0);
+    if (map == MAP_FAILED) {
+        psd_shm_close(s);
+        return -1;
+    }
+    s->hdr = (psd_shm_header_t*)map;
+    s->data = (float*)((uint8_t*)map + sizeof(psd_shm_header_t));
+
+    if (s->hdr->magic != PSD_SHM_MAGIC || shm_bytes(s->hdr->capacity) > s->map_bytes) {
+        psd_shm_close(s);
+        return -1;
+    }
+    return 0;
+}
+
+int psd_shm_read(const psd_shm_t *s, psd_shm_header_t *hdr_out, float *out, int max_bins) {
+    if (!s || !s->hdr || !out || max_bins <= 0) return -1;
+    const psd_shm_header_t *h = s->hdr;
+    // a writer restarted with a larger capacity grows the object past our mapping
+    size_t cap_floats = (s->map_bytes - sizeof(psd_shm_header_t)) / sizeof(float);
+
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint64_t s1 = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) continue;
+
+        psd_shm_header_t snap;
+        memcpy(&snap, h, sizeof(snap));
+        int n = (int)snap.nbins;
+        if (n > max_bins) n = max_bins;
+        if (n > (int)snap.capacity) n = (int)snap.capacity;
+        if ((size_t)n > cap_floats) n = (int)cap_floats;
+        if (n < 0) n = 0;
+        memcpy(out, s->data, (size_t)n * sizeof(float));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t s2 = __atomic_load_n(&h->seq, __ATOMIC_RELAXED);
+        if (s1 != s2) continue;
+
+        if (hdr_out) *hdr_out = snap;
+        return n;
+    }
+    return -1;
+}
+
+void psd_shm_close(psd_shm_t *s) {
+    if (!s) return;
+    if (s->hdr) munmap(s->hdr, s->map_bytes);
+    if (s->fd >= 0) close(s->fd);
+    s->hdr = NULL;
+    s->data = NULL;
+    s->fd = -1;
+}
+
+int psd_save_csv(const char *csv_path, const double *freq_rel, const double *psd, int length,
+                 uint64_t center_freq, const char *scale_label, const uint64_t *t_ns) {
+    if (!csv_path || !freq_rel || !psd || length <= 0) return -1;
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", csv_path);
+
+    FILE *fp = fopen(tmp_path, "w");
+    if (!fp) { perror("[CSV] fopen"); return -1; }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
+    fprintf(fp, "freq_hz,psd_%s%s\n", (scale_label && scale_label[0]) ? scale_label : "lin",
+            t_ns ? ",t_ns" : "");
+
+    for (int i = 0; i < length; i++) {
+        double f_abs = freq_rel[i] + (double)center_freq;
+        if (t_ns) fprintf(fp, "%.6f,%.12e,%llu\n", f_abs, psd[i], (unsigned long long)t_ns[i]);
+        else      fprintf(fp, "%.6f,%.12e\n", f_abs, psd[i]);
+    }
+
+    if (fclose(fp) != 0) { perror("[CSV] fclose"); return -1; }
+
+    /* readers never see a half-written file */
+    if (rename(tmp_path, csv_path) != 0) { perror("[CSV] rename"); return -1; }
+    return 0;
+}
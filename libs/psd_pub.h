@@ -0,0 +1,69 @@
+//libs/psd_pub.h
+#ifndef PSD_PUB_H
+#define PSD_PUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  Binary PSD publication through POSIX shared memory (/dev/shm/<name>).
+
+    [psd_shm_header_t, 256 bytes][float32 psd[capacity]]
+
+  Single writer, any number of readers, guarded by a seqlock: seq is odd
+  while a frame is being written. Readers copy header + bins and retry if
+  seq changed or was odd, so they always see a consistent frame.
+*/
+
+#define PSD_SHM_DEFAULT_NAME "/psd_last"
+#define PSD_FRAME_TOPIC      "psd_frame"   /* binary multipart trace on the ZMQ PUB socket (zmq_util.h) */
+#define PSD_SHM_MAGIC        0x4D485350u   /* "PSHM" */
+#define PSD_SHM_VERSION      1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;        // max bins the segment can hold
+    uint32_t nbins;           // bins in the current frame
+    uint64_t seq;             // seqlock counter (even = stable)
+    uint64_t timestamp_ns;    // CLOCK_REALTIME of the frame
+    double center_freq_hz;
+    double sample_rate_hz;
+    double f_start_hz;        // absolute frequency of bin 0
+    double df_hz;
+    char scale[16];
+    uint8_t reserved[256 - 80];
+} psd_shm_header_t;
+
+typedef struct {
+    char name[64];
+    int fd;
+    size_t map_bytes;
+    psd_shm_header_t *hdr;
+    float *data;
+    int writer;
+} psd_shm_t;
+
+/* Writer: create (or resize) the segment for up to `capacity` bins */
+int  psd_shm_create(psd_shm_t *s, const char *name, uint32_t capacity);
+
+/* Publish one frame; psd is the scaled trace, freq_rel the relative axis of bin 0 */
+int  psd_shm_publish(psd_shm_t *s, const double *psd, int nbins,
+                     double center_freq_hz, double sample_rate_hz,
+                     double f_start_rel_hz, double df_hz,
+                     const char *scale, uint64_t t_ns);
+
+/* Reader: map an existing segment read-only */
+int  psd_shm_open_reader(psd_shm_t *s, const char *name);
+
+/* Copy a consistent frame. Returns bins copied, 0 if nothing published yet, -1 on error.
+   Never more than this reader mapped: reopen after the writer grows the segment */
+int  psd_shm_read(const psd_shm_t *s, psd_shm_header_t *hdr_out, float *out, int max_bins);
+
+void psd_shm_close(psd_shm_t *s);
+
+/* Slow-path text export: freq_rel + center_freq => freq_abs, written to tmp + rename */
+int  psd_save_csv(const char *csv_path, const double *freq_rel, const double *psd, int length,
+                  uint64_t center_freq, const char *scale_label, const uint64_t *t_ns);
+
+#endif
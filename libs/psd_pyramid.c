@@ -0,0 +1,240 @@
+//libs/psd_pyramid.c
+#define _GNU_SOURCE
+#include "psd_pyramid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(psd_pyr_header_t) == 1024, "pyramid header must stay 1024 bytes");
+
+/* Level table for an n-bin frame; returns the floats it needs */
+static size_t pyr_layout(psd_pyr_level_t *lv, uint32_t *nlevels, uint32_t n, int min_bins) {
+    size_t off = n;
+    uint32_t L = 0;
+    lv[0].nbins = n;
+    lv[0].factor = 1;
+    lv[0].off_max = lv[0].off_mean = 0;
+
+    while (L + 1 < PSD_PYR_MAX_LEVELS && lv[L].nbins > (uint32_t)min_bins && lv[L].nbins > 1) {
+        psd_pyr_level_t *d = &lv[L + 1];
+        d->nbins = (lv[L].nbins + 1) / 2;
+        d->factor = lv[L].factor * 2;
+        d->off_max = (uint32_t)off;
+        d->off_mean = (uint32_t)(off + d->nbins);
+        off += 2 * (size_t)d->nbins;
+        L++;
+    }
+    *nlevels = L + 1;
+    return off;
+}
+
+int psd_pyr_create(psd_pyr_t *p, const char *name, uint32_t max_bins, int min_bins) {
+    if (!p || !name || max_bins == 0) return -1;
+    memset(p, 0, sizeof(*p));
+    p->fd = -1;
+    p->writer = 1;
+    p->min_bins = min_bins > 0 ? min_bins : 256;
+    snprintf(p->name, sizeof(p->name), "%s", name);
+
+    psd_pyr_level_t lv[PSD_PYR_MAX_LEVELS];
+    uint32_t nl;
+    size_t cap = pyr_layout(lv, &nl, max_bins, p->min_bins);
+    if (cap > UINT32_MAX) return -1;
+
+    p->fd = shm_open(p->name, O_RDWR | O_CREAT, 0644);
+    if (p->fd < 0) {
+        perror("[PYR] shm_open");
+        return -1;
+    }
+    p->map_bytes = sizeof(psd_pyr_header_t) + cap * sizeof(float);
+    if (ftruncate(p->fd, (off_t)p->map_bytes) != 0) {
+        perror("[PYR] ftruncate");
+        psd_pyr_close(p);
+        return -1;
+    }
+    void *map = mmap(NULL, p->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("[PYR] mmap");
+        psd_pyr_close(p);
+        return -1;
+    }
+    p->hdr = (psd_pyr_header_t*)map;
+    p->data = (float*)((uint8_t*)map + sizeof(psd_pyr_header_t));
+
+    /* keep seq monotonic across restarts so readers notice new frames */
+    uint64_t seq = (p->hdr->magic == PSD_PYR_MAGIC) ? (p->hdr->seq + 1) & ~1ull : 0;
+    __atomic_store_n(&p->hdr->seq, seq, __ATOMIC_RELEASE);
+    p->hdr->version = PSD_PYR_VERSION;
+    p->hdr->capacity = (uint32_t)cap;
+    p->hdr->nlevels = 0;
+    __atomic_store_n(&p->hdr->magic, PSD_PYR_MAGIC, __ATOMIC_RELEASE);
+
+    fprintf(stderr, "[PYR] /dev/shm%s | %u bins -> %u levels down to %u | %.2f MB\n",
+            p->name, max_bins, nl, lv[nl - 1].nbins, (double)p->map_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+/* One level from the previous one: pairs -> max and mean, odd tail copied */
+static void pyr_pool(const float *restrict smax, const float *restrict smean, uint32_t m,
+                     float *restrict dmax, float *restrict dmean) {
+    uint32_t half = m / 2;
+    #pragma omp simd
+    for (uint32_t j = 0; j < half; j++) {
+        float a = smax[2 * j], b = smax[2 * j + 1];
+        dmax[j] = a > b ? a : b;
+        dmean[j] = 0.5f * (smean[2 * j] + smean[2 * j + 1]);
+    }
+    if (m & 1) {
+        dmax[half] = smax[m - 1];
+        dmean[half] = smean[m - 1];
+    }
+}
+
+int psd_pyr_publish(psd_pyr_t *p, const double *psd, int n,
+                    double center_freq_hz, double sample_rate_hz,
+                    double f_start_rel_hz, double df_hz,
+                    const char *scale, uint64_t t_ns) {
+    if (!p || !p->hdr || !p->writer || !psd || n <= 0) return -1;
+
+    psd_pyr_header_t *h = p->hdr;
+    psd_pyr_level_t lv[PSD_PYR_MAX_LEVELS];
+    uint32_t nl;
+    if (pyr_layout(lv, &nl, (uint32_t)n, p->min_bins) > h->capacity) return -1;
+
+    uint64_t seq = __atomic_load_n(&h->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    h->nlevels = nl;
+    memcpy(h->level, lv, sizeof(lv[0]) * nl);
+    h->timestamp_ns = t_ns;
+    h->center_freq_hz = center_freq_hz;
+    h->sample_rate_hz = sample_rate_hz;
+    h->f_start_hz = center_freq_hz + f_start_rel_hz;
+    h->df_hz = df_hz;
+    snprintf(h->scale, sizeof(h->scale), "%s", scale ? scale : "lin");
+
+    float *d = p->data;
+    #pragma omp simd
+    for (int i = 0; i < n; i++) d[i] = (float)psd[i];
+
+    // every level reads the previous one (still in cache for the small ones): ~2n work in total
+    for (uint32_t L = 1; L < nl; L++) {
+        const psd_pyr_level_t *s = &lv[L - 1];
+        pyr_pool(d + s->off_max, d + s->off_mean, s->nbins, d + lv[L].off_max, d + lv[L].off_mean);
+    }
+
+    __atomic_store_n(&h->seq, seq + 2, __ATOMIC_RELEASE);
+    return (int)nl;
+}
+
+int psd_pyr_open_reader(psd_pyr_t *p, const char *name) {
+    if (!p || !name) return -1;
+    memset(p, 0, sizeof(*p));
+    snprintf(p->name, sizeof(p->name), "%s", name);
+
+    p->fd = shm_open(p->name, O_RDONLY, 0);
+    if (p->fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(p->fd, &st) != 0 || (size_t)st.st_size < sizeof(psd_pyr_header_t)) {
+        psd_pyr_close(p);
+        return -1;
+    }
+    p->map_bytes = (size_t)st.st_size;
+
+    void *map = mmap(NULL, p->map_bytes, PROT_READ, MAP_SHARED, p->fd, 0);
+    if (map == MAP_FAILED) {
+        psd_pyr_close(p);
+        return -1;
+    }
+    p->hdr = (psd_pyr_header_t*)map;
+    p->data = (float*)((uint8_t*)map + sizeof(psd_pyr_header_t));
+
+    if (p->hdr->magic != PSD_PYR_MAGIC ||
+        sizeof(psd_pyr_header_t) + (size_t)p->hdr->capacity * sizeof(float) > p->map_bytes) {
+        psd_pyr_close(p);
+        return -1;
+    }
+    return 0;
+}
+
+int psd_pyr_pick(const psd_pyr_header_t *h, double f0_hz, double f1_hz, int width,
+                 int *i0_out, int *n_out) {
+    if (!h || h->nlevels == 0 || h->nlevels > PSD_PYR_MAX_LEVELS || h->df_hz <= 0.0) return -1;
+    if (f1_hz < f0_hz) {
+        double t = f0_hz;
+        f0_hz = f1_hz;
+        f1_hz = t;
+    }
+
+    // level-0 bins centered inside [f0, f1]
+    int64_t n0 = h->level[0].nbins;
+    int64_t a = (int64_t)ceil((f0_hz - h->f_start_hz) / h->df_hz - 1e-9);
+    int64_t b = (int64_t)floor((f1_hz - h->f_start_hz) / h->df_hz + 1e-9) + 1;
+    if (a < 0) a = 0;
+    if (b > n0) b = n0;
+    if (b <= a) return -1;
+
+    int L = (int)h->nlevels - 1;
+    for (; L > 0; L--) {
+        int64_t F = h->level[L].factor;
+        if ((b - 1) / F + 1 - a / F >= width) break;
+    }
+    int64_t F = h->level[L].factor;
+    if (i0_out) *i0_out = (int)(a / F);
+    if (n_out) *n_out = (int)((b - 1) / F + 1 - a / F);
+    return L;
+}
+
+int psd_pyr_read(const psd_pyr_t *p, double f0_hz, double f1_hz, int width,
+                 psd_pyr_plane_t plane, float *out, int max_out,
+                 double *f_first_hz, double *df_out, uint64_t *t_ns_out) {
+    if (!p || !p->hdr || !out || max_out <= 0) return -1;
+    const psd_pyr_header_t *h = p->hdr;
+    size_t cap_floats = (p->map_bytes - sizeof(psd_pyr_header_t)) / sizeof(float);
+
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint64_t s1 = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) continue;
+
+        psd_pyr_header_t snap;
+        memcpy(&snap, h, sizeof(snap));
+        int i0 = 0, n = 0;
+        int L = psd_pyr_pick(&snap, f0_hz, f1_hz, width, &i0, &n);
+        if (L >= 0) {
+            const psd_pyr_level_t *lv = &snap.level[L];
+            size_t off = (plane == PSD_PYR_MEAN ? lv->off_mean : lv->off_max) + (size_t)i0;
+            if (n > max_out) n = max_out;
+            if (off + (size_t)n > cap_floats) n = 0;   // torn header: retried below
+            memcpy(out, p->data + off, (size_t)n * sizeof(float));
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t s2 = __atomic_load_n(&h->seq, __ATOMIC_RELAXED);
+        if (s1 != s2) continue;
+
+        if (L < 0) return 0;
+        double F = snap.level[L].factor;
+        if (f_first_hz) *f_first_hz = snap.f_start_hz + ((double)i0 * F + (F - 1.0) / 2.0) * snap.df_hz;
+        if (df_out) *df_out = F * snap.df_hz;
+        if (t_ns_out) *t_ns_out = snap.timestamp_ns;
+        return n;
+    }
+    return -1;
+}
+
+void psd_pyr_close(psd_pyr_t *p) {
+    if (!p) return;
+    if (p->hdr) munmap(p->hdr, p->map_bytes);
+    if (p->fd >= 0) close(p->fd);
+    p->hdr = NULL;
+    p->data = NULL;
+    p->fd = -1;
+}
@@ -0,0 +1,99 @@
+//libs/psd_pyramid.h
+#ifndef PSD_PYRAMID_H
+#define PSD_PYRAMID_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  Display pyramid of the scaled PSD in POSIX shared memory (/dev/shm/<name>):
+
+    [psd_pyr_header_t, 1024 bytes][float32 data[capacity]]
+
+  Level 0 is the full-resolution span crop. Level L pools 2^L level-0 bins:
+  bin j covers level-0 bins [j * 2^L, (j + 1) * 2^L) (the last one may be
+  shorter), centered at f_start_hz + (j * 2^L + (2^L - 1) / 2) * df_hz.
+  Each level keeps two planes: max (peaks survive any zoom) and mean (the
+  average of the published values: log-average on dB scales). For level 0
+  both offsets point to the same plane.
+
+  Same seqlock as psd_pub.h: seq is odd while a frame is being written.
+  A client zoomed on [f0, f1] at W pixels picks the coarsest level that
+  still has >= W bins in the range (psd_pyr_pick) and maps only that slice.
+*/
+
+#define PSD_PYR_MAGIC       0x52595050u   /* "PPYR" */
+#define PSD_PYR_VERSION     1u
+#define PSD_PYR_MAX_LEVELS  32
+
+typedef struct {
+    uint32_t nbins;
+    uint32_t factor;          // level-0 bins per bin (2^L)
+    uint32_t off_max;         // float offset of the max plane in data[]
+    uint32_t off_mean;        // ... and of the mean plane
+} psd_pyr_level_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;        // floats in data[]
+    uint32_t nlevels;         // levels in the current frame
+    uint64_t seq;             // seqlock counter (even = stable)
+    uint64_t timestamp_ns;    // CLOCK_REALTIME of the frame
+    double center_freq_hz;
+    double sample_rate_hz;
+    double f_start_hz;        // absolute frequency of level-0 bin 0
+    double df_hz;             // level-0 bin spacing
+    char scale[16];
+    uint8_t reserved[256 - 80];
+    psd_pyr_level_t level[PSD_PYR_MAX_LEVELS];
+    uint8_t reserved2[1024 - 256 - PSD_PYR_MAX_LEVELS * 16];
+} psd_pyr_header_t;
+
+typedef struct {
+    char name[64];
+    int fd;
+    size_t map_bytes;
+    psd_pyr_header_t *hdr;
+    float *data;
+    int writer;
+    int min_bins;             // writer: stop pooling at this size
+} psd_pyr_t;
+
+typedef enum {
+    PSD_PYR_MAX  = 0,
+    PSD_PYR_MEAN = 1
+} psd_pyr_plane_t;
+
+/* Writer: segment for frames of up to max_bins bins, pooled down to min_bins (0 = 256) */
+int  psd_pyr_create(psd_pyr_t *p, const char *name, uint32_t max_bins, int min_bins);
+
+/* Build every level from one scaled trace (n bins) and publish it */
+int  psd_pyr_publish(psd_pyr_t *p, const double *psd, int n,
+                     double center_freq_hz, double sample_rate_hz,
+                     double f_start_rel_hz, double df_hz,
+                     const char *scale, uint64_t t_ns);
+
+/* Reader: map an existing segment read-only */
+int  psd_pyr_open_reader(psd_pyr_t *p, const char *name);
+
+/*
+  Level and slice for [f0_hz, f1_hz] (absolute) at `width` pixels: the
+  coarsest level with at least `width` bins in the range (level 0 if even
+  that has fewer). Returns the level, -1 if the range misses the frame.
+*/
+int  psd_pyr_pick(const psd_pyr_header_t *h, double f0_hz, double f1_hz, int width,
+                  int *i0_out, int *n_out);
+
+/*
+  Consistent copy of the slice psd_pyr_pick selects (at most max_out bins).
+  f_first_hz / df_out: axis of the copied bins. Returns bins copied, 0 if
+  nothing is published or the range misses the frame, -1 on error.
+*/
+int  psd_pyr_read(const psd_pyr_t *p, double f0_hz, double f1_hz, int width,
+                  psd_pyr_plane_t plane, float *out, int max_out,
+                  double *f_first_hz, double *df_out, uint64_t *t_ns_out);
+
+void psd_pyr_close(psd_pyr_t *p);
+
+#endif
@@ -0,0 +1,223 @@
+//libs/psd_sched.c
+#include "psd_sched.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static bool same_group(const SDR_cfg_t *a, const SDR_cfg_t *b) {
+    return a->sample_rate == b->sample_rate && a->lna_gain == b->lna_gain &&
+           a->vga_gain == b->vga_gain && a->amp_enabled == b->amp_enabled &&
+           a->ppm_error == b->ppm_error;
+}
+
+static bool same_psd(const PsdConfig_t *a, const PsdConfig_t *b) {
+    return a->nperseg == b->nperseg && a->noverlap == b->noverlap &&
+           a->window_type == b->window_type && a->window_param == b->window_param &&
+           a->sample_rate == b->sample_rate && a->zoom_decim == b->zoom_decim &&
+           a->zoom_shift_hz == b->zoom_shift_hz && a->estimator == b->estimator &&
+           a->mt_nw == b->mt_nw && a->mt_k == b->mt_k;
+}
+
+/* Top-level config + job overrides -> hardware / PSD parameters (LO = center - lo_offset) */
+static int job_resolve(psd_job_t *j, const DesiredCfg_t *base, double lo_offset) {
+    const JobCfg_t *c = j->cfg;
+    DesiredCfg_t *d = &j->des;
+    *d = *base;
+    d->jobs = NULL;
+    d->n_jobs = 0;
+    d->center_freq = (uint64_t)llround(c->center_hz);
+    if (c->span > 0) d->span = c->span;
+    if (c->rbw > 0) d->rbw = c->rbw;
+    if (c->window >= 0) d->window_type = (PsdWindowType_t)c->window;
+    if (c->sample_rate > 0) d->sample_rate = c->sample_rate;
+    if (c->lna_gain >= 0) d->lna_gain = c->lna_gain;
+    if (c->vga_gain >= 0) d->vga_gain = c->vga_gain;
+    if (c->amp >= 0) d->amp_enabled = c->amp != 0;
+    d->lo_offset = lo_offset;
+
+    RB_cfg_t rb;
+    memset(&j->hw, 0, sizeof(j->hw));
+    memset(&j->psd, 0, sizeof(j->psd));
+    memset(&rb, 0, sizeof(rb));
+    if (find_params_psd(*d, &j->hw, &j->psd, &rb) != 0) return -1;
+
+    // Full band: crop around lo_offset instead of running the NCO over the capture
+    if (j->psd.zoom_decim <= 1) j->psd.zoom_shift_hz = 0.0;
+
+    int decim = j->psd.zoom_decim > 1 ? j->psd.zoom_decim : 1;
+    size_t need = ((size_t)j->psd.nperseg + PSD_ZOOM_CIC_ORDER) * (size_t)decim * 2;
+    j->bytes = (c->duration_s > 0) ? (size_t)(c->duration_s * j->hw.sample_rate) * 2 : rb.total_bytes;
+    if (j->bytes < need) j->bytes = need;
+
+    j->f_lo = c->center_hz - d->span / 2.0;
+    j->f_hi = c->center_hz + d->span / 2.0;
+    return 0;
+}
+
+static int cmp_job(const void *a, const void *b) {
+    const psd_job_t *x = (const psd_job_t*)a, *y = (const psd_job_t*)b;
+    if (x->hw.sample_rate != y->hw.sample_rate) return x->hw.sample_rate < y->hw.sample_rate ? -1 : 1;
+    if (x->hw.amp_enabled != y->hw.amp_enabled) return x->hw.amp_enabled ? 1 : -1;
+    if (x->hw.lna_gain != y->hw.lna_gain) return x->hw.lna_gain - y->hw.lna_gain;
+    if (x->hw.vga_gain != y->hw.vga_gain) return x->hw.vga_gain - y->hw.vga_gain;
+    if (x->f_lo != y->f_lo) return x->f_lo < y->f_lo ? -1 : 1;
+    return x->index - y->index;
+}
+
+void psd_sched_free(psd_sched_t *s) {
+    if (!s) return;
+    for (int e = 0; e < s->n_engines; e++) psd_welch_free(&s->engines[e]);
+    free(s->engines);
+    free(s->jobs);
+    free(s->order);
+    free(s->batches);
+    free(s->freq);
+    free(s->psd);
+    free(s->cap);
+    memset(s, 0, sizeof(*s));
+}
+
+int psd_sched_plan(psd_sched_t *s, const DesiredCfg_t *base) {
+    if (!s || !base || base->n_jobs <= 0 || !base->jobs) return -1;
+    memset(s, 0, sizeof(*s));
+
+    int n = base->n_jobs;
+    s->jobs = (psd_job_t*)calloc((size_t)n, sizeof(psd_job_t));
+    s->order = (int*)malloc((size_t)n * sizeof(int));
+    s->batches = (psd_batch_t*)calloc((size_t)n, sizeof(psd_batch_t));
+    s->engines = (psd_welch_t*)calloc((size_t)n, sizeof(psd_welch_t));
+    if (!s->jobs || !s->order || !s->batches || !s->engines) {
+        psd_sched_free(s);
+        return -1;
+    }
+    s->n_jobs = n;
+
+    for (int i = 0; i < n; i++) {
+        psd_job_t *j = &s->jobs[i];
+        j->cfg = &base->jobs[i];
+        j->index = i;
+        if (j->cfg->id[0]) snprintf(j->id, sizeof(j->id), "%s", j->cfg->id);
+        else snprintf(j->id, sizeof(j->id), "job%d", i);
+        if (job_resolve(j, base, base->lo_offset) != 0) {
+            fprintf(stderr, "[SCHED] %s: invalid PSD parameters\n", j->id);
+            psd_sched_free(s);
+            return -1;
+        }
+    }
+    qsort(s->jobs, (size_t)n, sizeof(psd_job_t), cmp_job);
+
+    // Serpentine: every other rate/gain group runs top-down, so a group starts where the last one ended
+    int groups = 0;
+    for (int g0 = 0; g0 < n; groups++) {
+        int g1 = g0 + 1;
+        while (g1 < n && same_group(&s->jobs[g1].hw, &s->jobs[g0].hw)) g1++;
+        for (int k = g0; k < g1; k++) s->order[k] = (groups & 1) ? g1 - 1 - (k - g0) : k;
+        g0 = g1;
+    }
+
+    // Batches: a job joins the current tuning when its whole band fits in the usable part
+    for (int k = 0; k < n; k++) {
+        psd_job_t *j = &s->jobs[s->order[k]];
+        psd_batch_t *b = s->n_batches ? &s->batches[s->n_batches - 1] : NULL;
+        if (b && same_group(&b->hw, &j->hw)) {
+            double lo = (double)b->hw.center_freq;
+            double half = PSD_SCHED_USABLE * b->hw.sample_rate / 2.0;
+            if (j->f_lo >= lo - half && j->f_hi <= lo + half) {
+                if (job_resolve(j, base, j->cfg->center_hz - lo) != 0) {
+                    fprintf(stderr, "[SCHED] %s: invalid PSD parameters at shared LO %.3f MHz\n",
+                            j->id, lo / 1e6);
+                    psd_sched_free(s);
+                    return -1;
+                }
+                j->hw.center_freq = b->hw.center_freq;
+                b->count++;
+                if (j->bytes > b->bytes) b->bytes = j->bytes;
+                continue;
+            }
+        }
+        b = &s->batches[s->n_batches++];
+        b->first = k;
+        b->count = 1;
+        b->hw = j->hw;
+        b->bytes = j->bytes;
+    }
+
+    // One Welch engine per distinct PSD config; scratch and capture sized for the largest
+    for (int i = 0; i < n; i++) {
+        psd_job_t *j = &s->jobs[i];
+        int e = 0;
+        while (e < s->n_engines && !same_psd(&s->engines[e].cfg, &j->psd)) e++;
+        if (e == s->n_engines) {
+            if (psd_welch_init(&s->engines[e], &j->psd) != 0) {
+                fprintf(stderr, "[SCHED] %s: PSD setup failed\n", j->id);
+                psd_sched_free(s);
+                return -1;
+            }
+            if (s->engines[e].nfft > s->max_nfft) s->max_nfft = s->engines[e].nfft;
+            s->n_engines++;
+        }
+        j->engine = e;
+    }
+    for (int b = 0; b < s->n_batches; b++) {
+        if (s->batches[b].bytes > s->cap_bytes) s->cap_bytes = s->batches[b].bytes;
+    }
+    s->freq = (double*)malloc((size_t)s->max_nfft * sizeof(double));
+    s->psd = (double*)malloc((size_t)s->max_nfft * sizeof(double));
+    s->cap = (int8_t*)malloc(s->cap_bytes);
+    if (!s->freq || !s->psd || !s->cap) {
+        psd_sched_free(s);
+        return -1;
+    }
+
+    fprintf(stderr, "[SCHED] plan: %d jobs -> %d captures (%d shared), %d rate/gain groups, %d PSD engines, %.1f MB max capture\n",
+            n, s->n_batches, n - s->n_batches, groups, s->n_engines, s->cap_bytes / 1e6);
+    return 0;
+}
+
+int psd_sched_run(psd_sched_t *s, psd_sched_acquire_fn acquire, psd_sched_out_fn out, void *user) {
+    if (!s || !s->jobs || !acquire) return -1;
+
+    s->rate_changes = s->gain_changes = s->retunes = 0;
+    uint64_t t0 = psd_now_ns();
+    int done = 0;
+    const SDR_cfg_t *prev = NULL;
+
+    for (int bi = 0; bi < s->n_batches; bi++) {
+        const psd_batch_t *b = &s->batches[bi];
+        if (prev) {
+            if (prev->sample_rate != b->hw.sample_rate) s->rate_changes++;
+            if (prev->lna_gain != b->hw.lna_gain || prev->vga_gain != b->hw.vga_gain ||
+                prev->amp_enabled != b->hw.amp_enabled) s->gain_changes++;
+            if (prev->center_freq != b->hw.center_freq) s->retunes++;
+        }
+        prev = &b->hw;
+
+        if (acquire(user, &b->hw, s->cap, b->bytes) != 0) {
+            fprintf(stderr, "[SCHED] capture failed at %.3f MHz\n", b->hw.center_freq / 1e6);
+            return -1;
+        }
+        uint64_t t_cap = psd_now_ns();
+
+        // every job of the batch reads the same capture (its own length, its own PSD config)
+        for (int k = b->first; k < b->first + b->count; k++) {
+            const psd_job_t *j = &s->jobs[s->order[k]];
+            psd_welch_t *w = &s->engines[j->engine];
+            psd_welch_reset(w);
+            psd_welch_run_iq8(w, s->cap, j->bytes / 2, t_cap);
+            if (psd_welch_result(w, s->freq, s->psd) <= 0) continue;
+            scale_psd(s->psd, w->nfft, j->des.scale);
+
+            int start = 0;
+            int len = psd_span_bins(s->freq, w->nfft, j->des.lo_offset, j->des.span, &start);
+            if (len > 0 && out) out(user, j, &s->freq[start], &s->psd[start], len, t_cap);
+            done++;
+        }
+    }
+
+    s->elapsed_s = (double)(psd_now_ns() - t0) / 1e9;
+    fprintf(stderr, "[SCHED] %d jobs in %.2f s (%.1f jobs/s) | %d captures, %d rate changes, %d gain changes, %d retunes\n",
+            done, s->elapsed_s, s->elapsed_s > 0 ? done / s->elapsed_s : 0.0,
+            s->n_batches, s->rate_changes, s->gain_changes, s->retunes);
+    return done;
+}
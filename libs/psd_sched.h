@@ -0,0 +1,81 @@
+//libs/psd_sched.h
+#ifndef PSD_SCHED_H
+#define PSD_SCHED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "psd.h"
+
+/*
+  Campaign job scheduler. Jobs (DesiredCfg_t.jobs) are resolved against the
+  top-level config, then ordered so the expensive hardware changes happen as
+  rarely as possible:
+
+    1. grouped by sample rate (hackrf_set_sample_rate is the slow one),
+    2. then by gain setting,
+    3. by frequency inside each group, alternating direction between
+       groups so the PLL never jumps back across the band.
+
+  Consecutive jobs with the same rate and gains whose band fits inside the
+  usable part of one tuning share a batch: one LO, one capture, and each
+  job runs its own PSD on it (cropped through lo_offset, the same way a
+  single measurement keeps the DC spike out of span).
+*/
+
+#define PSD_SCHED_USABLE 0.8   // fraction of fs a job may use inside a shared tuning
+
+typedef struct {
+    const JobCfg_t *cfg;
+    int index;                // position in the request
+    char id[32];
+    DesiredCfg_t des;         // top-level config with the job's overrides (shallow copy)
+    SDR_cfg_t hw;
+    PsdConfig_t psd;
+    size_t bytes;             // IQ this job needs (int8 I/Q pairs)
+    double f_lo;              // absolute band
+    double f_hi;
+    int engine;               // into engines[]
+} psd_job_t;
+
+typedef struct {
+    int first;                // into order[]
+    int count;
+    SDR_cfg_t hw;             // one tuning for every job of the batch
+    size_t bytes;             // longest job
+} psd_batch_t;
+
+/* Tune to hw (if it changed) and fill dst with `bytes` of settled IQ; 0 on success */
+typedef int  (*psd_sched_acquire_fn)(void *user, const SDR_cfg_t *hw, int8_t *dst, size_t bytes);
+
+/* One finished job: scaled PSD cropped to its span, freq_rel relative to job->hw.center_freq */
+typedef void (*psd_sched_out_fn)(void *user, const psd_job_t *job, const double *freq_rel,
+                                 const double *psd, int nbins, uint64_t t_ns);
+
+typedef struct {
+    psd_job_t *jobs;
+    int n_jobs;
+    int *order;               // execution order (indices into jobs[])
+    psd_batch_t *batches;
+    int n_batches;
+
+    psd_welch_t *engines;     // one per distinct PsdConfig_t (window + plan shared)
+    int n_engines;
+    double *freq;
+    double *psd;
+    int max_nfft;
+
+    int8_t *cap;
+    size_t cap_bytes;
+
+    /* last run */
+    int rate_changes;
+    int gain_changes;
+    int retunes;
+    double elapsed_s;
+} psd_sched_t;
+
+int  psd_sched_plan(psd_sched_t *s, const DesiredCfg_t *base);
+int  psd_sched_run(psd_sched_t *s, psd_sched_acquire_fn acquire, psd_sched_out_fn out, void *user);
+void psd_sched_free(psd_sched_t *s);
+
+#endif
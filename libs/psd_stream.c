@@ -0,0 +1,448 @@
+//libs/psd_stream.c
+#define _GNU_SOURCE
+#include "psd_stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <zlib.h>
+
+_Static_assert(sizeof(psd_stream_hdr_t) == 56, "stream header must stay 56 bytes");
+
+/* Unchanged bins a run may swallow: cheaper than closing it and opening another */
+#define PSD_STREAM_RUN_GAP 4
+
+struct psd_stream_buf {
+    uint8_t *data;            // header + payload
+    size_t len;
+    size_t cap;
+    int refs;                 // clients still sending it
+};
+
+static double stream_step(const psd_stream_cfg_t *c) {
+    return (c->db_max - c->db_min) / 255.0;
+}
+
+static int set_nonblock(int fd) {
+    int fl = fcntl(fd, F_GETFL, 0);
+    return (fl < 0) ? -1 : fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+}
+
+/* ------------------------------------------------------------------ producer */
+
+int psd_stream_push(psd_stream_t *st, const double *db, int n,
+                    double freq_abs0, double df_hz, uint64_t t_ns) {
+    if (!st || !st->started || !db || n <= 0) return -1;
+
+    int g = (n + st->row_cap - 1) / st->row_cap;
+    int m = (n + g - 1) / g;
+    float off = (float)st->cfg.db_min;
+    float inv = (float)(1.0 / stream_step(&st->cfg));
+    uint8_t *row = st->row;
+
+    if (g == 1) {
+        #pragma omp simd
+        for (int i = 0; i < n; i++) {
+            float q = ((float)db[i] - off) * inv + 0.5f;
+            row[i] = (uint8_t)fminf(fmaxf(q, 0.0f), 255.0f);
+        }
+    } else {
+        for (int j = 0; j < m; j++) {
+            int i0 = j * g, i1 = i0 + g < n ? i0 + g : n;
+            double mx = db[i0];
+            for (int i = i0 + 1; i < i1; i++) mx = db[i] > mx ? db[i] : mx;
+            float q = ((float)mx - off) * inv + 0.5f;
+            row[j] = (uint8_t)fminf(fmaxf(q, 0.0f), 255.0f);
+        }
+    }
+
+    // never wait for the server: if it holds the slot this frame is dropped
+    if (pthread_mutex_trylock(&st->mtx) != 0) {
+        st->dropped++;
+        return 0;
+    }
+    memcpy(st->latest, row, (size_t)m);
+    st->latest_n = m;
+    st->latest_t_ns = t_ns;
+    st->latest_f0 = freq_abs0 + 0.5 * (g - 1) * df_hz;
+    st->latest_df = df_hz * g;
+    st->latest_seq++;
+    pthread_mutex_unlock(&st->mtx);
+
+    char c = 1;
+    ssize_t w = write(st->wake[1], &c, 1);   // full pipe = server already woken
+    (void)w;
+    return m;
+}
+
+/* ------------------------------------------------------------------ encoding */
+
+static psd_stream_buf_t* buf_get(psd_stream_t *st) {
+    for (int i = 0; i < st->pool_n; i++) {
+        if (st->pool[i].refs == 0) return &st->pool[i];
+    }
+    return NULL;
+}
+
+static size_t put_varint(uint8_t *p, uint32_t v) {
+    size_t k = 0;
+    while (v >= 0x80) {
+        p[k++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[k++] = (uint8_t)v;
+    return k;
+}
+
+static size_t varint_len(uint32_t v) {
+    size_t k = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        k++;
+    }
+    return k;
+}
+
+/*
+  Bins of cur that left the deadband around ref, as runs; ref takes the sent
+  values. Returns the payload size, or -1 (ref untouched) when the delta
+  would not be smaller than a KEY.
+*/
+static long encode_delta(psd_stream_t *st, int n) {
+    const uint8_t *cur = st->cur;
+    uint8_t *ref = st->ref;
+    uint8_t *out = st->scratch;
+    int d = st->cfg.deadband;
+    size_t pos = 0;
+    int last = 0;
+
+    // dry run first: ref may only change if the delta is used
+    for (int pass = 0; pass < 2; pass++) {
+        pos = 0;
+        last = 0;
+        int i = 0;
+        while (i < n) {
+            if (abs((int)cur[i] - (int)ref[i]) <= d) {
+                i++;
+                continue;
+            }
+            int end = i + 1;
+            for (int j = i + 1; j < n && j - end < PSD_STREAM_RUN_GAP; j++) {
+                if (abs((int)cur[j] - (int)ref[j]) > d) end = j + 1;
+            }
+            if (pass == 0) {
+                pos += varint_len((uint32_t)(i - last)) + varint_len((uint32_t)(end - i)) + (size_t)(end - i);
+                if (pos >= (size_t)n) return -1;
+            } else {
+                pos += put_varint(out + pos, (uint32_t)(i - last));
+                pos += put_varint(out + pos, (uint32_t)(end - i));
+                memcpy(out + pos, cur + i, (size_t)(end - i));
+                memcpy(ref + i, cur + i, (size_t)(end - i));
+                pos += (size_t)(end - i);
+            }
+            last = end;
+            i = end;
+        }
+    }
+    return (long)pos;
+}
+
+static psd_stream_buf_t* make_msg(psd_stream_t *st, uint8_t type, const uint8_t *raw, size_t raw_len,
+                                  uint64_t t_ns) {
+    psd_stream_buf_t *b = buf_get(st);
+    if (!b) return NULL;
+
+    psd_stream_hdr_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic = PSD_STREAM_MAGIC;
+    h.version = PSD_STREAM_VERSION;
+    h.type = type;
+    h.seq = st->seq;
+    h.nbins = (uint32_t)st->ref_n;
+    h.t_ns = t_ns;
+    h.f_start_hz = st->ref_f0;
+    h.df_hz = st->ref_df;
+    h.db_offset = (float)st->cfg.db_min;
+    h.db_step = (float)stream_step(&st->cfg);
+    h.raw_bytes = (uint32_t)raw_len;
+
+    uint8_t *payload = b->data + sizeof(h);
+    uLongf zlen = (uLongf)(b->cap - sizeof(h));
+    if (st->cfg.compress && raw_len > 64 &&
+        compress2(payload, &zlen, raw, (uLong)raw_len, Z_BEST_SPEED) == Z_OK && zlen < raw_len) {
+        h.flags |= PSD_STREAM_F_ZLIB;
+        h.payload_bytes = (uint32_t)zlen;
+    } else {
+        memcpy(payload, raw, raw_len);
+        h.payload_bytes = (uint32_t)raw_len;
+    }
+    memcpy(b->data, &h, sizeof(h));
+    b->len = sizeof(h) + h.payload_bytes;
+    return b;
+}
+
+/* ------------------------------------------------------------------ clients */
+
+static void client_drop(psd_stream_t *st, int k) {
+    psd_stream_client_t *c = &st->cl[k];
+    if (c->buf) c->buf->refs--;
+    close(c->fd);
+    fprintf(stderr, "[STREAM] client %d left | %.1f MB sent, %llu frames skipped\n",
+            k, (double)c->sent_bytes / (1024.0 * 1024.0), (unsigned long long)c->skipped);
+    st->cl[k] = st->cl[--st->ncl];
+    memset(&st->cl[st->ncl], 0, sizeof(st->cl[0]));
+}
+
+/* Send as much as the socket takes; 0 = ok (maybe still pending), -1 = drop */
+static int client_flush(psd_stream_t *st, psd_stream_client_t *c) {
+    while (c->buf && c->off < c->buf->len) {
+        ssize_t w = send(c->fd, c->buf->data + c->off, c->buf->len - c->off, MSG_NOSIGNAL);
+        if (w < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+        c->off += (size_t)w;
+        c->sent_bytes += (uint64_t)w;
+        st->bytes_out += (uint64_t)w;
+    }
+    if (c->buf) {
+        c->buf->refs--;
+        c->buf = NULL;
+    }
+    return 0;
+}
+
+static void stream_accept(psd_stream_t *st) {
+    int fd = accept(st->listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    if (st->ncl >= st->cfg.max_clients) {
+        close(fd);
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    set_nonblock(fd);
+    psd_stream_client_t *c = &st->cl[st->ncl++];
+    memset(c, 0, sizeof(*c));
+    c->fd = fd;
+    fprintf(stderr, "[STREAM] client %d connected (%d total)\n", st->ncl - 1, st->ncl);
+}
+
+/* Encode the new frame once and hand it to every idle client */
+static void stream_frame(psd_stream_t *st, int n, double f0, double df, uint64_t t_ns) {
+    psd_stream_buf_t *delta = NULL, *key = NULL;
+    st->seq++;
+    st->frames++;
+
+    if (n != st->ref_n || f0 != st->ref_f0 || df != st->ref_df) {
+        // new geometry: everybody restarts from a KEY
+        memcpy(st->ref, st->cur, (size_t)n);
+        st->ref_n = n;
+        st->ref_f0 = f0;
+        st->ref_df = df;
+        for (int k = 0; k < st->ncl; k++) st->cl[k].synced = false;
+    } else {
+        long raw = encode_delta(st, n);
+        if (raw >= 0) {
+            delta = make_msg(st, PSD_STREAM_DELTA, st->scratch, (size_t)raw, t_ns);
+            if (delta) delta->refs++;   // pinned: the KEY below must not reuse it before a client takes it
+        } else {
+            memcpy(st->ref, st->cur, (size_t)n);
+            for (int k = 0; k < st->ncl; k++) st->cl[k].synced = false;
+        }
+    }
+
+    for (int k = 0; k < st->ncl; k++) {
+        psd_stream_client_t *c = &st->cl[k];
+        if (c->buf) {               // still sending an older frame: skip this one
+            c->synced = false;
+            c->skipped++;
+            continue;
+        }
+        if (c->synced && delta) {
+            c->buf = delta;
+        } else {
+            if (!key) key = make_msg(st, PSD_STREAM_KEY, st->ref, (size_t)n, t_ns);
+            if (!key) continue;
+            c->buf = key;
+            c->synced = true;
+        }
+        c->buf->refs++;
+        c->off = 0;
+    }
+    if (delta) delta->refs--;
+    for (int k = st->ncl - 1; k >= 0; k--) {
+        if (client_flush(st, &st->cl[k]) != 0) client_drop(st, k);
+    }
+}
+
+static void* stream_thread_fn(void *arg) {
+    psd_stream_t *st = (psd_stream_t*)arg;
+    struct pollfd pfd[2 + PSD_STREAM_MAX_CLIENTS];
+    uint64_t seen = 0;
+    char junk[256];
+
+    while (!st->stop) {
+        pfd[0].fd = st->wake[0];
+        pfd[0].events = POLLIN;
+        pfd[1].fd = st->listen_fd;
+        pfd[1].events = POLLIN;
+        int ncl = st->ncl;
+        for (int k = 0; k < ncl; k++) {
+            pfd[2 + k].fd = st->cl[k].fd;
+            pfd[2 + k].events = POLLIN | (st->cl[k].buf ? POLLOUT : 0);
+            pfd[2 + k].revents = 0;
+        }
+        if (poll(pfd, (nfds_t)(2 + ncl), 200) <= 0) continue;
+
+        // clients first: pfd[] indices only match before accept / drop
+        for (int k = ncl - 1; k >= 0; k--) {
+            short re = pfd[2 + k].revents;
+            int bad = (re & (POLLERR | POLLNVAL)) != 0;
+            if (!bad && (re & (POLLIN | POLLHUP))) {
+                ssize_t r = recv(st->cl[k].fd, junk, sizeof(junk), 0);   // clients never talk: EOF or junk
+                bad = (r == 0) || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+            }
+            if (!bad && (re & POLLOUT)) bad = client_flush(st, &st->cl[k]) != 0;
+            if (bad) client_drop(st, k);
+        }
+        if (pfd[1].revents & POLLIN) stream_accept(st);
+
+        if (pfd[0].revents & POLLIN) {
+            while (read(st->wake[0], junk, sizeof(junk)) > 0) {}
+
+            pthread_mutex_lock(&st->mtx);
+            int n = 0;
+            double f0 = 0.0, df = 0.0;
+            uint64_t t_ns = 0;
+            if (st->latest_seq != seen) {
+                seen = st->latest_seq;
+                uint8_t *t = st->cur;
+                st->cur = st->latest;
+                st->latest = t;
+                n = st->latest_n;
+                f0 = st->latest_f0;
+                df = st->latest_df;
+                t_ns = st->latest_t_ns;
+            }
+            pthread_mutex_unlock(&st->mtx);
+
+            if (n > 0) stream_frame(st, n, f0, df, t_ns);
+        }
+    }
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ lifecycle */
+
+int psd_stream_open(psd_stream_t *st, const psd_stream_cfg_t *cfg) {
+    if (!st || !cfg || cfg->port <= 0) return -1;
+    memset(st, 0, sizeof(*st));
+    st->listen_fd = -1;
+    st->wake[0] = st->wake[1] = -1;
+    st->cfg = *cfg;
+    if (st->cfg.bins <= 0) st->cfg.bins = 2048;
+    if (st->cfg.db_max <= st->cfg.db_min) {
+        st->cfg.db_min = -140.0;
+        st->cfg.db_max = -12.5;
+    }
+    if (st->cfg.deadband < 0) st->cfg.deadband = 0;
+    if (st->cfg.max_clients <= 0) st->cfg.max_clients = 8;
+    if (st->cfg.max_clients > PSD_STREAM_MAX_CLIENTS) st->cfg.max_clients = PSD_STREAM_MAX_CLIENTS;
+    pthread_mutex_init(&st->mtx, NULL);
+
+    size_t n = (size_t)st->cfg.bins;
+    st->row_cap = st->cfg.bins;
+    st->row = (uint8_t*)malloc(n);
+    st->latest = (uint8_t*)malloc(n);
+    st->cur = (uint8_t*)malloc(n);
+    st->ref = (uint8_t*)malloc(n);
+    st->scratch_cap = n + 16;
+    st->scratch = (uint8_t*)malloc(st->scratch_cap);
+    // every client holds at most one message, plus this frame's KEY and DELTA
+    st->pool_n = st->cfg.max_clients + 2;
+    st->pool = (psd_stream_buf_t*)calloc((size_t)st->pool_n, sizeof(psd_stream_buf_t));
+    int ok = st->row && st->latest && st->cur && st->ref && st->scratch && st->pool;
+    for (int i = 0; ok && i < st->pool_n; i++) {
+        st->pool[i].cap = sizeof(psd_stream_hdr_t) + compressBound((uLong)st->scratch_cap);
+        st->pool[i].data = (uint8_t*)malloc(st->pool[i].cap);
+        ok = st->pool[i].data != NULL;
+    }
+    if (!ok) {
+        fprintf(stderr, "[STREAM] alloc failed\n");
+        psd_stream_close(st);
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)cfg->port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // no auth: other interfaces only on request
+    if (cfg->bind_addr && inet_pton(AF_INET, cfg->bind_addr, &addr.sin_addr) != 1) {
+        fprintf(stderr, "[STREAM] bad bind address %s\n", cfg->bind_addr);
+        psd_stream_close(st);
+        return -1;
+    }
+    int one = 1;
+    st->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (st->listen_fd < 0 ||
+        setsockopt(st->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(st->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(st->listen_fd, 8) != 0 || set_nonblock(st->listen_fd) != 0) {
+        perror("[STREAM] listen");
+        psd_stream_close(st);
+        return -1;
+    }
+    if (pipe(st->wake) != 0 || set_nonblock(st->wake[0]) != 0 || set_nonblock(st->wake[1]) != 0) {
+        perror("[STREAM] pipe");
+        psd_stream_close(st);
+        return -1;
+    }
+
+    if (pthread_create(&st->th, NULL, stream_thread_fn, st) != 0) {
+        fprintf(stderr, "[STREAM] thread create failed\n");
+        psd_stream_close(st);
+        return -1;
+    }
+    st->started = true;
+
+    fprintf(stderr, "[STREAM] tcp %s:%d | %d bins, %.3f dB/level from %.1f, deadband %d%s\n",
+            cfg->bind_addr ? cfg->bind_addr : "127.0.0.1", cfg->port, st->cfg.bins,
+            stream_step(&st->cfg), st->cfg.db_min, st->cfg.deadband, st->cfg.compress ? ", zlib" : "");
+    return 0;
+}
+
+void psd_stream_close(psd_stream_t *st) {
+    if (!st) return;
+    if (st->started) {
+        st->stop = true;
+        char c = 1;
+        ssize_t w = write(st->wake[1], &c, 1);
+        (void)w;
+        pthread_join(st->th, NULL);
+        fprintf(stderr, "[STREAM] %llu frames | %llu dropped | %.1f MB out\n",
+                (unsigned long long)st->frames, (unsigned long long)st->dropped,
+                (double)st->bytes_out / (1024.0 * 1024.0));
+    }
+    pthread_mutex_destroy(&st->mtx);
+    while (st->ncl > 0) client_drop(st, st->ncl - 1);
+    if (st->listen_fd >= 0) close(st->listen_fd);
+    if (st->wake[0] >= 0) close(st->wake[0]);
+    if (st->wake[1] >= 0) close(st->wake[1]);
+    for (int i = 0; st->pool && i < st->pool_n; i++) free(st->pool[i].data);
+    free(st->pool);
+    free(st->row);
+    free(st->latest);
+    free(st->cur);
+    free(st->ref);
+    free(st->scratch);
+    memset(st, 0, sizeof(*st));
+    st->listen_fd = -1;
+}
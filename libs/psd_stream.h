@@ -0,0 +1,132 @@
+//libs/psd_stream.h
+#ifndef PSD_STREAM_H
+#define PSD_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/*
+  Spectrum stream over plain TCP (any number of clients, one encoding per frame).
+
+  Every message is a psd_stream_hdr_t followed by payload_bytes of payload
+  (zlib when flags & PSD_STREAM_F_ZLIB, raw_bytes once inflated):
+
+    KEY    nbins uint8 levels
+    DELTA  runs to the end of the payload: varint skip, varint len, len uint8
+           levels (varint = LEB128; skip counts from the end of the previous
+           run; bins not covered keep the previous value)
+
+  Level q of bin i is dB = db_offset + q * db_step; bin i is centered at
+  f_start_hz + i * df_hz. A client gets a KEY first and then DELTAs; when it
+  falls behind, the frames it could not take are skipped and it gets a KEY
+  again. All clients hold the same spectrum: the deltas only carry bins
+  that moved more than the deadband from what was last sent, and a KEY
+  carries that same shared state.
+*/
+
+#define PSD_STREAM_MAGIC     0x54535350u   /* "PSST" */
+#define PSD_STREAM_VERSION   1
+
+#define PSD_STREAM_KEY       0
+#define PSD_STREAM_DELTA     1
+#define PSD_STREAM_F_ZLIB    0x01
+
+#define PSD_STREAM_MAX_CLIENTS 32
+
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  type;            // PSD_STREAM_KEY / PSD_STREAM_DELTA
+    uint8_t  flags;
+    uint8_t  pad;
+    uint32_t seq;             // frame counter (DELTA n applies on top of frame n - 1)
+    uint32_t nbins;
+    uint64_t t_ns;
+    double   f_start_hz;      // absolute
+    double   df_hz;
+    float    db_offset;
+    float    db_step;
+    uint32_t payload_bytes;
+    uint32_t raw_bytes;
+} psd_stream_hdr_t;
+#pragma pack(pop)
+
+typedef struct {
+    int port;
+    const char *bind_addr;    // NULL = 127.0.0.1 ("0.0.0.0" = every interface)
+    int bins;                 // max-pool pushed traces to this many bins (0 = 2048)
+    double db_min;            // quantization range (0/0 = -140..-12.5, 0.5 dB steps)
+    double db_max;
+    int deadband;             // levels a bin must move before it is resent (0 = exact)
+    bool compress;            // zlib (fastest level) when it shrinks the payload
+    int max_clients;          // 0 = 8
+} psd_stream_cfg_t;
+
+typedef struct psd_stream_buf psd_stream_buf_t;
+
+typedef struct {
+    int fd;
+    psd_stream_buf_t *buf;    // message being sent (NULL = idle)
+    size_t off;
+    bool synced;              // holds the shared state: takes DELTAs
+    uint64_t sent_bytes;
+    uint64_t skipped;
+} psd_stream_client_t;
+
+/**
+ * The PSD thread only pools + quantizes into its own row and copies it into
+ * the "latest" slot with a trylock (a frame is dropped if the server holds
+ * it). The server thread polls the sockets, encodes each new frame once and
+ * hands the same buffer to every client that is ready for it.
+ */
+typedef struct {
+    psd_stream_cfg_t cfg;
+    int listen_fd;
+    int wake[2];              // pipe: producer -> server
+    pthread_t th;
+    bool started;
+    volatile bool stop;
+
+    /* producer */
+    uint8_t *row;
+    int row_cap;
+
+    /* latest frame, guarded by mtx */
+    pthread_mutex_t mtx;
+    uint8_t *latest;
+    int latest_n;
+    uint64_t latest_t_ns;
+    double latest_f0;
+    double latest_df;
+    uint64_t latest_seq;
+
+    /* server thread */
+    uint8_t *cur;
+    uint8_t *ref;             // state every synced client holds
+    int ref_n;
+    double ref_f0;
+    double ref_df;
+    uint32_t seq;
+    psd_stream_buf_t *pool;
+    int pool_n;
+    uint8_t *scratch;         // raw payload before zlib
+    size_t scratch_cap;
+    psd_stream_client_t cl[PSD_STREAM_MAX_CLIENTS];
+    int ncl;
+
+    uint64_t frames;          // frames encoded
+    uint64_t dropped;         // producer: slot busy
+    uint64_t bytes_out;
+} psd_stream_t;
+
+int  psd_stream_open(psd_stream_t *st, const psd_stream_cfg_t *cfg);
+void psd_stream_close(psd_stream_t *st);
+
+/* One scaled trace in dB: n bins, freq_abs0 = absolute frequency of bin 0 */
+int  psd_stream_push(psd_stream_t *st, const double *db, int n,
+                     double freq_abs0, double df_hz, uint64_t t_ns);
+
+#endif
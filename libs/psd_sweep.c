@@ -0,0 +1,293 @@
+//libs/psd_sweep.c
+#include "psd_sweep.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#define SWEEP_DEF_USABLE   0.75
+#define SWEEP_DEF_OVERLAP  0.25
+#define SWEEP_DEF_SETTLE_S 500e-6
+#define SWEEP_DEF_SEGMENTS 8
+#define SWEEP_NOTCH_W      1e-3    // DC bins still count when no neighbour covers them
+
+void psd_sweep_free(psd_sweep_t *sw) {
+    if (!sw) return;
+    if (sw->inited) {
+        pthread_mutex_destroy(&sw->mtx);
+        pthread_cond_destroy(&sw->cv);
+        psd_welch_free(&sw->welch);
+    }
+    free(sw->lo);
+    free(sw->w);
+    free(sw->freq_rel);
+    free(sw->acc);
+    free(sw->inv_w);
+    free(sw->out);
+    free(sw->step_f);
+    free(sw->step_p);
+    free(sw->cap[0]);
+    free(sw->cap[1]);
+    memset(sw, 0, sizeof(*sw));
+}
+
+int psd_sweep_init(psd_sweep_t *sw, const psd_sweep_cfg_t *cfg, const PsdConfig_t *psd_cfg) {
+    if (!sw || !cfg || !psd_cfg) return -1;
+    memset(sw, 0, sizeof(*sw));
+    sw->cfg = *cfg;
+    psd_sweep_cfg_t *c = &sw->cfg;
+    if (c->usable <= 0.0 || c->usable > 1.0) c->usable = SWEEP_DEF_USABLE;
+    if (c->overlap <= 0.0 || c->overlap >= 1.0) c->overlap = SWEEP_DEF_OVERLAP;
+    if (c->settle_s <= 0.0) c->settle_s = SWEEP_DEF_SETTLE_S;
+    if (c->f_stop_hz <= c->f_start_hz) {
+        fprintf(stderr, "[SWEEP] empty band %.0f .. %.0f Hz\n", c->f_start_hz, c->f_stop_hz);
+        return -1;
+    }
+
+    // Every step sees the full band at the LO: no zoom, no LO offset
+    PsdConfig_t pc = *psd_cfg;
+    pc.zoom_decim = 1;
+    pc.zoom_shift_hz = 0.0;
+    if (psd_welch_init(&sw->welch, &pc) != 0) return -1;
+    pthread_mutex_init(&sw->mtx, NULL);
+    pthread_cond_init(&sw->cv, NULL);
+    sw->inited = true;
+
+    int nfft = sw->welch.nfft;
+    sw->fs = sw->welch.fs;
+    double df = sw->fs / nfft;
+
+    // Usable half-width H and LO spacing S (bins); the ramp is the overlap 2H - S
+    int H = (int)(c->usable * nfft / 2.0);
+    if (H > nfft / 2 - 1) H = nfft / 2 - 1;
+    if (H < 1) H = 1;
+    int S = (int)floor(2.0 * H * (1.0 - c->overlap));
+    if (S < 1) S = 1;
+    int R = 2 * H - S;
+    int notch = (c->dc_notch_hz > 0.0) ? (int)ceil(c->dc_notch_hz / 2.0 / df) : -1;
+    sw->step_bins = S;
+
+    double span = c->f_stop_hz - c->f_start_hz;
+    sw->nsteps = (span <= 2.0 * H * df) ? 1 : (int)ceil((span - 2.0 * H * df) / (S * df)) + 1;
+    double center = 0.5 * (c->f_start_hz + c->f_stop_hz);
+    double lo0 = center - 0.5 * (sw->nsteps - 1) * S * df;
+    if (lo0 - H * df < 0.0) {
+        fprintf(stderr, "[SWEEP] band starts below 0 Hz\n");
+        psd_sweep_free(sw);
+        return -1;
+    }
+
+    sw->lo = (uint64_t*)malloc((size_t)sw->nsteps * sizeof(uint64_t));
+    sw->w = (double*)calloc((size_t)nfft, sizeof(double));
+    sw->step_f = (double*)malloc((size_t)nfft * sizeof(double));
+    sw->step_p = (double*)malloc((size_t)nfft * sizeof(double));
+    if (!sw->lo || !sw->w || !sw->step_f || !sw->step_p) {
+        psd_sweep_free(sw);
+        return -1;
+    }
+    for (int k = 0; k < sw->nsteps; k++) sw->lo[k] = (uint64_t)llround(lo0 + (double)k * S * df);
+
+    // Crossfade: 1 in the middle, linear down to the trimmed edges over the ramp
+    sw->w_lo = nfft / 2 - H;
+    sw->w_hi = nfft / 2 + H;
+    for (int i = sw->w_lo; i <= sw->w_hi; i++) {
+        int d = abs(i - nfft / 2);
+        double w = (R > 0) ? fmin(1.0, (double)(H + 1 - d) / (double)(R + 1)) : 1.0;
+        if (d <= notch) w *= SWEEP_NOTCH_W;
+        sw->w[i] = w;
+    }
+
+    // Grid: bins of step 0 from f_start on, up to f_stop or the last step's edge
+    double bin0_abs = lo0 - sw->fs / 2.0;
+    sw->i0 = (int)ceil((c->f_start_hz - bin0_abs) / df - 1e-9);
+    if (sw->i0 < sw->w_lo) sw->i0 = sw->w_lo;
+    double g0 = bin0_abs + sw->i0 * df;
+    int n_band = (int)floor((c->f_stop_hz - g0) / df + 1e-9) + 1;
+    int n_cov = sw->w_hi + (sw->nsteps - 1) * S - sw->i0 + 1;
+    sw->nbins = n_band < n_cov ? n_band : n_cov;
+    sw->center_hz = (uint64_t)llround(center);
+
+    sw->freq_rel = (double*)malloc((size_t)sw->nbins * sizeof(double));
+    sw->acc = (double*)calloc((size_t)sw->nbins, sizeof(double));
+    sw->inv_w = (double*)calloc((size_t)sw->nbins, sizeof(double));
+    sw->out = (double*)malloc((size_t)sw->nbins * sizeof(double));
+    if (!sw->freq_rel || !sw->acc || !sw->inv_w || !sw->out) {
+        psd_sweep_free(sw);
+        return -1;
+    }
+    for (int j = 0; j < sw->nbins; j++) sw->freq_rel[j] = g0 + j * df - (double)sw->center_hz;
+
+    // Total weight per output bin is fixed by the plan: invert it once
+    for (int k = 0; k < sw->nsteps; k++) {
+        int off = k * S - sw->i0;
+        for (int i = sw->w_lo; i <= sw->w_hi; i++) {
+            int j = i + off;
+            if (j >= 0 && j < sw->nbins) sw->inv_w[j] += sw->w[i];
+        }
+    }
+    for (int j = 0; j < sw->nbins; j++) sw->inv_w[j] = (sw->inv_w[j] > 0.0) ? 1.0 / sw->inv_w[j] : 0.0;
+
+    size_t samples = (c->dwell_s > 0.0) ? (size_t)(c->dwell_s * sw->fs)
+                                        : (size_t)nfft + (SWEEP_DEF_SEGMENTS - 1) * (size_t)sw->welch.step;
+    if (samples < (size_t)nfft) samples = (size_t)nfft;
+    sw->cap_bytes = samples * 2;
+    sw->settle_bytes = (size_t)(c->settle_s * sw->fs) * 2;
+    sw->cap[0] = (uint8_t*)malloc(sw->cap_bytes);
+    sw->cap[1] = (uint8_t*)malloc(sw->cap_bytes);
+    if (!sw->cap[0] || !sw->cap[1]) {
+        psd_sweep_free(sw);
+        return -1;
+    }
+    sw->fill = -1;
+
+    fprintf(stderr, "[SWEEP] %.3f .. %.3f MHz: %d steps of %.3f MHz (usable %.3f), %d bins of %.1f Hz, %zu samples/step\n",
+            c->f_start_hz / 1e6, c->f_stop_hz / 1e6, sw->nsteps, S * df / 1e6, 2.0 * H * df / 1e6,
+            sw->nbins, df, samples);
+    return 0;
+}
+
+void psd_sweep_rx(psd_sweep_t *sw, const uint8_t *buf, size_t len) {
+    pthread_mutex_lock(&sw->mtx);
+    int b = sw->fill;
+    if (b < 0) {
+        pthread_mutex_unlock(&sw->mtx);
+        return;
+    }
+    if (sw->rx_gen != sw->gen) {
+        // first transfer after the retune: may have started filling before it
+        sw->rx_gen = sw->gen;
+        sw->dropped_bytes += len;
+        pthread_mutex_unlock(&sw->mtx);
+        return;
+    }
+    if (sw->skip > 0) {
+        size_t s = sw->skip < len ? sw->skip : len;
+        sw->skip -= s;
+        sw->dropped_bytes += s;
+        buf += s;
+        len -= s;
+    }
+    size_t room = sw->cap_bytes - sw->cap_fill[b];
+    size_t n = len < room ? len : room;
+    memcpy(sw->cap[b] + sw->cap_fill[b], buf, n);
+    sw->cap_fill[b] += n;
+    if (sw->cap_fill[b] == sw->cap_bytes) {
+        sw->cap_ready[b] = true;
+        sw->fill = -1;
+        pthread_cond_signal(&sw->cv);
+    }
+    pthread_mutex_unlock(&sw->mtx);
+}
+
+/* Hand buffer b to the RX side; retuned = a new generation (drop + settle) */
+static void sweep_arm(psd_sweep_t *sw, int b, bool retuned) {
+    pthread_mutex_lock(&sw->mtx);
+    sw->cap_fill[b] = 0;
+    sw->cap_ready[b] = false;
+    if (retuned) {
+        sw->gen++;
+        sw->skip = sw->settle_bytes;
+    }
+    sw->fill = b;
+    pthread_mutex_unlock(&sw->mtx);
+}
+
+static int sweep_wait(psd_sweep_t *sw, int b) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += PSD_SWEEP_TIMEOUT_MS / 1000;
+    ts.tv_nsec += (long)(PSD_SWEEP_TIMEOUT_MS % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&sw->mtx);
+    int rc = 0;
+    while (!sw->cap_ready[b] && rc != ETIMEDOUT) rc = pthread_cond_timedwait(&sw->cv, &sw->mtx, &ts);
+    bool ok = sw->cap_ready[b];
+    sw->cap_ready[b] = false;
+    pthread_mutex_unlock(&sw->mtx);
+    return ok ? 0 : -1;
+}
+
+/* Welch of step k (buffer b) into the grid */
+static void sweep_step(psd_sweep_t *sw, int k, int b) {
+    psd_welch_reset(&sw->welch);
+    psd_welch_run_iq8(&sw->welch, (const int8_t*)sw->cap[b], sw->cap_bytes / 2, psd_now_ns());
+    if (psd_welch_result(&sw->welch, sw->step_f, sw->step_p) <= 0) return;
+
+    int off = k * sw->step_bins - sw->i0;
+    int lo = sw->w_lo > -off ? sw->w_lo : -off;
+    int hi = sw->w_hi < sw->nbins - 1 - off ? sw->w_hi : sw->nbins - 1 - off;
+    const double *w = sw->w;
+    const double *p = sw->step_p;
+    double *acc = sw->acc + off;
+    for (int i = lo; i <= hi; i++) acc[i] += w[i] * p[i];
+    sw->steps++;
+}
+
+int psd_sweep_run(psd_sweep_t *sw, psd_sweep_tune_fn tune, void *tune_user,
+                  psd_sweep_out_fn out, void *out_user, int max_passes, volatile bool *stop) {
+    if (!sw || !sw->lo || !tune) return -1;
+
+    int passes = 0, k = 0, b = 0;
+    if (tune(tune_user, sw->lo[0]) != 0) return -1;
+    sweep_arm(sw, 0, true);
+
+    uint64_t t_pass = psd_now_ns();
+    uint64_t t_log = 0;
+    while (!(stop && *stop)) {
+        if (sweep_wait(sw, b) != 0) {
+            fprintf(stderr, "[SWEEP] no samples for %d ms at step %d (%.3f MHz)\n",
+                    PSD_SWEEP_TIMEOUT_MS, k, sw->lo[k] / 1e6);
+            passes = -1;
+            break;
+        }
+
+        int next = (k + 1 < sw->nsteps) ? k + 1 : 0;
+        bool last = (next == 0);
+        bool more = !(last && max_passes > 0 && passes + 1 >= max_passes);
+
+        // Next step captures while this one is transformed
+        if (more) {
+            bool retune = sw->lo[next] != sw->lo[k];
+            if (retune && tune(tune_user, sw->lo[next]) != 0) {
+                fprintf(stderr, "[SWEEP] retune to %.3f MHz failed\n", sw->lo[next] / 1e6);
+                passes = -1;
+                break;
+            }
+            sweep_arm(sw, 1 - b, retune);
+        }
+        sweep_step(sw, k, b);
+
+        if (last) {
+            for (int j = 0; j < sw->nbins; j++) sw->out[j] = sw->acc[j] * sw->inv_w[j];
+            memset(sw->acc, 0, (size_t)sw->nbins * sizeof(double));
+            if (out) out(out_user, sw->freq_rel, sw->out, sw->nbins, sw->center_hz, t_pass);
+
+            uint64_t now = psd_now_ns();
+            sw->last_pass_ms = (double)(now - t_pass) / 1e6;
+            sw->passes++;
+            passes++;
+            if (now - t_log >= 1000000000ull) {
+                double bw = sw->cfg.f_stop_hz - sw->cfg.f_start_hz;
+                fprintf(stderr, "[SWEEP] pass %llu: %d steps in %.1f ms (%.2f GHz/s) | %.1f MB settling dropped\n",
+                        (unsigned long long)sw->passes, sw->nsteps, sw->last_pass_ms,
+                        bw / 1e9 / (sw->last_pass_ms / 1e3), sw->dropped_bytes / 1e6);
+                t_log = now;
+            }
+            t_pass = now;
+        }
+        if (!more) break;
+        k = next;
+        b = 1 - b;
+    }
+
+    pthread_mutex_lock(&sw->mtx);
+    sw->fill = -1;
+    pthread_mutex_unlock(&sw->mtx);
+    return passes;
+}
@@ -0,0 +1,109 @@
+//libs/psd_sweep.h
+#ifndef PSD_SWEEP_H
+#define PSD_SWEEP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "psd.h"
+
+/*
+  Wideband sweep (CAMPAIGN_MODE): the LO steps across the plan while the RX
+  stream keeps running. Only the usable fraction of each step is kept (the
+  band edges roll off in the baseband filter); neighbouring steps overlap by
+  a fraction of it and are crossfaded there with a linear taper, so the
+  stitched trace has no seams at step boundaries.
+
+  Every step uses the same Welch engine (one window, one FFTW plan) and
+  lands on a common frequency grid: steps are spaced a whole number of bins
+  apart, so bin i of step k is output bin i + k * step_bins - i0.
+*/
+
+#define PSD_SWEEP_TIMEOUT_MS 1000   // no samples for this long = device stalled
+
+typedef struct {
+    double f_start_hz;        // absolute
+    double f_stop_hz;
+    double usable;            // (0, 1]
+    double overlap;           // [0, 1)
+    double dwell_s;           // IQ per step after settling (0 = 8 Welch segments)
+    double settle_s;          // dropped after each retune
+    double dc_notch_hz;       // LO spike: weighted down, neighbours cover it
+} psd_sweep_cfg_t;
+
+/* Retune to lo_hz; 0 on success. Called from the sweep thread while RX is running */
+typedef int (*psd_sweep_tune_fn)(void *user, uint64_t lo_hz);
+
+/* One stitched pass: linear PSD, freq_rel relative to center_hz (psd_save_csv convention) */
+typedef void (*psd_sweep_out_fn)(void *user, const double *freq_rel, double *psd, int nbins,
+                                 uint64_t center_hz, uint64_t t_ns);
+
+/**
+ * Capture hand-off: the RX callback fills cap[fill] through psd_sweep_rx()
+ * while the sweep thread runs the Welch of the other buffer. Each transfer
+ * is tagged with the tuning generation it arrived in; the first one of a
+ * new generation may still hold samples from before the retune and is
+ * dropped whole, then settle_bytes more.
+ */
+typedef struct {
+    psd_sweep_cfg_t cfg;
+    bool inited;              // welch + sync objects live
+    double fs;
+
+    /* plan */
+    int nsteps;
+    uint64_t *lo;             // LO per step
+    int step_bins;            // LO spacing in bins
+    int i0;                   // first bin of step 0 inside the band
+    double *w;                // crossfade weight per bin of a step (fftshift order)
+    int w_lo, w_hi;           // bins with w > 0
+
+    /* grid */
+    int nbins;
+    uint64_t center_hz;
+    double *freq_rel;
+    double *acc;
+    double *inv_w;            // 1 / sum of the weights landing on each output bin
+    double *out;
+
+    /* per-step Welch (shared plan) */
+    psd_welch_t welch;
+    double *step_f;
+    double *step_p;
+
+    /* capture, guarded by mtx */
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    uint8_t *cap[2];
+    size_t cap_bytes;         // per step
+    size_t cap_fill[2];
+    bool cap_ready[2];
+    int fill;                 // buffer being filled (-1 = none armed)
+    uint32_t gen;             // bumped on every retune
+    uint32_t rx_gen;          // generation of the last transfer seen
+    size_t settle_bytes;
+    size_t skip;
+
+    /* stats */
+    uint64_t steps;
+    uint64_t passes;
+    uint64_t dropped_bytes;   // settling + in-flight transfers
+    double last_pass_ms;
+} psd_sweep_t;
+
+int  psd_sweep_init(psd_sweep_t *sw, const psd_sweep_cfg_t *cfg, const PsdConfig_t *psd_cfg);
+void psd_sweep_free(psd_sweep_t *sw);
+
+/* RX callback side: never blocks on the sweep thread's DSP */
+void psd_sweep_rx(psd_sweep_t *sw, const uint8_t *buf, size_t len);
+
+/*
+  Sweep thread: tune -> capture -> (next tune, Welch of this step) until
+  max_passes passes (0 = forever) or *stop. Returns the passes completed,
+  -1 if a retune failed or the stream stalled (caller recovers the device).
+*/
+int  psd_sweep_run(psd_sweep_t *sw, psd_sweep_tune_fn tune, void *tune_user,
+                   psd_sweep_out_fn out, void *out_user, int max_passes, volatile bool *stop);
+
+#endif
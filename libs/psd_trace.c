@@ -0,0 +1,140 @@
+//libs/psd_trace.c
+#include "psd_trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <float.h>
+
+static int kind_index(psd_trace_kind_t kind) {
+    switch (kind) {
+        case PSD_TRACE_MAX: return 0;
+        case PSD_TRACE_MIN: return 1;
+        case PSD_TRACE_EMA: return 2;
+        case PSD_TRACE_RMS: return 3;
+        default:            return -1;
+    }
+}
+
+int psd_trace_init(psd_trace_t *tr, int nbins, unsigned mask, bool with_time,
+                   double ema_tau_s, double segment_period_s) {
+    if (!tr || nbins <= 0) return -1;
+    memset(tr, 0, sizeof(*tr));
+    tr->nbins = nbins;
+    tr->mask = mask;
+    tr->with_time = with_time;
+    tr->ema_tau_s = ema_tau_s;
+
+    // alpha = 1 - exp(-dt/tau), dt = one Welch segment step
+    if (ema_tau_s > 0.0 && segment_period_s > 0.0) {
+        tr->ema_alpha = (float)(1.0 - exp(-segment_period_s / ema_tau_s));
+    } else {
+        tr->ema_alpha = 1.0f;
+    }
+
+    size_t fbytes = (size_t)nbins * sizeof(float);
+    if (mask & PSD_TRACE_MAX) tr->max_hold = (float*)malloc(fbytes);
+    if (mask & PSD_TRACE_MIN) tr->min_hold = (float*)malloc(fbytes);
+    if (mask & PSD_TRACE_EMA) tr->ema      = (float*)malloc(fbytes);
+    if (mask & PSD_TRACE_RMS) tr->rms_sum  = (double*)malloc((size_t)nbins * sizeof(double));
+
+    if (with_time) {
+        if (mask & PSD_TRACE_EMA) tr->ema_peak = (float*)malloc(fbytes);
+        if (mask & PSD_TRACE_RMS) tr->rms_peak = (float*)malloc(fbytes);
+        for (int k = 0; k < PSD_TRACE_COUNT; k++) {
+            if (mask & (1u << k)) {
+                tr->t_ext[k] = (uint64_t*)malloc((size_t)nbins * sizeof(uint64_t));
+                if (!tr->t_ext[k]) { psd_trace_free(tr); return -1; }
+            }
+        }
+    }
+
+    if (((mask & PSD_TRACE_MAX) && !tr->max_hold) ||
+        ((mask & PSD_TRACE_MIN) && !tr->min_hold) ||
+        ((mask & PSD_TRACE_EMA) && (!tr->ema || (with_time && !tr->ema_peak))) ||
+        ((mask & PSD_TRACE_RMS) && (!tr->rms_sum || (with_time && !tr->rms_peak)))) {
+        psd_trace_free(tr);
+        return -1;
+    }
+
+    psd_trace_reset(tr);
+    return 0;
+}
+
+void psd_trace_free(psd_trace_t *tr) {
+    if (!tr) return;
+    free(tr->max_hold);
+    free(tr->min_hold);
+    free(tr->ema);
+    free(tr->rms_sum);
+    free(tr->ema_peak);
+    free(tr->rms_peak);
+    for (int k = 0; k < PSD_TRACE_COUNT; k++) free(tr->t_ext[k]);
+    memset(tr, 0, sizeof(*tr));
+}
+
+void psd_trace_reset(psd_trace_t *tr) {
+    int n = tr->nbins;
+    for (int i = 0; i < n; i++) {
+        if (tr->max_hold) tr->max_hold[i] = 0.0f;
+        if (tr->min_hold) tr->min_hold[i] = FLT_MAX;
+        if (tr->ema)      tr->ema[i]      = 0.0f;
+        if (tr->rms_sum)  tr->rms_sum[i]  = 0.0;
+        if (tr->ema_peak) tr->ema_peak[i] = 0.0f;
+        if (tr->rms_peak) tr->rms_peak[i] = 0.0f;
+    }
+    for (int k = 0; k < PSD_TRACE_COUNT; k++) {
+        if (tr->t_ext[k]) memset(tr->t_ext[k], 0, (size_t)n * sizeof(uint64_t));
+    }
+    tr->n_frames = 0;
+}
+
+int psd_trace_get(const psd_trace_t *tr, psd_trace_kind_t kind, double *p_out) {
+    if (!tr || !p_out || !(tr->mask & kind) || tr->n_frames == 0) return -1;
+    int n = tr->nbins;
+
+    switch (kind) {
+        case PSD_TRACE_MAX:
+            for (int i = 0; i < n; i++) p_out[i] = tr->max_hold[i];
+            break;
+        case PSD_TRACE_MIN:
+            for (int i = 0; i < n; i++) p_out[i] = tr->min_hold[i];
+            break;
+        case PSD_TRACE_EMA:
+            for (int i = 0; i < n; i++) p_out[i] = tr->ema[i];
+            break;
+        case PSD_TRACE_RMS: {
+            double inv = 1.0 / (double)tr->n_frames;
+            for (int i = 0; i < n; i++) p_out[i] = tr->rms_sum[i] * inv;
+            break;
+        }
+        default:
+            return -1;
+    }
+    return 0;
+}
+
+const uint64_t* psd_trace_times(const psd_trace_t *tr, psd_trace_kind_t kind) {
+    int k = kind_index(kind);
+    if (!tr || k < 0) return NULL;
+    return tr->t_ext[k];
+}
+
+const char* psd_trace_name(psd_trace_kind_t kind) {
+    switch (kind) {
+        case PSD_TRACE_MAX: return "max";
+        case PSD_TRACE_MIN: return "min";
+        case PSD_TRACE_EMA: return "ema";
+        case PSD_TRACE_RMS: return "rms";
+        default:            return "unknown";
+    }
+}
+
+unsigned psd_trace_mask_from_string(const char *name) {
+    if (name == NULL) return 0;
+    if (strcasecmp(name, "max") == 0) return PSD_TRACE_MAX;
+    if (strcasecmp(name, "min") == 0) return PSD_TRACE_MIN;
+    if (strcasecmp(name, "ema") == 0) return PSD_TRACE_EMA;
+    if (strcasecmp(name, "rms") == 0) return PSD_TRACE_RMS;
+    return 0;
+}
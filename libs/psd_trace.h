@@ -0,0 +1,58 @@
+//libs/psd_trace.h
+#ifndef PSD_TRACE_H
+#define PSD_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Trace kinds (bitmask, as parsed from the "traces" JSON field) */
+typedef enum {
+    PSD_TRACE_MAX = 1u << 0,   // max-hold
+    PSD_TRACE_MIN = 1u << 1,   // min-hold
+    PSD_TRACE_EMA = 1u << 2,   // exponential average (time constant ema_tau_s)
+    PSD_TRACE_RMS = 1u << 3    // power (RMS) average since reset
+} psd_trace_kind_t;
+
+#define PSD_TRACE_COUNT 4
+
+/**
+ * Persistent per-bin trace accumulators, kept across frames.
+ * Updated by the Welch engine in the same pass that accumulates |X|^2,
+ * bins in output (fftshift) order, values in linear PSD units.
+ *
+ * With time tracking, t_ext[k][i] holds the timestamp (ns, CLOCK_REALTIME) at
+ * which trace k reached its extreme in bin i (the minimum for min-hold, the
+ * maximum for the others).
+ */
+typedef struct {
+    int nbins;
+    unsigned mask;
+    bool with_time;
+
+    float ema_alpha;          // per-segment smoothing factor
+    double ema_tau_s;
+
+    float *max_hold;
+    float *min_hold;
+    float *ema;
+    double *rms_sum;          // sum of power; mean = rms_sum / n_frames
+    uint64_t n_frames;
+
+    float *ema_peak;          // extremes of the averaged traces (time tracking)
+    float *rms_peak;
+    uint64_t *t_ext[PSD_TRACE_COUNT];
+} psd_trace_t;
+
+int  psd_trace_init(psd_trace_t *tr, int nbins, unsigned mask, bool with_time,
+                    double ema_tau_s, double segment_period_s);
+void psd_trace_free(psd_trace_t *tr);
+void psd_trace_reset(psd_trace_t *tr);
+
+/* Copy trace `kind` to p_out (double, ready for scale_psd). Returns -1 if not enabled/empty. */
+int  psd_trace_get(const psd_trace_t *tr, psd_trace_kind_t kind, double *p_out);
+const uint64_t* psd_trace_times(const psd_trace_t *tr, psd_trace_kind_t kind);
+
+const char* psd_trace_name(psd_trace_kind_t kind);
+unsigned psd_trace_mask_from_string(const char *name);
+
+#endif
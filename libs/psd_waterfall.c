@@ -0,0 +1,149 @@
+//libs/psd_waterfall.c
+#define _GNU_SOURCE
+#include "psd_waterfall.h"
+#include "psd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+_Static_assert(sizeof(psd_wf_header_t) == 256, "waterfall header must stay 256 bytes");
+
+int psd_wf_open(psd_waterfall_t *wf, const psd_wf_cfg_t *cfg) {
+    if (!wf || !cfg || !cfg->path || cfg->nrows <= 0 || cfg->crop_len <= 0) return -1;
+    if (cfg->crop_start < 0 || cfg->crop_start + cfg->crop_len > cfg->nfft) return -1;
+
+    memset(wf, 0, sizeof(*wf));
+    wf->fd = -1;
+    wf->cfg = *cfg;
+
+    size_t elem = (cfg->format == PSD_WF_U8) ? 1 : sizeof(float);
+    size_t row_bytes = sizeof(psd_wf_row_t) + (size_t)cfg->crop_len * elem;
+    row_bytes = (row_bytes + 7) & ~(size_t)7;
+    wf->map_bytes = sizeof(psd_wf_header_t) + row_bytes * (size_t)cfg->nrows;
+
+    wf->acc = (double*)calloc((size_t)cfg->crop_len, sizeof(double));
+    if (!wf->acc) return -1;
+
+    wf->fd = open(cfg->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (wf->fd < 0) {
+        perror("[WF] open");
+        psd_wf_close(wf);
+        return -1;
+    }
+    if (ftruncate(wf->fd, (off_t)wf->map_bytes) != 0) {
+        perror("[WF] ftruncate");
+        psd_wf_close(wf);
+        return -1;
+    }
+
+    void *map = mmap(NULL, wf->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, wf->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("[WF] mmap");
+        psd_wf_close(wf);
+        return -1;
+    }
+    wf->hdr = (psd_wf_header_t*)map;
+    wf->rows = (uint8_t*)map + sizeof(psd_wf_header_t);
+
+    double df = cfg->sample_rate_hz / cfg->nfft;
+    psd_wf_header_t *h = wf->hdr;
+    h->version = PSD_WF_VERSION;
+    h->nbins = (uint32_t)cfg->crop_len;
+    h->nrows = (uint32_t)cfg->nrows;
+    h->format = (uint32_t)cfg->format;
+    h->row_bytes = (uint32_t)row_bytes;
+    h->center_freq_hz = cfg->center_freq_hz;
+    h->sample_rate_hz = cfg->sample_rate_hz;
+    h->f_start_hz = cfg->center_freq_hz - cfg->sample_rate_hz / 2.0 + cfg->crop_start * df;
+    h->df_hz = df;
+    h->db_min = (float)cfg->db_min;
+    h->db_max = (float)cfg->db_max;
+    h->row_period_ns = (uint64_t)(cfg->row_ms * 1e6);
+    snprintf(h->scale, sizeof(h->scale), "%s", cfg->scale ? cfg->scale : "dBm");
+    __atomic_store_n(&h->rows_written, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->magic, PSD_WF_MAGIC, __ATOMIC_RELEASE);
+
+    fprintf(stderr, "[WF] %s | %d rows x %d bins (%s) | %.1f ms/row | %.1f MB\n",
+            cfg->path, cfg->nrows, cfg->crop_len,
+            cfg->format == PSD_WF_U8 ? "u8" : "f32", cfg->row_ms,
+            (double)wf->map_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+void psd_wf_close(psd_waterfall_t *wf) {
+    if (!wf) return;
+    if (wf->hdr) {
+        msync(wf->hdr, wf->map_bytes, MS_ASYNC);
+        munmap(wf->hdr, wf->map_bytes);
+    }
+    if (wf->fd >= 0) close(wf->fd);
+    free(wf->acc);
+    memset(wf, 0, sizeof(*wf));
+    wf->fd = -1;
+}
+
+static void emit_row(psd_waterfall_t *wf) {
+    psd_wf_header_t *h = wf->hdr;
+    int n = wf->cfg.crop_len;
+
+    // Row average in place, then the same unit conversion as the CSV path
+    double inv = 1.0 / (double)wf->acc_frames;
+    for (int i = 0; i < n; i++) wf->acc[i] *= inv;
+
+    const char *scale = wf->cfg.scale;
+    if (scale && (strcmp(scale, "W") == 0 || strcmp(scale, "V") == 0)) scale = "dBm";
+    scale_psd(wf->acc, n, scale);
+
+    uint64_t row_no = h->rows_written;
+    psd_wf_row_t *row = (psd_wf_row_t*)(wf->rows + (size_t)(row_no % h->nrows) * h->row_bytes);
+    void *data = row + 1;
+
+    __atomic_store_n(&row->seq, 2 * row_no + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    row->t_ns = wf->row_t0_ns;
+    row->n_frames = wf->acc_frames;
+
+    if (wf->cfg.format == PSD_WF_U8) {
+        uint8_t *q = (uint8_t*)data;
+        float lo = h->db_min;
+        float k = 255.0f / (h->db_max - h->db_min);
+        #pragma omp simd
+        for (int i = 0; i < n; i++) {
+            float v = ((float)wf->acc[i] - lo) * k;
+            v = fminf(fmaxf(v, 0.0f), 255.0f);
+            q[i] = (uint8_t)(v + 0.5f);
+        }
+    } else {
+        float *f = (float*)data;
+        for (int i = 0; i < n; i++) f[i] = (float)wf->acc[i];
+    }
+
+    __atomic_store_n(&row->seq, 2 * row_no + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->rows_written, row_no + 1, __ATOMIC_RELEASE);
+
+    memset(wf->acc, 0, (size_t)n * sizeof(double));
+    wf->acc_frames = 0;
+}
+
+void psd_wf_push_frame(psd_waterfall_t *wf, const float *frame, int nbins, uint64_t t_ns) {
+    if (!wf || !wf->hdr || nbins != wf->cfg.nfft) return;
+
+    // Close the current row once its period has elapsed (this frame starts the next one)
+    if (wf->acc_frames > 0 && t_ns >= wf->row_t0_ns + wf->hdr->row_period_ns) {
+        emit_row(wf);
+    }
+    if (wf->acc_frames == 0) wf->row_t0_ns = t_ns;
+
+    const float *src = &frame[wf->cfg.crop_start];
+    double *acc = wf->acc;
+    int n = wf->cfg.crop_len;
+    #pragma omp simd
+    for (int i = 0; i < n; i++) acc[i] += src[i];
+    wf->acc_frames++;
+}
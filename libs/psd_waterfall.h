@@ -0,0 +1,88 @@
+//libs/psd_waterfall.h
+#ifndef PSD_WATERFALL_H
+#define PSD_WATERFALL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Waterfall file layout (little endian, mmap'able):
+
+    [psd_wf_header_t, 256 bytes]
+    [row 0][row 1] ... [row nrows-1]     circular, row = rows_written % nrows
+
+  Each row is a psd_wf_row_t header followed by nbins values, float32 dB or
+  uint8 (dB = db_min + q * (db_max - db_min) / 255). A row's seq is odd while
+  it is being written; readers re-check it after copying.
+*/
+
+#define PSD_WF_MAGIC    0x46574450u   /* "PDWF" */
+#define PSD_WF_VERSION  1u
+
+typedef enum {
+    PSD_WF_F32 = 0,
+    PSD_WF_U8  = 1
+} psd_wf_format_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nbins;
+    uint32_t nrows;
+    uint32_t format;          // psd_wf_format_t
+    uint32_t row_bytes;       // stride between rows (header + data)
+    double center_freq_hz;
+    double sample_rate_hz;
+    double f_start_hz;        // absolute frequency of bin 0
+    double df_hz;
+    float db_min;
+    float db_max;
+    uint64_t row_period_ns;
+    uint64_t rows_written;    // total rows since open (atomic)
+    char scale[16];
+    uint8_t reserved[256 - 96];
+} psd_wf_header_t;
+
+typedef struct {
+    uint64_t seq;             // 2*row_number+2 when complete, odd while writing
+    uint64_t t_ns;            // CLOCK_REALTIME of the first frame in the row
+    uint32_t n_frames;        // FFT frames averaged into the row
+    uint32_t pad;
+} psd_wf_row_t;
+
+typedef struct {
+    const char *path;
+    int nrows;
+    double row_ms;
+    psd_wf_format_t format;
+    double db_min;
+    double db_max;
+
+    int nfft;                 // frame length delivered by the Welch engine
+    int crop_start;           // first kept bin (span crop)
+    int crop_len;
+    double center_freq_hz;
+    double sample_rate_hz;
+    const char *scale;
+} psd_wf_cfg_t;
+
+typedef struct {
+    int fd;
+    size_t map_bytes;
+    psd_wf_header_t *hdr;
+    uint8_t *rows;
+
+    psd_wf_cfg_t cfg;
+    double *acc;              // linear sum of frames for the current row
+    uint32_t acc_frames;
+    uint64_t row_t0_ns;
+} psd_waterfall_t;
+
+int  psd_wf_open(psd_waterfall_t *wf, const psd_wf_cfg_t *cfg);
+void psd_wf_close(psd_waterfall_t *wf);
+
+/* Feed one FFT frame (linear PSD, fftshift order, cfg.nfft bins). Emits a row every row_ms. */
+void psd_wf_push_frame(psd_waterfall_t *wf, const float *frame, int nbins, uint64_t t_ns);
+
+#endif
@@ -0,0 +1,452 @@
+//libs/psd_window.c
+#include "psd_window.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <fftw3.h>
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static psd_window_t *cache_head;
+static int cache_count;
+
+double psd_window_default_param(PsdWindowType_t type) {
+    switch (type) {
+        case KAISER_TYPE: return 8.6;   // beta: ~Blackman-Harris sidelobes
+        case TUKEY_TYPE:  return 0.5;   // alpha: taper fraction
+        default:          return 0.0;
+    }
+}
+
+const char *psd_window_name(PsdWindowType_t type) {
+    switch (type) {
+        case HAMMING_TYPE:     return "hamming";
+        case HANN_TYPE:        return "hann";
+        case RECTANGULAR_TYPE: return "rectangular";
+        case BLACKMAN_TYPE:    return "blackman";
+        case FLAT_TOP_TYPE:    return "flattop";
+        case KAISER_TYPE:      return "kaiser";
+        case TUKEY_TYPE:       return "tukey";
+        case BARTLETT_TYPE:    return "bartlett";
+        default:               return "?";
+    }
+}
+
+/* Modified Bessel function of the first kind, order 0 (power series) */
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    double q = x * x / 4.0;
+    for (int k = 1; k < 500; k++) {
+        term *= q / ((double)k * (double)k);
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+static void generate_window(PsdWindowType_t type, double param, double *w, int n) {
+    if (n == 1) {
+        w[0] = 1.0;
+        return;
+    }
+    double m = (double)(n - 1);
+
+    switch (type) {
+        case RECTANGULAR_TYPE:
+            for (int i = 0; i < n; i++) w[i] = 1.0;
+            break;
+        case HANN_TYPE:
+            for (int i = 0; i < n; i++) w[i] = 0.5 * (1 - cos((2.0 * M_PI * i) / m));
+            break;
+        case BLACKMAN_TYPE:
+            for (int i = 0; i < n; i++) {
+                w[i] = 0.42 - 0.5 * cos((2.0 * M_PI * i) / m) + 0.08 * cos((4.0 * M_PI * i) / m);
+            }
+            break;
+        case FLAT_TOP_TYPE: {
+            // SciPy/HFT flat top: amplitude error < 0.01 dB
+            const double a0 = 0.21557895, a1 = 0.41663158, a2 = 0.277263158,
+                         a3 = 0.083578947, a4 = 0.006947368;
+            for (int i = 0; i < n; i++) {
+                double x = 2.0 * M_PI * i / m;
+                w[i] = a0 - a1 * cos(x) + a2 * cos(2 * x) - a3 * cos(3 * x) + a4 * cos(4 * x);
+            }
+            break;
+        }
+        case KAISER_TYPE: {
+            double inv_i0b = 1.0 / bessel_i0(param);
+            for (int i = 0; i < n; i++) {
+                double r = 2.0 * i / m - 1.0;
+                w[i] = bessel_i0(param * sqrt(fmax(0.0, 1.0 - r * r))) * inv_i0b;
+            }
+            break;
+        }
+        case TUKEY_TYPE: {
+            double alpha = param;
+            if (alpha <= 0.0) {
+                for (int i = 0; i < n; i++) w[i] = 1.0;
+                break;
+            }
+            if (alpha > 1.0) alpha = 1.0;
+            double edge = alpha * m / 2.0;
+            for (int i = 0; i < n; i++) {
+                double d = (i < n / 2) ? (double)i : m - i;   // distance to nearest end
+                w[i] = (d < edge) ? 0.5 * (1.0 - cos(M_PI * d / edge)) : 1.0;
+            }
+            break;
+        }
+        case BARTLETT_TYPE:
+            for (int i = 0; i < n; i++) w[i] = 1.0 - fabs(2.0 * i / m - 1.0);
+            break;
+        case HAMMING_TYPE:
+        default:
+            for (int i = 0; i < n; i++) w[i] = 0.54 - 0.46 * cos((2.0 * M_PI * i) / m);
+            break;
+    }
+}
+
+static psd_window_t *window_build(PsdWindowType_t type, int n, double param) {
+    psd_window_t *win = (psd_window_t*)calloc(1, sizeof(*win));
+    if (!win) return NULL;
+    win->w = (double*)malloc((size_t)n * sizeof(double));
+    if (!win->w) {
+        free(win);
+        return NULL;
+    }
+
+    win->type = type;
+    win->n = n;
+    win->param = param;
+    generate_window(type, param, win->w, n);
+
+    double s1 = 0.0, s2 = 0.0;
+    for (int i = 0; i < n; i++) {
+        s1 += win->w[i];
+        s2 += win->w[i] * win->w[i];
+    }
+    win->cg = s1 / n;
+    win->u_norm = s2 / n;
+    win->enbw = (s1 > 0.0) ? n * s2 / (s1 * s1) : 1.0;
+    return win;
+}
+
+static void window_destroy(psd_window_t *win) {
+    free(win->w);
+    free(win);
+}
+
+/* Drop unreferenced entries beyond PSD_WINDOW_CACHE_MAX (lock held) */
+static void cache_trim(void) {
+    psd_window_t **pp = &cache_head;
+    while (*pp && cache_count > PSD_WINDOW_CACHE_MAX) {
+        psd_window_t *e = *pp;
+        if (e->refs == 0) {
+            *pp = e->next;
+            window_destroy(e);
+            cache_count--;
+        } else {
+            pp = &e->next;
+        }
+    }
+}
+
+const psd_window_t *psd_window_get(PsdWindowType_t type, int n, double param) {
+    if (n <= 0) return NULL;
+    if (param == 0.0) param = psd_window_default_param(type);
+
+    pthread_mutex_lock(&cache_lock);
+
+    psd_window_t **pp = &cache_head;
+    for (psd_window_t *e = cache_head; e; pp = &e->next, e = e->next) {
+        if (e->type == type && e->n == n && e->param == param) {
+            // move to front: the most recent windows are found first
+            *pp = e->next;
+            e->next = cache_head;
+            cache_head = e;
+            e->refs++;
+            pthread_mutex_unlock(&cache_lock);
+            return e;
+        }
+    }
+
+    psd_window_t *win = window_build(type, n, param);
+    if (win) {
+        win->refs = 1;
+        win->next = cache_head;
+        cache_head = win;
+        cache_count++;
+        cache_trim();
+    } else {
+        fprintf(stderr, "[WINDOW] alloc failed (%s, n=%d)\n", psd_window_name(type), n);
+    }
+
+    pthread_mutex_unlock(&cache_lock);
+    return win;
+}
+
+void psd_window_release(const psd_window_t *win) {
+    if (!win) return;
+    pthread_mutex_lock(&cache_lock);
+    ((psd_window_t*)win)->refs--;
+    cache_trim();
+    pthread_mutex_unlock(&cache_lock);
+}
+
+double psd_window_enbw(PsdWindowType_t type, int n, double param) {
+    const psd_window_t *win = psd_window_get(type, n > 0 ? n : PSD_WINDOW_REF_LEN, param);
+    if (!win) return 1.0;
+    double enbw = win->enbw;
+    psd_window_release(win);
+    return enbw;
+}
+
+// =========================================================
+// DPSS tapers
+// =========================================================
+
+/*
+  The DPSS of length n and half-bandwidth W = nw/n are the eigenvectors of
+  the symmetric tridiagonal matrix
+      d[i] = ((n-1-2i)/2)^2 cos(2 pi W),   e[i] = (i+1)(n-1-i)/2
+  belonging to its k largest eigenvalues: bisection (Sturm counts) for the
+  eigenvalues, inverse iteration for the vectors. O(n) memory and O(k n)
+  per sweep, so million-point tapers are fine.
+*/
+
+static pthread_mutex_t dpss_lock = PTHREAD_MUTEX_INITIALIZER;
+static psd_dpss_t *dpss_head;
+static int dpss_count;
+
+/* Number of eigenvalues of T strictly below x */
+static int sturm_count(const double *d, const double *e2, int n, double x) {
+    int count = 0;
+    double q = d[0] - x;
+    if (q < 0.0) count++;
+    for (int i = 1; i < n; i++) {
+        if (q == 0.0) q = 1e-300;
+        q = d[i] - x - e2[i - 1] / q;
+        if (q < 0.0) count++;
+    }
+    return count;
+}
+
+/* LU of (T - lambda I) with partial pivoting (LAPACK dgttrf layout) */
+static void tridiag_factor(const double *d, const double *e, int n, double lambda,
+                           double *dl, double *dd, double *du, double *du2, int *perm) {
+    for (int i = 0; i < n; i++) {
+        dd[i] = d[i] - lambda;
+        dl[i] = du[i] = (i < n - 1) ? e[i] : 0.0;
+        du2[i] = 0.0;
+    }
+    for (int i = 0; i < n - 1; i++) {
+        if (fabs(dd[i]) >= fabs(dl[i])) {
+            perm[i] = 0;
+            if (dd[i] == 0.0) dd[i] = 1e-300;
+            double f = dl[i] / dd[i];
+            dl[i] = f;
+            dd[i + 1] -= f * du[i];
+        } else {
+            perm[i] = 1;
+            double f = dd[i] / dl[i];
+            dd[i] = dl[i];
+            dl[i] = f;
+            double t = du[i];
+            du[i] = dd[i + 1];
+            dd[i + 1] = t - f * dd[i + 1];
+            if (i < n - 2) {
+                du2[i] = du[i + 1];
+                du[i + 1] = -f * du[i + 1];
+            }
+        }
+    }
+    if (dd[n - 1] == 0.0) dd[n - 1] = 1e-300;
+}
+
+static void tridiag_solve(const double *dl, const double *dd, const double *du,
+                          const double *du2, const int *perm, int n, double *b) {
+    for (int i = 0; i < n - 1; i++) {
+        if (perm[i] == 0) {
+            b[i + 1] -= dl[i] * b[i];
+        } else {
+            double t = b[i];
+            b[i] = b[i + 1];
+            b[i + 1] = t - dl[i] * b[i];
+        }
+    }
+    b[n - 1] /= dd[n - 1];
+    if (n > 1) b[n - 2] = (b[n - 2] - du[n - 2] * b[n - 1]) / dd[n - 2];
+    for (int i = n - 3; i >= 0; i--) {
+        b[i] = (b[i] - du[i] * b[i + 1] - du2[i] * b[i + 2]) / dd[i];
+    }
+}
+
+/* lambda_j = sum_m rxx[m] * r[m], r = autocorrelation of the ideal band-limiting kernel */
+static int dpss_concentration(psd_dpss_t *set, double W) {
+    int n = set->n;
+    int m = 2 * n;
+    fftw_complex *buf = fftw_alloc_complex(m);
+    if (!buf) return -1;
+    fftw_plan fwd = fftw_plan_dft_1d(m, buf, buf, FFTW_FORWARD, FFTW_ESTIMATE);
+    fftw_plan inv = fftw_plan_dft_1d(m, buf, buf, FFTW_BACKWARD, FFTW_ESTIMATE);
+    if (!fwd || !inv) {
+        if (fwd) fftw_destroy_plan(fwd);
+        if (inv) fftw_destroy_plan(inv);
+        fftw_free(buf);
+        return -1;
+    }
+
+    for (int j = 0; j < set->k; j++) {
+        const double *v = &set->w[(size_t)j * n];
+        for (int i = 0; i < n; i++) buf[i] = v[i];
+        for (int i = n; i < m; i++) buf[i] = 0.0;
+        fftw_execute(fwd);
+        for (int i = 0; i < m; i++) buf[i] = creal(buf[i]) * creal(buf[i]) + cimag(buf[i]) * cimag(buf[i]);
+        fftw_execute(inv);
+
+        double lam = 2.0 * W * creal(buf[0]) / m;
+        for (int i = 1; i < n; i++) {
+            double x = 2.0 * M_PI * W * i;
+            lam += 4.0 * W * (sin(x) / x) * creal(buf[i]) / m;
+        }
+        set->lambda[j] = fmin(fmax(lam, 0.0), 1.0);
+    }
+
+    fftw_destroy_plan(fwd);
+    fftw_destroy_plan(inv);
+    fftw_free(buf);
+    return 0;
+}
+
+static psd_dpss_t *dpss_build(int n, double nw, int k) {
+    double W = nw / n;
+    psd_dpss_t *set = (psd_dpss_t*)calloc(1, sizeof(*set));
+    double *d  = (double*)malloc((size_t)n * sizeof(double));
+    double *e  = (double*)malloc((size_t)n * sizeof(double));
+    double *e2 = (double*)malloc((size_t)n * sizeof(double));
+    double *lu_dl = (double*)malloc((size_t)n * sizeof(double));
+    double *lu_d = (double*)malloc((size_t)n * sizeof(double));
+    double *lu_du = (double*)malloc((size_t)n * sizeof(double));
+    double *lu_du2 = (double*)malloc((size_t)n * sizeof(double));
+    int *perm  = (int*)malloc((size_t)n * sizeof(int));
+    if (set) {
+        set->w = (double*)malloc((size_t)k * n * sizeof(double));
+        set->lambda = (double*)malloc((size_t)k * sizeof(double));
+    }
+    if (!set || !set->w || !set->lambda || !d || !e || !e2 || !lu_dl || !lu_d || !lu_du || !lu_du2 || !perm) {
+        if (set) { free(set->w); free(set->lambda); free(set); }
+        set = NULL;
+        goto out;
+    }
+    set->n = n;
+    set->nw = nw;
+    set->k = k;
+
+    double c = cos(2.0 * M_PI * W);
+    double lo = 0.0, hi = 0.0;
+    for (int i = 0; i < n; i++) {
+        double t = (n - 1 - 2.0 * i) / 2.0;
+        d[i] = t * t * c;
+        e[i] = (i < n - 1) ? (i + 1.0) * (n - 1.0 - i) / 2.0 : 0.0;
+        e2[i] = e[i] * e[i];
+    }
+    // Gershgorin bounds
+    for (int i = 0; i < n; i++) {
+        double r = e[i] + (i > 0 ? e[i - 1] : 0.0);
+        if (i == 0 || d[i] - r < lo) lo = d[i] - r;
+        if (i == 0 || d[i] + r > hi) hi = d[i] + r;
+    }
+
+    for (int j = 0; j < k; j++) {
+        // (n-1-j)-th eigenvalue in ascending order
+        int idx = n - 1 - j;
+        double a = lo, b = hi;
+        for (int it = 0; it < 200 && b - a > 1e-13 * fmax(1.0, fabs(b)); it++) {
+            double mid = 0.5 * (a + b);
+            if (sturm_count(d, e2, n, mid) <= idx) a = mid;
+            else b = mid;
+        }
+        double lambda = 0.5 * (a + b);
+
+        double *v = &set->w[(size_t)j * n];
+        for (int i = 0; i < n; i++) v[i] = 1.0 + 0.01 * ((i * 7919) % 97);
+        tridiag_factor(d, e, n, lambda, lu_dl, lu_d, lu_du, lu_du2, perm);
+        for (int it = 0; it < 3; it++) {
+            tridiag_solve(lu_dl, lu_d, lu_du, lu_du2, perm, n, v);
+            double nrm = 0.0;
+            for (int i = 0; i < n; i++) nrm += v[i] * v[i];
+            nrm = 1.0 / sqrt(nrm);
+            for (int i = 0; i < n; i++) v[i] *= nrm;
+        }
+        // symmetric tapers: positive mean; antisymmetric: positive first half
+        double s = 0.0;
+        for (int i = 0; i < n / 2; i++) s += (j % 2 == 0) ? v[i] + v[n - 1 - i] : v[i];
+        if (s < 0.0) for (int i = 0; i < n; i++) v[i] = -v[i];
+    }
+
+    if (dpss_concentration(set, W) != 0) {
+        // fall back to the asymptotic ideal: all tapers fully concentrated
+        for (int j = 0; j < k; j++) set->lambda[j] = 1.0;
+    }
+
+out:
+    free(d); free(e); free(e2); free(lu_dl); free(lu_d); free(lu_du); free(lu_du2); free(perm);
+    return set;
+}
+
+const psd_dpss_t *psd_dpss_get(int n, double nw, int k) {
+    if (n < 4) return NULL;
+    if (nw <= 0.0) nw = PSD_DPSS_DEFAULT_NW;
+    if (k <= 0) k = (int)(2.0 * nw) - 1;
+    if (k < 1) k = 1;
+    if (k > PSD_DPSS_MAX_K) k = PSD_DPSS_MAX_K;
+    if (k > n) k = n;
+
+    pthread_mutex_lock(&dpss_lock);
+
+    for (psd_dpss_t *e = dpss_head; e; e = e->next) {
+        if (e->n == n && e->nw == nw && e->k == k) {
+            e->refs++;
+            pthread_mutex_unlock(&dpss_lock);
+            return e;
+        }
+    }
+
+    psd_dpss_t *set = dpss_build(n, nw, k);
+    if (set) {
+        set->refs = 1;
+        set->next = dpss_head;
+        dpss_head = set;
+        dpss_count++;
+        fprintf(stderr, "[WINDOW] DPSS n=%d NW=%.2f K=%d | lambda_0=%.6f lambda_K-1=%.6f\n",
+                n, nw, k, set->lambda[0], set->lambda[k - 1]);
+    } else {
+        fprintf(stderr, "[WINDOW] DPSS alloc failed (n=%d, K=%d)\n", n, k);
+    }
+
+    pthread_mutex_unlock(&dpss_lock);
+    return set;
+}
+
+void psd_dpss_release(const psd_dpss_t *set) {
+    if (!set) return;
+    pthread_mutex_lock(&dpss_lock);
+    ((psd_dpss_t*)set)->refs--;
+
+    // taper sets are large: keep at most one unreferenced set
+    psd_dpss_t **pp = &dpss_head;
+    int idle = 0;
+    while (*pp) {
+        psd_dpss_t *e = *pp;
+        if (e->refs == 0 && idle++ > 0) {
+            *pp = e->next;
+            free(e->w);
+            free(e->lambda);
+            free(e);
+            dpss_count--;
+        } else {
+            pp = &e->next;
+        }
+    }
+    pthread_mutex_unlock(&dpss_lock);
+}
@@ -0,0 +1,70 @@
+//libs/psd_window.h
+#ifndef PSD_WINDOW_H
+#define PSD_WINDOW_H
+
+#include "datatypes.h"
+
+/* Length used for the RBW estimate before the FFT size is known */
+#define PSD_WINDOW_REF_LEN   4096
+/* Unreferenced windows kept around for reuse */
+#define PSD_WINDOW_CACHE_MAX 8
+
+/**
+ * One precomputed window (symmetric, length n), shared through the cache.
+ * param: Kaiser beta, Tukey alpha; ignored by the other types.
+ *
+ *   enbw   = n * sum(w^2) / sum(w)^2      (bins)
+ *   cg     = sum(w) / n                   (coherent gain)
+ *   u_norm = sum(w^2) / n                 (Welch power normalisation)
+ */
+typedef struct psd_window {
+    PsdWindowType_t type;
+    int n;
+    double param;
+
+    double *w;
+
+    double enbw;
+    double cg;
+    double u_norm;
+
+    int refs;
+    struct psd_window *next;
+} psd_window_t;
+
+/* Window from the cache (computed on first use). Pair with psd_window_release */
+const psd_window_t *psd_window_get(PsdWindowType_t type, int n, double param);
+void psd_window_release(const psd_window_t *win);
+
+/* Default parameter when the config leaves it at 0 */
+double psd_window_default_param(PsdWindowType_t type);
+
+/* Exact ENBW (bins) at length n; n <= 0 uses PSD_WINDOW_REF_LEN */
+double psd_window_enbw(PsdWindowType_t type, int n, double param);
+
+const char *psd_window_name(PsdWindowType_t type);
+
+/**
+ * DPSS (Slepian) taper set for (n, nw, k), cached like the windows.
+ * Tapers are unit energy, stored back to back (taper j at w + j*n);
+ * lambda[j] is the in-band energy concentration used by adaptive weighting.
+ */
+typedef struct psd_dpss {
+    int n;
+    double nw;
+    int k;
+
+    double *w;
+    double *lambda;
+
+    int refs;
+    struct psd_dpss *next;
+} psd_dpss_t;
+
+#define PSD_DPSS_DEFAULT_NW 4.0
+#define PSD_DPSS_MAX_K      64
+
+const psd_dpss_t *psd_dpss_get(int n, double nw, int k);
+void psd_dpss_release(const psd_dpss_t *set);
+
+#endif
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
 
@@ -12,6 +13,12 @@ void rb_init(ring_buffer_t *rb, size_t size) {
     rb->size = size;
     rb->head = 0;
     rb->tail = 0;
+    memset(rb->tags, 0, sizeof(rb->tags));
+    rb->tag_seq = 0;
+    rb->dropped = 0;
+    rb->tail_skew = 0;
+    rb->gap_first = rb->gap_end = 0;
+    rb->gap_skips = 0;
     pthread_mutex_init(&rb->lock, NULL);
 }
 
@@ -33,9 +40,41 @@ void rb_reset(ring_buffer_t *rb) {
     }
     rb->head = 0;
     rb->tail = 0;
+    memset(rb->tags, 0, sizeof(rb->tags));
+    rb->dropped = 0;
+    rb->tail_skew = 0;
+    rb->gap_first = rb->gap_end = 0;
     pthread_mutex_unlock(&rb->lock);
 }
 
+/* Forget drops the tail has passed (lock held) */
+static void gaps_prune(ring_buffer_t *rb) {
+    while (rb->gap_first != rb->gap_end && rb->gaps[rb->gap_first % RB_MAX_GAPS].store <= rb->tail) {
+        rb->tail_skew = rb->gaps[rb->gap_first % RB_MAX_GAPS].skew;
+        rb->gap_first++;
+    }
+}
+
+/* len bytes lost at the head (lock held) */
+static void gap_record(ring_buffer_t *rb, size_t len) {
+    rb->dropped += len;
+    if (rb->head == rb->tail) {
+        rb->tail_skew = rb->dropped;   // nothing unread: no gap to split a read
+        return;
+    }
+    if (rb->gap_first != rb->gap_end && rb->gaps[(rb->gap_end - 1) % RB_MAX_GAPS].store == rb->head) {
+        rb->gaps[(rb->gap_end - 1) % RB_MAX_GAPS].skew = rb->dropped;   // same hole, longer
+        return;
+    }
+    if (rb->gap_end - rb->gap_first == RB_MAX_GAPS) {
+        // no room to remember it: what precedes the oldest drop is given up
+        rb->tail = rb->gaps[rb->gap_first % RB_MAX_GAPS].store;
+        gaps_prune(rb);
+    }
+    rb->gaps[rb->gap_end % RB_MAX_GAPS] = (rb_gap_t){ .store = rb->head, .skew = rb->dropped };
+    rb->gap_end++;
+}
+
 size_t rb_write(ring_buffer_t *rb, const void *data, size_t len) {
     pthread_mutex_lock(&rb->lock);
     
@@ -43,6 +82,7 @@ size_t rb_write(ring_buffer_t *rb, const void *data, size_t len) {
     size_t to_write = MIN(len, space_free);
 
     if (to_write == 0) {
+        if (len > 0) gap_record(rb, len);
         pthread_mutex_unlock(&rb->lock);
         return 0;
     }
@@ -56,6 +96,12 @@ size_t rb_write(ring_buffer_t *rb, const void *data, size_t len) {
     if (chunk2 > 0) memcpy(rb->buffer, (uint8_t*)data + chunk1, chunk2);
 
     rb->head += to_write;
+    if (to_write < len) gap_record(rb, len - to_write);
+
+    if (rb->tag_seq) {
+        rb_tag_t *t = &rb->tags[rb->tag_seq % RB_MAX_TAGS];
+        if (!(t->flags & RB_TAG_SETTLED) && rb->head + rb->dropped >= t->valid_pos) t->flags |= RB_TAG_SETTLED;
+    }
     
     pthread_mutex_unlock(&rb->lock);
     return to_write;
@@ -80,6 +126,7 @@ size_t rb_read(ring_buffer_t *rb, void *data, size_t len) {
     if (chunk2 > 0) memcpy((uint8_t*)data + chunk1, rb->buffer, chunk2);
 
     rb->tail += to_read;
+    gaps_prune(rb);
 
     pthread_mutex_unlock(&rb->lock);
     return to_read;
@@ -90,4 +137,100 @@ size_t rb_available(ring_buffer_t *rb) {
     size_t val = rb->head - rb->tail;
     pthread_mutex_unlock(&rb->lock);
     return val;
-}
\ No newline at end of file
+}
+
+rb_tag_t rb_tag(ring_buffer_t *rb, uint32_t flags, size_t settle_bytes, int flush) {
+    pthread_mutex_lock(&rb->lock);
+    if (flush) {
+        rb->tail = rb->head;
+        gaps_prune(rb);
+    }
+
+    uint64_t pos = rb->head + rb->dropped;
+    rb_tag_t t = {
+        .pos = pos,
+        .valid_pos = pos + settle_bytes,
+        .seq = ++rb->tag_seq,
+        .flags = flags & ~RB_TAG_SETTLED
+    };
+    if (settle_bytes == 0) t.flags |= RB_TAG_SETTLED;
+    rb->tags[t.seq % RB_MAX_TAGS] = t;
+    pthread_mutex_unlock(&rb->lock);
+    return t;
+}
+
+int rb_last_tag(ring_buffer_t *rb, rb_tag_t *out) {
+    pthread_mutex_lock(&rb->lock);
+    int ok = rb->tag_seq != 0;
+    if (ok && out) *out = rb->tags[rb->tag_seq % RB_MAX_TAGS];
+    pthread_mutex_unlock(&rb->lock);
+    return ok ? 0 : -1;
+}
+
+size_t rb_read_from(ring_buffer_t *rb, uint64_t pos, void *data, size_t len, uint64_t *start_out) {
+    pthread_mutex_lock(&rb->lock);
+    gaps_prune(rb);
+
+    // drop what precedes pos (settling / pre-retune samples), one gap-free run at a time
+    for (;;) {
+        bool gap = rb->gap_first != rb->gap_end;
+        size_t run_end = gap ? rb->gaps[rb->gap_first % RB_MAX_GAPS].store : rb->head;
+        uint64_t at = rb->tail + rb->tail_skew;
+        if (at < pos) {
+            rb->tail += MIN((size_t)(pos - at), run_end - rb->tail);
+            if (rb->tail < run_end) continue;   // pos is inside this run
+            if (!gap) break;                    // caught up with the head
+        } else {
+            if (!gap || run_end - rb->tail >= len) break;
+            rb->tail = run_end;   // a drop splits the capture: start over after it
+            rb->gap_skips++;
+        }
+        gaps_prune(rb);
+    }
+
+    if (rb->tail + rb->tail_skew < pos || rb->head - rb->tail < len || len == 0) {
+        pthread_mutex_unlock(&rb->lock);
+        return 0;
+    }
+    if (start_out) *start_out = rb->tail + rb->tail_skew;
+
+    size_t tail_idx = rb->tail % rb->size;
+    size_t chunk1 = MIN(len, rb->size - tail_idx);
+    size_t chunk2 = len - chunk1;
+
+    memcpy(data, rb->buffer + tail_idx, chunk1);
+    if (chunk2 > 0) memcpy((uint8_t*)data + chunk1, rb->buffer, chunk2);
+
+    rb->tail += len;
+    gaps_prune(rb);
+
+    pthread_mutex_unlock(&rb->lock);
+    return len;
+}
+
+size_t rb_read_run(ring_buffer_t *rb, void *data, size_t len, uint64_t *start_out) {
+    pthread_mutex_lock(&rb->lock);
+    gaps_prune(rb);
+
+    size_t run_end = (rb->gap_first != rb->gap_end) ? rb->gaps[rb->gap_first % RB_MAX_GAPS].store : rb->head;
+    size_t to_read = MIN(len, run_end - rb->tail);
+    if (start_out) *start_out = rb->tail + rb->tail_skew;
+
+    if (to_read == 0) {
+        pthread_mutex_unlock(&rb->lock);
+        return 0;
+    }
+
+    size_t tail_idx = rb->tail % rb->size;
+    size_t chunk1 = MIN(to_read, rb->size - tail_idx);
+    size_t chunk2 = to_read - chunk1;
+
+    memcpy(data, rb->buffer + tail_idx, chunk1);
+    if (chunk2 > 0) memcpy((uint8_t*)data + chunk1, rb->buffer, chunk2);
+
+    rb->tail += to_read;
+    gaps_prune(rb);
+
+    pthread_mutex_unlock(&rb->lock);
+    return to_read;
+}
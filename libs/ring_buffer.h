@@ -6,12 +6,50 @@
 #include <stddef.h>
 #include <pthread.h>
 
+#define RB_MAX_TAGS 32
+#define RB_MAX_GAPS 32
+
+/* What changed at a tag */
+#define RB_TAG_FREQ     0x01
+#define RB_TAG_GAIN     0x02
+#define RB_TAG_RATE     0x04
+#define RB_TAG_SETTLED  0x80    // the stream has reached valid_pos
+
+/*
+  Stream tag: a position is the stream index of a byte (sample = pos / 2 for
+  int8 IQ), counting the bytes rb_write dropped on a full ring too. pos is
+  where the change was applied; samples before valid_pos may predate it or
+  still be settling.
+*/
+typedef struct {
+    uint64_t pos;
+    uint64_t valid_pos;
+    uint32_t seq;
+    uint32_t flags;
+} rb_tag_t;
+
+/* Drop on a full ring: bytes stored from `store` on sit `skew` bytes further in the stream */
+typedef struct {
+    uint64_t store;
+    uint64_t skew;
+} rb_gap_t;
+
 typedef struct {
     uint8_t *buffer;
     size_t size;
-    size_t head;
+    size_t head;                  // stored-byte counters (stream position = counter + skew)
     size_t tail;
     pthread_mutex_t lock;
+
+    rb_tag_t tags[RB_MAX_TAGS];   // last RB_MAX_TAGS tags, tags[seq % RB_MAX_TAGS]
+    uint32_t tag_seq;
+
+    uint64_t dropped;             // bytes lost on a full ring = skew of the head
+    uint64_t tail_skew;           // skew of the byte at tail
+    rb_gap_t gaps[RB_MAX_GAPS];   // drops inside the unread data, gaps[n % RB_MAX_GAPS]
+    uint32_t gap_first;
+    uint32_t gap_end;
+    uint64_t gap_skips;           // rb_read_from runs abandoned because a drop split them
 } ring_buffer_t;
 
 void rb_init(ring_buffer_t *rb, size_t size);
@@ -21,4 +59,20 @@ size_t rb_write(ring_buffer_t *rb, const void *data, size_t len);
 size_t rb_read(ring_buffer_t *rb, void *data, size_t len);
 size_t rb_available(ring_buffer_t *rb);
 
+/* Tag the current write position; flush = drop everything queued before it */
+rb_tag_t rb_tag(ring_buffer_t *rb, uint32_t flags, size_t settle_bytes, int flush);
+int rb_last_tag(ring_buffer_t *rb, rb_tag_t *out);
+
+/* All-or-nothing read of len gap-free bytes from stream position pos on (earlier
+   bytes are dropped, a position already consumed starts at tail). 0 until all are
+   there; a run split by a drop is discarded and the read restarts after it.
+   *start_out (may be NULL) = stream position of the first byte returned, > pos
+   when data had to be skipped. */
+size_t rb_read_from(ring_buffer_t *rb, uint64_t pos, void *data, size_t len, uint64_t *start_out);
+
+/* rb_read that stops at the next drop: the bytes returned are contiguous in the
+   stream and *start_out (may be NULL) is the stream position of the first one,
+   so a reader sees a gap exactly where start_out != end of its previous read. */
+size_t rb_read_run(ring_buffer_t *rb, void *data, size_t len, uint64_t *start_out);
+
 #endif
\ No newline at end of file
@@ -1,24 +1,146 @@
 //libs/sdr_HAL.c
 #include "sdr_HAL.h"
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
 
-static void tune_freq_with_ppm(hackrf_device* dev, uint64_t target_freq, int ppm_error) {
-    double correction = 1.0 + ((double)ppm_error / 1000000.0);
-    uint64_t corrected_freq = (uint64_t)((double)target_freq * correction);
-    
-    printf("[HAL] Target: %lu Hz | PPM: %d | Tuning to: %lu Hz\n", 
-           target_freq, ppm_error, corrected_freq);
+static const char *op_names[SDR_OP_COUNT] = { "amp", "lna", "vga", "rate", "sync", "freq" };
+
+static pthread_mutex_t hal_lock = PTHREAD_MUTEX_INITIALIZER;
+static hackrf_device *cached_dev = NULL;   // NULL = nothing applied yet
+static SDR_cfg_t cached_cfg;
+static sdr_hal_op_stat_t op_stats[SDR_OP_COUNT];
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* Book-keeping for one control transfer (hal_lock held); appends "name N us" to log */
+static int op_done(sdr_hal_op_t op, double t0, int status, char *log, size_t cap, size_t *len) {
+    sdr_hal_op_stat_t *s = &op_stats[op];
+    double dt = now_us() - t0;
+    s->count++;
+    if (status != HACKRF_SUCCESS) s->errors++;
+    s->last_us = dt;
+    s->total_us += dt;
+    if (dt > s->max_us) s->max_us = dt;
+
+    if (log && *len < cap) {
+        *len += (size_t)snprintf(log + *len, cap - *len, " %s %.0f us%s", op_names[op], dt,
+                                 status == HACKRF_SUCCESS ? "" : " (error)");
+    }
+    return status == HACKRF_SUCCESS ? 0 : 1;
+}
 
-    hackrf_set_freq(dev, corrected_freq);
+static uint64_t ppm_corrected(uint64_t target_freq, int ppm_error) {
+    double correction = 1.0 + ((double)ppm_error / 1000000.0);
+    return (uint64_t)((double)target_freq * correction);
 }
 
 void hackrf_apply_cfg(hackrf_device* dev, SDR_cfg_t *cfg) {
     if (!dev || !cfg) return;
 
-    hackrf_set_amp_enable(dev, cfg->amp_enabled ? 1 : 0);
-    hackrf_set_lna_gain(dev, cfg->lna_gain);
-    hackrf_set_vga_gain(dev, cfg->vga_gain);
-    hackrf_set_sample_rate(dev, cfg->sample_rate);
-    hackrf_set_hw_sync_mode(dev, 0);
-    tune_freq_with_ppm(dev, cfg->center_freq, cfg->ppm_error);
-}
\ No newline at end of file
+    pthread_mutex_lock(&hal_lock);
+    bool full = (dev != cached_dev);
+    const SDR_cfg_t *c = &cached_cfg;
+    char log[192];
+    size_t len = 0;
+    int ops = 0, errors = 0;
+    double t_all = now_us(), t0;
+
+    if (full || cfg->amp_enabled != c->amp_enabled) {
+        t0 = now_us();
+        errors += op_done(SDR_OP_AMP, t0, hackrf_set_amp_enable(dev, cfg->amp_enabled ? 1 : 0), log, sizeof(log), &len);
+        ops++;
+    }
+    if (full || cfg->lna_gain != c->lna_gain) {
+        t0 = now_us();
+        errors += op_done(SDR_OP_LNA, t0, hackrf_set_lna_gain(dev, cfg->lna_gain), log, sizeof(log), &len);
+        ops++;
+    }
+    if (full || cfg->vga_gain != c->vga_gain) {
+        t0 = now_us();
+        errors += op_done(SDR_OP_VGA, t0, hackrf_set_vga_gain(dev, cfg->vga_gain), log, sizeof(log), &len);
+        ops++;
+    }
+    if (full || cfg->sample_rate != c->sample_rate) {
+        t0 = now_us();
+        errors += op_done(SDR_OP_RATE, t0, hackrf_set_sample_rate(dev, cfg->sample_rate), log, sizeof(log), &len);
+        ops++;
+    }
+    if (full) {
+        t0 = now_us();
+        errors += op_done(SDR_OP_SYNC, t0, hackrf_set_hw_sync_mode(dev, 0), log, sizeof(log), &len);
+        ops++;
+    }
+    if (full || cfg->center_freq != c->center_freq || cfg->ppm_error != c->ppm_error) {
+        uint64_t corrected_freq = ppm_corrected(cfg->center_freq, cfg->ppm_error);
+        printf("[HAL] Target: %lu Hz | PPM: %d | Tuning to: %lu Hz\n",
+               cfg->center_freq, cfg->ppm_error, corrected_freq);
+        t0 = now_us();
+        errors += op_done(SDR_OP_FREQ, t0, hackrf_set_freq(dev, corrected_freq), log, sizeof(log), &len);
+        ops++;
+    }
+
+    // a failed setting leaves the device state unknown: next apply sends everything
+    cached_dev = errors ? NULL : dev;
+    cached_cfg = *cfg;
+    pthread_mutex_unlock(&hal_lock);
+
+    if (ops > 0) {
+        printf("[HAL] %s apply: %d ops in %.2f ms |%s\n", full ? "full" : "delta", ops,
+               (now_us() - t_all) / 1e3, log);
+    } else {
+        printf("[HAL] config unchanged: nothing sent\n");
+    }
+}
+
+int sdr_hal_retune(hackrf_device* dev, uint64_t freq) {
+    if (!dev) return -1;
+
+    pthread_mutex_lock(&hal_lock);
+    if (dev == cached_dev && freq == cached_cfg.center_freq) {
+        pthread_mutex_unlock(&hal_lock);
+        return 0;
+    }
+    int ppm = (dev == cached_dev) ? cached_cfg.ppm_error : 0;
+    double t0 = now_us();
+    int st = hackrf_set_freq(dev, ppm_corrected(freq, ppm));
+    op_done(SDR_OP_FREQ, t0, st, NULL, 0, NULL);
+    if (st == HACKRF_SUCCESS && dev == cached_dev) cached_cfg.center_freq = freq;
+    pthread_mutex_unlock(&hal_lock);
+    return st == HACKRF_SUCCESS ? 0 : -1;
+}
+
+void sdr_hal_invalidate(void) {
+    pthread_mutex_lock(&hal_lock);
+    cached_dev = NULL;
+    memset(&cached_cfg, 0, sizeof(cached_cfg));
+    pthread_mutex_unlock(&hal_lock);
+}
+
+void sdr_hal_stats(sdr_hal_op_stat_t out[SDR_OP_COUNT]) {
+    pthread_mutex_lock(&hal_lock);
+    memcpy(out, op_stats, sizeof(op_stats));
+    pthread_mutex_unlock(&hal_lock);
+}
+
+void sdr_hal_stats_reset(void) {
+    pthread_mutex_lock(&hal_lock);
+    memset(op_stats, 0, sizeof(op_stats));
+    pthread_mutex_unlock(&hal_lock);
+}
+
+void sdr_hal_stats_print(void) {
+    sdr_hal_op_stat_t s[SDR_OP_COUNT];
+    sdr_hal_stats(s);
+    for (int i = 0; i < SDR_OP_COUNT; i++) {
+        if (s[i].count == 0) continue;
+        printf("[HAL] %-4s: %8llu ops | avg %7.1f us | max %7.1f us | last %7.1f us | %llu errors\n",
+               op_names[i], (unsigned long long)s[i].count, s[i].total_us / (double)s[i].count,
+               s[i].max_us, s[i].last_us, (unsigned long long)s[i].errors);
+    }
+}
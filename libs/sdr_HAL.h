@@ -19,6 +19,41 @@ typedef struct {
     int ppm_error;
 } SDR_cfg_t;
 
+/* Control operations timed by the HAL (each one is a USB control transfer) */
+typedef enum {
+    SDR_OP_AMP,
+    SDR_OP_LNA,
+    SDR_OP_VGA,
+    SDR_OP_RATE,
+    SDR_OP_SYNC,
+    SDR_OP_FREQ,
+    SDR_OP_COUNT
+} sdr_hal_op_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t errors;
+    double last_us;
+    double total_us;
+    double max_us;
+} sdr_hal_op_stat_t;
+
+/**
+ * The HAL keeps the last configuration it applied to the device: after the
+ * first full apply only the settings that changed are sent. A different
+ * device handle (or sdr_hal_invalidate) forces the full sequence again.
+ */
 void hackrf_apply_cfg(hackrf_device* dev, SDR_cfg_t *cfg);
 
-#endif
\ No newline at end of file
+/* LO only (ppm from the last apply), no logging: the sweep / scan hot path */
+int  sdr_hal_retune(hackrf_device* dev, uint64_t freq);
+
+/* Forget the cached state (device reopened or reset behind the HAL) */
+void sdr_hal_invalidate(void);
+
+/* Latency per operation since start (or since the last reset) */
+void sdr_hal_stats(sdr_hal_op_stat_t out[SDR_OP_COUNT]);
+void sdr_hal_stats_reset(void);
+void sdr_hal_stats_print(void);
+
+#endif
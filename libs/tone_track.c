@@ -0,0 +1,149 @@
+//libs/tone_track.c
+#include "tone_track.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TONE_TRACK_R_N  0.999     // r^N: total damping over one window
+
+void tone_track_close(tone_track_t *t) {
+    if (!t) return;
+    free(t->sr); free(t->si);
+    free(t->cr); free(t->ci);
+    free(t->nr); free(t->ni);
+    free(t->hist);
+    free(t->pts);
+    free(t->msg);
+    memset(t, 0, sizeof(*t));
+}
+
+int tone_track_open(tone_track_t *t, const ToneCfg_t *cfg, double fs, double f_ref_hz,
+                    tone_track_emit_fn emit, void *user) {
+    if (!t || !cfg || fs <= 0.0) return -1;
+    memset(t, 0, sizeof(*t));
+
+    for (int i = 0; i < cfg->n_tones && i < TONE_TRACK_MAX; i++) {
+        double off = cfg->freq_hz[i] - f_ref_hz;
+        if (fabs(off) >= fs / 2.0) {
+            fprintf(stderr, "[TONE] %.0f Hz outside the %.0f Hz stream, dropped\n", cfg->freq_hz[i], fs);
+            continue;
+        }
+        t->freq_hz[t->k++] = cfg->freq_hz[i];
+    }
+    if (t->k == 0) return -1;
+
+    double rbw = cfg->rbw_hz > 0.0 ? cfg->rbw_hz : 1000.0;
+    double rate = cfg->rate_hz > 0.0 ? cfg->rate_hz : 1000.0;
+    double pub_ms = cfg->publish_ms > 0.0 ? cfg->publish_ms : 100.0;
+
+    t->fs = fs;
+    t->f_ref_hz = f_ref_hz;
+    t->N = (int)lround(fs / rbw);
+    if (t->N < 16) t->N = 16;
+    t->hop = (int)lround(fs / rate);
+    if (t->hop < 1) t->hop = 1;
+    t->npts = (int)lround(rate * pub_ms / 1000.0);
+    if (t->npts < 1) t->npts = 1;
+    if (t->npts > TONE_TRACK_MAX_PTS) t->npts = TONE_TRACK_MAX_PTS;
+
+    size_t kb = (size_t)t->k * sizeof(float);
+    t->sr = (float*)calloc(1, kb);  t->si = (float*)calloc(1, kb);
+    t->cr = (float*)malloc(kb);     t->ci = (float*)malloc(kb);
+    t->nr = (float*)malloc(kb);     t->ni = (float*)malloc(kb);
+    t->hist = (int8_t*)calloc((size_t)t->N, 2);
+    t->pts = (float*)malloc((size_t)t->k * t->npts * sizeof(float));
+    t->msg_cap = 96 + (size_t)t->k * (32 + (size_t)t->npts * 8);
+    t->msg = (char*)malloc(t->msg_cap);
+    if (!t->sr || !t->si || !t->cr || !t->ci || !t->nr || !t->ni || !t->hist || !t->pts || !t->msg) {
+        tone_track_close(t);
+        return -1;
+    }
+
+    double r = pow(TONE_TRACK_R_N, 1.0 / t->N);
+    for (int j = 0; j < t->k; j++) {
+        double w = 2.0 * M_PI * (t->freq_hz[j] - f_ref_hz) / fs;
+        t->cr[j] = (float)(r * cos(w));
+        t->ci[j] = (float)(r * sin(w));
+        // w*N reduced before the trig call: N can be large
+        double wn = fmod(w * t->N, 2.0 * M_PI);
+        t->nr[j] = (float)(TONE_TRACK_R_N * cos(wn));
+        t->ni[j] = (float)(TONE_TRACK_R_N * sin(wn));
+    }
+
+    t->emit = emit;
+    t->emit_user = user;
+
+    fprintf(stderr, "[TONE] %d tones | fs=%.0f | N=%d (rbw %.1f Hz) | %.1f pts/s\n",
+            t->k, fs, t->N, fs / t->N, fs / t->hop);
+    return 0;
+}
+
+static void emit_points(tone_track_t *t) {
+    char *p = t->msg;
+    size_t cap = t->msg_cap;
+    size_t pos = (size_t)snprintf(p, cap, "{\"t\":%llu,\"dt_us\":%.3f,\"rbw\":%.1f,\"f\":[",
+                                  (unsigned long long)t->t_first, t->hop * 1e6 / t->fs, t->fs / t->N);
+    for (int j = 0; j < t->k; j++) {
+        pos += (size_t)snprintf(p + pos, cap - pos, "%s%.0f", j ? "," : "", t->freq_hz[j]);
+    }
+    pos += (size_t)snprintf(p + pos, cap - pos, "],\"p\":[");
+    for (int j = 0; j < t->k; j++) {
+        const float *s = &t->pts[(size_t)j * t->npts];
+        if (j) p[pos++] = ',';
+        p[pos++] = '[';
+        for (int i = 0; i < t->fill; i++) {
+            pos += (size_t)snprintf(p + pos, cap - pos, "%s%.1f", i ? "," : "", s[i]);
+        }
+        p[pos++] = ']';
+    }
+    snprintf(p + pos, cap - pos, "]}");
+
+    if (t->emit) t->emit(t->emit_user, p);
+    t->msgs++;
+    t->fill = 0;
+}
+
+void tone_track_feed_iq8(tone_track_t *t, const int8_t *iq, size_t n, uint64_t t_ns) {
+    if (!t || !t->sr || !iq) return;
+
+    const int k = t->k;
+    float *restrict sr = t->sr, *restrict si = t->si;
+    const float *restrict cr = t->cr, *restrict ci = t->ci;
+    const float *restrict nr = t->nr, *restrict ni = t->ni;
+    // |S|^2 -> dBFS: window gain N, int8 full scale 128
+    const float norm = 1.0f / ((float)t->N * (float)t->N * 128.0f * 128.0f);
+
+    for (size_t s = 0; s < n; s++) {
+        float xr = iq[2 * s], xi = iq[2 * s + 1];
+        int8_t *h = &t->hist[2 * t->hpos];
+        float or_ = h[0], oi = h[1];
+        h[0] = iq[2 * s];
+        h[1] = iq[2 * s + 1];
+        if (++t->hpos == t->N) t->hpos = 0;
+
+        #pragma omp simd
+        for (int j = 0; j < k; j++) {
+            float ar = sr[j] * cr[j] - si[j] * ci[j];
+            float ai = sr[j] * ci[j] + si[j] * cr[j];
+            sr[j] = ar + xr - (nr[j] * or_ - ni[j] * oi);
+            si[j] = ai + xi - (nr[j] * oi + ni[j] * or_);
+        }
+
+        t->seen++;
+        if (++t->hop_cnt < t->hop) continue;
+        t->hop_cnt = 0;
+        if (t->seen < (uint64_t)t->N) continue;   // window not full yet
+
+        if (t->fill == 0) t->t_first = t_ns + (uint64_t)((double)s * 1e9 / t->fs);
+        for (int j = 0; j < k; j++) {
+            float pw = (sr[j] * sr[j] + si[j] * si[j]) * norm;
+            t->pts[(size_t)j * t->npts + t->fill] = 10.0f * log10f(pw + 1e-20f);
+        }
+        if (++t->fill == t->npts) emit_points(t);
+    }
+}
@@ -0,0 +1,65 @@
+//libs/tone_track.h
+#ifndef TONE_TRACK_H
+#define TONE_TRACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "datatypes.h"
+
+#define TONE_TRACK_TOPIC     "tone_track"
+#define TONE_TRACK_MAX_PTS   1000     // points per tone and message
+
+typedef void (*tone_track_emit_fn)(void *user, const char *json);
+
+/**
+ * Bank of sliding DFTs, one per tracked frequency, over a complex int8 stream.
+ * Each new sample updates every tone with
+ *     S[n] = r e^{jw} S[n-1] + x[n] - r^N e^{jwN} x[n-N]
+ * so the cost is O(K) per sample for K tones, independent of the window N
+ * (= fs / rbw). The state is stored per tone in separate arrays so the
+ * inner loop vectorizes across tones. r < 1 keeps the float recursion from
+ * drifting (r^N = 0.999, < 0.01 dB bias).
+ *
+ * Every hop samples |S|^2 / N^2 is taken as one point (dBFS) of each
+ * tone's time series; a message with publish_ms of points is emitted.
+ */
+typedef struct {
+    int k;
+    int N;
+    double fs;
+    double f_ref_hz;          // absolute frequency of DC
+    double freq_hz[TONE_TRACK_MAX];
+
+    /* state, k each */
+    float *sr, *si;
+    float *cr, *ci;           // r e^{jw}
+    float *nr, *ni;           // r^N e^{jwN}
+
+    int8_t *hist;             // last N samples (IQ interleaved)
+    int hpos;
+
+    int hop;                  // samples per output point
+    int hop_cnt;
+    uint64_t seen;            // samples since open (window full after N)
+
+    float *pts;               // [k][npts] dBFS
+    int npts;
+    int fill;
+    uint64_t t_first;         // time of the first point of the pending message
+    uint64_t msgs;
+
+    char *msg;
+    size_t msg_cap;
+    tone_track_emit_fn emit;
+    void *emit_user;
+} tone_track_t;
+
+/* fs / f_ref_hz describe the input stream; tones outside +-fs/2 are dropped */
+int  tone_track_open(tone_track_t *t, const ToneCfg_t *cfg, double fs, double f_ref_hz,
+                     tone_track_emit_fn emit, void *user);
+void tone_track_close(tone_track_t *t);
+
+/* n complex samples (2n bytes); t_ns = time of iq[0] */
+void tone_track_feed_iq8(tone_track_t *t, const int8_t *iq, size_t n, uint64_t t_ns);
+
+#endif
@@ -5,8 +5,9 @@
 #include <string.h>
 
 zpub_t* zpub_init(void) {
-    zpub_t *pub = malloc(sizeof(zpub_t));
+    zpub_t *pub = calloc(1, sizeof(zpub_t));
     if (!pub) return NULL;
+    pthread_mutex_init(&pub->lock, NULL);
 
     pub->context = zmq_ctx_new();
     pub->socket = zmq_socket(pub->context, ZMQ_PUB);
@@ -28,29 +29,126 @@ zpub_t* zpub_init(void) {
 int zpub_publish(zpub_t *pub, const char *topic, const char *json_payload) {
     if (!pub || !topic || !json_payload) return -1;
 
-    // 1. Calculate required length: Topic + Space + JSON + NullTerminator
-    int len = snprintf(NULL, 0, "%s %s", topic, json_payload);
-    if (len < 0) return -1;
+    // "topic {json}" in one frame, to match the Python split(" ", 1) logic;
+    // built straight into the message: no format pass, no staging buffer
+    // (zmq_msg_init_size still allocates anything past its ~30-byte inline size)
+    size_t tl = strlen(topic), jl = strlen(json_payload);
+    zmq_msg_t msg;
+    if (zmq_msg_init_size(&msg, tl + 1 + jl) != 0) return -1;
+    char *p = (char*)zmq_msg_data(&msg);
+    memcpy(p, topic, tl);
+    p[tl] = ' ';
+    memcpy(p + tl + 1, json_payload, jl);
 
-    // 2. Allocate buffer
-    char *buffer = malloc(len + 1);
-    if (!buffer) return -1;
+    pthread_mutex_lock(&pub->lock);
+    int bytes_sent = zmq_msg_send(&msg, pub->socket, 0);
+    pthread_mutex_unlock(&pub->lock);
+    if (bytes_sent < 0) zmq_msg_close(&msg);
+    return bytes_sent;
+}
 
-    // 3. Format the string: "topic {json}"
-    snprintf(buffer, len + 1, "%s %s", topic, json_payload);
+/* ZMQ is done with one zero-copy frame of a slot (called from its I/O thread) */
+static void zpub_bin_free(void *data, void *hint) {
+    (void)data;
+    zpub_bin_slot_t *slot = (zpub_bin_slot_t*)hint;
+    __atomic_sub_fetch(&slot->refs, 1, __ATOMIC_RELEASE);
+}
 
-    // 4. Send
-    // We send as a single string to match the Python split(" ", 1) logic
-    int bytes_sent = zmq_send(pub->socket, buffer, len, 0);
+int zpub_bin_enable(zpub_t *pub, int nslots, size_t max_floats) {
+    if (!pub || nslots <= 0 || max_floats == 0) return -1;
+    if (pub->slots) return (pub->slot_cap >= max_floats) ? 0 : -1;   // slots may be in flight: never resized
 
-    free(buffer);
-    return bytes_sent;
+    pub->slots = calloc((size_t)nslots, sizeof(zpub_bin_slot_t));
+    if (!pub->slots) return -1;
+    for (int i = 0; i < nslots; i++) {
+        pub->slots[i].mem = malloc(sizeof(zpub_bin_hdr_t) + max_floats * sizeof(float));
+        if (!pub->slots[i].mem) {
+            for (int k = 0; k < i; k++) free(pub->slots[k].mem);
+            free(pub->slots);
+            pub->slots = NULL;
+            return -1;
+        }
+    }
+    pub->nslots = nslots;
+    pub->slot_cap = max_floats;
+    printf("[ZPUB] binary frames: %d slots x %zu floats\n", nslots, max_floats);
+    return 0;
+}
+
+int zpub_bin_acquire(zpub_t *pub, zpub_bin_buf_t *buf) {
+    if (!pub || !buf || !pub->slots) return -1;
+
+    for (int k = 0; k < pub->nslots; k++) {
+        zpub_bin_slot_t *slot = &pub->slots[(pub->next_slot + k) % pub->nslots];
+        int expected = 0;
+        // 2 references: the header frame and the data frame
+        if (__atomic_compare_exchange_n(&slot->refs, &expected, 2, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            pub->next_slot = (pub->next_slot + k + 1) % pub->nslots;
+            buf->slot = slot;
+            buf->hdr = (zpub_bin_hdr_t*)slot->mem;
+            buf->data = (float*)((uint8_t*)slot->mem + sizeof(zpub_bin_hdr_t));
+            buf->cap = pub->slot_cap;
+            memset(buf->hdr, 0, sizeof(*buf->hdr));
+            return 0;
+        }
+    }
+    pub->bin_dropped++;
+    return -1;
+}
+
+int zpub_bin_publish(zpub_t *pub, const char *topic, zpub_bin_buf_t *buf, uint32_t count) {
+    if (!pub || !topic || !buf || !buf->slot) return -1;
+    zpub_bin_slot_t *slot = buf->slot;
+    buf->slot = NULL;
+    if (count > buf->cap) count = (uint32_t)buf->cap;
+
+    zpub_bin_hdr_t *h = buf->hdr;
+    h->magic = ZPUB_BIN_MAGIC;
+    h->version = ZPUB_BIN_VERSION;
+    h->count = count;
+
+    // each frame that exists holds one of the slot's 2 refs; a frame that
+    // never makes it into a message gives its ref back here
+    zmq_msg_t mh, md;
+    if (zmq_msg_init_data(&mh, h, sizeof(*h), zpub_bin_free, slot) != 0) {
+        __atomic_sub_fetch(&slot->refs, 2, __ATOMIC_RELEASE);
+        pub->bin_dropped++;
+        return -1;
+    }
+    if (zmq_msg_init_data(&md, buf->data, (size_t)count * sizeof(float), zpub_bin_free, slot) != 0) {
+        __atomic_sub_fetch(&slot->refs, 1, __ATOMIC_RELEASE);
+        zmq_msg_close(&mh);
+        pub->bin_dropped++;
+        return -1;
+    }
+
+    pthread_mutex_lock(&pub->lock);
+    h->seq = pub->bin_seq++;
+    // PUB never blocks: at HWM the first frame fails and nothing is queued.
+    // zmq_msg_send only takes a message on success: close whatever it did not take
+    int rc = zmq_send(pub->socket, topic, strlen(topic), ZMQ_SNDMORE | ZMQ_DONTWAIT);
+    if (rc >= 0) rc = zmq_msg_send(&mh, pub->socket, ZMQ_SNDMORE);
+    if (rc < 0) zmq_msg_close(&mh);
+    if (rc >= 0) rc = zmq_msg_send(&md, pub->socket, 0);
+    if (rc < 0) zmq_msg_close(&md);
+    if (rc >= 0) pub->bin_sent++;
+    else pub->bin_dropped++;
+    pthread_mutex_unlock(&pub->lock);
+    return rc < 0 ? -1 : 0;
 }
 
 void zpub_close(zpub_t *pub) {
     if (pub) {
         if (pub->socket) zmq_close(pub->socket);
-        if (pub->context) zmq_ctx_term(pub->context);
+        if (pub->context) zmq_ctx_term(pub->context);   // returns once every zero-copy frame is released
+        if (pub->slots) {
+            printf("[ZPUB] binary frames: %llu sent, %llu dropped\n",
+                   (unsigned long long)pub->bin_sent, (unsigned long long)pub->bin_dropped);
+            for (int i = 0; i < pub->nslots; i++) free(pub->slots[i].mem);
+            free(pub->slots);
+        }
+        pthread_mutex_destroy(&pub->lock);
         free(pub);
         printf("[ZPUB] Publisher closed.\n");
     }
@@ -107,4 +205,96 @@ void zsub_close(zsub_t *sub) {
     zmq_close(sub->socket);
     zmq_ctx_term(sub->context);
     free(sub);
-}
\ No newline at end of file
+}
+/* ------------------------------------------------------------------ binary subscriber */
+
+static void* bin_listener_thread(void *arg) {
+    zsub_bin_t *sub = (zsub_bin_t*)arg;
+    zmq_msg_t part[3];
+    float small[16];
+
+    while (sub->running) {
+        for (int i = 0; i < 3; i++) zmq_msg_init(&part[i]);
+
+        // first part (or the 1 s timeout); the rest of a message is already here
+        int n = 0;
+        if (zmq_msg_recv(&part[0], sub->socket, 0) >= 0) {
+            n = 1;
+            int more = zmq_msg_more(&part[0]);
+            while (more) {
+                zmq_msg_t extra, *m = (n < 3) ? &part[n] : &extra;
+                if (m == &extra) zmq_msg_init(&extra);
+                if (zmq_msg_recv(m, sub->socket, 0) < 0) break;
+                more = zmq_msg_more(m);
+                if (m == &extra) zmq_msg_close(&extra);
+                n++;
+            }
+        }
+
+        const zpub_bin_hdr_t *h = (const zpub_bin_hdr_t*)zmq_msg_data(&part[1]);
+        if (n == 0) {
+            // timeout: loop to check running
+        } else if (n == 3 && zmq_msg_size(&part[1]) == sizeof(zpub_bin_hdr_t) &&
+                   h->magic == ZPUB_BIN_MAGIC &&
+                   zmq_msg_size(&part[2]) == (size_t)h->count * sizeof(float)) {
+            char topic[64];
+            size_t tl = zmq_msg_size(&part[0]);
+            if (tl >= sizeof(topic)) tl = sizeof(topic) - 1;
+            memcpy(topic, zmq_msg_data(&part[0]), tl);
+            topic[tl] = '\0';
+
+            zpub_bin_hdr_t hdr;
+            memcpy(&hdr, h, sizeof(hdr));
+            const float *data = (const float*)zmq_msg_data(&part[2]);
+            // large frames are heap blocks; only tiny ones can sit unaligned inside the msg
+            if (((uintptr_t)data % sizeof(float)) != 0 && hdr.count <= 16) {
+                memcpy(small, data, hdr.count * sizeof(float));
+                data = small;
+            }
+            sub->received++;
+            if (sub->callback) sub->callback(sub->user, topic, &hdr, data);
+        } else {
+            sub->bad++;
+        }
+        for (int i = 0; i < 3; i++) zmq_msg_close(&part[i]);
+    }
+    return NULL;
+}
+
+zsub_bin_t* zsub_bin_init(const char *addr, const char *topic, zsub_bin_cb_t cb, void *user) {
+    zsub_bin_t *sub = calloc(1, sizeof(zsub_bin_t));
+    if (!sub) return NULL;
+    sub->context = zmq_ctx_new();
+    sub->socket = zmq_socket(sub->context, ZMQ_SUB);
+    sub->callback = cb;
+    sub->user = user;
+
+    int timeout = 1000;
+    zmq_setsockopt(sub->socket, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+    if (zmq_connect(sub->socket, addr ? addr : PUB_IPC_ADDR) != 0) {
+        fprintf(stderr, "[ZSUB] connect %s: %s\n", addr ? addr : PUB_IPC_ADDR, zmq_strerror(zmq_errno()));
+        zmq_close(sub->socket);
+        zmq_ctx_term(sub->context);
+        free(sub);
+        return NULL;
+    }
+    zmq_setsockopt(sub->socket, ZMQ_SUBSCRIBE, topic ? topic : "", topic ? strlen(topic) : 0);
+    return sub;
+}
+
+void zsub_bin_start(zsub_bin_t *sub) {
+    if (!sub) return;
+    sub->running = 1;
+    pthread_create(&sub->thread_id, NULL, bin_listener_thread, sub);
+}
+
+void zsub_bin_close(zsub_bin_t *sub) {
+    if (!sub) return;
+    if (sub->running) {
+        sub->running = 0;
+        pthread_join(sub->thread_id, NULL);
+    }
+    zmq_close(sub->socket);
+    zmq_ctx_term(sub->context);
+    free(sub);
+}
@@ -4,6 +4,8 @@
 
 #include <zmq.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #define IPC_ADDR "ipc:///tmp/zmq_feed"
 #define PUB_IPC_ADDR "ipc:///tmp/zmq_data"
@@ -19,11 +21,78 @@ typedef struct {
     msg_callback_t callback;
     int running;
 } zsub_t;
+/*
+  Binary multipart messages on the same PUB socket:
+
+    frame 1  topic (no terminator)
+    frame 2  zpub_bin_hdr_t (64 bytes, little endian)
+    frame 3  float32[count]
+
+  Frames 2 and 3 are sent zero-copy from a preallocated slot; ZMQ hands the
+  slot back through the free callback once the message left every
+  subscriber queue. Text subscribers never match: their topics are distinct.
+*/
+#define ZPUB_BIN_MAGIC   0x4E494250u   /* "PBIN" */
+#define ZPUB_BIN_VERSION 1
+
+typedef enum {
+    ZPUB_BIN_PSD    = 1,        // trace: data[i] at f_start_hz + i * df_hz, in `scale`
+    ZPUB_BIN_SERIES = 2         // generic metric vector (meaning given by the topic)
+} zpub_bin_kind_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t kind;              // zpub_bin_kind_t
+    uint32_t seq;               // per-publisher message counter (gaps = drops)
+    uint32_t count;             // float32 values in frame 3
+    uint64_t t_ns;              // CLOCK_REALTIME
+    double center_freq_hz;
+    double f_start_hz;
+    double df_hz;
+    char scale[16];
+} zpub_bin_hdr_t;
+
+typedef struct {
+    void *mem;                  // [zpub_bin_hdr_t][float data[cap]]
+    int refs;                   // frames still held (caller or ZMQ), atomic; 0 = free
+} zpub_bin_slot_t;
+
+/* A slot handed out by zpub_bin_acquire */
+typedef struct {
+    zpub_bin_hdr_t *hdr;
+    float *data;
+    size_t cap;
+    zpub_bin_slot_t *slot;
+} zpub_bin_buf_t;
+
 typedef struct {
     void *context;
     void *socket;
+    pthread_mutex_t lock;       // ZMQ sockets are not thread safe: PSD + tone threads share this one
+
+    zpub_bin_slot_t *slots;
+    int nslots;
+    size_t slot_cap;            // floats per slot
+    int next_slot;
+    uint32_t bin_seq;
+    uint64_t bin_sent;
+    uint64_t bin_dropped;       // no free slot or HWM
 } zpub_t;
 
+typedef void (*zsub_bin_cb_t)(void *user, const char *topic, const zpub_bin_hdr_t *hdr, const float *data);
+
+typedef struct {
+    void *context;
+    void *socket;
+    pthread_t thread_id;
+    zsub_bin_cb_t callback;
+    void *user;
+    volatile int running;
+    uint64_t received;
+    uint64_t bad;               // malformed multipart messages
+} zsub_bin_t;
+
 zsub_t* zsub_init(const char *topic, msg_callback_t cb);
 void zsub_start(zsub_t *sub);
 void zsub_close(zsub_t *sub);
@@ -31,4 +100,16 @@ zpub_t* zpub_init(void);
 int zpub_publish(zpub_t *pub, const char *topic, const char *json_payload);
 void zpub_close(zpub_t *pub);
 
+/* Binary path: nslots buffers of up to max_floats (0 if already enabled large enough) */
+int  zpub_bin_enable(zpub_t *pub, int nslots, size_t max_floats);
+/* Free slot to fill, -1 if every slot is still in flight (the frame should be dropped) */
+int  zpub_bin_acquire(zpub_t *pub, zpub_bin_buf_t *buf);
+/* Send buf->hdr + count floats; always takes the slot back, even on error */
+int  zpub_bin_publish(zpub_t *pub, const char *topic, zpub_bin_buf_t *buf, uint32_t count);
+
+/* Subscriber for binary messages; addr NULL = PUB_IPC_ADDR. data is only valid inside the callback */
+zsub_bin_t* zsub_bin_init(const char *addr, const char *topic, zsub_bin_cb_t cb, void *user);
+void zsub_bin_start(zsub_bin_t *sub);
+void zsub_bin_close(zsub_bin_t *sub);
+
 #endif
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "opus_tx.h"
 
 #include "psd.h"
+#include "psd_pub.h"
 #include "datatypes.h"
 #include "sdr_HAL.h"
 
@@ -105,35 +106,14 @@ static SDR_cfg_t    g_hack_cfg    = {0};
 static PsdConfig_t  g_psd_cfg     = {0};
 static RB_cfg_t     g_rb_cfg      = {0};
 
+/* PSD binary publication (shm, seqlock) */
+static psd_shm_t    g_psd_shm     = { .fd = -1 };
+
 /* ===================== HELPERS ===================== */
 static const char* mode_str(demod_mode_t m) {
     switch (m) { case DEMOD_AM: return "AM"; case DEMOD_FM: return "FM"; default: return "UNKNOWN"; }
 }
 
-/* CSV: freq_rel + center_freq => freq_abs */
-static int save_results_csv(const char *csv_path,
-                            double* freq_array_rel,
-                            double* psd_array,
-                            int length,
-                            const SDR_cfg_t *local_hack,
-                            const char *scale_label)
-{
-    if (!csv_path || !freq_array_rel || !psd_array || length <= 0 || !local_hack) return -1;
-
-    FILE *fp = fopen(csv_path, "w");
-    if (!fp) { perror("[CSV] fopen"); return -1; }
-
-    fprintf(fp, "freq_hz,psd_%s\n", (scale_label && scale_label[0]) ? scale_label : "lin");
-
-    for (int i = 0; i < length; i++) {
-        double f_abs = freq_array_rel[i] + (double)local_hack->center_freq;
-        fprintf(fp, "%.6f,%.12e\n", f_abs, psd_array[i]);
-    }
-
-    fclose(fp);
-    return 0;
-}
-
 /* ===================== CIC DECIMATOR (FAST STREAMING) ===================== */
 /*
    CIC decimator:
@@ -457,26 +437,22 @@ static void* psd_thread_fn(void* arg) {
         execute_welch_psd(sig, &g_psd_cfg, freq, psd);
         scale_psd(psd, g_psd_cfg.nperseg, g_desired_cfg.scale);
 
-        double half_span = g_desired_cfg.span / 2.0;
         int start_idx = 0;
-        int end_idx = g_psd_cfg.nperseg - 1;
-
-        for (int i = 0; i < g_psd_cfg.nperseg; i++) {
-            if (freq[i] >= -half_span) { start_idx = i; break; }
-        }
-        for (int i = start_idx; i < g_psd_cfg.nperseg; i++) {
-            if (freq[i] > half_span) { end_idx = i - 1; break; }
-            end_idx = i;
-        }
-
-        int valid_len = end_idx - start_idx + 1;
+        int valid_len = psd_span_bins(freq, g_psd_cfg.nperseg, g_desired_cfg.lo_offset,
+                                      g_desired_cfg.span, &start_idx);
         if (valid_len > 0) {
-            if (save_results_csv(PSD_CSV_PATH,
-                                 &freq[start_idx],
-                                 &psd[start_idx],
-                                 valid_len,
-                                 &g_hack_cfg,
-                                 g_desired_cfg.scale) == 0) {
+            double df = freq[1] - freq[0];
+            psd_shm_publish(&g_psd_shm, &psd[start_idx], valid_len,
+                            (double)g_hack_cfg.center_freq, g_psd_cfg.sample_rate,
+                            freq[start_idx], df, g_desired_cfg.scale, psd_now_ns());
+
+            if (psd_save_csv(PSD_CSV_PATH,
+                             &freq[start_idx],
+                             &psd[start_idx],
+                             valid_len,
+                             g_hack_cfg.center_freq,
+                             g_desired_cfg.scale,
+                             NULL) == 0) {
                 fprintf(stderr, "[PSD] Saved CSV: %s | bins=%d | drops=%lu\n",
                         PSD_CSV_PATH, valid_len,
                         (unsigned long)atomic_load(&g_psd_drops));
@@ -541,9 +517,16 @@ int main(void) {
     g_desired_cfg.amp_enabled  = 1;
     g_desired_cfg.antenna_port = 1;
 
-    find_params_psd(g_desired_cfg, &g_hack_cfg, &g_psd_cfg, &g_rb_cfg);
+    if (find_params_psd(g_desired_cfg, &g_hack_cfg, &g_psd_cfg, &g_rb_cfg) != 0) {
+        fprintf(stderr, "[MAIN] invalid PSD configuration\n");
+        return 1;
+    }
     print_config_summary(&g_desired_cfg, &g_hack_cfg, &g_psd_cfg, &g_rb_cfg);
 
+    if (psd_shm_create(&g_psd_shm, PSD_SHM_DEFAULT_NAME, (uint32_t)g_psd_cfg.nperseg) != 0) {
+        fprintf(stderr, "[MAIN] PSD shm disabled (CSV only)\n");
+    }
+
     /* 5) HackRF init/open/apply */
     if (hackrf_init() != HACKRF_SUCCESS) {
         fprintf(stderr, "[MAIN] hackrf_init failed\n");
@@ -627,6 +610,7 @@ int main(void) {
     rb_sig_free(&g_pcm_rb);
 
     rb_free(&g_psd_rb);
+    psd_shm_close(&g_psd_shm);
 
     fprintf(stderr,
         "[MAIN] Done | RAW drops=%lu | DEMOD_IQ drops=%lu | PSD drops=%lu | PCM drops=%lu\n",
@@ -26,6 +26,7 @@
 
 /* New modular libs */
 #include "pipeline_threads.h"   /* threads library */
+#include "psd_pub.h"            /* shm PSD publication */
 #include "cic_decim.h"          /* not used directly in main, but OK to include */
 
 /* ===================== CONFIG ===================== */
@@ -69,19 +70,60 @@
 /* PSD ring buffer */
 #define PSD_RB_BYTES            (100 * 1024 * 1024)
 
-/* PSD output */
-#define PSD_CSV_PATH            "static2/last_psd.csv"
+/* PSD output: binary shm frame (readers: plot_server.py) + optional CSV */
+#define PSD_SHM_NAME            PSD_SHM_DEFAULT_NAME
+#define PSD_CSV_PATH            "static2/last_psd.csv"   /* NULL to disable */
+#define PSD_PYRAMID_MIN_BINS    0                        /* max/mean zoom levels in "<shm>_pyr" (e.g. 256; 0 = off) */
 
 /* PSD loop */
 #define PSD_WAIT_TIMEOUT_ITERS  500
 #define PSD_WAIT_SLEEP_US       10000
 #define PSD_POST_SLEEP_US       500000
 
+/* PSD mode: REALTIME_MODE (capture + sleep) or RTSA_MODE (gapless, traces at PSD_RTSA_FPS) */
+#define PSD_RF_MODE             REALTIME_MODE
+#define PSD_RTSA_FPS            20.0
+
+/* Frame cache: last N seconds of FFT frames, re-averaged on JSON queries from stdin (e.g. 10.0; 0 = off) */
+#define PSD_FRAME_CACHE_S       0.0
+
+/* Noise floor + channel detection on every trace, published on PUB_IPC_ADDR topic "psd_detect" (0 = off) */
+#define PSD_DETECT              0
+
+/* Burst start/stop events from every FFT frame, topic "psd_burst" (0 = off) */
+#define PSD_BURST               0
+
+/* Channel power / 99% OBW / ACPR of the tuned channel on every trace, topic "psd_meas" (e.g. 200000.0; 0 = off) */
+#define PSD_MEAS_BW_HZ          0.0
+
+/* Every trace as a binary float32 multipart message, topic "psd_frame" (zsub_bin_* readers; 0 = off) */
+#define PSD_ZMQ_FRAMES          0
+
+/* Per-bin correction table (rf/bb rows, libs/psd_cal.h) applied to every PSD output; NULL = off */
+#define PSD_CALIBRATION         NULL
+
+/* Remote spectrum: uint8 dB + delta runs over TCP on 127.0.0.1 (psd_stream_client.py, e.g. 5601; 0 = off) */
+#define PSD_STREAM_PORT         0
+
+/* Every published trace into an append-only history (segments of 1 h, last 48 kept;
+   e.g. "static2/archive"; NULL = off) */
+#define PSD_ARCHIVE_DIR         NULL
+
+/* Per-bin P10/P50/P90 + duty cycle over the whole run, checkpointed here (e.g. "static2/occupancy.pocc";
+   NULL = off); report with {"occ_query": {"quantiles": [10, 50, 90]}} on stdin */
+#define PSD_OCC_PATH            NULL
+
+/* Sliding-DFT power of g_tone_freqs on the demod IQ at kHz rates, topic "tone_track" (0 = off) */
+#define TONE_TRACK              0
+#define TONE_RB_BYTES           (1 * 1024 * 1024)
+
 /* ===================== DEMOD MODES ===================== */
 static demod_mode_t g_mode = DEMOD_FM; /* DEMOD_FM or DEMOD_AM */
 
 /* ===================== GLOBAL STATE ===================== */
 static atomic_int g_stop = 0;
+static const double g_tone_freqs[] = { FREQ_HZ, FREQ_HZ - 400000.0, FREQ_HZ + 400000.0 };
+static MeasChannel_t g_meas_chan = { .center_hz = (double)FREQ_HZ, .bw_hz = PSD_MEAS_BW_HZ };
 
 static hackrf_device *g_dev = NULL;
 static opus_tx_t *g_tx = NULL;
@@ -90,15 +132,20 @@ static opus_tx_t *g_tx = NULL;
 static rb_sig_t g_iq_raw_rb;     /* IQ @ Fs_in */
 static rb_sig_t g_iq_demod_rb;   /* IQ @ 1.92 MHz */
 static rb_sig_t g_pcm_rb;
+static rb_sig_t g_iq_tone_rb;    /* copy of the demod IQ for the tone tracker */
 
 static atomic_ulong g_iq_raw_drops   = 0;
 static atomic_ulong g_iq_demod_drops = 0;
 static atomic_ulong g_pcm_drops      = 0;
+static atomic_ulong g_iq_tone_drops  = 0;
 
 /* PSD RB + control */
 static ring_buffer_t g_psd_rb;
 static volatile bool g_psd_capture_active = false;
 static atomic_ulong g_psd_drops = 0;
+static atomic_ulong g_psd_overruns = 0;
+static pthread_mutex_t g_psd_query_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *g_psd_query_json = NULL;
 
 /* Demod params */
 static float g_fm_deemph_or_audio_bw = 8000.0f;
@@ -171,6 +218,7 @@ int main(void) {
     rb_sig_init(&g_iq_raw_rb,   IQ_RB_RAW_BYTES);
     rb_sig_init(&g_iq_demod_rb, IQ_RB_DEMOD_BYTES);
     rb_sig_init(&g_pcm_rb,      PCM_RB_BYTES);
+    if (TONE_TRACK) rb_sig_init(&g_iq_tone_rb, TONE_RB_BYTES);
 
     /* 3) PSD ring buffer */
     rb_init(&g_psd_rb, PSD_RB_BYTES);
@@ -178,6 +226,38 @@ int main(void) {
 
     /* 4) Build desired config (HW + PSD) */
     memset(&g_desired_cfg, 0, sizeof(g_desired_cfg));
+    g_desired_cfg.rf_mode      = PSD_RF_MODE;
+    g_desired_cfg.frame_rate   = PSD_RTSA_FPS;
+    g_desired_cfg.pyramid_min_bins = PSD_PYRAMID_MIN_BINS;
+    g_desired_cfg.zmq_frames = PSD_ZMQ_FRAMES;
+    g_desired_cfg.calibration = PSD_CALIBRATION;
+    g_desired_cfg.frame_cache.seconds = PSD_FRAME_CACHE_S;
+    g_desired_cfg.detect.enabled = PSD_DETECT;
+    g_desired_cfg.detect.gap_bins = 1;
+    g_desired_cfg.burst.enabled = PSD_BURST;
+    if (PSD_MEAS_BW_HZ > 0) {
+        g_desired_cfg.measure.channels = &g_meas_chan;
+        g_desired_cfg.measure.n_channels = 1;
+    }
+    g_desired_cfg.stream.port = PSD_STREAM_PORT;
+    g_desired_cfg.stream.deadband = 1;
+    g_desired_cfg.stream.compress = true;
+    g_desired_cfg.archive.dir = PSD_ARCHIVE_DIR;
+    g_desired_cfg.archive.quantize_u8 = true;
+    g_desired_cfg.archive.db_min = -140.0;
+    g_desired_cfg.archive.db_max = -20.0;
+    g_desired_cfg.archive.segment_s = 3600.0;
+    g_desired_cfg.archive.keep_segments = 48;
+    g_desired_cfg.occupancy.enabled = (PSD_OCC_PATH != NULL);
+    g_desired_cfg.occupancy.path = PSD_OCC_PATH;
+    g_desired_cfg.occupancy.threshold_db = NAN;
+    if (TONE_TRACK) {
+        for (size_t i = 0; i < sizeof(g_tone_freqs) / sizeof(g_tone_freqs[0]) && i < TONE_TRACK_MAX; i++) {
+            g_desired_cfg.tones.freq_hz[g_desired_cfg.tones.n_tones++] = g_tone_freqs[i];
+        }
+        g_desired_cfg.tones.rbw_hz = 2000.0;
+        g_desired_cfg.tones.rate_hz = 1000.0;
+    }
     g_desired_cfg.rbw          = 1000; /* example */
     g_desired_cfg.center_freq  = (double)FREQ_HZ;
     g_desired_cfg.sample_rate  = (double)SAMPLE_RATE_RF_IN;  /* PSD uses high Fs */
@@ -188,7 +268,10 @@ int main(void) {
     g_desired_cfg.amp_enabled  = 1;
     g_desired_cfg.antenna_port = 1;
 
-    find_params_psd(g_desired_cfg, &g_hack_cfg, &g_psd_cfg, &g_rb_cfg);
+    if (find_params_psd(g_desired_cfg, &g_hack_cfg, &g_psd_cfg, &g_rb_cfg) != 0) {
+        fprintf(stderr, "[MAIN] invalid PSD configuration\n");
+        return 1;
+    }
     print_config_summary(&g_desired_cfg, &g_hack_cfg, &g_psd_cfg, &g_rb_cfg);
 
     /* 5) HackRF init/open/apply */
@@ -220,14 +303,19 @@ int main(void) {
     ctx.iq_raw_rb   = &g_iq_raw_rb;
     ctx.iq_demod_rb = &g_iq_demod_rb;
     ctx.pcm_rb      = &g_pcm_rb;
+    ctx.iq_tone_rb  = (g_desired_cfg.tones.n_tones > 0) ? &g_iq_tone_rb : NULL;
 
     ctx.iq_raw_drops   = &g_iq_raw_drops;
     ctx.iq_demod_drops = &g_iq_demod_drops;
     ctx.pcm_drops      = &g_pcm_drops;
+    ctx.iq_tone_drops  = &g_iq_tone_drops;
 
     ctx.psd_rb            = &g_psd_rb;
     ctx.psd_capture_active = &g_psd_capture_active;
     ctx.psd_drops         = &g_psd_drops;
+    ctx.psd_overruns      = &g_psd_overruns;
+    ctx.psd_query_lock    = &g_psd_query_lock;
+    ctx.psd_query_json    = &g_psd_query_json;
 
     ctx.tx = g_tx;
 
@@ -239,7 +327,11 @@ int main(void) {
     ctx.psd_cfg     = &g_psd_cfg;
     ctx.rb_cfg      = &g_rb_cfg;
 
+    ctx.psd_shm_name = PSD_SHM_NAME;
     ctx.psd_csv_path = PSD_CSV_PATH;
+    ctx.zpub = (g_desired_cfg.detect.enabled || g_desired_cfg.burst.enabled || g_desired_cfg.zmq_frames ||
+                g_desired_cfg.measure.n_channels > 0 || g_desired_cfg.tones.n_tones > 0)
+               ? zpub_init() : NULL;
 
     ctx.psd_wait_timeout_iters = PSD_WAIT_TIMEOUT_ITERS;
     ctx.psd_wait_sleep_us      = PSD_WAIT_SLEEP_US;
@@ -251,6 +343,7 @@ int main(void) {
         hackrf_close(g_dev);
         hackrf_exit();
         opus_tx_destroy(g_tx);
+        zpub_close(ctx.zpub);
         return 1;
     }
 
@@ -261,12 +354,20 @@ int main(void) {
     }
 
     fprintf(stderr,
-        "[MAIN] Running | Fc=%.3f MHz | Fs_in=%d | Fs_demod=%d | Demod=%s | PSD total_bytes=%zu | ENTER to stop\n",
+        "[MAIN] Running | Fc=%.3f MHz | Fs_in=%d | Fs_demod=%d | Demod=%s | PSD total_bytes=%zu | ENTER to stop, JSON line = cache query / mask / occupancy report\n",
         (double)FREQ_HZ / 1e6, SAMPLE_RATE_RF_IN, SAMPLE_RATE_DEMOD,
         mode_str(g_mode), (size_t)g_rb_cfg.total_bytes
     );
 
-    getchar();
+    /* e.g. {"cache_query": {"window_s": 2, "mode": "max"}, "span": 2e6, "scale": "dBuV"}
+       or  {"mask": {"relative": true, "points": [[-2e5, -90], [-1e5, -60], [1e5, -60], [2e5, -90]]}} */
+    char line[4096];
+    while (fgets(line, sizeof(line), stdin)) {
+        if (line[0] == '\n' || line[0] == '\r') break;
+        if (pipeline_psd_post_query(&ctx, line) != 0) {
+            fprintf(stderr, "[MAIN] query ignored\n");
+        }
+    }
 
     /* 8) Stop + join */
     pipeline_threads_stop(&ctx);
@@ -283,14 +384,18 @@ int main(void) {
     rb_sig_free(&g_iq_raw_rb);
     rb_sig_free(&g_iq_demod_rb);
     rb_sig_free(&g_pcm_rb);
+    if (TONE_TRACK) rb_sig_free(&g_iq_tone_rb);
 
     rb_free(&g_psd_rb);
+    zpub_close(ctx.zpub);
 
     fprintf(stderr,
-        "[MAIN] Done | RAW drops=%lu | DEMOD_IQ drops=%lu | PSD drops=%lu | PCM drops=%lu\n",
+        "[MAIN] Done | RAW drops=%lu | DEMOD_IQ drops=%lu | TONE_IQ drops=%lu | PSD drops=%lu | PSD overruns=%lu | PCM drops=%lu\n",
         (unsigned long)atomic_load(&g_iq_raw_drops),
         (unsigned long)atomic_load(&g_iq_demod_drops),
+        (unsigned long)atomic_load(&g_iq_tone_drops),
         (unsigned long)atomic_load(&g_psd_drops),
+        (unsigned long)atomic_load(&g_psd_overruns),
         (unsigned long)atomic_load(&g_pcm_drops));
 
     return 0;
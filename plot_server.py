@@ -1,6 +1,158 @@
-from flask import Flask, jsonify, render_template_string
+from flask import Flask, jsonify, render_template_string, request
+import numpy as np
 import pandas as pd
 from pathlib import Path
+import time
+
+WATERFALL_PATH = Path("static/waterfall.bin")
+ARCHIVE_DIR = Path("static2/archive")
+PERSISTENCE_PATH = Path("static/persistence.bin")
+PSD_SHM_PATH = Path("/dev/shm/psd_last")
+PSD_PYR_PATH = Path("/dev/shm/psd_last_pyr")
+
+# Layout de libs/psd_pub.h (header 256 bytes + float32[capacity], seqlock en "seq")
+SHM_HEADER = np.dtype([
+    ("magic", "<u4"), ("version", "<u4"), ("capacity", "<u4"), ("nbins", "<u4"),
+    ("seq", "<u8"), ("timestamp_ns", "<u8"),
+    ("center_freq_hz", "<f8"), ("sample_rate_hz", "<f8"),
+    ("f_start_hz", "<f8"), ("df_hz", "<f8"),
+    ("scale", "S16"),
+])
+
+
+def read_psd_shm(path: Path, retries: int = 100):
+    """Lee un frame consistente del segmento shm (seqlock): (freqs_hz, psd, header)."""
+    mm = np.memmap(path, dtype=np.uint8, mode="r")
+    for _ in range(retries):
+        s1 = int(mm[16:24].view("<u8")[0])
+        if s1 & 1:
+            continue
+        hdr = np.frombuffer(mm[:SHM_HEADER.itemsize].tobytes(), dtype=SHM_HEADER)[0]
+        n = int(min(hdr["nbins"], hdr["capacity"]))
+        psd = mm[256:256 + 4 * n].copy().view("<f4")
+        s2 = int(mm[16:24].view("<u8")[0])
+        if s1 == s2:
+            if hdr["magic"] != 0x4D485350 or n == 0:
+                raise ValueError("shm sin frames")
+            freqs = hdr["f_start_hz"] + np.arange(n) * hdr["df_hz"]
+            return freqs, psd, hdr
+    raise TimeoutError("seqlock: no se obtuvo frame consistente")
+
+# Layout de libs/psd_pyramid.h (header 1024 bytes: 256 + tabla de niveles; luego float32 data[capacity])
+PYR_HEADER = np.dtype([
+    ("magic", "<u4"), ("version", "<u4"), ("capacity", "<u4"), ("nlevels", "<u4"),
+    ("seq", "<u8"), ("timestamp_ns", "<u8"),
+    ("center_freq_hz", "<f8"), ("sample_rate_hz", "<f8"),
+    ("f_start_hz", "<f8"), ("df_hz", "<f8"),
+    ("scale", "S16"),
+])
+PYR_LEVEL = np.dtype([("nbins", "<u4"), ("factor", "<u4"), ("off_max", "<u4"), ("off_mean", "<u4")])
+PYR_DATA_OFFSET = 1024
+
+
+def read_psd_pyramid(path: Path, f0: float, f1: float, width: int, plane: str = "max", retries: int = 100):
+    """Nivel más grueso con >= width bins en [f0, f1]; solo se copia ese tramo (seqlock)."""
+    mm = np.memmap(path, dtype=np.uint8, mode="r")
+    for _ in range(retries):
+        s1 = int(mm[16:24].view("<u8")[0])
+        if s1 & 1:
+            continue
+        hdr = np.frombuffer(mm[:PYR_HEADER.itemsize].tobytes(), dtype=PYR_HEADER)[0]
+        nl = int(hdr["nlevels"])
+        if hdr["magic"] != 0x52595050 or nl == 0 or hdr["df_hz"] <= 0:
+            raise ValueError("pirámide sin frames")
+        levels = np.frombuffer(mm[256:256 + nl * PYR_LEVEL.itemsize].tobytes(), dtype=PYR_LEVEL)
+
+        lo, hi = min(f0, f1), max(f0, f1)
+        a = max(int(np.ceil((lo - hdr["f_start_hz"]) / hdr["df_hz"] - 1e-9)), 0)
+        b = min(int(np.floor((hi - hdr["f_start_hz"]) / hdr["df_hz"] + 1e-9)) + 1, int(levels[0]["nbins"]))
+        if b <= a:
+            return np.zeros(0), np.zeros(0, dtype=np.float32), hdr
+        lvl = 0
+        for L in range(nl - 1, 0, -1):
+            F = int(levels[L]["factor"])
+            if (b - 1) // F + 1 - a // F >= width:
+                lvl = L
+                break
+        F = int(levels[lvl]["factor"])
+        i0, n = a // F, (b - 1) // F + 1 - a // F
+        off = PYR_DATA_OFFSET + 4 * (int(levels[lvl]["off_mean" if plane == "mean" else "off_max"]) + i0)
+        psd = mm[off:off + 4 * n].copy().view("<f4")
+        s2 = int(mm[16:24].view("<u8")[0])
+        if s1 == s2:
+            freqs = hdr["f_start_hz"] + ((i0 + np.arange(n)) * F + (F - 1) / 2.0) * hdr["df_hz"]
+            return freqs, psd, hdr
+    raise TimeoutError("seqlock: no se obtuvo frame consistente")
+
+# Layout de libs/psd_waterfall.h (header 256 bytes + filas circulares)
+WF_HEADER = np.dtype([
+    ("magic", "<u4"), ("version", "<u4"), ("nbins", "<u4"), ("nrows", "<u4"),
+    ("format", "<u4"), ("row_bytes", "<u4"),
+    ("center_freq_hz", "<f8"), ("sample_rate_hz", "<f8"),
+    ("f_start_hz", "<f8"), ("df_hz", "<f8"),
+    ("db_min", "<f4"), ("db_max", "<f4"),
+    ("row_period_ns", "<u8"), ("rows_written", "<u8"),
+    ("scale", "S16"),
+])
+WF_ROW_HDR_BYTES = 24
+
+
+def read_waterfall(path: Path, last_rows: int):
+    """Devuelve (freqs_hz, t_ns[rows], db[rows, bins]) de las últimas filas, sin parsear texto."""
+    mm = np.memmap(path, dtype=np.uint8, mode="r")
+    hdr = np.frombuffer(mm[:WF_HEADER.itemsize], dtype=WF_HEADER)[0]
+    if hdr["magic"] != 0x46574450:
+        raise ValueError("waterfall magic inválido")
+
+    nbins, nrows, row_bytes = int(hdr["nbins"]), int(hdr["nrows"]), int(hdr["row_bytes"])
+    written = int(hdr["rows_written"])
+    count = min(last_rows, written, nrows)
+
+    rows = mm[256:256 + nrows * row_bytes].reshape(nrows, row_bytes)
+    idx = np.array([(written - count + k) % nrows for k in range(count)], dtype=np.int64)
+    seq = rows[idx, 0:8].copy().view("<u8").ravel()
+    idx = idx[seq % 2 == 0]  # fila a medio escribir -> se omite
+    t_ns = rows[idx, 8:16].copy().view("<u8").ravel()
+
+    data = rows[idx, WF_ROW_HDR_BYTES:]
+    if hdr["format"] == 1:
+        q = data[:, :nbins].astype(np.float32)
+        db = hdr["db_min"] + q * (hdr["db_max"] - hdr["db_min"]) / 255.0
+    else:
+        db = data[:, :nbins * 4].copy().view("<f4")
+
+    freqs = hdr["f_start_hz"] + np.arange(nbins) * hdr["df_hz"]
+    return freqs, t_ns, db
+
+# Layout de libs/psd_persist.h (header 256 bytes + uint16[ncols][nlevels], seqlock en "seq")
+PX_HEADER = np.dtype([
+    ("magic", "<u4"), ("version", "<u4"), ("ncols", "<u4"), ("nlevels", "<u4"),
+    ("seq", "<u8"), ("t_ns", "<u8"), ("frames", "<u8"),
+    ("center_freq_hz", "<f8"), ("f_start_hz", "<f8"), ("df_hz", "<f8"),
+    ("db_min", "<f4"), ("db_max", "<f4"), ("max_hits", "<f4"), ("decay_s", "<f4"),
+    ("scale", "S16"),
+])
+
+
+def read_persistence(path: Path, retries: int = 100):
+    """Matriz de densidad (freqs_hz, levels_db, density[ncols, nlevels] en 0..1, header)."""
+    mm = np.memmap(path, dtype=np.uint8, mode="r")
+    for _ in range(retries):
+        s1 = int(mm[16:24].view("<u8")[0])
+        if s1 & 1:
+            continue
+        hdr = np.frombuffer(mm[:PX_HEADER.itemsize].tobytes(), dtype=PX_HEADER)[0]
+        ncols, nlevels = int(hdr["ncols"]), int(hdr["nlevels"])
+        q = mm[256:256 + 2 * ncols * nlevels].copy().view("<u2")
+        s2 = int(mm[16:24].view("<u8")[0])
+        if s1 == s2:
+            if hdr["magic"] != 0x58504450:
+                raise ValueError("persistence magic inválido")
+            step = (hdr["db_max"] - hdr["db_min"]) / nlevels
+            levels = hdr["db_min"] + (np.arange(nlevels) + 0.5) * step
+            freqs = hdr["f_start_hz"] + np.arange(ncols) * hdr["df_hz"]
+            return freqs, levels, q.reshape(ncols, nlevels) / 65535.0, hdr
+    raise TimeoutError("seqlock: no se obtuvo matriz consistente")
 
 app = Flask(__name__)
 
@@ -25,9 +177,14 @@ HTML_PAGE = """
 
     <script>
         let chartInit = false;
+        let zoom = null;   // [f0, f1] del eje x tras un zoom; null = span completo
 
         async function fetchData() {
-            const response = await fetch('/data');
+            // solo los bins que caben en pantalla: el servidor elige el nivel de la pirámide
+            const px = document.getElementById('chart').clientWidth || 1500;
+            let url = `/psd?px=${px}`;
+            if (zoom) url += `&f0=${zoom[0]}&f1=${zoom[1]}`;
+            const response = await fetch(url);
             const data = await response.json();
             return data;
         }
@@ -47,11 +204,16 @@ HTML_PAGE = """
                 title: 'Densidad Espectral de Potencia (PSD)',
                 xaxis: { title: 'Frecuencia [Hz]' },
                 yaxis: { title: 'Potencia [dBFS]' },
-                margin: { t: 50, l: 70, r: 30, b: 60 }
+                margin: { t: 50, l: 70, r: 30, b: 60 },
+                uirevision: 'keep'
             };
 
             if (!chartInit) {
                 Plotly.newPlot('chart', [trace], layout);
+                document.getElementById('chart').on('plotly_relayout', (ev) => {
+                    if (ev['xaxis.range[0]'] !== undefined) zoom = [ev['xaxis.range[0]'], ev['xaxis.range[1]']];
+                    else if (ev['xaxis.autorange']) zoom = null;
+                });
                 chartInit = true;
             } else {
                 Plotly.react('chart', [trace], layout);
@@ -67,12 +229,106 @@ HTML_PAGE = """
 </html>
 """
 
+# Layout de libs/psd_archive.h (segmentos psd_<t0>.pda: header 256 bytes + registros fijos; índice .pdi)
+AR_HEADER = np.dtype([
+    ("magic", "<u4"), ("version", "<u4"), ("nbins", "<u4"), ("format", "<u4"),
+    ("rec_bytes", "<u4"), ("pad", "<u4"),
+    ("center_freq_hz", "<f8"), ("sample_rate_hz", "<f8"),
+    ("f_start_hz", "<f8"), ("df_hz", "<f8"),
+    ("db_min", "<f4"), ("db_max", "<f4"), ("t_first_ns", "<u8"),
+    ("scale", "S16"),
+])
+AR_REC_HDR_BYTES = 16
+AR_INDEX = np.dtype([("t_ns", "<u8"), ("rec", "<u8")])
+
+
+def _ar_seek(times_at, idx, nrec, key, side):
+    """Primer registro con t >= key (side='left') o t > key ('right'): índice disperso + búsqueda binaria."""
+    a, b = 0, nrec
+    if len(idx):
+        k = int(np.searchsorted(idx["t_ns"], key, side=side))
+        if k > 0:
+            a = min(int(idx["rec"][k - 1]), nrec)
+        if k < len(idx):
+            b = min(int(idx["rec"][k]) + 1, nrec)
+    while a < b:
+        mid = (a + b) // 2
+        t = times_at(mid)
+        if (t <= key) if side == "right" else (t < key):
+            a = mid + 1
+        else:
+            b = mid
+    return a
+
+
+def read_archive(path: Path, t0_ns: int, t1_ns: int, rows: int):
+    """(freqs_hz, t_ns[rows], db[rows, bins]) en [t0, t1], un registro por fila (sin recorrer el rango)."""
+    segs = sorted(path.glob("psd_*.pda"))
+    starts = [int(p.stem[4:]) for p in segs]
+    spans = []
+    for i, seg in enumerate(segs):
+        if starts[i] > t1_ns:
+            break
+        if i + 1 < len(segs) and starts[i + 1] < t0_ns:
+            continue
+        mm = np.memmap(seg, dtype=np.uint8, mode="r")
+        hdr = np.frombuffer(mm[:AR_HEADER.itemsize], dtype=AR_HEADER)[0]
+        if hdr["magic"] != 0x52414450 or (spans and hdr["nbins"] != spans[0][1]["nbins"]):
+            continue
+        rb = int(hdr["rec_bytes"])
+        nrec = (len(mm) - 256) // rb
+        if nrec <= 0:
+            continue
+        recs = mm[256:256 + nrec * rb].reshape(nrec, rb)
+        idx_path = seg.with_suffix(".pdi")
+        idx = np.fromfile(idx_path, dtype=AR_INDEX) if idx_path.exists() else np.zeros(0, AR_INDEX)
+        times_at = lambda k, r=recs: int(r[k, 0:8].view("<u8")[0])
+        lo = _ar_seek(times_at, idx, nrec, t0_ns, "left")
+        hi = _ar_seek(times_at, idx, nrec, t1_ns, "right")
+        if hi > lo:
+            spans.append((recs, hdr, lo, hi))
+
+    if not spans:
+        return np.zeros(0), np.zeros(0, dtype=np.uint64), np.zeros((0, 0), dtype=np.float32)
+
+    hdr = spans[0][1]
+    nbins = int(hdr["nbins"])
+    counts = np.array([hi - lo for _, _, lo, hi in spans])
+    total = int(counts.sum())
+    n = min(rows, total)
+    picks = (np.arange(n, dtype=np.int64) * total) // n      # primer registro de cada fila
+    bounds = np.concatenate(([0], np.cumsum(counts)))
+    seg_of = np.searchsorted(bounds, picks, side="right") - 1
+
+    t_ns = np.empty(n, dtype=np.uint64)
+    db = np.empty((n, nbins), dtype=np.float32)
+    for j, (g, s) in enumerate(zip(picks, seg_of)):
+        recs, h, lo, _ = spans[s]
+        rec = recs[lo + g - bounds[s]]
+        t_ns[j] = rec[0:8].view("<u8")[0]
+        data = rec[AR_REC_HDR_BYTES:]
+        if h["format"] == 1:
+            db[j] = h["db_min"] + data[:nbins].astype(np.float32) * (h["db_max"] - h["db_min"]) / 255.0
+        else:
+            db[j] = data[:nbins * 4].view("<f4")
+
+    freqs = hdr["f_start_hz"] + np.arange(nbins) * hdr["df_hz"]
+    return freqs, t_ns, db
+
 @app.route('/')
 def home():
     return render_template_string(HTML_PAGE)
 
 @app.route('/data')
 def get_data():
+    # Camino rápido: frame binario en shm (sin parseo)
+    if PSD_SHM_PATH.exists():
+        try:
+            freqs, psd, _ = read_psd_shm(PSD_SHM_PATH)
+            return jsonify({"freq": freqs.tolist(), "psd": psd.tolist()})
+        except Exception:
+            pass  # cae al CSV
+
     csv_path = Path("static/last_psd.csv")
 
     if not csv_path.exists():
@@ -90,5 +346,58 @@ def get_data():
     except Exception as e:
         return jsonify({"error": str(e), "freq": [], "psd": []})
 
+@app.route('/psd')
+def get_psd_range():
+    """?f0=<Hz>&f1=<Hz>&px=<ancho>&plane=max|mean: tramo de la pirámide al nivel del zoom"""
+    if not PSD_PYR_PATH.exists():
+        return get_data()
+    try:
+        px = int(request.args.get("px", 1500))
+        f0 = float(request.args.get("f0", 0.0))
+        f1 = float(request.args.get("f1", 1e12))
+        plane = request.args.get("plane", "max")
+        freqs, psd, _ = read_psd_pyramid(PSD_PYR_PATH, f0, f1, px, plane)
+        return jsonify({"freq": freqs.tolist(), "psd": psd.tolist()})
+    except Exception as e:
+        return jsonify({"error": str(e), "freq": [], "psd": []})
+
+@app.route('/waterfall')
+def get_waterfall():
+    if not WATERFALL_PATH.exists():
+        return jsonify({"freq": [], "t_ns": [], "db": []})
+    try:
+        rows = int(request.args.get("rows", 100))
+        freqs, t_ns, db = read_waterfall(WATERFALL_PATH, rows)
+        return jsonify({"freq": freqs.tolist(), "t_ns": t_ns.tolist(), "db": db.tolist()})
+    except Exception as e:
+        return jsonify({"error": str(e), "freq": [], "t_ns": [], "db": []})
+
+@app.route('/persistence')
+def get_persistence():
+    if not PERSISTENCE_PATH.exists():
+        return jsonify({"freq": [], "levels_db": [], "density": []})
+    try:
+        freqs, levels, dens, hdr = read_persistence(PERSISTENCE_PATH)
+        return jsonify({"freq": freqs.tolist(), "levels_db": levels.tolist(),
+                        "density": dens.T.tolist(), "max_hits": float(hdr["max_hits"]),
+                        "frames": int(hdr["frames"])})
+    except Exception as e:
+        return jsonify({"error": str(e), "freq": [], "levels_db": [], "density": []})
+
+@app.route('/history')
+def get_history():
+    """?t0=<ns>&t1=<ns>&rows=N (por defecto: la última hora, 200 filas)"""
+    if not ARCHIVE_DIR.exists():
+        return jsonify({"freq": [], "t_ns": [], "db": []})
+    try:
+        now = time.time_ns()
+        t1 = int(request.args.get("t1", now))
+        t0 = int(request.args.get("t0", t1 - 3600 * 10**9))
+        rows = int(request.args.get("rows", 200))
+        freqs, t_ns, db = read_archive(ARCHIVE_DIR, t0, t1, rows)
+        return jsonify({"freq": freqs.tolist(), "t_ns": t_ns.tolist(), "db": db.tolist()})
+    except Exception as e:
+        return jsonify({"error": str(e), "freq": [], "t_ns": [], "db": []})
+
 if __name__ == '__main__':
     app.run(host='0.0.0.0', port=5000, debug=False)
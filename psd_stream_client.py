@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+Cliente de prueba del stream de espectro (libs/psd_stream.h).
+
+    python3 psd_stream_client.py [host] [port] [--frames N] [--csv out.csv]
+
+Reconstruye el espectro (KEY + DELTAs) e imprime fps, kbps y estadísticas
+por segundo; con --csv guarda el último frame en dB.
+"""
+import socket
+import struct
+import sys
+import time
+import zlib
+
+HDR = struct.Struct("<IBBBxIIQddffII")   # 56 bytes, ver psd_stream_hdr_t
+MAGIC = 0x54535350
+KEY, DELTA = 0, 1
+F_ZLIB = 0x01
+
+
+def recv_exact(sock, n):
+    buf = bytearray()
+    while len(buf) < n:
+        chunk = sock.recv(n - len(buf))
+        if not chunk:
+            raise ConnectionError("stream cerrado")
+        buf += chunk
+    return bytes(buf)
+
+
+def read_varint(p, pos):
+    v, shift = 0, 0
+    while True:
+        b = p[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        if b < 0x80:
+            return v, pos
+        shift += 7
+
+
+class SpectrumState:
+    def __init__(self):
+        self.levels = None
+        self.seq = None
+        self.hdr = None
+
+    def apply(self, hdr, payload):
+        magic, _ver, mtype, flags, seq, nbins, t_ns, f0, df, db_off, db_step, _plen, raw_len = hdr
+        if magic != MAGIC:
+            raise ValueError("magic inválido")
+        if flags & F_ZLIB:
+            payload = zlib.decompress(payload)
+        if len(payload) != raw_len:
+            raise ValueError("payload truncado")
+
+        if mtype == KEY:
+            if len(payload) != nbins:
+                raise ValueError("KEY con tamaño incorrecto")
+            self.levels = bytearray(payload)
+        else:
+            if self.levels is None or len(self.levels) != nbins or seq != self.seq + 1:
+                raise ValueError(f"DELTA {seq} sin base (último {self.seq})")
+            pos, i = 0, 0
+            while pos < len(payload):
+                skip, pos = read_varint(payload, pos)
+                run, pos = read_varint(payload, pos)
+                i += skip
+                self.levels[i:i + run] = payload[pos:pos + run]
+                pos += run
+                i += run
+        self.seq = seq
+        self.hdr = (t_ns, f0, df, db_off, db_step)
+
+    def db(self):
+        _, _, _, db_off, db_step = self.hdr
+        return [db_off + q * db_step for q in self.levels]
+
+    def freqs(self):
+        _, f0, df, _, _ = self.hdr
+        return [f0 + i * df for i in range(len(self.levels))]
+
+
+def main():
+    args = [a for a in sys.argv[1:]]
+    frames_max, csv_path = None, None
+    if "--frames" in args:
+        k = args.index("--frames")
+        frames_max = int(args[k + 1])
+        del args[k:k + 2]
+    if "--csv" in args:
+        k = args.index("--csv")
+        csv_path = args[k + 1]
+        del args[k:k + 2]
+    host = args[0] if len(args) > 0 else "127.0.0.1"
+    port = int(args[1]) if len(args) > 1 else 5601
+
+    sock = socket.create_connection((host, port))
+    st = SpectrumState()
+    frames = keys = nbytes = 0
+    win_t, win_frames, win_bytes = time.time(), 0, 0
+
+    while frames_max is None or frames < frames_max:
+        try:
+            hdr = HDR.unpack(recv_exact(sock, HDR.size))
+            payload = recv_exact(sock, hdr[11])
+        except (ConnectionError, KeyboardInterrupt):
+            break
+        st.apply(hdr, payload)
+
+        frames += 1
+        keys += hdr[2] == KEY
+        nbytes += HDR.size + len(payload)
+        win_frames += 1
+        win_bytes += HDR.size + len(payload)
+
+        now = time.time()
+        if now - win_t >= 1.0:
+            db = st.db()
+            print(f"seq {st.seq} | {len(db)} bins | {win_frames / (now - win_t):.1f} fps | "
+                  f"{8 * win_bytes / (now - win_t) / 1000:.1f} kbps | max {max(db):.1f} dB | keys {keys}")
+            win_t, win_frames, win_bytes = now, 0, 0
+
+    print(f"{frames} frames, {keys} keys, {nbytes / max(frames, 1):.0f} B/frame")
+    if csv_path and st.levels is not None:
+        with open(csv_path, "w") as fp:
+            fp.write("freq_hz,psd_db\n")
+            for f, v in zip(st.freqs(), st.db()):
+                fp.write(f"{f:.1f},{v:.2f}\n")
+
+
+if __name__ == "__main__":
+    main()
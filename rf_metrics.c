@@ -11,6 +11,11 @@
 #include <libhackrf/hackrf.h>
 
 #include "psd.h"
+#include "psd_pub.h"
+#include "psd_meas.h"
+#include "psd_cal.h"
+#include "psd_sweep.h"
+#include "psd_sched.h"
 #include "datatypes.h"
 #include "sdr_HAL.h"
 #include "ring_buffer.h"
@@ -29,11 +34,29 @@ PsdConfig_t psd_cfg = {0};
 SDR_cfg_t hack_cfg = {0};
 RB_cfg_t rb_cfg = {0};
 
+// CAMPAIGN_MODE: el callback entrega las muestras al barrido en vez del ring buffer
+psd_sweep_t *g_sweep = NULL;
+
+// RX abierto entre medidas: la config se aplica en caliente y el ring lleva tags
+// con la posición de cada cambio
+#define RF_SETTLE_US          500.0   // PLL / ganancias tras un cambio
+#define RF_IDLE_STOP_S        2.0     // sin medidas durante este tiempo se para el RX (0 = nunca)
+
+bool rx_running = false;
+uint64_t last_acq_ns = 0;
+SDR_cfg_t applied_cfg;
+volatile size_t last_xfer_bytes = 0;    // tamaño de transfer: lo que puede ir "en vuelo" al cambiar
+
 // =========================================================
 // CALLBACKS (MISMAS)
 // =========================================================
 int rx_callback(hackrf_transfer* transfer) {
     if (stop_streaming) return 0;
+    if (g_sweep) {
+        psd_sweep_rx(g_sweep, transfer->buffer, transfer->valid_length);
+        return 0;
+    }
+    last_xfer_bytes = (size_t)transfer->valid_length;
     rb_write(&rb, transfer->buffer, transfer->valid_length);
     return 0;
 }
@@ -47,6 +70,7 @@ int recover_hackrf(void) {
         hackrf_close(device);
         device = NULL;
     }
+    sdr_hal_invalidate();
 
     int attempts = 0;
     while (attempts < 3) {
@@ -61,38 +85,183 @@ int recover_hackrf(void) {
     return -1;
 }
 
+/* "static/last_psd.csv" -> "static/last_psd_<tag><ext>" (ext NULL = la del CSV) */
+static int out_path(char *dst, size_t cap, const char *csv_out, const char *tag, const char *ext) {
+    const char *dot = strrchr(csv_out, '.');
+    int stem = dot ? (int)(dot - csv_out) : (int)strlen(csv_out);
+    if (!ext) ext = dot ? dot : "";
+    int n = snprintf(dst, cap, "%.*s_%s%s", stem, csv_out, tag, ext);
+    return (n < 0 || (size_t)n >= cap) ? -1 : 0;
+}
+
 // =========================================================
-// REEMPLAZO DIRECTO DE publish_results(): ahora CSV
-// (misma idea: freq_rel + center_freq => freq_abs)
+// ADQUISICIÓN CONTINUA: sin start/stop por medida
 // =========================================================
-static int save_results_csv(const char *csv_path,
-                            double* freq_array_rel,
-                            double* psd_array,
-                            int length,
-                            SDR_cfg_t *local_hack,
-                            const char *scale_label)
-{
-    if (!csv_path || !freq_array_rel || !psd_array || length <= 0 || !local_hack) return -1;
-
-    FILE *fp = fopen(csv_path, "w");
-    if (!fp) {
-        perror("[CSV] fopen");
-        return -1;
-    }
+static uint32_t cfg_changes(const SDR_cfg_t *a, const SDR_cfg_t *b) {
+    uint32_t f = 0;
+    if (a->center_freq != b->center_freq || a->ppm_error != b->ppm_error) f |= RB_TAG_FREQ;
+    if (a->lna_gain != b->lna_gain || a->vga_gain != b->vga_gain || a->amp_enabled != b->amp_enabled) f |= RB_TAG_GAIN;
+    if (a->sample_rate != b->sample_rate) f |= RB_TAG_RATE;
+    return f;
+}
 
-    // Header simple
-    fprintf(fp, "freq_hz,psd_%s\n", (scale_label && scale_label[0]) ? scale_label : "lin");
+static void rx_stop(void) {
+    if (!rx_running) return;
+    stop_streaming = true;
+    hackrf_stop_rx(device);
+    rx_running = false;
+}
 
-    for (int i = 0; i < length; i++) {
-        double f_abs = freq_array_rel[i] + (double)local_hack->center_freq;
-        fprintf(fp, "%.6f,%.12e\n", f_abs, psd_array[i]);
+/* Aplica la config con el RX en marcha, etiqueta el ring y copia `len` bytes válidos */
+static int acquire_continuous(const SDR_cfg_t *hw, int8_t *dst, size_t len) {
+    uint32_t flags = rx_running ? cfg_changes(hw, &applied_cfg) : (RB_TAG_FREQ | RB_TAG_GAIN | RB_TAG_RATE);
+    if (flags) {
+        hackrf_apply_cfg(device, (SDR_cfg_t*)hw);
+        applied_cfg = *hw;
     }
+    if (!rx_running) {
+        stop_streaming = false;
+        if (hackrf_start_rx(device, rx_callback, NULL) != HACKRF_SUCCESS) return -1;
+        rx_running = true;
+    }
+
+    // tras un cambio: el transfer en vuelo (puede ser anterior) + asentamiento
+    size_t settle = flags ? last_xfer_bytes + (size_t)(RF_SETTLE_US * 1e-6 * hw->sample_rate) * 2 : 0;
+    rb_tag_t tag = rb_tag(&rb, flags, settle, 1);
 
-    fclose(fp);
-    printf("[CSV] Saved results (%d bins) -> %s\n", length, csv_path);
+    uint64_t t0 = psd_now_ns();
+    uint64_t start = 0;
+    while (rb_read_from(&rb, tag.valid_pos, dst, len, &start) == 0) {
+        if (psd_now_ns() - t0 > 5000000000ull) return -1;
+        usleep(1000);
+    }
+    last_acq_ns = psd_now_ns();
+    printf("[ACQ] tag #%u @ sample %" PRIu64 " (%s%s%s) valid from %" PRIu64 " | %.1f ms\n",
+           tag.seq, tag.pos / 2,
+           (flags & RB_TAG_FREQ) ? "F" : "", (flags & RB_TAG_GAIN) ? "G" : "", (flags & RB_TAG_RATE) ? "R" : "",
+           tag.valid_pos / 2, (double)(psd_now_ns() - t0) / 1e6);
+    if (start != tag.valid_pos) {
+        // el ring se llenó: la captura empieza después del hueco, nunca lo cruza
+        printf("[ACQ] capture starts at sample %" PRIu64 " (%" PRIu64 " bytes dropped so far)\n",
+               start / 2, rb.dropped);
+    }
     return 0;
 }
 
+// =========================================================
+// CAMPAIGN_MODE: barrido de LO sin parar el stream
+// =========================================================
+typedef struct {
+    const char *scale;
+    const char *csv_out;
+    psd_shm_t *shm;
+    double sample_rate;
+} sweep_out_t;
+
+static int sweep_tune(void *user, uint64_t lo_hz) {
+    (void)user;
+    return sdr_hal_retune(device, lo_hz);
+}
+
+static void sweep_publish(void *user, const double *freq_rel, double *psd, int nbins,
+                          uint64_t center_hz, uint64_t t_ns) {
+    sweep_out_t *o = (sweep_out_t*)user;
+    scale_psd(psd, nbins, o->scale);
+
+    if (!o->shm->hdr || o->shm->hdr->capacity < (uint32_t)nbins) {
+        psd_shm_close(o->shm);
+        psd_shm_create(o->shm, PSD_SHM_DEFAULT_NAME, (uint32_t)nbins);
+    }
+    psd_shm_publish(o->shm, psd, nbins, (double)center_hz, o->sample_rate,
+                    freq_rel[0], nbins > 1 ? freq_rel[1] - freq_rel[0] : 0.0, o->scale, t_ns);
+    if (o->csv_out) psd_save_csv(o->csv_out, freq_rel, psd, nbins, center_hz, o->scale, NULL);
+}
+
+/* Sweeps the band until the pass count is reached; -1 = device needs recovery */
+static int run_campaign(const DesiredCfg_t *des, SDR_cfg_t *hw, const PsdConfig_t *pc,
+                        psd_shm_t *shm, const char *csv_out) {
+    const SweepCfg_t *s = &des->sweep;
+    psd_sweep_cfg_t sc = {
+        .f_start_hz = s->f_start_hz,
+        .f_stop_hz = s->f_stop_hz,
+        .usable = s->usable,
+        .overlap = s->overlap,
+        .dwell_s = s->dwell_ms / 1e3,
+        .settle_s = s->settle_us / 1e6,
+        .dc_notch_hz = s->dc_notch_hz
+    };
+    if (sc.f_start_hz <= 0 && sc.f_stop_hz <= 0) {
+        sc.f_start_hz = (double)des->center_freq - des->span / 2.0;
+        sc.f_stop_hz = (double)des->center_freq + des->span / 2.0;
+    }
+
+    psd_sweep_t sweep;
+    if (psd_sweep_init(&sweep, &sc, pc) != 0) return 0;   // plan inválido: no es culpa del HW
+
+    sweep_out_t out = { .scale = des->scale, .csv_out = csv_out, .shm = shm, .sample_rate = hw->sample_rate };
+    hw->center_freq = sweep.lo[0];
+    hackrf_apply_cfg(device, hw);
+
+    g_sweep = &sweep;
+    stop_streaming = false;
+    int passes = -1;
+    if (hackrf_start_rx(device, rx_callback, NULL) == HACKRF_SUCCESS) {
+        sdr_hal_stats_reset();
+        passes = psd_sweep_run(&sweep, sweep_tune, NULL, sweep_publish, &out, s->passes, NULL);
+        stop_streaming = true;
+        hackrf_stop_rx(device);
+    }
+    g_sweep = NULL;
+    stop_streaming = true;
+
+    if (passes >= 0) {
+        printf("[SWEEP] %d passes, %" PRIu64 " steps, last pass %.1f ms\n",
+               passes, sweep.steps, sweep.last_pass_ms);
+    }
+    sdr_hal_stats_print();
+    psd_sweep_free(&sweep);
+    return passes < 0 ? -1 : 0;
+}
+
+// =========================================================
+// CAMPAIGN_MODE con lista de jobs: planificador (rate / ganancia / frecuencia)
+// =========================================================
+static int job_acquire(void *user, const SDR_cfg_t *hw, int8_t *dst, size_t bytes) {
+    (void)user;
+    if (bytes > rb.size) {
+        fprintf(stderr, "[SCHED] capture of %zu bytes exceeds the ring\n", bytes);
+        return -1;
+    }
+    return acquire_continuous(hw, dst, bytes);
+}
+
+static void job_publish(void *user, const psd_job_t *job, const double *freq_rel,
+                        const double *psd, int nbins, uint64_t t_ns) {
+    (void)t_ns;
+    const char *csv_out = (const char*)user;
+    int pk = 0;
+    for (int i = 1; i < nbins; i++) if (psd[i] > psd[pk]) pk = i;
+    printf("[JOB] %-12s %.3f MHz | %d bins | peak %.1f %s @ %.4f MHz\n", job->id,
+           job->cfg->center_hz / 1e6, nbins, psd[pk], job->des.scale ? job->des.scale : "",
+           ((double)job->hw.center_freq + freq_rel[pk]) / 1e6);
+
+    char path[512];
+    if (csv_out && out_path(path, sizeof(path), csv_out, job->id, NULL) == 0) {
+        psd_save_csv(path, freq_rel, psd, nbins, job->hw.center_freq, job->des.scale, NULL);
+    }
+}
+
+static int run_jobs(const DesiredCfg_t *des, const char *csv_out) {
+    psd_sched_t sched;
+    if (psd_sched_plan(&sched, des) != 0) return 0;   // plan inválido: no es culpa del HW
+
+    sdr_hal_stats_reset();
+    int done = psd_sched_run(&sched, job_acquire, job_publish, (void*)csv_out);
+    sdr_hal_stats_print();
+    psd_sched_free(&sched);
+    return done < 0 ? -1 : 0;
+}
+
 // =========================================================
 // MAIN (MISMA LOGICA; solo sin ZMQ)
 // =========================================================
@@ -117,14 +286,34 @@ int main() {
     // Caso B: si es char*:
     desired_config.scale = "dBm";
 
+    // CAMPAIGN_MODE: barrido 1 MHz - 6 GHz con el stream abierto (descomentar)
+    // desired_config.rf_mode = CAMPAIGN_MODE;
+    // desired_config.sweep.f_start_hz = 1e6;
+    // desired_config.sweep.f_stop_hz = 6e9;
+    //
+    // ... o una lista de jobs (mismo rate/ganancia y banda dentro de una sintonía = una captura):
+    // static JobCfg_t jobs[] = {
+    //     { .id = "fm",  .center_hz = 98e6,  .span = 4e6, .window = -1, .lna_gain = -1, .vga_gain = -1, .amp = -1 },
+    //     { .id = "air", .center_hz = 125e6, .span = 2e6, .rbw = 2000, .window = -1, .lna_gain = -1, .vga_gain = -1, .amp = -1 },
+    // };
+    // desired_config.jobs = jobs;
+    // desired_config.n_jobs = 2;
+
     desired_config.lna_gain = 0;
     desired_config.vga_gain = 0;
     desired_config.antenna_port = 1;
     desired_config.amp_enabled = 1;
 
+    // Medidas por canal (potencia / OBW / ACPR): vacías por defecto, el plan llega en el JSON, p.ej.
+    //   "measure": {"obw_pct": 99, "plan": {"start_hz": 95.9e6, "step_hz": 200e3, "count": 99, "bw_hz": 200e3}}
+    // y el resultado se escribe junto al CSV (static/last_psd_meas.json)
+
     // Reutiliza tu función existente: genera hack_cfg, psd_cfg, rb_cfg
     // EXACTAMENTE como lo hacías tras parsear JSON
-    find_params_psd(desired_config, &hack_cfg, &psd_cfg, &rb_cfg);
+    if (find_params_psd(desired_config, &hack_cfg, &psd_cfg, &rb_cfg) != 0) {
+        fprintf(stderr, "[SYSTEM] Error: invalid PSD configuration\n");
+        return 1;
+    }
     print_config_summary(&desired_config, &hack_cfg, &psd_cfg, &rb_cfg);
 
 
@@ -149,14 +338,27 @@ int main() {
     PsdConfig_t local_psd_cfg;
     DesiredCfg_t local_desired_cfg;
 
-    // Ruta CSV fija (si quieres, construye con timestamp/center_freq)
+    // Salida binaria (shm + seqlock) y CSV opcional (ruta fija; NULL para desactivar)
     const char *csv_out = "static/last_psd.csv";
+    psd_shm_t shm = { .fd = -1 };
+
+    // Tabla de calibración opcional: un vector por sintonía, cacheado entre barridos
+    const char *cal_path = "static/calibration.csv";
+    psd_cal_t cal;
+    bool has_cal = (access(cal_path, R_OK) == 0) && psd_cal_load(&cal, cal_path) == 0;
 
     // -------------------------
     // 3) LOOP PRINCIPAL (IGUAL)
     // -------------------------
     while (1) {
         if (!config_received) {
+            // sin peticiones: no dejar el HackRF volcando al ring indefinidamente
+            if (rx_running && RF_IDLE_STOP_S > 0 &&
+                psd_now_ns() - last_acq_ns > (uint64_t)(RF_IDLE_STOP_S * 1e9)) {
+                rx_stop();
+                printf("[ACQ] idle for %.1f s: RX stopped (%" PRIu64 " bytes dropped on a full ring)\n",
+                       RF_IDLE_STOP_S, rb.dropped);
+            }
             usleep(10000);
             continue;
         }
@@ -173,82 +375,125 @@ int main() {
         memcpy(&local_desired_cfg, &desired_config, sizeof(DesiredCfg_t));
         config_received = false;
 
-        if (local_rb_cfg.total_bytes > rb.size) {
-            printf("[SYSTEM] Error: Request exceeds buffer size!\n");
+        if (local_desired_cfg.rf_mode == CAMPAIGN_MODE && local_desired_cfg.n_jobs > 0) {
+            if (run_jobs(&local_desired_cfg, csv_out) != 0) {
+                needs_recovery = true;
+                goto error_handler;
+            }
             continue;
         }
 
-        // ACQUIRE (IGUAL)
-        rb_reset(&rb);
-        stop_streaming = false;
-        hackrf_apply_cfg(device, &local_hack_cfg);
-
-        if (hackrf_start_rx(device, rx_callback, NULL) != HACKRF_SUCCESS) {
-            needs_recovery = true;
-            goto error_handler;
+        if (local_desired_cfg.rf_mode == CAMPAIGN_MODE) {
+            rx_stop();
+            if (run_campaign(&local_desired_cfg, &local_hack_cfg, &local_psd_cfg, &shm, csv_out) != 0) {
+                needs_recovery = true;
+                goto error_handler;
+            }
+            continue;
         }
 
-        int safety_timeout = 500;
-        while (safety_timeout > 0) {
-            if (rb_available(&rb) >= local_rb_cfg.total_bytes) break;
-            usleep(10000);
-            safety_timeout--;
+        if (local_rb_cfg.total_bytes > rb.size) {
+            printf("[SYSTEM] Error: Request exceeds buffer size!\n");
+            continue;
         }
 
-        stop_streaming = true;
-        hackrf_stop_rx(device);
-        usleep(50000);
+        // ACQUIRE
+        int8_t* linear_buffer = malloc(local_rb_cfg.total_bytes);
+        if (!linear_buffer) continue;
 
-        if (safety_timeout <= 0) {
+        if (acquire_continuous(&local_hack_cfg, linear_buffer, local_rb_cfg.total_bytes) != 0) {
+            free(linear_buffer);
             needs_recovery = true;
             goto error_handler;
         }
 
         // PROCESS (IGUAL)
-        int8_t* linear_buffer = malloc(local_rb_cfg.total_bytes);
-        if (linear_buffer) {
-            rb_read(&rb, linear_buffer, local_rb_cfg.total_bytes);
+        {
 
-            signal_iq_t* sig = load_iq_from_buffer(linear_buffer, local_rb_cfg.total_bytes);
+            // int8 directo al motor Welch (sin copia compleja de 16 B/muestra)
+            psd_welch_t welch;
+            bool welch_ok = (psd_welch_init(&welch, &local_psd_cfg) == 0);
 
             double* freq = malloc(local_psd_cfg.nperseg * sizeof(double));
             double* psd  = malloc(local_psd_cfg.nperseg * sizeof(double));
 
-            if (freq && psd && sig) {
-                // 1) PSD full-band (IGUAL)
-                execute_welch_psd(sig, &local_psd_cfg, freq, psd);
-                scale_psd(psd, local_psd_cfg.nperseg, local_desired_cfg.scale);
-
-                // 2) SPAN logic (IGUAL)
-                double half_span = local_desired_cfg.span / 2.0;
-                int start_idx = 0;
-                int end_idx = local_psd_cfg.nperseg - 1;
-
-                for (int i = 0; i < local_psd_cfg.nperseg; i++) {
-                    if (freq[i] >= -half_span) {
-                        start_idx = i;
-                        break;
+            if (freq && psd && welch_ok) {
+                // 0) Calibración como ganancia por bin del motor: la ven la PSD y las medidas
+                if (has_cal) {
+                    psd_cal_tuning_t tun = {
+                        .center_freq_hz = local_hack_cfg.center_freq,
+                        .sample_rate_hz = local_hack_cfg.sample_rate,
+                        .lna_gain = local_hack_cfg.lna_gain,
+                        .vga_gain = local_hack_cfg.vga_gain,
+                        .amp_enabled = local_hack_cfg.amp_enabled
+                    };
+                    psd_welch_freq_axis(&welch, freq);
+                    const double *corr = psd_cal_vector(&cal, &tun, freq, local_psd_cfg.nperseg);
+                    if (!corr || psd_welch_set_gain_db(&welch, corr) != 0) {
+                        fprintf(stderr, "[CAL] correction failed: levels are uncalibrated\n");
                     }
                 }
-                for (int i = start_idx; i < local_psd_cfg.nperseg; i++) {
-                    if (freq[i] > half_span) {
-                        end_idx = i - 1;
-                        break;
+
+                // 1) PSD (full-band, o zoom si "zoom": true)
+                psd_welch_run_iq8(&welch, linear_buffer, local_rb_cfg.total_bytes / 2, psd_now_ns());
+                if (psd_welch_result(&welch, freq, psd) < 0) {
+                    psd_welch_freq_axis(&welch, freq);
+                    memset(psd, 0, local_psd_cfg.nperseg * sizeof(double));
+                }
+
+                // 1b) Potencia de canal / OBW / ACPR sobre la PSD lineal (antes de escalar)
+                psd_meas_t meas;
+                if (local_desired_cfg.measure.n_channels > 0 &&
+                    psd_meas_init(&meas, &local_desired_cfg.measure, local_psd_cfg.nperseg) == 0) {
+                    size_t cap = psd_meas_json_cap(&meas);
+                    char *json = malloc(cap);
+                    if (json &&
+                        psd_meas_load(&meas, freq, psd, local_psd_cfg.nperseg,
+                                      (double)local_hack_cfg.center_freq) == 0) {
+                        psd_meas_run(&meas);
+                        char meas_out[512];
+                        FILE *fp = csv_out && out_path(meas_out, sizeof(meas_out), csv_out, "meas", ".json") == 0
+                                 ? fopen(meas_out, "w") : NULL;
+                        if (fp && psd_meas_json(&meas, psd_now_ns(), json, cap) > 0) {
+                            fputs(json, fp);
+                            printf("[MEAS] %d channels -> %s\n", meas.nch, meas_out);
+                        }
+                        if (fp) fclose(fp);
                     }
-                    end_idx = i;
+                    free(json);
+                    psd_meas_free(&meas);
                 }
 
-                int valid_len = end_idx - start_idx + 1;
+                scale_psd(psd, local_psd_cfg.nperseg, local_desired_cfg.scale);
+
+                // 2) SPAN logic (IGUAL)
+                int start_idx = 0;
+                int valid_len = psd_span_bins(freq, local_psd_cfg.nperseg,
+                                              local_desired_cfg.lo_offset,
+                                              local_desired_cfg.span, &start_idx);
 
                 // 3) ANTES: publish_results(...)
                 //    AHORA: guardar CSV con los bins “cropeados”
                 if (valid_len > 0) {
-                    save_results_csv(csv_out,
+                    if (!shm.hdr || shm.hdr->capacity < (uint32_t)local_psd_cfg.nperseg) {
+                        psd_shm_close(&shm);
+                        psd_shm_create(&shm, PSD_SHM_DEFAULT_NAME, (uint32_t)local_psd_cfg.nperseg);
+                    }
+                    psd_shm_publish(&shm, &psd[start_idx], valid_len,
+                                    (double)local_hack_cfg.center_freq, local_psd_cfg.sample_rate,
+                                    freq[start_idx], freq[1] - freq[0],
+                                    local_desired_cfg.scale, psd_now_ns());
+
+                    if (csv_out &&
+                        psd_save_csv(csv_out,
                                      &freq[start_idx],
                                      &psd[start_idx],
                                      valid_len,
-                                     &local_hack_cfg,
-                                     local_desired_cfg.scale);
+                                     local_hack_cfg.center_freq,
+                                     local_desired_cfg.scale,
+                                     NULL) == 0) {
+                        printf("[CSV] Saved results (%d bins) -> %s\n", valid_len, csv_out);
+                    }
                 } else {
                     printf("[DSP] Warning: Span resulted in 0 bins.\n");
                 }
@@ -257,7 +502,7 @@ int main() {
             free(linear_buffer);
             if (freq) free(freq);
             if (psd) free(psd);
-            free_signal_iq(sig);
+            if (welch_ok) psd_welch_free(&welch);
         }
 
         // Si quieres “una sola adquisición y salir”, descomenta:
@@ -267,6 +512,7 @@ int main() {
 
 error_handler:
         stop_streaming = true;
+        rx_running = false;
         if (needs_recovery) {
             recover_hackrf();
             needs_recovery = false;
@@ -275,6 +521,8 @@ error_handler:
         }
     }
 
+    psd_shm_close(&shm);
+    if (has_cal) psd_cal_free(&cal);
     rb_free(&rb);
     return 0;
 }
@@ -0,0 +1,627 @@
+//tests/check_psd.c
+/*
+  Comprobaciones numéricas de los motores PSD, sin hardware: cada check
+  genera IQ sintético conocido, lo compara con una referencia directa y
+  cuenta los fallos. Sale con 0 si todo cuadra.
+
+    ./build_check.sh      (compila build/check_psd y lo ejecuta)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "psd.h"
+#include "psd_archive.h"
+#include "psd_sweep.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do {                               \
+    if (!(cond)) {                                          \
+        fprintf(stderr, "[CHECK] FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__);                       \
+        fprintf(stderr, "\n");                              \
+        g_failures++;                                       \
+    }                                                       \
+} while (0)
+
+/* Tono complejo en un bin exacto + ruido uniforme determinista, cuantizado a int8 */
+static void make_tone_iq8(int8_t *iq, size_t n, double f_rel, double fs, double amp, double noise) {
+    uint32_t seed = 12345u;
+    for (size_t i = 0; i < n; i++) {
+        double complex z = amp * cexp(I * 2.0 * M_PI * f_rel * (double)i / fs);
+        seed = seed * 1103515245u + 12345u;
+        double nr = ((seed >> 16) & 0x7fff) / 32767.0 - 0.5;
+        seed = seed * 1103515245u + 12345u;
+        double ni = ((seed >> 16) & 0x7fff) / 32767.0 - 0.5;
+        iq[2 * i]     = (int8_t)lrint(creal(z) + 2.0 * noise * nr);
+        iq[2 * i + 1] = (int8_t)lrint(cimag(z) + 2.0 * noise * ni);
+    }
+}
+
+static double max_rel_diff(const double *a, const double *b, int n) {
+    double d = 0.0;
+    for (int i = 0; i < n; i++) {
+        double den = fmax(fabs(a[i]), 1e-300);
+        d = fmax(d, fabs(a[i] - b[i]) / den);
+    }
+    return d;
+}
+
+// =========================================================
+// Welch (user-026): motor streaming vs. el execute_welch_psd original
+// =========================================================
+
+/*
+  Referencia: el Welch de antes del motor streaming, con DFT directa en vez
+  de FFTW. Hann simétrica, U = mean(w^2), escala 1 / (fs * U * K * N),
+  salida en orden fftshift con f = -fs/2 + i * df.
+*/
+static void welch_reference(const int8_t *iq, size_t n_samples, int nperseg, int noverlap,
+                            double fs, double *f_out, double *p_out) {
+    int step = nperseg - noverlap;
+    int k_segments = (int)((n_samples - (size_t)noverlap) / (size_t)step);
+
+    double *w = malloc((size_t)nperseg * sizeof(double));
+    double complex *x = malloc((size_t)nperseg * sizeof(double complex));
+    double complex *tw = malloc((size_t)nperseg * sizeof(double complex));
+    double u = 0.0;
+    for (int i = 0; i < nperseg; i++) {
+        w[i] = 0.5 * (1 - cos((2.0 * M_PI * i) / (nperseg - 1)));
+        u += w[i] * w[i];
+        tw[i] = cexp(-I * 2.0 * M_PI * i / nperseg);
+    }
+    u /= nperseg;
+
+    memset(p_out, 0, (size_t)nperseg * sizeof(double));
+    for (int k = 0; k < k_segments; k++) {
+        size_t s0 = (size_t)k * (size_t)step;
+        for (int i = 0; i < nperseg; i++) {
+            x[i] = ((double)iq[2 * (s0 + i)] + (double)iq[2 * (s0 + i) + 1] * I) * w[i];
+        }
+        for (int b = 0; b < nperseg; b++) {
+            double complex acc = 0.0;
+            for (int i = 0; i < nperseg; i++) acc += x[i] * tw[((long)b * i) % nperseg];
+            int o = (b + nperseg / 2) % nperseg;   // fftshift
+            p_out[o] += creal(acc) * creal(acc) + cimag(acc) * cimag(acc);
+        }
+    }
+
+    double scale = 1.0 / (fs * u * k_segments * nperseg);
+    double df = fs / nperseg;
+    for (int i = 0; i < nperseg; i++) {
+        p_out[i] *= scale;
+        f_out[i] = -fs / 2.0 + i * df;
+    }
+
+    free(w);
+    free(x);
+    free(tw);
+}
+
+static void check_welch(void) {
+    const int nperseg = 256, noverlap = 128, tone_bin = 37;
+    const double fs = 1e6;
+    const size_t n = (size_t)nperseg * 20 + 77;   // segmentos enteros + cola sin usar
+
+    int8_t *iq = malloc(2 * n);
+    double *f_ref = malloc(nperseg * sizeof(double)), *p_ref = malloc(nperseg * sizeof(double));
+    double *f = malloc(nperseg * sizeof(double)), *p = malloc(nperseg * sizeof(double));
+    make_tone_iq8(iq, n, tone_bin * fs / nperseg, fs, 60.0, 8.0);
+    welch_reference(iq, n, nperseg, noverlap, fs, f_ref, p_ref);
+
+    PsdConfig_t cfg = { .window_type = HANN_TYPE, .sample_rate = fs, .nperseg = nperseg, .noverlap = noverlap };
+
+    // 1) execute_welch_psd (API de antes, ahora sobre el motor)
+    signal_iq_t *sig = load_iq_from_buffer(iq, 2 * n);
+    execute_welch_psd(sig, &cfg, f, p);
+    free_signal_iq(sig);
+    double d = max_rel_diff(p_ref, p, nperseg);
+    CHECK(d < 1e-9, "execute_welch_psd vs reference: max rel diff %g", d);
+    for (int i = 0; i < nperseg; i++) {
+        if (fabs(f[i] - f_ref[i]) > 1e-6) { CHECK(0, "frequency axis differs at bin %d", i); break; }
+    }
+
+    // 2) una captura int8 de una vez
+    psd_welch_t w;
+    CHECK(psd_welch_init(&w, &cfg) == 0, "psd_welch_init");
+    psd_welch_run_iq8(&w, iq, n, 0);
+    CHECK(psd_welch_result(&w, f, p) > 0, "psd_welch_result (run_iq8)");
+    d = max_rel_diff(p_ref, p, nperseg);
+    CHECK(d < 1e-9, "psd_welch_run_iq8 vs reference: max rel diff %g", d);
+
+    // 3) streaming: trozos que no caen en fronteras de segmento
+    psd_welch_reset(&w);
+    psd_welch_flush_history(&w);
+    static const size_t chunks[] = { 1, 7, 300, 129, 1000, 4096 };
+    size_t off = 0;
+    for (int c = 0; off < n; c = (c + 1) % 6) {
+        size_t len = chunks[c] < n - off ? chunks[c] : n - off;
+        psd_welch_feed_iq8(&w, iq + 2 * off, len);
+        off += len;
+    }
+    CHECK(psd_welch_result(&w, f, p) > 0, "psd_welch_result (feed_iq8)");
+    d = max_rel_diff(p_ref, p, nperseg);
+    CHECK(d < 1e-9, "psd_welch_feed_iq8 vs reference: max rel diff %g", d);
+
+    // 4) ganancia por bin (calibración): resultado = referencia * 10^(dB/10)
+    double *g_db = malloc(nperseg * sizeof(double)), *p_cal = malloc(nperseg * sizeof(double));
+    for (int i = 0; i < nperseg; i++) {
+        g_db[i] = -3.0 + 6.0 * i / nperseg;
+        p_cal[i] = p_ref[i] * pow(10.0, g_db[i] / 10.0);
+    }
+    CHECK(psd_welch_set_gain_db(&w, g_db) == 0, "psd_welch_set_gain_db");
+    psd_welch_reset(&w);
+    psd_welch_run_iq8(&w, iq, n, 0);
+    psd_welch_result(&w, f, p);
+    double dg = max_rel_diff(p_cal, p, nperseg);
+    CHECK(dg < 1e-9, "per-bin gain: max rel diff %g", dg);
+    psd_welch_set_gain_db(&w, NULL);
+    psd_welch_reset(&w);
+    psd_welch_run_iq8(&w, iq, n, 0);
+    psd_welch_result(&w, f, p);
+    CHECK(max_rel_diff(p_ref, p, nperseg) < 1e-9, "per-bin gain not cleared");
+    free(g_db);
+    free(p_cal);
+    psd_welch_free(&w);
+
+    int pk = 0;
+    for (int i = 1; i < nperseg; i++) if (p_ref[i] > p_ref[pk]) pk = i;
+    CHECK(pk == nperseg / 2 + tone_bin, "tone at bin %d, expected %d", pk, nperseg / 2 + tone_bin);
+
+    printf("[CHECK] welch: %d bins, tone at %+.0f Hz, max rel diff %.2g\n", nperseg, f_ref[pk], d);
+    free(iq);
+    free(f_ref); free(p_ref); free(f); free(p);
+}
+
+// =========================================================
+// Multitaper (user-033): tapers DPSS y calibración del estimador
+// =========================================================
+
+/*
+  Cada taper debe ser vector propio de la matriz tridiagonal de Slepian
+  (diag ((N-1-2i)/2)^2 cos(2 pi W), off-diag i(N-i)/2), los K ortonormales,
+  y lambda[k] la concentración en banda calculada directamente con el
+  núcleo sinc: lambda = v' A v, A[m][n] = sin(2 pi W (m-n)) / (pi (m-n)).
+*/
+static void check_dpss(int n, double nw, int k_req) {
+    const psd_dpss_t *dp = psd_dpss_get(n, nw, k_req);
+    CHECK(dp != NULL, "psd_dpss_get(%d, %g, %d)", n, nw, k_req);
+    if (!dp) return;
+
+    int K = dp->k;
+    double W = nw / n;
+    double c = cos(2.0 * M_PI * W);
+    double worst_orth = 0.0, worst_res = 0.0, worst_lam = 0.0;
+
+    for (int a = 0; a < K; a++) {
+        const double *va = &dp->w[(size_t)a * n];
+        for (int b = a; b < K; b++) {
+            const double *vb = &dp->w[(size_t)b * n];
+            double dot = 0.0;
+            for (int i = 0; i < n; i++) dot += va[i] * vb[i];
+            worst_orth = fmax(worst_orth, fabs(dot - (a == b ? 1.0 : 0.0)));
+        }
+
+        // T v y su cociente de Rayleigh
+        double mu = 0.0, res = 0.0;
+        double *tv = malloc((size_t)n * sizeof(double));
+        for (int i = 0; i < n; i++) {
+            double d = (n - 1 - 2.0 * i) / 2.0;
+            tv[i] = d * d * c * va[i];
+            if (i > 0)     tv[i] += 0.5 * i * (n - i) * va[i - 1];
+            if (i < n - 1) tv[i] += 0.5 * (i + 1) * (n - i - 1) * va[i + 1];
+            mu += va[i] * tv[i];
+        }
+        for (int i = 0; i < n; i++) res += (tv[i] - mu * va[i]) * (tv[i] - mu * va[i]);
+        worst_res = fmax(worst_res, sqrt(res) / fmax(fabs(mu), 1.0));
+        free(tv);
+
+        double lam = 0.0;
+        for (int i = 0; i < n; i++) {
+            double row = 2.0 * W * va[i];
+            for (int j = 0; j < n; j++) {
+                if (j != i) row += sin(2.0 * M_PI * W * (i - j)) / (M_PI * (i - j)) * va[j];
+            }
+            lam += va[i] * row;
+        }
+        worst_lam = fmax(worst_lam, fabs(lam - dp->lambda[a]));
+        if (a > 0) CHECK(dp->lambda[a] <= dp->lambda[a - 1] + 1e-12, "lambda not descending at k=%d", a);
+    }
+
+    CHECK(worst_orth < 1e-9, "dpss n=%d nw=%g: orthonormality error %g", n, nw, worst_orth);
+    CHECK(worst_res < 1e-7, "dpss n=%d nw=%g: eigen residual %g", n, nw, worst_res);
+    CHECK(worst_lam < 1e-8, "dpss n=%d nw=%g: lambda error %g", n, nw, worst_lam);
+    CHECK(dp->lambda[0] > 0.999, "dpss n=%d nw=%g: lambda[0] = %g", n, nw, dp->lambda[0]);
+
+    printf("[CHECK] dpss n=%d nw=%g K=%d: orth %.1e, residual %.1e, lambda %.1e (l0=%.12f l%d=%.6f)\n",
+           n, nw, K, worst_orth, worst_res, worst_lam, dp->lambda[0], K - 1, dp->lambda[K - 1]);
+    psd_dpss_release(dp);
+}
+
+/* Ruido blanco: la media de la PSD por fs tiene que dar la potencia media de las muestras */
+static void check_multitaper(void) {
+    const int nperseg = 256, tone_bin = -50;
+    const double fs = 2e6;
+    const size_t n = (size_t)nperseg * 64;
+
+    int8_t *iq = malloc(2 * n);
+    double *f = malloc(nperseg * sizeof(double)), *p = malloc(nperseg * sizeof(double));
+
+    PsdConfig_t cfg = { .window_type = HANN_TYPE, .sample_rate = fs, .nperseg = nperseg,
+                        .noverlap = 0, .estimator = PSD_ESTIMATOR_MULTITAPER, .mt_nw = 4.0 };
+    psd_welch_t w;
+    CHECK(psd_welch_init(&w, &cfg) == 0, "psd_welch_init (multitaper)");
+
+    make_tone_iq8(iq, n, 0.0, fs, 0.0, 20.0);
+    double pwr = 0.0;
+    for (size_t i = 0; i < 2 * n; i++) pwr += (double)iq[i] * iq[i];
+    pwr /= n;
+
+    psd_welch_run_iq8(&w, iq, n, 0);
+    CHECK(psd_welch_result(&w, f, p) == 64, "multitaper segments");
+    double mean = 0.0;
+    for (int i = 0; i < nperseg; i++) mean += p[i];
+    mean = mean / nperseg * fs;
+    double err = fabs(mean - pwr) / pwr;
+    CHECK(err < 0.03, "multitaper noise level %g vs sample power %g (%.1f%%)", mean, pwr, 100 * err);
+
+    // tono: pico en su bin y fuera de la banda +-NW bins vuelve al suelo
+    make_tone_iq8(iq, n, tone_bin * fs / nperseg, fs, 60.0, 8.0);
+    psd_welch_reset(&w);
+    psd_welch_run_iq8(&w, iq, n, 0);
+    psd_welch_result(&w, f, p);
+    int pk = 0;
+    for (int i = 1; i < nperseg; i++) if (p[i] > p[pk]) pk = i;
+    CHECK(pk == nperseg / 2 + tone_bin, "multitaper tone at bin %d, expected %d", pk, nperseg / 2 + tone_bin);
+    double floor_db = 10 * log10(p[(pk + nperseg / 2) % nperseg]);
+    double edge_db = 10 * log10(p[pk + 8]);
+    CHECK(edge_db - floor_db < 6.0, "multitaper leakage 8 bins off the tone: %.1f dB over floor", edge_db - floor_db);
+
+    printf("[CHECK] multitaper: noise %.1f vs %.1f (%.2f%%), tone at %+.0f Hz, %.1f dB over floor\n",
+           mean, pwr, 100 * err, f[pk], 10 * log10(p[pk]) - floor_db);
+    psd_welch_free(&w);
+    free(iq);
+    free(f); free(p);
+}
+
+// =========================================================
+// Archivo (user-042): append -> segmentos -> query
+// =========================================================
+
+#define AR_BINS 64
+#define AR_RECS 600
+#define AR_T0   1000000000ull
+#define AR_DT   1000000ull
+
+static double ar_value(int k, int i) { return -120.0 + (double)((k * 7) % 50) + 0.25 * i; }
+
+/* Fila esperada: registros [k0 + r*total/rows, k0 + (r+1)*total/rows), como documenta psd_ar_query */
+static void ar_expected(int k0, int total, int rows, int r, psd_ar_mode_t mode, double *out) {
+    int a = k0 + (int)((uint64_t)r * total / rows);
+    int b = k0 + (int)((uint64_t)(r + 1) * total / rows);
+    for (int i = 0; i < AR_BINS; i++) {
+        double acc = ar_value(a, i);
+        for (int k = a + 1; k < b && mode != PSD_AR_PICK; k++) {
+            acc = (mode == PSD_AR_MAX) ? fmax(acc, ar_value(k, i)) : acc + ar_value(k, i);
+        }
+        out[i] = (mode == PSD_AR_MEAN) ? acc / (b - a) : acc;
+    }
+}
+
+static void ar_rmdir(const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *e;
+    char path[512];
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        unlink(path);
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+static void check_archive_format(psd_ar_format_t format) {
+    char dir[] = "/tmp/check_psd_arXXXXXX";
+    CHECK(mkdtemp(dir) != NULL, "mkdtemp");
+
+    psd_ar_cfg_t cfg = {
+        .dir = dir, .format = format, .db_min = -130.0, .db_max = -40.0,
+        .segment_mb = 0.01,           // ~36 registros por segmento: la query cruza muchos
+        .queue_rows = 1024,           // > AR_RECS, el writer no puede perder nada
+        .nbins = AR_BINS, .center_freq_hz = 100e6, .sample_rate_hz = 2e6,
+        .f_start_hz = 99e6, .df_hz = 2e6 / AR_BINS, .scale = "dBm",
+    };
+    psd_archive_t ar;
+    CHECK(psd_ar_open(&ar, &cfg) == 0, "psd_ar_open");
+
+    double db[AR_BINS];
+    for (int k = 0; k < AR_RECS; k++) {
+        for (int i = 0; i < AR_BINS; i++) db[i] = ar_value(k, i);
+        CHECK(psd_ar_append(&ar, db, AR_BINS, AR_T0 + (uint64_t)k * AR_DT) == 0, "append %d", k);
+    }
+    CHECK(ar.dropped == 0, "archive dropped %llu", (unsigned long long)ar.dropped);
+    psd_ar_close(&ar);
+
+    // uint8: medio escalón de cuantización
+    double tol = (format == PSD_AR_U8) ? 0.5 * (cfg.db_max - cfg.db_min) / 255.0 + 1e-3 : 1e-3;
+    double worst = 0.0;
+    double expect[AR_BINS];
+    psd_ar_result_t res;
+
+    // límites entre registros: [k0 - 1/2, k1 + 1/2] selecciona exactamente k0..k1
+    const int k0 = 123, k1 = 456, total = k1 - k0 + 1;
+    static const psd_ar_mode_t modes[] = { PSD_AR_PICK, PSD_AR_MAX, PSD_AR_MEAN };
+    for (int m = 0; m < 3; m++) {
+        memset(&res, 0, sizeof(res));
+        int rc = psd_ar_query(dir, AR_T0 + k0 * AR_DT - AR_DT / 2, AR_T0 + k1 * AR_DT + AR_DT / 2,
+                              25, modes[m], &res);
+        CHECK(rc == 0 && res.matched == (uint64_t)total && res.rows == 25 && res.nbins == AR_BINS,
+              "query mode %d: rc %d matched %llu rows %d nbins %d", m, rc,
+              (unsigned long long)res.matched, res.rows, res.nbins);
+        for (int r = 0; r < res.rows && res.nbins == AR_BINS; r++) {
+            uint64_t t_exp = AR_T0 + (uint64_t)(k0 + (int)((uint64_t)r * total / 25)) * AR_DT;
+            CHECK(res.t_ns[r] == t_exp, "mode %d row %d: t %llu, expected %llu", m, r,
+                  (unsigned long long)res.t_ns[r], (unsigned long long)t_exp);
+            ar_expected(k0, total, 25, r, modes[m], expect);
+            for (int i = 0; i < AR_BINS; i++) worst = fmax(worst, fabs(res.db[(size_t)r * AR_BINS + i] - expect[i]));
+        }
+        psd_ar_result_free(&res);
+    }
+
+    // más filas que registros: cada registro una vez, sin huecos entre segmentos
+    memset(&res, 0, sizeof(res));
+    psd_ar_query(dir, 0, UINT64_MAX, 10 * AR_RECS, PSD_AR_PICK, &res);
+    CHECK(res.matched == AR_RECS && res.rows == AR_RECS, "full query: matched %llu rows %d",
+          (unsigned long long)res.matched, res.rows);
+    for (int r = 0; r < res.rows; r++) {
+        if (res.t_ns[r] != AR_T0 + (uint64_t)r * AR_DT) { CHECK(0, "full query: row %d out of order", r); break; }
+        ar_expected(r, 1, 1, 0, PSD_AR_PICK, expect);
+        for (int i = 0; i < AR_BINS; i++) worst = fmax(worst, fabs(res.db[(size_t)r * AR_BINS + i] - expect[i]));
+    }
+    CHECK(fabs(res.f_start_hz - cfg.f_start_hz) < 1e-6 && fabs(res.df_hz - cfg.df_hz) < 1e-9, "frequency axis");
+    psd_ar_result_free(&res);
+
+    // fuera de rango: ok, sin filas
+    memset(&res, 0, sizeof(res));
+    CHECK(psd_ar_query(dir, 0, AR_T0 - 1, 10, PSD_AR_MAX, &res) == 0 && res.matched == 0 && res.rows == 0,
+          "empty query: matched %llu rows %d", (unsigned long long)res.matched, res.rows);
+    psd_ar_result_free(&res);
+
+    /*
+      Mismo directorio, mismo número de bins, otro formato (cambió la config
+      entre ejecuciones), y detrás un segmento con rec_bytes corrupto: la
+      query que empieza en este formato los salta; la que empieza en el otro
+      formato solo ve ese segmento.
+    */
+    psd_ar_cfg_t other = cfg;
+    other.format = (format == PSD_AR_U8) ? PSD_AR_F32 : PSD_AR_U8;
+    other.segment_mb = 0.0;
+    CHECK(psd_ar_open(&ar, &other) == 0, "psd_ar_open (other format)");
+    for (int k = AR_RECS; k < AR_RECS + 100; k++) {
+        for (int i = 0; i < AR_BINS; i++) db[i] = ar_value(k, i);
+        psd_ar_append(&ar, db, AR_BINS, AR_T0 + (uint64_t)k * AR_DT);
+    }
+    psd_ar_close(&ar);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/psd_%020llu.pda", dir, (unsigned long long)(AR_T0 + (AR_RECS + 200) * AR_DT));
+    FILE *fp = fopen(path, "wb");
+    if (fp) {
+        psd_ar_header_t h = { .magic = PSD_AR_MAGIC, .version = PSD_AR_VERSION, .nbins = AR_BINS,
+                              .format = (uint32_t)format, .rec_bytes = 24 };
+        uint8_t junk[24 * 8];
+        memset(junk, 0x7f, sizeof(junk));
+        for (int k = 0; k < 8; k++) ((psd_ar_rec_t*)&junk[24 * k])->t_ns = AR_T0 + (AR_RECS + 200 + k) * AR_DT;
+        fwrite(&h, sizeof(h), 1, fp);
+        fwrite(junk, sizeof(junk), 1, fp);
+        fclose(fp);
+    }
+
+    memset(&res, 0, sizeof(res));
+    CHECK(psd_ar_query(dir, 0, UINT64_MAX, 10 * AR_RECS, PSD_AR_MAX, &res) == 0 && res.matched == AR_RECS,
+          "mixed formats: matched %llu, expected %d", (unsigned long long)res.matched, AR_RECS);
+    psd_ar_result_free(&res);
+
+    double tol_other = (other.format == PSD_AR_U8) ? 0.5 * (cfg.db_max - cfg.db_min) / 255.0 + 1e-3 : 1e-3;
+    double worst_other = 0.0;
+    memset(&res, 0, sizeof(res));
+    psd_ar_query(dir, AR_T0 + AR_RECS * AR_DT, UINT64_MAX, 1000, PSD_AR_PICK, &res);
+    CHECK(res.matched == 100 && res.rows == 100, "other format: matched %llu rows %d",
+          (unsigned long long)res.matched, res.rows);
+    for (int r = 0; r < res.rows; r++) {
+        ar_expected(AR_RECS + r, 1, 1, 0, PSD_AR_PICK, expect);
+        for (int i = 0; i < AR_BINS; i++) worst_other = fmax(worst_other, fabs(res.db[(size_t)r * AR_BINS + i] - expect[i]));
+    }
+    CHECK(worst_other <= tol_other, "other format: max dB error %g (tol %g)", worst_other, tol_other);
+    psd_ar_result_free(&res);
+
+    CHECK(worst <= tol, "archive %s: max dB error %g (tol %g)", format == PSD_AR_U8 ? "u8" : "f32", worst, tol);
+    printf("[CHECK] archive %s: %d records, max dB error %.3g, other-format segment skipped\n",
+           format == PSD_AR_U8 ? "u8" : "f32", AR_RECS, worst);
+    ar_rmdir(dir);
+}
+
+// =========================================================
+// Barrido (user-047): pasos cosidos sobre un RX simulado
+// =========================================================
+
+/*
+  Un hilo hace de HackRF: genera transfers de 8192 muestras con tres tonos
+  fijos en frecuencia absoluta + ruido uniforme, vistos desde el LO que haya
+  sintonizado el barrido en ese momento (como el hardware, un transfer en
+  vuelo durante el retune trae muestras del LO anterior).
+*/
+#define SW_TONES 3
+#define SW_AMP   40.0
+#define SW_NOISE 6.0
+
+typedef struct {
+    psd_sweep_t *sw;
+    double fs;
+    double tones[SW_TONES];
+    volatile uint64_t lo;
+    volatile bool quit;
+
+    int passes;
+    int nbins;
+    double f_first, f_last;
+    double peak_err_hz[SW_TONES];
+    double tone_pwr[SW_TONES];
+    double floor_db, floor_spread_db;
+} sw_sim_t;
+
+static void *sw_rx_thread(void *arg) {
+    sw_sim_t *sim = (sw_sim_t*)arg;
+    static uint8_t buf[2 * 8192];
+    double t = 0.0;
+    uint32_t seed = 1u;
+    while (!sim->quit) {
+        double lo = (double)sim->lo;
+        for (int i = 0; i < 8192; i++) {
+            double complex z = 0.0;
+            for (int k = 0; k < SW_TONES; k++) {
+                double f = sim->tones[k] - lo;
+                if (fabs(f) < sim->fs / 2) z += SW_AMP * cexp(I * 2.0 * M_PI * f * t);
+            }
+            seed = seed * 1103515245u + 12345u;
+            double nr = ((seed >> 16) & 0x7fff) / 32767.0 - 0.5;
+            seed = seed * 1103515245u + 12345u;
+            double ni = ((seed >> 16) & 0x7fff) / 32767.0 - 0.5;
+            z += SW_NOISE * (nr + I * ni);
+            buf[2 * i]     = (uint8_t)(int8_t)lrint(creal(z));
+            buf[2 * i + 1] = (uint8_t)(int8_t)lrint(cimag(z));
+            t += 1.0 / sim->fs;
+        }
+        psd_sweep_rx(sim->sw, buf, sizeof(buf));
+        usleep(1000);
+    }
+    return NULL;
+}
+
+static int sw_tune(void *user, uint64_t lo_hz) {
+    ((sw_sim_t*)user)->lo = lo_hz;
+    return 0;
+}
+
+static void sw_out(void *user, const double *freq_rel, double *psd, int nbins, uint64_t center_hz, uint64_t t_ns) {
+    (void)t_ns;
+    sw_sim_t *sim = (sw_sim_t*)user;
+    double df = freq_rel[1] - freq_rel[0];
+    sim->passes++;
+    sim->nbins = nbins;
+    sim->f_first = center_hz + freq_rel[0];
+    sim->f_last = center_hz + freq_rel[nbins - 1];
+
+    // tono: bin más alto a +-50 kHz y potencia integrada en +-4 bins
+    for (int k = 0; k < SW_TONES; k++) {
+        int best = -1;
+        for (int j = 0; j < nbins; j++) {
+            if (fabs(center_hz + freq_rel[j] - sim->tones[k]) < 50e3 && (best < 0 || psd[j] > psd[best])) best = j;
+        }
+        if (best < 0) { sim->peak_err_hz[k] = INFINITY; continue; }
+        sim->peak_err_hz[k] = fabs(center_hz + freq_rel[best] - sim->tones[k]);
+        double pw = 0.0;
+        for (int j = best - 4; j <= best + 4; j++) if (j >= 0 && j < nbins) pw += psd[j] * df;
+        sim->tone_pwr[k] = pw;
+    }
+
+    /*
+      Suelo lejos de los tonos, plegado por posición dentro del paso (bin de
+      salida j cae en (j + i0) % step_bins): una costura o un peso mal
+      normalizado se repite en cada paso y sale en el spread del perfil.
+    */
+    int period = sim->sw->step_bins;
+    int groups = period / 8 > 0 ? period / 8 : 1;
+    double prof[64] = { 0 };
+    int prof_n[64] = { 0 };
+    if (groups > 64) groups = 64;
+    double sum = 0.0;
+    int n_floor = 0;
+    for (int j = 0; j < nbins; j++) {
+        bool near = false;
+        for (int k = 0; k < SW_TONES; k++) if (fabs(center_hz + freq_rel[j] - sim->tones[k]) < 100e3) near = true;
+        if (near) continue;
+        sum += psd[j];
+        n_floor++;
+        int g = ((j + sim->sw->i0) % period) * groups / period;
+        prof[g] += psd[j];
+        prof_n[g]++;
+    }
+    double lo = INFINITY, hi = -INFINITY;
+    for (int g = 0; g < groups; g++) {
+        if (!prof_n[g]) continue;
+        double d = 10 * log10(prof[g] / prof_n[g]);
+        lo = fmin(lo, d);
+        hi = fmax(hi, d);
+    }
+    sim->floor_db = 10 * log10(sum / n_floor);
+    sim->floor_spread_db = hi - lo;
+}
+
+static void check_sweep(void) {
+    static psd_sweep_t sw;
+    sw_sim_t sim = { .sw = &sw, .fs = 2e6, .tones = { 101.3e6, 107.77e6, 118.2e6 } };
+
+    PsdConfig_t pc = { .window_type = HANN_TYPE, .sample_rate = sim.fs, .nperseg = 256, .noverlap = 128 };
+    psd_sweep_cfg_t cfg = { .f_start_hz = 100e6, .f_stop_hz = 120e6, .overlap = 0.5, .dc_notch_hz = 20e3 };
+    if (psd_sweep_init(&sw, &cfg, &pc) != 0) {
+        CHECK(0, "psd_sweep_init");
+        return;
+    }
+    sim.lo = sw.lo[0];
+
+    pthread_t th;
+    pthread_create(&th, NULL, sw_rx_thread, &sim);
+    int passes = psd_sweep_run(&sw, sw_tune, &sim, sw_out, &sim, 2, NULL);
+    sim.quit = true;
+    pthread_join(th, NULL);
+
+    double df = sim.fs / pc.nperseg;
+    // ruido: uniforme +-SW_NOISE/2 por componente + cuantización int8
+    double noise_db = 10 * log10(2.0 * (SW_NOISE * SW_NOISE / 12.0 + 1.0 / 12.0) / sim.fs);
+
+    CHECK(passes == 2 && sim.passes == 2, "sweep passes %d (callback %d)", passes, sim.passes);
+    CHECK(sim.f_first <= cfg.f_start_hz + df && sim.f_last >= cfg.f_stop_hz - df,
+          "sweep grid %.4f .. %.4f MHz", sim.f_first / 1e6, sim.f_last / 1e6);
+    for (int k = 0; k < SW_TONES; k++) {
+        CHECK(sim.peak_err_hz[k] <= df, "tone %.3f MHz: peak %.0f Hz off", sim.tones[k] / 1e6, sim.peak_err_hz[k]);
+        double err_db = 10 * log10(sim.tone_pwr[k] / (SW_AMP * SW_AMP));
+        CHECK(fabs(err_db) < 0.5, "tone %.3f MHz: power %+.2f dB off", sim.tones[k] / 1e6, err_db);
+    }
+    CHECK(fabs(sim.floor_db - noise_db) < 0.5, "sweep floor %.2f dB, expected %.2f", sim.floor_db, noise_db);
+    CHECK(sim.floor_spread_db < 1.0, "sweep floor not flat: %.2f dB spread", sim.floor_spread_db);
+
+    printf("[CHECK] sweep: %d steps, %d bins, floor %.2f dB (expected %.2f, spread %.2f), tones within %.0f Hz\n",
+           sw.nsteps, sim.nbins, sim.floor_db, noise_db, sim.floor_spread_db,
+           fmax(sim.peak_err_hz[0], fmax(sim.peak_err_hz[1], sim.peak_err_hz[2])));
+    psd_sweep_free(&sw);
+}
+
+int main(void) {
+    check_welch();
+    check_dpss(128, 4.0, 0);
+    check_dpss(512, 2.5, 4);
+    check_multitaper();
+    check_archive_format(PSD_AR_F32);
+    check_archive_format(PSD_AR_U8);
+    check_sweep();
+
+    if (g_failures) {
+        fprintf(stderr, "[CHECK] %d failure(s)\n", g_failures);
+        return 1;
+    }
+    printf("[CHECK] all passed\n");
+    return 0;
+}